@@ -0,0 +1,302 @@
+#include "stdafx.h"
+#include "assetStreamer.h"
+#include "Engine/FileSystem/virtualFileSystem.h"
+#include "Engine/Metrics/metrics.h"
+
+#include <algorithm>
+
+namespace {
+	constexpr size_t gPageSize = 4096;
+	constexpr std::array<std::string_view, static_cast<size_t>(RF::StreamPriority::Count)> gLatencyStatNames = {
+		"AssetStreamer/latencyMs/Critical",
+		"AssetStreamer/latencyMs/Visible",
+		"AssetStreamer/latencyMs/Prefetch",
+	};
+
+	double MsSince(const std::chrono::steady_clock::time_point& from) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+	}
+
+	// Reads one byte per page so the page faults of a mapped file are taken on the I/O thread and not in decode
+	void TouchPages(std::span<const std::byte> data) {
+		uint8_t checksum = 0;
+		for (size_t i = 0; i < data.size(); i += gPageSize) {
+			checksum ^= static_cast<uint8_t>(data[i]);
+		}
+
+		static std::atomic<uint8_t> sink = 0;
+		sink.store(checksum, std::memory_order_relaxed);
+	}
+}
+
+RF::AssetStreamer::AssetStreamer(VirtualFileSystem& fileSystem, JobSystem& jobSystem, Metrics* metrics, const AssetStreamerSettings& settings)
+	: mFileSystem(fileSystem), mJobSystem(jobSystem), mMetrics(metrics), mSettings(settings) {
+	const unsigned int threadCount = mSettings.ioThreadCount > 0 ? mSettings.ioThreadCount : 1;
+	mIoThreads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		mIoThreads.emplace_back([this]() { IoThreadLoop(); });
+	}
+}
+
+RF::AssetStreamer::~AssetStreamer() {
+	{
+		std::lock_guard lock(mMutex);
+		mIsStopping = true;
+	}
+	mCondition.notify_all();
+
+	for (std::thread& thread : mIoThreads) {
+		thread.join();
+	}
+
+	// Backend reads and decode jobs hold on to this streamer, they have to be done before it goes away
+	if (mSettings.fileBackend) {
+		mSettings.fileBackend->WaitIdle();
+	}
+	mJobSystem.Wait(mDecodeCounter);
+}
+
+RF::StreamRequestId RF::AssetStreamer::Request(StreamRequest request) {
+	auto pending = std::make_shared<PendingRequest>();
+	pending->requestTime = std::chrono::steady_clock::now();
+	pending->result.path = request.path;
+	pending->result.priority = request.priority;
+	pending->request = std::move(request);
+
+	StreamRequestId id = gInvalidStreamRequest;
+	{
+		std::lock_guard lock(mMutex);
+		id = mNextId++;
+		pending->result.id = id;
+		mRequests.emplace(id, pending);
+		mQueues[static_cast<size_t>(pending->result.priority)].push_back(pending);
+	}
+	mCondition.notify_one();
+
+	return id;
+}
+
+bool RF::AssetStreamer::Cancel(const StreamRequestId id) {
+	std::lock_guard lock(mMutex);
+	auto it = mRequests.find(id);
+	if (it == mRequests.end()) {
+		return false;
+	}
+
+	// Queued requests are dropped when they reach the front, in flight ones when they are delivered
+	it->second->isCancelled = true;
+	return true;
+}
+
+size_t RF::AssetStreamer::ProcessCompletions() {
+	std::vector<std::shared_ptr<PendingRequest>> completed;
+	{
+		std::lock_guard lock(mCompletedMutex);
+		const size_t limit = mSettings.maxCompletionsPerFrame > 0 ? mSettings.maxCompletionsPerFrame : mCompleted.size();
+		const size_t count = std::min(limit, mCompleted.size());
+		completed.assign(mCompleted.begin(), mCompleted.begin() + static_cast<std::ptrdiff_t>(count));
+		mCompleted.erase(mCompleted.begin(), mCompleted.begin() + static_cast<std::ptrdiff_t>(count));
+	}
+
+	if (completed.empty()) {
+		return 0;
+	}
+
+	{
+		std::lock_guard lock(mMutex);
+		for (const auto& pending : completed) {
+			mRequests.erase(pending->result.id);
+			--mInFlight;
+		}
+	}
+	mCondition.notify_all();
+
+	size_t delivered = 0;
+	for (const auto& pending : completed) {
+		if (pending->isCancelled) {
+			if (mMetrics) {
+				mMetrics->Increment("AssetStreamer/cancelled");
+			}
+			continue;
+		}
+
+		StreamResult& result = pending->result;
+		result.latencyMs = MsSince(pending->requestTime);
+		if (mMetrics) {
+			mMetrics->Record("AssetStreamer/latencyMs", result.latencyMs);
+			mMetrics->Record(gLatencyStatNames[static_cast<size_t>(result.priority)], result.latencyMs);
+			mMetrics->Increment(result.status == StreamStatus::Loaded ? "AssetStreamer/loaded" : "AssetStreamer/notFound");
+		}
+
+		if (pending->request.onComplete) {
+			pending->request.onComplete(result);
+		}
+		++delivered;
+	}
+
+	return delivered;
+}
+
+void RF::AssetStreamer::Flush() {
+	while (PendingCount() > 0) {
+		if (ProcessCompletions() == 0 && !mJobSystem.TryRunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+size_t RF::AssetStreamer::PendingCount() const {
+	std::lock_guard lock(mMutex);
+	return mRequests.size();
+}
+
+void RF::AssetStreamer::IoThreadLoop() {
+	while (true) {
+		std::shared_ptr<PendingRequest> pending;
+		{
+			std::unique_lock lock(mMutex);
+			mCondition.wait(lock, [this]() {
+				const bool hasQueued = std::any_of(mQueues.begin(), mQueues.end(), [](const auto& queue) { return !queue.empty(); });
+				return mIsStopping || (hasQueued && mInFlight < mSettings.maxInFlight);
+			});
+
+			if (mIsStopping) {
+				return;
+			}
+
+			pending = PopHighestPriority();
+			if (pending->isCancelled) {
+				mRequests.erase(pending->result.id);
+				if (mMetrics) {
+					mMetrics->Increment("AssetStreamer/cancelled");
+				}
+				continue;
+			}
+
+			++mInFlight;
+		}
+
+		if (mSettings.fileBackend) {
+			ReadWithBackend(pending);
+		}
+		else {
+			ReadMapped(pending);
+		}
+	}
+}
+
+std::shared_ptr<RF::AssetStreamer::PendingRequest> RF::AssetStreamer::PopHighestPriority() {
+	for (auto& queue : mQueues) {
+		if (!queue.empty()) {
+			std::shared_ptr<PendingRequest> pending = std::move(queue.front());
+			queue.pop_front();
+			return pending;
+		}
+	}
+
+	return nullptr;
+}
+
+void RF::AssetStreamer::ReadMapped(const std::shared_ptr<PendingRequest>& pending) {
+	const auto ioStart = std::chrono::steady_clock::now();
+	StreamResult& result = pending->result;
+	result.data = mFileSystem.Read(result.path);
+	if (result.data.empty() && !mFileSystem.Exists(result.path)) {
+		result.status = StreamStatus::NotFound;
+		Complete(pending);
+		return;
+	}
+
+	Throttle(result.data.size());
+	TouchPages(result.data);
+	result.status = StreamStatus::Loaded;
+	OnRead(pending, ioStart);
+}
+
+void RF::AssetStreamer::ReadWithBackend(const std::shared_ptr<PendingRequest>& pending) {
+	const auto ioStart = std::chrono::steady_clock::now();
+	FileLocation location;
+	if (!mFileSystem.Resolve(pending->result.path, location)) {
+		pending->result.status = StreamStatus::NotFound;
+		Complete(pending);
+		return;
+	}
+
+	Throttle(static_cast<size_t>(location.size));
+
+	// Aligned and padded so large loose files can be read unbuffered
+	pending->readBuffer = AlignedBuffer(static_cast<size_t>(location.size));
+
+	FileReadRequest request;
+	request.path = location.file;
+	request.offset = location.offset;
+	request.size = location.size;
+	request.destination = { pending->readBuffer.Span().data(), pending->readBuffer.Capacity() };
+	request.onComplete = [this, pending, ioStart](const FileReadResult& readResult) {
+		StreamResult& result = pending->result;
+		if (readResult.error != 0) {
+			result.status = StreamStatus::NotFound;
+			Complete(pending);
+			return;
+		}
+
+		result.data = readResult.data;
+		result.status = StreamStatus::Loaded;
+		OnRead(pending, ioStart);
+	};
+
+	std::vector<FileReadRequest> requests;
+	requests.push_back(std::move(request));
+	mSettings.fileBackend->Submit(std::move(requests));
+}
+
+void RF::AssetStreamer::OnRead(const std::shared_ptr<PendingRequest>& pending, const std::chrono::steady_clock::time_point& ioStart) {
+	if (mMetrics) {
+		mMetrics->Record("AssetStreamer/ioMs", MsSince(ioStart));
+		mMetrics->Increment("AssetStreamer/bytes", static_cast<int64_t>(pending->result.data.size()));
+	}
+
+	if (pending->request.decode && !pending->isCancelled) {
+		mJobSystem.Run([this, pending]() { Decode(pending); }, &mDecodeCounter);
+	}
+	else {
+		Complete(pending);
+	}
+}
+
+void RF::AssetStreamer::Throttle(const size_t byteCount) {
+	if (mSettings.maxBytesPerSecond == 0) {
+		return;
+	}
+
+	// Every read reserves a time slot proportional to its size, reads wait for the start of their slot
+	const auto duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(static_cast<double>(byteCount) / static_cast<double>(mSettings.maxBytesPerSecond)));
+
+	std::chrono::steady_clock::time_point start;
+	{
+		std::lock_guard lock(mMutex);
+		start = std::max(std::chrono::steady_clock::now(), mNextReadTime);
+		mNextReadTime = start + duration;
+	}
+
+	std::this_thread::sleep_until(start);
+}
+
+void RF::AssetStreamer::Decode(const std::shared_ptr<PendingRequest>& pending) {
+	if (!pending->isCancelled) {
+		const auto decodeStart = std::chrono::steady_clock::now();
+		pending->request.decode(pending->result);
+
+		if (mMetrics) {
+			mMetrics->Record("AssetStreamer/decodeMs", MsSince(decodeStart));
+		}
+	}
+
+	Complete(pending);
+}
+
+void RF::AssetStreamer::Complete(const std::shared_ptr<PendingRequest>& pending) {
+	std::lock_guard lock(mCompletedMutex);
+	mCompleted.push_back(pending);
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Platform/asyncFileBackend.h"
+
+namespace RF {
+	class Metrics;
+	class VirtualFileSystem;
+
+	// Lower value is served first
+	enum class StreamPriority : uint8_t {
+		Critical,
+		Visible,
+		Prefetch,
+		Count
+	};
+
+	enum class StreamStatus : uint8_t {
+		Loaded,
+		NotFound
+	};
+
+	using StreamRequestId = uint64_t;
+	constexpr StreamRequestId gInvalidStreamRequest = 0;
+
+	struct StreamResult {
+		StreamRequestId id = gInvalidStreamRequest;
+		std::string path = "";
+		StreamPriority priority = StreamPriority::Visible;
+		StreamStatus status = StreamStatus::NotFound;
+		// View into the VFS mapping, or into the streamer's read buffer when reading through a file backend.
+		// Only guaranteed to be valid during decode and onComplete
+		std::span<const std::byte> data = {};
+		// Whatever the decode step produced
+		std::shared_ptr<void> asset = nullptr;
+		double latencyMs = 0.0;
+	};
+
+	struct StreamRequest {
+		std::string path = "";
+		StreamPriority priority = StreamPriority::Visible;
+		// Runs on the job system after the read, fills in StreamResult::asset
+		std::function<void(StreamResult& result)> decode = nullptr;
+		// Runs on the main thread in ProcessCompletions()
+		std::function<void(const StreamResult& result)> onComplete = nullptr;
+	};
+
+	struct AssetStreamerSettings {
+		unsigned int ioThreadCount = 2;
+		// Requests between leaving the queue and having their completion delivered
+		unsigned int maxInFlight = 16;
+		// 0 means unlimited
+		uint64_t maxBytesPerSecond = 0;
+		// 0 means every finished request is delivered in the same frame
+		unsigned int maxCompletionsPerFrame = 0;
+		// Reads go through the VFS mappings when null, else files are read into owned buffers by the backend
+		AsyncFileBackend* fileBackend = nullptr;
+	};
+
+	/// <summary>
+	/// Loads files from the VirtualFileSystem on dedicated I/O threads, highest priority first,
+	/// decodes them on the job system and hands the results to the main thread at a frame boundary.
+	/// </summary>
+	class AssetStreamer {
+	public:
+		AssetStreamer(VirtualFileSystem& fileSystem, JobSystem& jobSystem, Metrics* metrics, const AssetStreamerSettings& settings = {});
+		~AssetStreamer();
+		AssetStreamer(const AssetStreamer&) = delete;
+		void operator=(const AssetStreamer&) = delete;
+
+		StreamRequestId Request(StreamRequest request);
+
+		/// <summary>
+		/// The completion callback of a cancelled request is never called.
+		/// </summary>
+		/// <returns>False if the request is unknown or already delivered.</returns>
+		bool Cancel(const StreamRequestId id);
+
+		/// <summary>
+		/// Delivers finished requests to their callbacks. Call once per frame from the main thread.
+		/// </summary>
+		/// <returns>Number of delivered requests.</returns>
+		size_t ProcessCompletions();
+
+		/// <summary>
+		/// Blocks, delivering completions, until every request is done. Meant for loading screens.
+		/// </summary>
+		void Flush();
+
+		/// <returns>Requests that are queued, in flight or waiting to be delivered.</returns>
+		size_t PendingCount() const;
+
+	private:
+		struct PendingRequest {
+			StreamRequest request;
+			StreamResult result;
+			std::chrono::steady_clock::time_point requestTime;
+			std::atomic<bool> isCancelled = false;
+			AlignedBuffer readBuffer;
+		};
+
+		void IoThreadLoop();
+		std::shared_ptr<PendingRequest> PopHighestPriority();
+		void ReadMapped(const std::shared_ptr<PendingRequest>& pending);
+		void ReadWithBackend(const std::shared_ptr<PendingRequest>& pending);
+		void OnRead(const std::shared_ptr<PendingRequest>& pending, const std::chrono::steady_clock::time_point& ioStart);
+		void Throttle(const size_t byteCount);
+		void Decode(const std::shared_ptr<PendingRequest>& pending);
+		void Complete(const std::shared_ptr<PendingRequest>& pending);
+
+		VirtualFileSystem& mFileSystem;
+		JobSystem& mJobSystem;
+		Metrics* mMetrics = nullptr;
+		const AssetStreamerSettings mSettings;
+
+		std::array<std::deque<std::shared_ptr<PendingRequest>>, static_cast<size_t>(StreamPriority::Count)> mQueues;
+		std::unordered_map<StreamRequestId, std::shared_ptr<PendingRequest>> mRequests;
+		StreamRequestId mNextId = 1;
+		unsigned int mInFlight = 0;
+		std::chrono::steady_clock::time_point mNextReadTime;
+		bool mIsStopping = false;
+		mutable std::mutex mMutex;
+		std::condition_variable mCondition;
+
+		std::vector<std::shared_ptr<PendingRequest>> mCompleted;
+		std::mutex mCompletedMutex;
+
+		JobCounter mDecodeCounter;
+		std::vector<std::thread> mIoThreads;
+	};
+}
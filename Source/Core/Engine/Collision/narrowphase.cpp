@@ -0,0 +1,244 @@
+#include "stdafx.h"
+#include "narrowphase.h"
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Spatial/spatialQueryBatch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles AVX intrinsics anywhere, other compilers need the functions using them marked
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace {
+	constexpr size_t gLanes = 8;
+	constexpr size_t gBlockSize = RF::Narrowphase::gBlockSize;
+	// Centers closer than this get an arbitrary normal instead of dividing by almost zero
+	constexpr float gMinDistance = 1e-6f;
+
+	// A block of pairs gathered into SoA. Circles leave the segment empty, capsule pairs store the capsule's start
+	// in a, its segment and the circle in b. Padding pairs are all zero and never overlap
+	struct Block {
+		alignas(32) std::array<float, gBlockSize> ax;
+		alignas(32) std::array<float, gBlockSize> ay;
+		alignas(32) std::array<float, gBlockSize> segmentXs;
+		alignas(32) std::array<float, gBlockSize> segmentYs;
+		alignas(32) std::array<float, gBlockSize> bx;
+		alignas(32) std::array<float, gBlockSize> by;
+		alignas(32) std::array<float, gBlockSize> radiusSums;
+	};
+
+	// Where a block's results go, pair 0 of the block is at a multiple of eight
+	struct Output {
+		float* normalXs = nullptr;
+		float* normalYs = nullptr;
+		float* depths = nullptr;
+		uint8_t* hitMasks = nullptr;
+	};
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	// Contact between shape b's center and the closest point of shape a, (dx, dy) apart, the same math as the AVX2 lanes
+	void ResolveScalar(const float dx, const float dy, const float radiusSum, const size_t i, const Output& output) {
+		const float distance = std::sqrt(dx * dx + dy * dy);
+		const float inverse = 1.0f / distance;
+		const bool separated = distance > gMinDistance;
+		output.normalXs[i] = separated ? dx * inverse : 1.0f;
+		output.normalYs[i] = separated ? dy * inverse : 0.0f;
+		output.depths[i] = radiusSum - distance;
+	}
+
+	void HitMasksScalar(const size_t count, const Output& output) {
+		for (size_t group = 0; group < count; group += gLanes) {
+			unsigned int mask = 0;
+			for (size_t lane = 0; lane < gLanes; ++lane) {
+				mask |= static_cast<unsigned int>(output.depths[group + lane] > 0.0f) << lane;
+			}
+			output.hitMasks[group / gLanes] = static_cast<uint8_t>(mask);
+		}
+	}
+
+	void CirclesScalar(const Block& block, const size_t count, const Output& output) {
+		for (size_t i = 0; i < count; ++i) {
+			ResolveScalar(block.bx[i] - block.ax[i], block.by[i] - block.ay[i], block.radiusSums[i], i, output);
+		}
+		HitMasksScalar(count, output);
+	}
+
+	void CapsulesScalar(const Block& block, const size_t count, const Output& output) {
+		for (size_t i = 0; i < count; ++i) {
+			const float sx = block.segmentXs[i];
+			const float sy = block.segmentYs[i];
+			const float px = block.bx[i] - block.ax[i];
+			const float py = block.by[i] - block.ay[i];
+			const float lengthSquared = sx * sx + sy * sy;
+			const float t = lengthSquared > 0.0f ? std::clamp((px * sx + py * sy) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+			ResolveScalar(px - t * sx, py - t * sy, block.radiusSums[i], i, output);
+		}
+		HitMasksScalar(count, output);
+	}
+
+	AVX2_FUNCTION void ResolveAvx2(const __m256 dx, const __m256 dy, const __m256 radiusSum, const size_t i, const Output& output) {
+		const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+		const __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), distance);
+		const __m256 separated = _mm256_cmp_ps(distance, _mm256_set1_ps(gMinDistance), _CMP_GT_OQ);
+		const __m256 depth = _mm256_sub_ps(radiusSum, distance);
+		_mm256_storeu_ps(output.normalXs + i, _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(dx, inverse), separated));
+		_mm256_storeu_ps(output.normalYs + i, _mm256_blendv_ps(_mm256_setzero_ps(), _mm256_mul_ps(dy, inverse), separated));
+		_mm256_storeu_ps(output.depths + i, depth);
+		output.hitMasks[i / gLanes] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_cmp_ps(depth, _mm256_setzero_ps(), _CMP_GT_OQ)));
+	}
+
+	AVX2_FUNCTION void CirclesAvx2(const Block& block, const size_t count, const Output& output) {
+		for (size_t i = 0; i < count; i += gLanes) {
+			const __m256 dx = _mm256_sub_ps(_mm256_load_ps(block.bx.data() + i), _mm256_load_ps(block.ax.data() + i));
+			const __m256 dy = _mm256_sub_ps(_mm256_load_ps(block.by.data() + i), _mm256_load_ps(block.ay.data() + i));
+			ResolveAvx2(dx, dy, _mm256_load_ps(block.radiusSums.data() + i), i, output);
+		}
+	}
+
+	AVX2_FUNCTION void CapsulesAvx2(const Block& block, const size_t count, const Output& output) {
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		for (size_t i = 0; i < count; i += gLanes) {
+			const __m256 sx = _mm256_load_ps(block.segmentXs.data() + i);
+			const __m256 sy = _mm256_load_ps(block.segmentYs.data() + i);
+			const __m256 px = _mm256_sub_ps(_mm256_load_ps(block.bx.data() + i), _mm256_load_ps(block.ax.data() + i));
+			const __m256 py = _mm256_sub_ps(_mm256_load_ps(block.by.data() + i), _mm256_load_ps(block.ay.data() + i));
+			const __m256 lengthSquared = _mm256_add_ps(_mm256_mul_ps(sx, sx), _mm256_mul_ps(sy, sy));
+			const __m256 projection = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(px, sx), _mm256_mul_ps(py, sy)), lengthSquared);
+			// Degenerate segments divide by zero, masking them to 0 also drops the NaN
+			const __m256 clamped = _mm256_min_ps(_mm256_max_ps(projection, zero), one);
+			const __m256 t = _mm256_and_ps(clamped, _mm256_cmp_ps(lengthSquared, zero, _CMP_GT_OQ));
+			const __m256 dx = _mm256_sub_ps(px, _mm256_mul_ps(t, sx));
+			const __m256 dy = _mm256_sub_ps(py, _mm256_mul_ps(t, sy));
+			ResolveAvx2(dx, dy, _mm256_load_ps(block.radiusSums.data() + i), i, output);
+		}
+	}
+
+	bool DetectAvx2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+
+		// The OS has to save the upper halves of the ymm registers too
+		__cpuid(info, 1);
+		constexpr int osSavesYmm = (1 << 27) | (1 << 28);
+		if ((info[2] & osSavesYmm) != osSavesYmm || (_xgetbv(0) & 6) != 6) {
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	// Gathers and resolves every block of pairs, gather(block, begin, count) fills the block for pairs [begin, begin + count).
+	// Kernels are handed a multiple of eight pairs
+	template <typename Gather>
+	void Run(RF::JobSystem* jobSystem, const size_t pairCount, const Output& output, const Gather& gather, void (*resolve)(const Block&, size_t, const Output&)) {
+		const size_t blockCount = (pairCount + gBlockSize - 1) / gBlockSize;
+		ParallelFor(jobSystem, blockCount, 1, [pairCount, &output, &gather, resolve](const size_t begin, const size_t end) {
+			Block block;
+			for (size_t blockIndex = begin; blockIndex < end; ++blockIndex) {
+				const size_t first = blockIndex * gBlockSize;
+				const size_t count = std::min(gBlockSize, pairCount - first);
+				const size_t padded = (count + gLanes - 1) / gLanes * gLanes;
+				gather(block, first, count);
+				std::fill(block.ax.begin() + count, block.ax.begin() + padded, 0.0f);
+				std::fill(block.ay.begin() + count, block.ay.begin() + padded, 0.0f);
+				std::fill(block.segmentXs.begin() + count, block.segmentXs.begin() + padded, 0.0f);
+				std::fill(block.segmentYs.begin() + count, block.segmentYs.begin() + padded, 0.0f);
+				std::fill(block.bx.begin() + count, block.bx.begin() + padded, 0.0f);
+				std::fill(block.by.begin() + count, block.by.begin() + padded, 0.0f);
+				std::fill(block.radiusSums.begin() + count, block.radiusSums.begin() + padded, 0.0f);
+
+				const Output blockOutput = { output.normalXs + first, output.normalYs + first, output.depths + first, output.hitMasks + first / gLanes };
+				resolve(block, padded, blockOutput);
+			}
+		});
+	}
+}
+
+void RF::ContactBatch::Resize(const size_t count) {
+	const size_t padded = (count + gLanes - 1) / gLanes * gLanes;
+	mCount = count;
+	mNormalXs.resize(padded);
+	mNormalYs.resize(padded);
+	mDepths.resize(padded);
+	mHitMasks.resize(padded / gLanes);
+}
+
+RF::Narrowphase::Narrowphase(JobSystem* jobSystem) : mUseAvx2(IsAvx2Supported()), mJobSystem(jobSystem) {}
+
+bool RF::Narrowphase::IsAvx2Supported() {
+	static const bool supported = DetectAvx2();
+	return supported;
+}
+
+void RF::Narrowphase::CirclesVsCircles(std::span<const CollisionPair> pairs, const CircleSet& circles, ContactBatch& contacts) const {
+	assert(circles.xs.size() == circles.ys.size() && circles.xs.size() == circles.radii.size() && "Narrowphase circle spans have different sizes");
+	contacts.Resize(pairs.size());
+	const Output output = { contacts.mNormalXs.data(), contacts.mNormalYs.data(), contacts.mDepths.data(), contacts.mHitMasks.data() };
+	Run(mJobSystem, pairs.size(), output, [&pairs, &circles](Block& block, const size_t begin, const size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const CollisionPair& pair = pairs[begin + i];
+			assert(pair.a < circles.xs.size() && pair.b < circles.xs.size() && "Narrowphase pair out of range");
+			block.ax[i] = circles.xs[pair.a];
+			block.ay[i] = circles.ys[pair.a];
+			block.bx[i] = circles.xs[pair.b];
+			block.by[i] = circles.ys[pair.b];
+			block.radiusSums[i] = circles.radii[pair.a] + circles.radii[pair.b];
+		}
+	}, mUseAvx2 ? CirclesAvx2 : CirclesScalar);
+}
+
+void RF::Narrowphase::CapsulesVsCircles(std::span<const CollisionPair> pairs, const CapsuleSet& capsules, const CircleSet& circles, ContactBatch& contacts) const {
+	assert(circles.xs.size() == circles.ys.size() && circles.xs.size() == circles.radii.size() && "Narrowphase circle spans have different sizes");
+	assert(capsules.startXs.size() == capsules.startYs.size() && capsules.startXs.size() == capsules.endXs.size() && capsules.startXs.size() == capsules.endYs.size()
+		&& capsules.startXs.size() == capsules.radii.size() && "Narrowphase capsule spans have different sizes");
+	contacts.Resize(pairs.size());
+	const Output output = { contacts.mNormalXs.data(), contacts.mNormalYs.data(), contacts.mDepths.data(), contacts.mHitMasks.data() };
+	Run(mJobSystem, pairs.size(), output, [&pairs, &capsules, &circles](Block& block, const size_t begin, const size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			const CollisionPair& pair = pairs[begin + i];
+			assert(pair.a < capsules.startXs.size() && pair.b < circles.xs.size() && "Narrowphase pair out of range");
+			block.ax[i] = capsules.startXs[pair.a];
+			block.ay[i] = capsules.startYs[pair.a];
+			block.segmentXs[i] = capsules.endXs[pair.a] - capsules.startXs[pair.a];
+			block.segmentYs[i] = capsules.endYs[pair.a] - capsules.startYs[pair.a];
+			block.bx[i] = circles.xs[pair.b];
+			block.by[i] = circles.ys[pair.b];
+			block.radiusSums[i] = capsules.radii[pair.a] + circles.radii[pair.b];
+		}
+	}, mUseAvx2 ? CapsulesAvx2 : CapsulesScalar);
+}
+
+void RF::Narrowphase::AppendPairs(const SpatialQueryBatch& queries, const bool selfQuery, std::vector<CollisionPair>& pairs) {
+	for (size_t query = 0; query < queries.QueryCount(); ++query) {
+		const uint32_t a = static_cast<uint32_t>(query);
+		for (const uint32_t b : queries.Results(query)) {
+			if (!selfQuery || a < b) {
+				pairs.push_back({ a, b });
+			}
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RF {
+	class JobSystem;
+	class SpatialQueryBatch;
+
+	// Candidate pair from a broadphase, indices into the two shape sets
+	struct CollisionPair {
+		uint32_t a = 0;
+		uint32_t b = 0;
+	};
+
+	// Circles as SoA, all spans the same length
+	struct CircleSet {
+		std::span<const float> xs;
+		std::span<const float> ys;
+		std::span<const float> radii;
+	};
+
+	// Capsules as SoA, segments from start to end swept by radius
+	struct CapsuleSet {
+		std::span<const float> startXs;
+		std::span<const float> startYs;
+		std::span<const float> endXs;
+		std::span<const float> endYs;
+		std::span<const float> radii;
+	};
+
+	/// <summary>
+	/// Results of a narrowphase batch, one per pair in pair order. Normals point from shape a to shape b and have
+	/// unit length, depth is how far the shapes overlap and zero or negative for pairs that don't. Bit j of
+	/// HitMasks()[g] is set if pair 8 * g + j overlaps.
+	/// </summary>
+	class ContactBatch {
+	public:
+		size_t Count() const { return mCount; }
+		bool IsHit(const size_t pair) const { return ((static_cast<unsigned int>(mHitMasks[pair / 8]) >> (pair % 8)) & 1u) != 0; }
+		std::span<const float> NormalXs() const { return std::span<const float>(mNormalXs).first(mCount); }
+		std::span<const float> NormalYs() const { return std::span<const float>(mNormalYs).first(mCount); }
+		std::span<const float> Depths() const { return std::span<const float>(mDepths).first(mCount); }
+		std::span<const uint8_t> HitMasks() const { return mHitMasks; }
+
+		/// <summary>
+		/// Calls func(pair) for every overlapping pair in order, skipping eight misses at a time.
+		/// </summary>
+		template <typename Func>
+		void ForEachHit(Func&& func) const {
+			for (size_t group = 0; group < mHitMasks.size(); ++group) {
+				for (unsigned int mask = mHitMasks[group]; mask != 0; mask &= mask - 1) {
+					func(group * 8 + static_cast<size_t>(std::countr_zero(mask)));
+				}
+			}
+		}
+
+	private:
+		friend class Narrowphase;
+
+		// Outputs are padded to a multiple of eight pairs
+		void Resize(const size_t count);
+
+		size_t mCount = 0;
+		std::vector<float> mNormalXs;
+		std::vector<float> mNormalYs;
+		std::vector<float> mDepths;
+		std::vector<uint8_t> mHitMasks;
+	};
+
+	/// <summary>
+	/// Batched circle vs circle and capsule vs circle tests for broadphase candidate pairs. Pairs are processed in
+	/// blocks: the positions and radii of a block are gathered into SoA arrays on the stack, then resolved eight
+	/// pairs per instruction with AVX2, or one at a time on CPUs without it. Blocks run over the job system and
+	/// every pair's results only depend on its own shapes, so output doesn't change with the number of jobs.
+	/// </summary>
+	class Narrowphase {
+	public:
+		explicit Narrowphase(JobSystem* jobSystem = nullptr);
+		Narrowphase(const Narrowphase&) = delete;
+		void operator=(const Narrowphase&) = delete;
+
+		static bool IsAvx2Supported();
+		bool IsAvx2Enabled() const { return mUseAvx2; }
+		// Falls back to the scalar path when disabled, ignored if the CPU has no AVX2
+		void SetAvx2Enabled(const bool enabled) { mUseAvx2 = enabled && IsAvx2Supported(); }
+
+		// pair.a and pair.b both index circles
+		void CirclesVsCircles(std::span<const CollisionPair> pairs, const CircleSet& circles, ContactBatch& contacts) const;
+		// pair.a indexes capsules, pair.b circles
+		void CapsulesVsCircles(std::span<const CollisionPair> pairs, const CapsuleSet& capsules, const CircleSet& circles, ContactBatch& contacts) const;
+
+		/// <summary>
+		/// Appends the pairs (query, result) of a batch of broadphase queries to pairs. For a batch where every
+		/// shape queried the set it belongs to, selfQuery keeps one pair per couple and drops shapes paired with
+		/// themselves.
+		/// </summary>
+		static void AppendPairs(const SpatialQueryBatch& queries, const bool selfQuery, std::vector<CollisionPair>& pairs);
+
+		static constexpr size_t gBlockSize = 256;
+
+	private:
+		bool mUseAvx2 = false;
+		JobSystem* mJobSystem = nullptr;
+	};
+}
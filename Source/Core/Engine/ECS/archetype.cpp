@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "archetype.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+	size_t AlignUp(const size_t value, const size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+RF::ChunkPool::~ChunkPool() {
+	assert(mFreeChunks.size() == mAllocatedCount && "Chunks are still in use");
+	for (std::byte* memory : mFreeChunks) {
+		::operator delete(memory, std::align_val_t(gChunkColumnAlignment));
+	}
+}
+
+std::byte* RF::ChunkPool::Allocate() {
+	if (mFreeChunks.empty()) {
+		++mAllocatedCount;
+		return static_cast<std::byte*>(::operator new(gChunkSize, std::align_val_t(gChunkColumnAlignment)));
+	}
+
+	std::byte* memory = mFreeChunks.back();
+	mFreeChunks.pop_back();
+	return memory;
+}
+
+void RF::ChunkPool::Free(std::byte* memory) {
+	mFreeChunks.push_back(memory);
+}
+
+size_t RF::ChunkPool::AllocatedCount() const {
+	return mAllocatedCount;
+}
+
+RF::Archetype::Archetype(const ComponentMask& mask, ChunkPool& chunkPool) : mMask(mask), mChunkPool(chunkPool) {
+	mColumnOffsets.fill(gNoColumn);
+	mTypeIndices.fill(0);
+
+	size_t rowSize = sizeof(Entity);
+	size_t columnCount = 1;
+	for (size_t type = 0; type < gMaxComponentTypes; ++type) {
+		if (!mask.test(type)) {
+			continue;
+		}
+
+		mTypeIndices[type] = static_cast<uint16_t>(mTypes.size());
+		mTypes.push_back(static_cast<ComponentTypeId>(type));
+		const ComponentInfo& info = Ecs::GetComponentInfo(static_cast<ComponentTypeId>(type));
+		assert(info.alignment <= gChunkColumnAlignment && "Component alignment is larger than the chunk column alignment");
+		if (info.size > 0) {
+			rowSize += info.size;
+			++columnCount;
+		}
+	}
+
+	// Every column can lose up to one alignment worth of bytes to padding
+	const size_t usableSize = gChunkSize - columnCount * gChunkColumnAlignment;
+	mChunkCapacity = static_cast<uint32_t>(usableSize / rowSize);
+	assert(mChunkCapacity > 0 && "Components are too large to fit a single entity in a chunk");
+
+	size_t offset = AlignUp(sizeof(Entity) * mChunkCapacity, gChunkColumnAlignment);
+	for (const ComponentTypeId type : mTypes) {
+		const ComponentInfo& info = Ecs::GetComponentInfo(type);
+		if (info.size == 0) {
+			continue;
+		}
+
+		mColumnOffsets[type] = static_cast<uint32_t>(offset);
+		offset = AlignUp(offset + static_cast<size_t>(info.size) * mChunkCapacity, gChunkColumnAlignment);
+	}
+	assert(offset <= gChunkSize);
+
+	for (const ComponentTypeId type : mTypes) {
+		mComponentSizes.push_back(Ecs::GetComponentInfo(type).size);
+	}
+}
+
+RF::Archetype::~Archetype() {
+	for (Chunk& chunk : mChunks) {
+		mChunkPool.Free(chunk.memory);
+	}
+}
+
+void RF::Archetype::AddRow(const Entity entity, uint32_t& chunkIndex, uint32_t& row) {
+	if (mChunks.empty() || mChunks.back().count == mChunkCapacity) {
+		PushChunk();
+	}
+
+	Chunk& chunk = mChunks.back();
+	chunkIndex = static_cast<uint32_t>(mChunks.size() - 1);
+	row = chunk.count++;
+	Entities(chunk)[row] = entity;
+	++mEntityCount;
+}
+
+uint32_t RF::Archetype::AddRows(const uint32_t count, uint32_t& chunkIndex, uint32_t& firstRow) {
+	if (mChunks.empty() || mChunks.back().count == mChunkCapacity) {
+		PushChunk();
+	}
+
+	Chunk& chunk = mChunks.back();
+	const uint32_t added = count < mChunkCapacity - chunk.count ? count : mChunkCapacity - chunk.count;
+	chunkIndex = static_cast<uint32_t>(mChunks.size() - 1);
+	firstRow = chunk.count;
+	chunk.count += added;
+	mEntityCount += added;
+	return added;
+}
+
+RF::Entity RF::Archetype::RemoveRow(const uint32_t chunkIndex, const uint32_t row) {
+	Chunk& chunk = mChunks[chunkIndex];
+	Chunk& lastChunk = mChunks.back();
+	const uint32_t lastRow = lastChunk.count - 1;
+
+	Entity moved = Entity::Null;
+	if (&chunk != &lastChunk || row != lastRow) {
+		moved = Entities(lastChunk)[lastRow];
+		Entities(chunk)[row] = moved;
+
+		for (size_t i = 0; i < mTypes.size(); ++i) {
+			const size_t size = mComponentSizes[i];
+			if (size == 0) {
+				continue;
+			}
+
+			const uint32_t offset = mColumnOffsets[mTypes[i]];
+			std::memcpy(chunk.memory + offset + row * size, lastChunk.memory + offset + lastRow * size, size);
+		}
+	}
+
+	--lastChunk.count;
+	--mEntityCount;
+	if (lastChunk.count == 0) {
+		PopChunk();
+	}
+
+	return moved;
+}
+
+void RF::Archetype::Clear() {
+	for (Chunk& chunk : mChunks) {
+		mChunkPool.Free(chunk.memory);
+	}
+	mChunks.clear();
+	mChangedVersions.clear();
+	mAddedVersions.clear();
+	mEntityCount = 0;
+}
+
+void RF::Archetype::MarkAdded(const size_t chunkIndex, const ComponentTypeId type, const uint64_t version) {
+	const size_t index = VersionIndex(chunkIndex, type);
+	mAddedVersions[index] = version;
+	mChangedVersions[index] = version;
+}
+
+void RF::Archetype::MarkAllAdded(const size_t chunkIndex, const uint64_t version) {
+	const size_t first = chunkIndex * mTypes.size();
+	std::fill_n(mAddedVersions.begin() + static_cast<std::ptrdiff_t>(first), mTypes.size(), version);
+	std::fill_n(mChangedVersions.begin() + static_cast<std::ptrdiff_t>(first), mTypes.size(), version);
+}
+
+void RF::Archetype::MarkAllChanged(const size_t chunkIndex, const uint64_t version) {
+	const size_t first = chunkIndex * mTypes.size();
+	std::fill_n(mChangedVersions.begin() + static_cast<std::ptrdiff_t>(first), mTypes.size(), version);
+}
+
+void RF::Archetype::PushChunk() {
+	mChunks.push_back({ mChunkPool.Allocate(), 0 });
+	mChangedVersions.resize(mChunks.size() * mTypes.size(), 0);
+	mAddedVersions.resize(mChunks.size() * mTypes.size(), 0);
+}
+
+void RF::Archetype::PopChunk() {
+	mChunkPool.Free(mChunks.back().memory);
+	mChunks.pop_back();
+	mChangedVersions.resize(mChunks.size() * mTypes.size());
+	mAddedVersions.resize(mChunks.size() * mTypes.size());
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "component.h"
+#include "entity.h"
+
+namespace RF {
+	constexpr size_t gChunkSize = 16 * 1024;
+	// Every column starts on a cache line so SIMD loops can use aligned loads
+	constexpr size_t gChunkColumnAlignment = 64;
+
+	struct Chunk {
+		std::byte* memory = nullptr;
+		uint32_t count = 0;
+	};
+
+	/// <summary>
+	/// Recycles chunk memory between archetypes of a world, so entities moving back and forth don't hit the heap.
+	/// </summary>
+	class ChunkPool {
+	public:
+		ChunkPool() = default;
+		~ChunkPool();
+		ChunkPool(const ChunkPool&) = delete;
+		void operator=(const ChunkPool&) = delete;
+
+		std::byte* Allocate();
+		void Free(std::byte* memory);
+
+		size_t AllocatedCount() const;
+
+	private:
+		std::vector<std::byte*> mFreeChunks;
+		size_t mAllocatedCount = 0;
+	};
+
+	/// <summary>
+	/// All entities with exactly the same set of components. They are stored in 16KB chunks, each chunk holds
+	/// an entity array followed by one tightly packed array per component (SoA). Rows are kept dense, removing
+	/// an entity moves the last entity of the archetype into the hole.
+	/// </summary>
+	class Archetype {
+	public:
+		Archetype(const ComponentMask& mask, ChunkPool& chunkPool);
+		~Archetype();
+		Archetype(const Archetype&) = delete;
+		void operator=(const Archetype&) = delete;
+
+		const ComponentMask& Mask() const { return mMask; }
+		// Sorted by id
+		std::span<const ComponentTypeId> Types() const { return mTypes; }
+		bool Has(const ComponentTypeId type) const { return mMask.test(type); }
+
+		uint32_t ChunkCapacity() const { return mChunkCapacity; }
+		size_t ChunkCount() const { return mChunks.size(); }
+		size_t EntityCount() const { return mEntityCount; }
+
+		Chunk& GetChunk(const size_t index) { return mChunks[index]; }
+		const Chunk& GetChunk(const size_t index) const { return mChunks[index]; }
+
+		Entity* Entities(const Chunk& chunk) const { return reinterpret_cast<Entity*>(chunk.memory); }
+
+		/// <returns>Start of the component array in the chunk, nullptr for tags and components the archetype doesn't have.</returns>
+		std::byte* Column(const Chunk& chunk, const ComponentTypeId type) const {
+			const uint32_t offset = mColumnOffsets[type];
+			return offset != gNoColumn ? chunk.memory + offset : nullptr;
+		}
+
+		template <typename T>
+		T* Column(const Chunk& chunk) const {
+			return reinterpret_cast<T*>(Column(chunk, Ecs::TypeId<std::remove_const_t<T>>()));
+		}
+
+		/// <summary>
+		/// Appends an uninitialized row for the entity, allocating a chunk if the last one is full.
+		/// </summary>
+		void AddRow(const Entity entity, uint32_t& chunkIndex, uint32_t& row);
+
+		/// <summary>
+		/// Appends up to count uninitialized rows to the last chunk, or a new one if it is full.
+		/// </summary>
+		/// <returns>Number of rows added, less than count when the chunk filled up.</returns>
+		uint32_t AddRows(const uint32_t count, uint32_t& chunkIndex, uint32_t& firstRow);
+
+		/// <summary>
+		/// Removes a row by moving the archetype's last row into it.
+		/// </summary>
+		/// <returns>The entity that was moved into the row, Entity::Null if the removed row was the last one.</returns>
+		Entity RemoveRow(const uint32_t chunkIndex, const uint32_t row);
+
+		/// <summary>
+		/// Drops every row and returns the chunks to the pool.
+		/// </summary>
+		void Clear();
+
+		// Change versions per chunk and component, in World::ChangeVersion() units. A chunk's changed version is
+		// bumped by write access and whenever rows move in, its added version when rows that gained the component
+		// (or were created with it) land in the chunk. Versions of a new chunk start at 0.
+		uint64_t ChangedVersion(const size_t chunkIndex, const ComponentTypeId type) const { return mChangedVersions[VersionIndex(chunkIndex, type)]; }
+		uint64_t AddedVersion(const size_t chunkIndex, const ComponentTypeId type) const { return mAddedVersions[VersionIndex(chunkIndex, type)]; }
+		void MarkChanged(const size_t chunkIndex, const ComponentTypeId type, const uint64_t version) { mChangedVersions[VersionIndex(chunkIndex, type)] = version; }
+
+		/// <summary>
+		/// Marks the component as both added and changed.
+		/// </summary>
+		void MarkAdded(const size_t chunkIndex, const ComponentTypeId type, const uint64_t version);
+		void MarkAllAdded(const size_t chunkIndex, const uint64_t version);
+		void MarkAllChanged(const size_t chunkIndex, const uint64_t version);
+
+	private:
+		static constexpr uint32_t gNoColumn = UINT32_MAX;
+
+		size_t VersionIndex(const size_t chunkIndex, const ComponentTypeId type) const {
+			assert(mMask.test(type) && "Archetype doesn't have the component");
+			return chunkIndex * mTypes.size() + mTypeIndices[type];
+		}
+
+		void PushChunk();
+		void PopChunk();
+
+		ComponentMask mMask;
+		std::vector<ComponentTypeId> mTypes;
+		// Per component type, the byte offset of its column inside a chunk
+		std::array<uint32_t, gMaxComponentTypes> mColumnOffsets;
+		std::vector<uint32_t> mComponentSizes;
+		// Per component type, its index in mTypes
+		std::array<uint16_t, gMaxComponentTypes> mTypeIndices;
+		uint32_t mChunkCapacity = 0;
+
+		std::vector<Chunk> mChunks;
+		// mTypes.size() versions per chunk
+		std::vector<uint64_t> mChangedVersions;
+		std::vector<uint64_t> mAddedVersions;
+		size_t mEntityCount = 0;
+		ChunkPool& mChunkPool;
+	};
+}
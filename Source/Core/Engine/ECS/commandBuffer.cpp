@@ -0,0 +1,248 @@
+#include "stdafx.h"
+#include "commandBuffer.h"
+#include "world.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+
+namespace {
+	struct CommandRef {
+		uint64_t sortKey = 0;
+		uint32_t buffer = 0;
+		uint32_t command = 0;
+	};
+
+	uint32_t PlaceholderIndex(const RF::Entity placeholder) {
+		return RF::Ecs::EntityIndex(placeholder) - 1;
+	}
+}
+
+void RF::CommandBuffer::Destroy(const Entity entity) {
+	++mCommandCount;
+	mCommands.push_back({ .sortKey = mSortKey, .entity = entity, .type = CommandType::Destroy });
+}
+
+RF::Entity RF::CommandBuffer::Resolve(const Entity entity) const {
+	if (!IsPlaceholder(entity)) {
+		return entity;
+	}
+
+	const uint32_t index = PlaceholderIndex(entity);
+	return index < mResolved.size() ? mResolved[index] : Entity::Null;
+}
+
+bool RF::CommandBuffer::IsPlaceholder(const Entity entity) {
+	// Live entities never have generation 0
+	return Ecs::EntityGeneration(entity) == 0 && entity != Entity::Null;
+}
+
+void RF::CommandBuffer::Playback(World& world) {
+	CommandBuffer* buffer = this;
+	Playback(world, std::span<CommandBuffer* const>(&buffer, 1));
+}
+
+void RF::CommandBuffer::Playback(World& world, std::span<CommandBuffer* const> buffers) {
+	size_t commandCount = 0;
+	for (const CommandBuffer* buffer : buffers) {
+		commandCount += buffer->mCommands.size();
+	}
+
+	std::vector<CommandRef> order;
+	order.reserve(commandCount);
+	for (size_t i = 0; i < buffers.size(); ++i) {
+		CommandBuffer& buffer = *buffers[i];
+		buffer.mResolved.assign(buffer.mPlaceholderCount, Entity::Null);
+		for (size_t command = 0; command < buffer.mCommands.size(); ++command) {
+			order.push_back({ buffer.mCommands[command].sortKey, static_cast<uint32_t>(i), static_cast<uint32_t>(command) });
+		}
+	}
+
+	auto isLess = [](const CommandRef& lhs, const CommandRef& rhs) { return lhs.sortKey < rhs.sortKey; };
+	if (!std::is_sorted(order.begin(), order.end(), isLess)) {
+		std::stable_sort(order.begin(), order.end(), isLess);
+	}
+
+	std::vector<Entity> created;
+	size_t i = 0;
+	while (i < order.size()) {
+		CommandBuffer& buffer = *buffers[order[i].buffer];
+		const Command& command = buffer.mCommands[order[i].command];
+
+		if (command.type == CommandType::Create) {
+			// Runs of creates that continue each other's rows and placeholders, e.g. from chunks with consecutive sort
+			// keys, are made in one batch
+			const SpawnGroup& group = buffer.mSpawnGroups[command.spawnGroup];
+			size_t end = i + 1;
+			uint32_t count = command.count;
+			while (end < order.size() && order[end].buffer == order[i].buffer) {
+				const Command& next = buffer.mCommands[order[end].command];
+				if (next.type != CommandType::Create || next.spawnGroup != command.spawnGroup || next.data != command.data + count
+					|| PlaceholderIndex(next.entity) != PlaceholderIndex(command.entity) + count) {
+					break;
+				}
+				count += next.count;
+				++end;
+			}
+
+			created.resize(count);
+			const uint32_t firstGroupRow = command.data;
+			world.CreateBatch(world.GetOrCreateArchetype(group.mask), created,
+				[&group, firstGroupRow](const Archetype& archetype, const Chunk& chunk, const uint32_t firstRow, const uint32_t rowCount, const size_t firstEntity) {
+					for (size_t column = 0; column < group.types.size(); ++column) {
+						const size_t size = Ecs::GetComponentInfo(group.types[column]).size;
+						std::memcpy(archetype.Column(chunk, group.types[column]) + size * firstRow, group.columns[column].data() + size * (firstGroupRow + firstEntity), size * rowCount);
+					}
+				});
+
+			std::copy(created.begin(), created.end(), buffer.mResolved.begin() + static_cast<std::ptrdiff_t>(PlaceholderIndex(command.entity)));
+			i = end;
+			continue;
+		}
+
+		const Entity entity = buffer.Resolve(command.entity);
+		assert(entity != Entity::Null && "CommandBuffer used a placeholder before the command that creates it");
+		switch (command.type) {
+		case CommandType::Destroy:
+			world.Destroy(entity);
+			break;
+		case CommandType::Add: {
+			void* data = world.AddComponent(entity, command.component);
+			if (data) {
+				std::memcpy(data, buffer.mData.data() + command.data, Ecs::GetComponentInfo(command.component).size);
+			}
+			break;
+		}
+		case CommandType::Remove:
+			world.RemoveComponent(entity, command.component);
+			break;
+		default:
+			break;
+		}
+		++i;
+	}
+
+	for (CommandBuffer* buffer : buffers) {
+		buffer->Clear();
+	}
+}
+
+void RF::CommandBuffer::Clear() {
+	mCommands.clear();
+	mCommandCount = 0;
+	mData.clear();
+	for (SpawnGroup& group : mSpawnGroups) {
+		for (std::vector<std::byte>& column : group.columns) {
+			column.clear();
+		}
+		group.count = 0;
+	}
+	mPlaceholderCount = 0;
+	mSortKey = 0;
+}
+
+uint16_t RF::CommandBuffer::GetSpawnGroup(const ComponentMask& mask) {
+	// Systems usually spawn one kind of entity in a row
+	if (mLastSpawnGroup < mSpawnGroups.size() && mSpawnGroups[mLastSpawnGroup].mask == mask) {
+		return mLastSpawnGroup;
+	}
+
+	for (size_t i = 0; i < mSpawnGroups.size(); ++i) {
+		if (mSpawnGroups[i].mask == mask) {
+			mLastSpawnGroup = static_cast<uint16_t>(i);
+			return mLastSpawnGroup;
+		}
+	}
+
+	SpawnGroup group;
+	group.mask = mask;
+	for (size_t type = 0; type < gMaxComponentTypes; ++type) {
+		if (mask.test(type) && Ecs::GetComponentInfo(static_cast<ComponentTypeId>(type)).size > 0) {
+			group.types.push_back(static_cast<ComponentTypeId>(type));
+		}
+	}
+	group.columns.resize(group.types.size());
+	mSpawnGroups.push_back(std::move(group));
+
+	mLastSpawnGroup = static_cast<uint16_t>(mSpawnGroups.size() - 1);
+	return mLastSpawnGroup;
+}
+
+void RF::CommandBuffer::AppendComponent(SpawnGroup& group, const ComponentTypeId type, const void* component) {
+	const size_t size = Ecs::GetComponentInfo(type).size;
+	if (size == 0) {
+		return;
+	}
+
+	auto it = std::find(group.types.begin(), group.types.end(), type);
+	std::vector<std::byte>& column = group.columns[static_cast<size_t>(it - group.types.begin())];
+	const size_t offset = column.size();
+	column.resize(offset + size);
+	std::memcpy(column.data() + offset, component, size);
+}
+
+RF::Entity RF::CommandBuffer::RecordCreate(const uint16_t spawnGroup) {
+	const Entity placeholder = Ecs::MakeEntity(++mPlaceholderCount, 0);
+	++mCommandCount;
+
+	// Nothing was recorded since the last create of the group, so its rows and placeholders continue the run
+	if (!mCommands.empty()) {
+		Command& last = mCommands.back();
+		if (last.type == CommandType::Create && last.spawnGroup == spawnGroup && last.sortKey == mSortKey) {
+			++last.count;
+			++mSpawnGroups[spawnGroup].count;
+			return placeholder;
+		}
+	}
+
+	mCommands.push_back({
+		.sortKey = mSortKey,
+		.entity = placeholder,
+		.data = mSpawnGroups[spawnGroup].count++,
+		.spawnGroup = spawnGroup,
+		.type = CommandType::Create,
+	});
+	return placeholder;
+}
+
+void RF::CommandBuffer::RecordAdd(const Entity entity, const ComponentTypeId type, const void* component) {
+	const size_t size = Ecs::GetComponentInfo(type).size;
+	const uint32_t offset = static_cast<uint32_t>(mData.size());
+	mData.resize(offset + size);
+	std::memcpy(mData.data() + offset, component, size);
+
+	++mCommandCount;
+	mCommands.push_back({ .sortKey = mSortKey, .entity = entity, .data = offset, .component = type, .type = CommandType::Add });
+}
+
+void RF::CommandBuffer::RecordRemove(const Entity entity, const ComponentTypeId type) {
+	++mCommandCount;
+	mCommands.push_back({ .sortKey = mSortKey, .entity = entity, .component = type, .type = CommandType::Remove });
+}
+
+RF::CommandBufferSet::CommandBufferSet(const JobSystem& jobSystem) {
+	// Thread index 0 is every thread outside the job system, workers are 1..WorkerCount()
+	for (unsigned int i = 0; i <= jobSystem.WorkerCount(); ++i) {
+		mBuffers.push_back(std::make_unique<CommandBuffer>());
+	}
+}
+
+RF::CommandBuffer& RF::CommandBufferSet::Get() {
+	return Get(JobSystem::CurrentThreadIndex());
+}
+
+RF::CommandBuffer& RF::CommandBufferSet::Get(const size_t threadIndex) {
+	assert(threadIndex < mBuffers.size() && "CommandBufferSet was made for a different job system");
+	return *mBuffers[threadIndex];
+}
+
+size_t RF::CommandBufferSet::BufferCount() const {
+	return mBuffers.size();
+}
+
+void RF::CommandBufferSet::Playback(World& world) {
+	std::vector<CommandBuffer*> buffers;
+	for (const std::unique_ptr<CommandBuffer>& buffer : mBuffers) {
+		buffers.push_back(buffer.get());
+	}
+	CommandBuffer::Playback(world, buffers);
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "component.h"
+#include "entity.h"
+
+namespace RF {
+	class JobSystem;
+	class World;
+
+	/// <summary>
+	/// Records structural changes to apply to a World later, at a sync point, so systems iterating chunks in
+	/// parallel can spawn and kill entities. Create returns a placeholder that later commands in the same buffer
+	/// can use, Resolve() turns it into the real entity after playback.
+	/// Consecutive creates of one archetype with the same sort key are recorded as one command, their components
+	/// packed per type. Playback sorts commands by their sort key and creates each run of entities in a batch that
+	/// is filled with one memcpy per component and chunk.
+	/// </summary>
+	class CommandBuffer {
+	public:
+		CommandBuffer() = default;
+		CommandBuffer(const CommandBuffer&) = delete;
+		void operator=(const CommandBuffer&) = delete;
+
+		/// <summary>
+		/// Key for the commands recorded from now on, playback runs commands with lower keys first. Parallel systems
+		/// set it to something deterministic per work item, e.g. the chunk or entity the commands come from.
+		/// </summary>
+		void SetSortKey(const uint64_t sortKey) { mSortKey = sortKey; }
+
+		template <typename... Ts>
+		Entity Create(const Ts&... components) {
+			static_assert(((!Ecs::gIsSparse<Ts>) && ...), "Sparse components can't be spawned with the entity, record an Add");
+			const uint16_t groupIndex = GetSpawnGroup(Ecs::MakeMask<Ts...>());
+			SpawnGroup& group = mSpawnGroups[groupIndex];
+			(AppendComponent(group, Ecs::TypeId<Ts>(), &components), ...);
+			return RecordCreate(groupIndex);
+		}
+
+		void Destroy(const Entity entity);
+
+		template <typename T>
+		void Add(const Entity entity, const T& component = {}) {
+			RecordAdd(entity, Ecs::TypeId<T>(), &component);
+		}
+
+		template <typename T>
+		void Remove(const Entity entity) {
+			RecordRemove(entity, Ecs::TypeId<T>());
+		}
+
+		/// <returns>The entity a placeholder was created as in the last playback, other entities are returned as is.</returns>
+		Entity Resolve(const Entity entity) const;
+		static bool IsPlaceholder(const Entity entity);
+
+		size_t CommandCount() const { return mCommandCount; }
+
+		void Playback(World& world);
+
+		/// <summary>
+		/// Plays back several buffers as one stream, ordered by sort key and then by buffer order.
+		/// </summary>
+		static void Playback(World& world, std::span<CommandBuffer* const> buffers);
+
+		/// <summary>
+		/// Drops recorded commands. Keeps the memory, buffers are meant to be reused every frame.
+		/// </summary>
+		void Clear();
+
+	private:
+		enum class CommandType : uint8_t {
+			Create,
+			Destroy,
+			Add,
+			Remove
+		};
+
+		struct Command {
+			uint64_t sortKey = 0;
+			// The first placeholder for creates
+			Entity entity = Entity::Null;
+			// First row in the spawn group for creates, offset into mData for adds
+			uint32_t data = 0;
+			// Entities a create makes, with consecutive placeholders starting at entity and rows starting at data
+			uint32_t count = 1;
+			uint16_t spawnGroup = 0;
+			ComponentTypeId component = 0;
+			CommandType type = CommandType::Create;
+		};
+
+		// Components of created entities, one packed array per component type
+		struct SpawnGroup {
+			ComponentMask mask = {};
+			std::vector<ComponentTypeId> types = {};
+			std::vector<std::vector<std::byte>> columns = {};
+			uint32_t count = 0;
+		};
+
+		uint16_t GetSpawnGroup(const ComponentMask& mask);
+		void AppendComponent(SpawnGroup& group, const ComponentTypeId type, const void* component);
+		Entity RecordCreate(const uint16_t spawnGroup);
+		void RecordAdd(const Entity entity, const ComponentTypeId type, const void* component);
+		void RecordRemove(const Entity entity, const ComponentTypeId type);
+
+		uint64_t mSortKey = 0;
+		std::vector<Command> mCommands;
+		size_t mCommandCount = 0;
+		std::vector<std::byte> mData;
+		std::vector<SpawnGroup> mSpawnGroups;
+		uint16_t mLastSpawnGroup = 0;
+		uint32_t mPlaceholderCount = 0;
+		std::vector<Entity> mResolved;
+	};
+
+	/// <summary>
+	/// One CommandBuffer per job system thread, so jobs can record without locks.
+	/// </summary>
+	class CommandBufferSet {
+	public:
+		explicit CommandBufferSet(const JobSystem& jobSystem);
+		CommandBufferSet(const CommandBufferSet&) = delete;
+		void operator=(const CommandBufferSet&) = delete;
+
+		/// <returns>The calling thread's buffer. Threads outside the job system share buffer 0, so only the main thread may use it.</returns>
+		CommandBuffer& Get();
+		CommandBuffer& Get(const size_t threadIndex);
+		size_t BufferCount() const;
+
+		/// <summary>
+		/// Plays back and clears every buffer. Commands with equal sort keys run in thread order, which depends on
+		/// scheduling, so parallel systems have to set sort keys for the result to be deterministic.
+		/// </summary>
+		void Playback(World& world);
+
+	private:
+		std::vector<std::unique_ptr<CommandBuffer>> mBuffers;
+	};
+}
@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "component.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace {
+	// Fixed storage so infos can be read without a lock while other threads register new types
+	std::array<RF::ComponentInfo, RF::gMaxComponentTypes> gComponentInfos;
+	std::atomic<size_t> gComponentTypeCount = 0;
+	std::mutex gRegistryMutex;
+}
+
+RF::ComponentTypeId RF::Ecs::RegisterComponentType(const ComponentInfo& info) {
+	std::lock_guard lock(gRegistryMutex);
+
+	const size_t id = gComponentTypeCount.load(std::memory_order_relaxed);
+	assert(id < gMaxComponentTypes && "Too many component types, raise gMaxComponentTypes");
+	// Prefabs and snapshots find types by name, two types with the same unqualified name would get mixed up
+	assert(std::none_of(gComponentInfos.begin(), gComponentInfos.begin() + static_cast<std::ptrdiff_t>(id), [&info](const RF::ComponentInfo& other) { return other.name == info.name; })
+		&& "A component type with the same name is already registered, names have to be unique without namespaces");
+
+	gComponentInfos[id] = info;
+	gComponentTypeCount.store(id + 1, std::memory_order_release);
+	return static_cast<ComponentTypeId>(id);
+}
+
+const RF::ComponentInfo& RF::Ecs::GetComponentInfo(const ComponentTypeId id) {
+	assert(id < gComponentTypeCount.load(std::memory_order_acquire) && "Unknown component type");
+	return gComponentInfos[id];
+}
+
+size_t RF::Ecs::ComponentTypeCount() {
+	return gComponentTypeCount.load(std::memory_order_acquire);
+}
+
+bool RF::Ecs::FindComponentType(std::string_view name, ComponentTypeId& id) {
+	const size_t count = ComponentTypeCount();
+	for (size_t i = 0; i < count; ++i) {
+		if (gComponentInfos[i].name == name) {
+			id = static_cast<ComponentTypeId>(i);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace RF {
+	using ComponentTypeId = uint16_t;
+	constexpr size_t gMaxComponentTypes = 256;
+	using ComponentMask = std::bitset<gMaxComponentTypes>;
+
+	// Where a component type's values live. Archetype components are columns in chunks, adding or removing one moves
+	// the entity to another archetype. Sparse components live in a SparseSet per type and are added and removed in
+	// O(1) without moving the entity, for tags and small components that flip often (status effects).
+	// A component opts in with a static member: static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+	enum class ComponentStorage : uint8_t {
+		Archetype,
+		Sparse
+	};
+
+	struct ComponentInfo {
+		std::string name = "";
+		// 0 for tag components, they have no storage and only show up in the archetype mask
+		uint32_t size = 0;
+		uint32_t alignment = 1;
+		void (*construct)(void* destination) = nullptr;
+		ComponentStorage storage = ComponentStorage::Archetype;
+	};
+
+	namespace Ecs {
+		/// <summary>
+		/// Adds a component type to the global registry. Ids are handed out in registration order, names have to be
+		/// unique since prefabs and snapshots refer to types by name.
+		/// </summary>
+		ComponentTypeId RegisterComponentType(const ComponentInfo& info);
+		const ComponentInfo& GetComponentInfo(const ComponentTypeId id);
+		size_t ComponentTypeCount();
+
+		/// <returns>False if no type with the name has been registered yet.</returns>
+		bool FindComponentType(std::string_view name, ComponentTypeId& id);
+
+		/// <summary>
+		/// Unqualified type name taken from the compiler's function signature, e.g. "Position" for "struct Game::Position".
+		/// </summary>
+		template <typename T>
+		constexpr std::string_view TypeName() {
+#ifdef _MSC_VER
+			std::string_view name = __FUNCSIG__;
+			const size_t begin = name.find("TypeName<") + 9;
+			const size_t end = name.rfind(">(void)");
+#else
+			std::string_view name = __PRETTY_FUNCTION__;
+			const size_t begin = name.find("T = ") + 4;
+			const size_t end = name.find_first_of(";]", begin);
+#endif
+			name = name.substr(begin, end - begin);
+
+			const size_t lastScope = name.rfind("::");
+			if (lastScope != std::string_view::npos) {
+				return name.substr(lastScope + 2);
+			}
+			for (const std::string_view prefix : { std::string_view("struct "), std::string_view("class ") }) {
+				if (name.starts_with(prefix)) {
+					return name.substr(prefix.size());
+				}
+			}
+			return name;
+		}
+
+		template <typename T>
+		constexpr ComponentStorage StorageOf() {
+			if constexpr (requires { T::gStorage; }) {
+				return T::gStorage;
+			}
+			else {
+				return ComponentStorage::Archetype;
+			}
+		}
+
+		template <typename T>
+		constexpr bool gIsSparse = StorageOf<std::remove_const_t<T>>() == ComponentStorage::Sparse;
+
+		/// <summary>
+		/// Id of a component type, registered on first use. Components are plain data, they are moved with memcpy.
+		/// </summary>
+		template <typename T>
+		ComponentTypeId TypeId() {
+			static_assert(std::is_same_v<T, std::remove_cvref_t<T>>, "Component types can't be const or references");
+			static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Components must be plain data");
+			static_assert(std::is_default_constructible_v<T>, "Components must be default constructible");
+
+			static const ComponentTypeId id = RegisterComponentType({
+				.name = std::string(TypeName<T>()),
+				.size = std::is_empty_v<T> ? 0u : static_cast<uint32_t>(sizeof(T)),
+				.alignment = static_cast<uint32_t>(alignof(T)),
+				.construct = [](void* destination) { new (destination) T(); },
+				.storage = StorageOf<T>(),
+			});
+			return id;
+		}
+
+		template <typename... Ts>
+		ComponentMask MakeMask() {
+			ComponentMask mask;
+			(mask.set(TypeId<std::remove_const_t<Ts>>()), ...);
+			return mask;
+		}
+
+		// Only the archetype stored components of Ts, the mask of the archetype entities with Ts live in
+		template <typename... Ts>
+		ComponentMask MakeArchetypeMask() {
+			ComponentMask mask;
+			((gIsSparse<Ts> ? mask : mask.set(TypeId<std::remove_const_t<Ts>>())), ...);
+			return mask;
+		}
+	}
+}
@@ -0,0 +1,259 @@
+#include "stdafx.h"
+#include "ecsProfiler.h"
+#include "systemScheduler.h"
+#include "world.h"
+#include "Engine/Metrics/metrics.h"
+#include "Util/jsonUtil.h"
+
+#include <algorithm>
+#include <cstdio>
+
+RF::EcsProfiler::EcsProfiler(World& world, const SystemScheduler* systems, const size_t topSystemCount)
+	: mWorld(world), mSystems(systems), mTopSystemCount(topSystemCount) {
+	mWorld.SetProfiler(this);
+}
+
+RF::EcsProfiler::~EcsProfiler() {
+	mWorld.SetProfiler(nullptr);
+}
+
+void RF::EcsProfiler::Sample() {
+	++mSampleCount;
+	if (!mSystems) {
+		return;
+	}
+
+	const std::vector<SystemTiming>& timings = mSystems->Timings();
+	if (mSystemTotals.size() < timings.size()) {
+		mSystemTotals.resize(timings.size());
+	}
+	for (size_t i = 0; i < timings.size(); ++i) {
+		mSystemTotals[i].name = timings[i].name;
+		mSystemTotals[i].ms += timings[i].endMs - timings[i].startMs;
+		mSystemTotals[i].entityCount += static_cast<double>(timings[i].entityCount);
+	}
+}
+
+std::vector<RF::ArchetypeOccupancy> RF::EcsProfiler::Archetypes() const {
+	std::vector<ArchetypeOccupancy> archetypes;
+	for (uint32_t i = 0; i < mWorld.ArchetypeCount(); ++i) {
+		const Archetype& archetype = mWorld.GetArchetype(i);
+		size_t rowSize = sizeof(Entity);
+		for (const ComponentTypeId type : archetype.Types()) {
+			rowSize += Ecs::GetComponentInfo(type).size;
+		}
+
+		ArchetypeOccupancy occupancy;
+		occupancy.index = i;
+		occupancy.components = ArchetypeName(i);
+		occupancy.entityCount = archetype.EntityCount();
+		occupancy.chunkCount = archetype.ChunkCount();
+		occupancy.chunkCapacity = archetype.ChunkCapacity();
+		const size_t rowCapacity = occupancy.chunkCount * occupancy.chunkCapacity;
+		occupancy.fillRatio = rowCapacity > 0 ? static_cast<double>(occupancy.entityCount) / static_cast<double>(rowCapacity) : 0.0;
+		occupancy.reservedBytes = occupancy.chunkCount * gChunkSize;
+		occupancy.usedBytes = occupancy.entityCount * rowSize;
+		archetypes.push_back(occupancy);
+	}
+	return archetypes;
+}
+
+std::vector<RF::ComponentOccupancy> RF::EcsProfiler::Components() const {
+	std::vector<ComponentOccupancy> components(Ecs::ComponentTypeCount());
+	for (size_t type = 0; type < components.size(); ++type) {
+		const ComponentInfo& info = Ecs::GetComponentInfo(static_cast<ComponentTypeId>(type));
+		components[type].name = info.name;
+		components[type].isSparse = info.storage == ComponentStorage::Sparse;
+	}
+
+	for (size_t i = 0; i < mWorld.ArchetypeCount(); ++i) {
+		const Archetype& archetype = mWorld.GetArchetype(i);
+		for (const ComponentTypeId type : archetype.Types()) {
+			const size_t size = Ecs::GetComponentInfo(type).size;
+			components[type].entityCount += archetype.EntityCount();
+			components[type].usedBytes += size * archetype.EntityCount();
+			components[type].reservedBytes += size * archetype.ChunkCapacity() * archetype.ChunkCount();
+		}
+	}
+
+	// Sparse sets also count their dense entity array and the pages of slots
+	for (const ComponentTypeId type : mWorld.SparseTypes()) {
+		const SparseSet& set = *mWorld.FindSparseSet(type);
+		components[type].entityCount = set.Count();
+		components[type].usedBytes = set.Count() * (sizeof(Entity) + Ecs::GetComponentInfo(type).size);
+		components[type].reservedBytes = set.ReservedBytes();
+	}
+
+	// Types no entity has are left out
+	std::erase_if(components, [](const ComponentOccupancy& component) { return component.entityCount == 0; });
+	return components;
+}
+
+std::vector<RF::ArchetypeTransitionCount> RF::EcsProfiler::Transitions() const {
+	std::vector<ArchetypeTransitionCount> transitions;
+	transitions.reserve(mTransitions.size());
+	for (const auto& [key, count] : mTransitions) {
+		transitions.push_back({ static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key & 0xFFFFFFFFull), count });
+	}
+
+	std::sort(transitions.begin(), transitions.end(), [](const ArchetypeTransitionCount& lhs, const ArchetypeTransitionCount& rhs) {
+		return lhs.count != rhs.count ? lhs.count > rhs.count : (lhs.from != rhs.from ? lhs.from < rhs.from : lhs.to < rhs.to);
+	});
+	return transitions;
+}
+
+std::vector<RF::SystemSample> RF::EcsProfiler::TopSystemsByTime() const {
+	return TopSystems(false);
+}
+
+std::vector<RF::SystemSample> RF::EcsProfiler::TopSystemsByEntities() const {
+	return TopSystems(true);
+}
+
+nlohmann::json RF::EcsProfiler::BuildReport() const {
+	size_t entityCount = 0;
+	size_t chunkCount = 0;
+	size_t rowCapacity = 0;
+	size_t reservedBytes = 0;
+	size_t usedBytes = 0;
+
+	nlohmann::json archetypes = nlohmann::json::array();
+	for (const ArchetypeOccupancy& archetype : Archetypes()) {
+		entityCount += archetype.entityCount;
+		chunkCount += archetype.chunkCount;
+		rowCapacity += archetype.chunkCount * archetype.chunkCapacity;
+		reservedBytes += archetype.reservedBytes;
+		usedBytes += archetype.usedBytes;
+		archetypes.push_back({
+			{ "index", archetype.index },
+			{ "components", archetype.components },
+			{ "entities", archetype.entityCount },
+			{ "chunks", archetype.chunkCount },
+			{ "chunkCapacity", archetype.chunkCapacity },
+			{ "fillRatio", archetype.fillRatio },
+			{ "reservedBytes", archetype.reservedBytes },
+			{ "usedBytes", archetype.usedBytes },
+		});
+	}
+
+	nlohmann::json components = nlohmann::json::array();
+	for (const ComponentOccupancy& component : Components()) {
+		components.push_back({
+			{ "name", component.name },
+			{ "storage", component.isSparse ? "sparse" : "archetype" },
+			{ "entities", component.entityCount },
+			{ "usedBytes", component.usedBytes },
+			{ "reservedBytes", component.reservedBytes },
+		});
+	}
+
+	nlohmann::json transitions = nlohmann::json::array();
+	for (const ArchetypeTransitionCount& transition : Transitions()) {
+		transitions.push_back({
+			{ "from", ArchetypeName(transition.from) },
+			{ "to", ArchetypeName(transition.to) },
+			{ "count", transition.count },
+			{ "perFrame", mSampleCount > 0 ? static_cast<double>(transition.count) / static_cast<double>(mSampleCount) : 0.0 },
+		});
+	}
+
+	auto systemsJson = [](const std::vector<SystemSample>& systems) {
+		nlohmann::json json = nlohmann::json::array();
+		for (const SystemSample& system : systems) {
+			json.push_back({ { "name", system.name }, { "ms", system.ms }, { "entities", system.entityCount } });
+		}
+		return json;
+	};
+
+	nlohmann::json report;
+	report["totals"] = {
+		{ "entities", entityCount },
+		{ "archetypes", mWorld.ArchetypeCount() },
+		{ "chunks", chunkCount },
+		{ "fillRatio", rowCapacity > 0 ? static_cast<double>(entityCount) / static_cast<double>(rowCapacity) : 0.0 },
+		{ "reservedBytes", reservedBytes },
+		{ "usedBytes", usedBytes },
+		{ "sampledFrames", mSampleCount },
+	};
+	report["archetypes"] = archetypes;
+	report["components"] = components;
+	report["transitions"] = transitions;
+	report["systemsByTime"] = systemsJson(TopSystemsByTime());
+	report["systemsByEntities"] = systemsJson(TopSystemsByEntities());
+	return report;
+}
+
+void RF::EcsProfiler::WriteReport(const std::string& path) const {
+	RF::Json::Serialize(path, BuildReport());
+}
+
+std::wstring RF::EcsProfiler::Summary() const {
+	size_t chunkCount = 0;
+	size_t rowCapacity = 0;
+	size_t reservedBytes = 0;
+	for (size_t i = 0; i < mWorld.ArchetypeCount(); ++i) {
+		const Archetype& archetype = mWorld.GetArchetype(i);
+		chunkCount += archetype.ChunkCount();
+		rowCapacity += archetype.ChunkCount() * archetype.ChunkCapacity();
+		reservedBytes += archetype.ChunkCount() * gChunkSize;
+	}
+
+	char text[256] = {};
+	std::snprintf(text, sizeof(text), "%zu entities, %zu archetypes, %zu chunks %.0f%% full, %.1f MB",
+		mWorld.EntityCount(), mWorld.ArchetypeCount(), chunkCount,
+		rowCapacity > 0 ? 100.0 * static_cast<double>(mWorld.EntityCount()) / static_cast<double>(rowCapacity) : 0.0,
+		static_cast<double>(reservedBytes) / (1024.0 * 1024.0));
+	std::string summary = text;
+
+	const std::vector<SystemSample> systems = TopSystemsByTime();
+	for (size_t i = 0; i < systems.size() && i < 3; ++i) {
+		std::snprintf(text, sizeof(text), "%s %s %.2f ms", i == 0 ? " |" : ",", systems[i].name.c_str(), systems[i].ms);
+		summary += text;
+	}
+	return std::wstring(summary.begin(), summary.end());
+}
+
+void RF::EcsProfiler::RecordMetrics(Metrics& metrics) const {
+	size_t chunkCount = 0;
+	size_t rowCapacity = 0;
+	for (size_t i = 0; i < mWorld.ArchetypeCount(); ++i) {
+		const Archetype& archetype = mWorld.GetArchetype(i);
+		chunkCount += archetype.ChunkCount();
+		rowCapacity += archetype.ChunkCount() * archetype.ChunkCapacity();
+	}
+
+	uint64_t transitionCount = 0;
+	for (const auto& [key, count] : mTransitions) {
+		transitionCount += count;
+	}
+
+	metrics.Record("Ecs/entities", static_cast<double>(mWorld.EntityCount()));
+	metrics.Record("Ecs/archetypes", static_cast<double>(mWorld.ArchetypeCount()));
+	metrics.Record("Ecs/chunks", static_cast<double>(chunkCount));
+	metrics.Record("Ecs/fillRatio", rowCapacity > 0 ? static_cast<double>(mWorld.EntityCount()) / static_cast<double>(rowCapacity) : 0.0);
+	metrics.Record("Ecs/transitions", static_cast<double>(transitionCount));
+}
+
+std::string RF::EcsProfiler::ArchetypeName(const uint32_t index) const {
+	std::string name;
+	for (const ComponentTypeId type : mWorld.GetArchetype(index).Types()) {
+		name += (name.empty() ? "" : "+") + Ecs::GetComponentInfo(type).name;
+	}
+	return name.empty() ? "<empty>" : name;
+}
+
+std::vector<RF::SystemSample> RF::EcsProfiler::TopSystems(const bool byEntities) const {
+	std::vector<SystemSample> systems;
+	const double frames = static_cast<double>(std::max<size_t>(mSampleCount, 1));
+	for (const SystemTotals& totals : mSystemTotals) {
+		systems.push_back({ totals.name, totals.ms / frames, totals.entityCount / frames });
+	}
+
+	auto isMoreExpensive = [byEntities](const SystemSample& lhs, const SystemSample& rhs) {
+		return byEntities ? lhs.entityCount > rhs.entityCount : lhs.ms > rhs.ms;
+	};
+	const size_t count = std::min(systems.size(), mTopSystemCount);
+	std::partial_sort(systems.begin(), systems.begin() + static_cast<std::ptrdiff_t>(count), systems.end(), isMoreExpensive);
+	systems.resize(count);
+	return systems;
+}
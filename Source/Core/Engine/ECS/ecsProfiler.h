@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace RF {
+	class Metrics;
+	class SystemScheduler;
+	class World;
+
+	struct ArchetypeOccupancy {
+		uint32_t index = 0;
+		std::string components = "";
+		size_t entityCount = 0;
+		size_t chunkCount = 0;
+		uint32_t chunkCapacity = 0;
+		// Entities over rows the chunks have room for
+		double fillRatio = 0.0;
+		// Bytes of chunk memory, and the part of it holding entities and components
+		size_t reservedBytes = 0;
+		size_t usedBytes = 0;
+	};
+
+	struct ComponentOccupancy {
+		std::string name = "";
+		bool isSparse = false;
+		size_t entityCount = 0;
+		size_t usedBytes = 0;
+		// For archetype components the column space of every chunk that has the component
+		size_t reservedBytes = 0;
+	};
+
+	struct ArchetypeTransitionCount {
+		uint32_t from = 0;
+		uint32_t to = 0;
+		uint64_t count = 0;
+	};
+
+	struct SystemSample {
+		std::string name = "";
+		// Averages over the frames sampled so far
+		double ms = 0.0;
+		double entityCount = 0.0;
+	};
+
+	/// <summary>
+	/// Memory and occupancy of a World and the cost of its systems: per archetype entity counts, chunk fill and
+	/// bytes, bytes per component, how often entities move between each pair of archetypes, and the most
+	/// expensive systems by time and by entities touched.
+	/// Nothing here runs unless a profiler exists. Creating one hooks it into the world to count archetype moves,
+	/// Sample() once per frame after the systems ran collects their timings, occupancy is only walked when a
+	/// report is built.
+	/// </summary>
+	class EcsProfiler {
+	public:
+		EcsProfiler(World& world, const SystemScheduler* systems = nullptr, const size_t topSystemCount = 5);
+		~EcsProfiler();
+		EcsProfiler(const EcsProfiler&) = delete;
+		void operator=(const EcsProfiler&) = delete;
+
+		/// <summary>
+		/// Called by the world for every entity that changes archetype.
+		/// </summary>
+		void RecordTransition(const uint32_t from, const uint32_t to) { ++mTransitions[(static_cast<uint64_t>(from) << 32) | to]; }
+
+		/// <summary>
+		/// Adds the last frame's system timings and entity counts.
+		/// </summary>
+		void Sample();
+		size_t SampleCount() const { return mSampleCount; }
+
+		std::vector<ArchetypeOccupancy> Archetypes() const;
+		std::vector<ComponentOccupancy> Components() const;
+		// Most frequent first
+		std::vector<ArchetypeTransitionCount> Transitions() const;
+		std::vector<SystemSample> TopSystemsByTime() const;
+		std::vector<SystemSample> TopSystemsByEntities() const;
+
+		nlohmann::json BuildReport() const;
+		void WriteReport(const std::string& path) const;
+
+		/// <summary>
+		/// One line for Window::SetCustomText.
+		/// </summary>
+		std::wstring Summary() const;
+
+		/// <summary>
+		/// Records the totals as "Ecs/..." stats, so they end up in the metrics file.
+		/// </summary>
+		void RecordMetrics(Metrics& metrics) const;
+
+	private:
+		struct SystemTotals {
+			std::string name = "";
+			double ms = 0.0;
+			double entityCount = 0.0;
+		};
+
+		std::string ArchetypeName(const uint32_t index) const;
+		std::vector<SystemSample> TopSystems(const bool byEntities) const;
+
+		World& mWorld;
+		const SystemScheduler* mSystems = nullptr;
+		const size_t mTopSystemCount;
+
+		// Keyed by source archetype in the high and target archetype in the low 32 bits
+		std::unordered_map<uint64_t, uint64_t> mTransitions;
+		// By system index, the scheduler never removes systems
+		std::vector<SystemTotals> mSystemTotals;
+		size_t mSampleCount = 0;
+	};
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+namespace RF {
+	// Index into the world's entity records in the low 32 bits, generation in the high 32 bits.
+	// Generations start at 1 so Entity::Null never refers to a live entity
+	enum class Entity : uint64_t {
+		Null = 0
+	};
+
+	namespace Ecs {
+		constexpr Entity MakeEntity(const uint32_t index, const uint32_t generation) {
+			return static_cast<Entity>((static_cast<uint64_t>(generation) << 32) | index);
+		}
+
+		constexpr uint32_t EntityIndex(const Entity entity) {
+			return static_cast<uint32_t>(static_cast<uint64_t>(entity) & 0xFFFFFFFFull);
+		}
+
+		constexpr uint32_t EntityGeneration(const Entity entity) {
+			return static_cast<uint32_t>(static_cast<uint64_t>(entity) >> 32);
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "prefab.h"
+#include "world.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+	std::array<RF::ComponentJsonReader, RF::gMaxComponentTypes> gJsonReaders = {};
+
+	size_t AlignUp(const size_t value, const size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+void RF::Ecs::SetJsonReader(const ComponentTypeId type, const ComponentJsonReader reader) {
+	gJsonReaders[type] = reader;
+}
+
+RF::ComponentJsonReader RF::Ecs::GetJsonReader(const ComponentTypeId type) {
+	return gJsonReaders[type];
+}
+
+bool RF::Prefab::Compile(World& world, const nlohmann::json& json) {
+	mMask.reset();
+	mTypes.clear();
+	mOffsets.clear();
+	mTemplate.clear();
+	mError.clear();
+
+	auto components = json.find("components");
+	if (components == json.end() || !components->is_object()) {
+		mError = "Prefab has no \"components\" object";
+		return false;
+	}
+
+	for (const auto& [name, value] : components->items()) {
+		ComponentTypeId type = 0;
+		if (!Ecs::FindComponentType(name, type)) {
+			mError = "Unknown component \"" + name + "\"";
+			return false;
+		}
+		if (Ecs::GetComponentInfo(type).storage == ComponentStorage::Sparse) {
+			mError = "Component \"" + name + "\" is sparse, add it after instantiating";
+			return false;
+		}
+		mMask.set(type);
+	}
+
+	// Same order as the archetype's columns, each value aligned like its column
+	mArchetype = world.GetOrCreateArchetype(mMask);
+	size_t size = 0;
+	for (const ComponentTypeId type : world.GetArchetype(mArchetype).Types()) {
+		const ComponentInfo& info = Ecs::GetComponentInfo(type);
+		if (info.size > 0) {
+			size = AlignUp(size, info.alignment);
+			mTypes.push_back(type);
+			mOffsets.push_back(static_cast<uint32_t>(size));
+			size += info.size;
+		}
+	}
+
+	mTemplate.resize(size);
+	for (size_t i = 0; i < mTypes.size(); ++i) {
+		Ecs::GetComponentInfo(mTypes[i]).construct(mTemplate.data() + mOffsets[i]);
+	}
+
+	for (const auto& [name, value] : components->items()) {
+		if (value.is_null() || value.empty()) {
+			continue;
+		}
+
+		ComponentTypeId type = 0;
+		Ecs::FindComponentType(name, type);
+		auto it = std::find(mTypes.begin(), mTypes.end(), type);
+		std::byte* component = it != mTypes.end() ? mTemplate.data() + mOffsets[static_cast<size_t>(it - mTypes.begin())] : nullptr;
+		const ComponentJsonReader reader = Ecs::GetJsonReader(type);
+		if (!component || !reader) {
+			mError = "Component \"" + name + "\" has fields in the prefab but " + (component ? "no JSON reader" : "is a tag");
+			return false;
+		}
+
+		// nlohmann reports type mismatches with exceptions, they end up as a failed compile
+		try {
+			reader(value, component);
+		}
+		catch (const nlohmann::json::exception& exception) {
+			mError = "Component \"" + name + "\": " + exception.what();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const void* RF::Prefab::Get(const ComponentTypeId type) const {
+	auto it = std::find(mTypes.begin(), mTypes.end(), type);
+	return it != mTypes.end() ? mTemplate.data() + mOffsets[static_cast<size_t>(it - mTypes.begin())] : nullptr;
+}
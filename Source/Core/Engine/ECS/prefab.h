@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "component.h"
+
+namespace RF {
+	class World;
+
+	// Reads a component's fields from JSON into storage that already holds a default constructed component
+	using ComponentJsonReader = void (*)(const nlohmann::json& json, void* component);
+
+	// One value per instance for a component of a prefab, replacing the template's value
+	struct ComponentOverride {
+		ComponentTypeId type = 0;
+		const std::byte* data = nullptr;
+	};
+
+	namespace Ecs {
+		/// <summary>
+		/// Makes a component type loadable from prefab JSON. Not thread safe, meant for startup.
+		/// </summary>
+		void SetJsonReader(const ComponentTypeId type, const ComponentJsonReader reader);
+		ComponentJsonReader GetJsonReader(const ComponentTypeId type);
+
+		/// <summary>
+		/// Registers a reader that goes through nlohmann's from_json for T, so fields missing in the JSON keep
+		/// their default values only if from_json skips them (e.g. NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT).
+		/// </summary>
+		template <typename T>
+		void RegisterJsonReader() {
+			SetJsonReader(TypeId<T>(), [](const nlohmann::json& json, void* component) { json.get_to(*static_cast<T*>(component)); });
+		}
+
+		/// <summary>
+		/// Per instance values for InstantiateBatch(), values.size() has to match the number of instances.
+		/// </summary>
+		template <typename T>
+		ComponentOverride Override(std::span<const T> values) {
+			return { TypeId<T>(), reinterpret_cast<const std::byte*>(values.data()) };
+		}
+	}
+
+	/// <summary>
+	/// A template entity compiled from JSON once: the archetype it spawns into and one packed row of component
+	/// values. World::InstantiateBatch() copies the row into chunk space, so spawning doesn't touch JSON,
+	/// look up names or move entities between archetypes.
+	/// The JSON names components by their type name, tags take an empty object:
+	/// { "components": { "Position": { "x": 0, "y": 0 }, "Health": { "value": 50 }, "Enemy": {} } }
+	/// </summary>
+	class Prefab {
+	public:
+		/// <summary>
+		/// Component types have to be registered (used once through Ecs::TypeId) before, and every component with
+		/// fields in the JSON needs a reader. Sparse components can't be part of a prefab.
+		/// </summary>
+		/// <returns>False, with the reason in Error(), for unknown components or components without a reader.</returns>
+		bool Compile(World& world, const nlohmann::json& json);
+
+		uint32_t ArchetypeIndex() const { return mArchetype; }
+		const ComponentMask& Mask() const { return mMask; }
+
+		/// <summary>
+		/// Component types with data, in archetype order, and their packed template values.
+		/// </summary>
+		std::span<const ComponentTypeId> Types() const { return mTypes; }
+		const std::byte* TemplateValue(const size_t typeIndex) const { return mTemplate.data() + mOffsets[typeIndex]; }
+
+		/// <returns>Nullptr if the prefab doesn't have the component or it is a tag.</returns>
+		const void* Get(const ComponentTypeId type) const;
+		template <typename T>
+		const T* Get() const { return static_cast<const T*>(Get(Ecs::TypeId<T>())); }
+
+		const std::string& Error() const { return mError; }
+
+	private:
+		uint32_t mArchetype = 0;
+		ComponentMask mMask;
+		std::vector<ComponentTypeId> mTypes;
+		std::vector<uint32_t> mOffsets;
+		std::vector<std::byte> mTemplate;
+		std::string mError;
+	};
+}
@@ -0,0 +1,461 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "world.h"
+
+namespace RF {
+	// Query terms. Read and Write hand out component spans, With and Without only filter.
+	// Changed and Added require the component and skip chunks where it wasn't written or added since the query's
+	// last iteration, a chunk passes if any of its Changed/Added terms do. Sparse components work with every term
+	// but Changed and Added
+	template <typename T>
+	struct Read {};
+	template <typename T>
+	struct Write {};
+	template <typename T>
+	struct With {};
+	template <typename T>
+	struct Without {};
+	template <typename T>
+	struct Changed {};
+	template <typename T>
+	struct Added {};
+
+	namespace Ecs {
+		enum class TermKind : uint8_t {
+			Read,
+			Write,
+			With,
+			Without,
+			Changed,
+			Added
+		};
+
+		template <typename Term>
+		struct TermTraits;
+
+		template <typename T>
+		struct TermTraits<Read<T>> {
+			using Component = T;
+			using Data = const T;
+			static constexpr TermKind kind = TermKind::Read;
+		};
+
+		template <typename T>
+		struct TermTraits<Write<T>> {
+			using Component = T;
+			using Data = T;
+			static constexpr TermKind kind = TermKind::Write;
+		};
+
+		template <typename T>
+		struct TermTraits<With<T>> {
+			using Component = T;
+			using Data = void;
+			static constexpr TermKind kind = TermKind::With;
+		};
+
+		template <typename T>
+		struct TermTraits<Without<T>> {
+			using Component = T;
+			using Data = void;
+			static constexpr TermKind kind = TermKind::Without;
+		};
+
+		template <typename T>
+		struct TermTraits<Changed<T>> {
+			using Component = T;
+			using Data = void;
+			static constexpr TermKind kind = TermKind::Changed;
+		};
+
+		template <typename T>
+		struct TermTraits<Added<T>> {
+			using Component = T;
+			using Data = void;
+			static constexpr TermKind kind = TermKind::Added;
+		};
+
+		template <typename Term>
+		constexpr bool gIsDataTerm = TermTraits<Term>::kind == TermKind::Read || TermTraits<Term>::kind == TermKind::Write;
+
+		// Tuple of one span per data term, filter terms contribute nothing
+		template <typename Term>
+		using TermSpans = std::conditional_t<gIsDataTerm<Term>, std::tuple<std::span<typename TermTraits<Term>::Data>>, std::tuple<>>;
+
+		template <typename... Terms>
+		ComponentMask MakeTermMask(const TermKind kind) {
+			ComponentMask mask;
+			((TermTraits<Terms>::kind == kind ? mask.set(TypeId<typename TermTraits<Terms>::Component>()) : mask), ...);
+			return mask;
+		}
+
+		template <typename... Terms>
+		ComponentMask MakeSparseTermMask() {
+			ComponentMask mask;
+			((gIsSparse<typename TermTraits<Terms>::Component> ? mask.set(TypeId<typename TermTraits<Terms>::Component>()) : mask), ...);
+			return mask;
+		}
+
+		inline std::vector<ComponentTypeId> MaskTypes(const ComponentMask& mask) {
+			std::vector<ComponentTypeId> types;
+			for (size_t type = 0; type < gMaxComponentTypes && types.size() < mask.count(); ++type) {
+				if (mask.test(type)) {
+					types.push_back(static_cast<ComponentTypeId>(type));
+				}
+			}
+			return types;
+		}
+	}
+
+	/// <summary>
+	/// A cached view over every archetype that matches the terms, e.g. Query&lt;Read&lt;Position&gt;, Write&lt;Velocity&gt;, Without&lt;Dead&gt;&gt;.
+	/// Archetypes are only ever added to a world, so the query remembers how many it has checked and only
+	/// matches the new ones on the next iteration. Iteration hands out one typed span per Read/Write term and chunk.
+	/// Write terms stamp every chunk they hand out as changed, Changed/Added terms compare the chunk's stamps with
+	/// the version of the query's last iteration, so work done per iteration scales with the changed chunks.
+	/// Queries with sparse component terms have no chunk spans, Each() walks the smallest sparse set the query requires
+	/// and looks up the rest of every entity through its archetype row, so its cost follows the flagged entities.
+	/// </summary>
+	template <typename... Terms>
+	class Query {
+	public:
+		static constexpr size_t gDataTermCount = (static_cast<size_t>(Ecs::gIsDataTerm<Terms>) + ... + 0);
+		static constexpr bool gHasSparseTerms = (Ecs::gIsSparse<typename Ecs::TermTraits<Terms>::Component> || ...);
+		using ChunkSpans = decltype(std::tuple_cat(std::declval<Ecs::TermSpans<Terms>>()...));
+
+		static_assert(((!Ecs::gIsSparse<typename Ecs::TermTraits<Terms>::Component> ||
+			(Ecs::TermTraits<Terms>::kind != Ecs::TermKind::Changed && Ecs::TermTraits<Terms>::kind != Ecs::TermKind::Added)) && ...),
+			"Sparse components have no change versions");
+
+		explicit Query(World& world)
+			: mWorld(world)
+			, mRequired((ReadMask() | WriteMask() | Ecs::MakeTermMask<Terms...>(Ecs::TermKind::With)
+				| Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Changed) | Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Added)) & ~Ecs::MakeSparseTermMask<Terms...>())
+			, mExcluded(Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Without) & ~Ecs::MakeSparseTermMask<Terms...>())
+			, mWrittenTypes(Ecs::MaskTypes(WriteMask() & ~Ecs::MakeSparseTermMask<Terms...>()))
+			, mChangedTypes(Ecs::MaskTypes(Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Changed)))
+			, mAddedTypes(Ecs::MaskTypes(Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Added)))
+			, mSparseRequired(Ecs::MaskTypes((ReadMask() | WriteMask() | Ecs::MakeTermMask<Terms...>(Ecs::TermKind::With)) & Ecs::MakeSparseTermMask<Terms...>()))
+			, mSparseExcluded(Ecs::MaskTypes(Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Without) & Ecs::MakeSparseTermMask<Terms...>())) {}
+
+		/// <summary>
+		/// Matches archetypes created since the last call. Iteration calls this, it only needs to be called
+		/// directly before using MatchedArchetypes().
+		/// </summary>
+		void Update() {
+			const size_t archetypeCount = mWorld.ArchetypeCount();
+			for (size_t i = mCheckedArchetypeCount; i < archetypeCount; ++i) {
+				const ComponentMask& mask = mWorld.GetArchetype(i).Mask();
+				const bool isMatch = (mask & mRequired) == mRequired && (mask & mExcluded).none();
+				if (isMatch) {
+					mMatchedArchetypes.push_back(static_cast<uint32_t>(i));
+				}
+				if constexpr (gHasSparseTerms) {
+					mIsMatched.push_back(isMatch);
+				}
+			}
+			mCheckedArchetypeCount = archetypeCount;
+		}
+
+		/// <summary>
+		/// Calls func(std::span&lt;const Entity&gt;, spans...) for every chunk, with the spans in the order of the Read/Write terms.
+		/// </summary>
+		template <typename Func>
+		void ForEachChunk(Func&& func) {
+			static_assert(!gHasSparseTerms, "Sparse components aren't stored in chunks, use Each");
+			BeginIteration();
+			for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+				Archetype& archetype = mWorld.GetArchetype(archetypeIndex);
+				for (size_t i = 0; i < archetype.ChunkCount(); ++i) {
+					VisitChunk(archetype, i, func);
+				}
+			}
+			EndIteration();
+		}
+
+		/// <summary>
+		/// Calls func like ForEachChunk() for the chunks [begin, end) of the matched archetypes, counted in match order.
+		/// Doesn't match new archetypes, so several threads can iterate disjoint ranges between BeginIteration() and
+		/// EndIteration(). Chunks filtered out by Changed/Added terms still count towards the range.
+		/// </summary>
+		template <typename Func>
+		void ForEachChunkInRange(const size_t begin, const size_t end, Func&& func) const {
+			static_assert(!gHasSparseTerms, "Sparse components aren't stored in chunks, use Each");
+			assert(mIterationVersion > 0 && "ForEachChunkInRange has to run between BeginIteration and EndIteration");
+			size_t first = 0;
+			for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+				Archetype& archetype = mWorld.GetArchetype(archetypeIndex);
+				const size_t chunkCount = archetype.ChunkCount();
+				if (first + chunkCount > begin) {
+					const size_t rangeBegin = begin > first ? begin - first : 0;
+					const size_t rangeEnd = end - first < chunkCount ? end - first : chunkCount;
+					for (size_t i = rangeBegin; i < rangeEnd; ++i) {
+						VisitChunk(archetype, i, func);
+					}
+				}
+
+				first += chunkCount;
+				if (first >= end) {
+					return;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Calls func(data&amp;...) for every entity, one reference per Read/Write term.
+		/// </summary>
+		template <typename Func>
+		void Each(Func&& func) {
+			if constexpr (gHasSparseTerms) {
+				BeginIteration();
+				// Filters and stamps are per chunk, consecutive entities are often in the same one
+				Archetype* archetype = nullptr;
+				uint32_t chunkIndex = 0;
+				bool isChunkPassing = false;
+				ForEachSparseMatch([this, &func, &archetype, &chunkIndex, &isChunkPassing](const Entity entity, const World::Location& location) {
+					Archetype* entityArchetype = &mWorld.GetArchetype(location.archetype);
+					if (entityArchetype != archetype || location.chunk != chunkIndex) {
+						archetype = entityArchetype;
+						chunkIndex = location.chunk;
+						isChunkPassing = PassesChangeFilters(*archetype, chunkIndex);
+						for (const ComponentTypeId type : mWrittenTypes) {
+							if (isChunkPassing) {
+								archetype->MarkChanged(chunkIndex, type, mIterationVersion);
+							}
+						}
+					}
+
+					if (isChunkPassing) {
+						const Chunk& chunk = archetype->GetChunk(chunkIndex);
+						std::apply([&func](auto*... values) { func(*values...); }, std::tuple_cat(GetTermPointers<Terms>(*archetype, chunk, location.row, entity)...));
+					}
+				});
+				EndIteration();
+			}
+			else {
+				ForEachChunk([&func](std::span<const Entity> entities, auto... spans) {
+					for (size_t i = 0; i < entities.size(); ++i) {
+						func(spans[i]...);
+					}
+				});
+			}
+		}
+
+		/// <summary>
+		/// Matches new archetypes and starts an iteration: writes are stamped with a fresh version and change filters
+		/// pass chunks stamped after the previous iteration. ForEachChunk() and Each() call this themselves.
+		/// </summary>
+		void BeginIteration() {
+			Update();
+			mIterationSince = mLastIterationVersion;
+			mIterationVersion = mWorld.AdvanceChangeVersion();
+		}
+
+		/// <summary>
+		/// Ends the iteration. The next one only sees changes made from now on, this iteration's own writes don't
+		/// count, so a system that filters on a component it writes doesn't wake itself up.
+		/// </summary>
+		void EndIteration() {
+			mLastIterationVersion = mIterationVersion;
+			mWorld.AdvanceChangeVersion();
+		}
+
+		/// <returns>True if the chunk passes the Changed/Added terms of the current iteration.</returns>
+		bool PassesChangeFilters(const Archetype& archetype, const size_t chunkIndex) const {
+			if (mChangedTypes.empty() && mAddedTypes.empty()) {
+				return true;
+			}
+
+			for (const ComponentTypeId type : mChangedTypes) {
+				if (archetype.ChangedVersion(chunkIndex, type) > mIterationSince) {
+					return true;
+				}
+			}
+			for (const ComponentTypeId type : mAddedTypes) {
+				if (archetype.AddedVersion(chunkIndex, type) > mIterationSince) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/// <returns>The typed spans of one chunk of a matched archetype.</returns>
+		static ChunkSpans GetSpans(const Archetype& archetype, const Chunk& chunk) {
+			return std::tuple_cat(GetTermSpans<Terms>(archetype, chunk)...);
+		}
+
+		size_t ChunkCount() {
+			static_assert(!gHasSparseTerms, "Sparse components aren't stored in chunks");
+			Update();
+			size_t count = 0;
+			for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+				count += mWorld.GetArchetype(archetypeIndex).ChunkCount();
+			}
+			return count;
+		}
+
+		size_t EntityCount() {
+			Update();
+			size_t count = 0;
+			if constexpr (gHasSparseTerms) {
+				ForEachSparseMatch([&count](const Entity, const World::Location&) { ++count; });
+			}
+			else {
+				for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+					count += mWorld.GetArchetype(archetypeIndex).EntityCount();
+				}
+			}
+			return count;
+		}
+
+		std::span<const uint32_t> MatchedArchetypes() const { return mMatchedArchetypes; }
+		World& GetWorld() const { return mWorld; }
+
+		static ComponentMask ReadMask() { return Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Read); }
+		static ComponentMask WriteMask() { return Ecs::MakeTermMask<Terms...>(Ecs::TermKind::Write); }
+
+	private:
+		// A sparse set drives iteration while it has fewer than 1 / ratio of the matched archetypes' entities. Going
+		// through the set costs a cache miss or two per entity, walking the chunks a few ns per row
+		static constexpr size_t gSparseDriveRatio = 8;
+
+		template <typename Func>
+		void VisitChunk(Archetype& archetype, const size_t chunkIndex, Func& func) const {
+			if (!PassesChangeFilters(archetype, chunkIndex)) {
+				return;
+			}
+
+			for (const ComponentTypeId type : mWrittenTypes) {
+				archetype.MarkChanged(chunkIndex, type, mIterationVersion);
+			}
+
+			const Chunk& chunk = archetype.GetChunk(chunkIndex);
+			std::apply(func, std::tuple_cat(std::make_tuple(std::span<const Entity>(archetype.Entities(chunk), chunk.count)), GetSpans(archetype, chunk)));
+		}
+
+		// Calls func(entity, location) for every entity of a matched archetype that passes the sparse terms.
+		// Walks the smallest required set when it is small compared to the matched archetypes, its order is random
+		// in memory. Otherwise walks the chunks in order and checks the sets per row.
+		template <typename Func>
+		void ForEachSparseMatch(Func&& func) const {
+			std::array<const SparseSet*, sizeof...(Terms)> required = {};
+			std::array<const SparseSet*, sizeof...(Terms)> excluded = {};
+			size_t requiredCount = 0;
+			size_t excludedCount = 0;
+			const SparseSet* driver = nullptr;
+			for (const ComponentTypeId type : mSparseRequired) {
+				const SparseSet* set = mWorld.FindSparseSet(type);
+				if (!set) {
+					return;
+				}
+				required[requiredCount++] = set;
+				if (!driver || set->Count() < driver->Count()) {
+					driver = set;
+				}
+			}
+			for (const ComponentTypeId type : mSparseExcluded) {
+				const SparseSet* set = mWorld.FindSparseSet(type);
+				if (set) {
+					excluded[excludedCount++] = set;
+				}
+			}
+
+			// Entities found through the world are alive, so the sets only need to be checked by index
+			auto passesSparseTerms = [&](const uint32_t index) {
+				for (size_t i = 0; i < requiredCount; ++i) {
+					if (!required[i]->ContainsIndex(index)) {
+						return false;
+					}
+				}
+				for (size_t i = 0; i < excludedCount; ++i) {
+					if (excluded[i]->ContainsIndex(index)) {
+						return false;
+					}
+				}
+				return true;
+			};
+
+			size_t matchedCount = 0;
+			for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+				matchedCount += mWorld.GetArchetype(archetypeIndex).EntityCount();
+			}
+
+			if (driver && driver->Count() * gSparseDriveRatio < matchedCount) {
+				World::Location location;
+				for (const Entity entity : driver->Entities()) {
+					if (mWorld.GetLocation(entity, location) && mIsMatched[location.archetype] && passesSparseTerms(Ecs::EntityIndex(entity))) {
+						func(entity, location);
+					}
+				}
+				return;
+			}
+
+			for (const uint32_t archetypeIndex : mMatchedArchetypes) {
+				const Archetype& archetype = mWorld.GetArchetype(archetypeIndex);
+				for (uint32_t chunkIndex = 0; chunkIndex < archetype.ChunkCount(); ++chunkIndex) {
+					const Chunk& chunk = archetype.GetChunk(chunkIndex);
+					const Entity* entities = archetype.Entities(chunk);
+					for (uint32_t row = 0; row < chunk.count; ++row) {
+						if (passesSparseTerms(Ecs::EntityIndex(entities[row]))) {
+							func(entities[row], World::Location{ archetypeIndex, chunkIndex, row });
+						}
+					}
+				}
+			}
+		}
+
+		template <typename Term>
+		auto GetTermPointers(const Archetype& archetype, const Chunk& chunk, const uint32_t row, const Entity entity) const {
+			if constexpr (Ecs::gIsDataTerm<Term>) {
+				using Data = typename Ecs::TermTraits<Term>::Data;
+				static_assert(!std::is_empty_v<Data>, "Tags have no data, use With or Without");
+				if constexpr (Ecs::gIsSparse<Data>) {
+					return std::make_tuple(static_cast<Data*>(mWorld.GetSparseSet(Ecs::TypeId<std::remove_const_t<Data>>()).Get(entity)));
+				}
+				else {
+					return std::make_tuple(archetype.Column<Data>(chunk) + row);
+				}
+			}
+			else {
+				return std::tuple<>();
+			}
+		}
+
+		template <typename Term>
+		static Ecs::TermSpans<Term> GetTermSpans(const Archetype& archetype, const Chunk& chunk) {
+			if constexpr (Ecs::gIsDataTerm<Term>) {
+				using Data = typename Ecs::TermTraits<Term>::Data;
+				static_assert(!std::is_empty_v<Data>, "Tags have no data, use With or Without");
+				return std::make_tuple(std::span<Data>(archetype.Column<Data>(chunk), chunk.count));
+			}
+			else {
+				return {};
+			}
+		}
+
+		World& mWorld;
+		const ComponentMask mRequired;
+		const ComponentMask mExcluded;
+		const std::vector<ComponentTypeId> mWrittenTypes;
+		const std::vector<ComponentTypeId> mChangedTypes;
+		const std::vector<ComponentTypeId> mAddedTypes;
+		const std::vector<ComponentTypeId> mSparseRequired;
+		const std::vector<ComponentTypeId> mSparseExcluded;
+		std::vector<uint32_t> mMatchedArchetypes;
+		// Per archetype of the world, whether it matches, for queries that find entities through sparse sets
+		std::vector<bool> mIsMatched;
+		size_t mCheckedArchetypeCount = 0;
+
+		// 0 so a query that never ran sees everything as changed and added
+		uint64_t mLastIterationVersion = 0;
+		uint64_t mIterationSince = 0;
+		uint64_t mIterationVersion = 0;
+	};
+}
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "sparseSet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+RF::SparseSet::SparseSet(const ComponentTypeId type) : mType(type) {
+	const ComponentInfo& info = Ecs::GetComponentInfo(type);
+	assert(info.alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ && "Sparse component alignment is larger than the heap alignment");
+	mComponentSize = info.size;
+}
+
+void* RF::SparseSet::Insert(const Entity entity) {
+	uint32_t& slot = SlotOf(Ecs::EntityIndex(entity));
+	if (slot != gNoSlot && mEntities[slot] == entity) {
+		return Get(entity);
+	}
+
+	// A dead generation of the same index takes over its slot, otherwise a slot is appended
+	if (slot != gNoSlot) {
+		mEntities[slot] = entity;
+	}
+	else {
+		slot = static_cast<uint32_t>(mEntities.size());
+		mEntities.push_back(entity);
+		mValues.resize(mValues.size() + mComponentSize);
+	}
+	if (mComponentSize == 0) {
+		return nullptr;
+	}
+
+	std::byte* value = mValues.data() + static_cast<size_t>(mComponentSize) * slot;
+	Ecs::GetComponentInfo(mType).construct(value);
+	return value;
+}
+
+bool RF::SparseSet::Remove(const Entity entity) {
+	const uint32_t slot = Find(entity);
+	if (slot == gNoSlot) {
+		return false;
+	}
+
+	const uint32_t last = static_cast<uint32_t>(mEntities.size() - 1);
+	if (slot != last) {
+		const Entity moved = mEntities[last];
+		mEntities[slot] = moved;
+		SlotOf(Ecs::EntityIndex(moved)) = slot;
+		if (mComponentSize > 0) {
+			std::memcpy(mValues.data() + static_cast<size_t>(mComponentSize) * slot, mValues.data() + static_cast<size_t>(mComponentSize) * last, mComponentSize);
+		}
+	}
+
+	SlotOf(Ecs::EntityIndex(entity)) = gNoSlot;
+	mEntities.pop_back();
+	mValues.resize(mValues.size() - mComponentSize);
+	return true;
+}
+
+void RF::SparseSet::Clear() {
+	// Pages stay, the same indices are likely to be flagged again
+	for (const Entity entity : mEntities) {
+		SlotOf(Ecs::EntityIndex(entity)) = gNoSlot;
+	}
+	mEntities.clear();
+	mValues.clear();
+}
+
+size_t RF::SparseSet::PageCount() const {
+	return static_cast<size_t>(std::count_if(mPages.begin(), mPages.end(), [](const std::unique_ptr<uint32_t[]>& page) { return page != nullptr; }));
+}
+
+size_t RF::SparseSet::ReservedBytes() const {
+	return PageCount() * gPageSize * sizeof(uint32_t) + mEntities.capacity() * sizeof(Entity) + mValues.capacity();
+}
+
+uint32_t& RF::SparseSet::SlotOf(const uint32_t index) {
+	const size_t page = index >> gPageShift;
+	if (page >= mPages.size()) {
+		mPages.resize(page + 1);
+	}
+	if (!mPages[page]) {
+		mPages[page] = std::make_unique<uint32_t[]>(gPageSize);
+		std::fill_n(mPages[page].get(), gPageSize, gNoSlot);
+	}
+	return mPages[page][index & (gPageSize - 1)];
+}
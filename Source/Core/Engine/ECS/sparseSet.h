@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "component.h"
+#include "entity.h"
+
+namespace RF {
+	/// <summary>
+	/// Storage for one sparse component type: a paged sparse array from entity index to a slot in dense arrays of
+	/// entities and values. Insert and Remove are O(1) and don't touch other components, removing swaps the last
+	/// slot into the hole. Pages are allocated when an index in them is first used, so a few flagged entities with
+	/// high indices don't cost a table as large as the world.
+	/// </summary>
+	class SparseSet {
+	public:
+		explicit SparseSet(const ComponentTypeId type);
+		SparseSet(const SparseSet&) = delete;
+		void operator=(const SparseSet&) = delete;
+
+		bool Contains(const Entity entity) const { return Find(entity) != gNoSlot; }
+
+		/// <summary>
+		/// Contains() without the generation check, only valid for live entities since the world drops dead ones.
+		/// </summary>
+		bool ContainsIndex(const uint32_t index) const {
+			const size_t page = index >> gPageShift;
+			return page < mPages.size() && mPages[page] && mPages[page][index & (gPageSize - 1)] != gNoSlot;
+		}
+
+		/// <summary>
+		/// Adds the entity with a default constructed value, or keeps the value it already has.
+		/// </summary>
+		/// <returns>The value's storage, nullptr for tags.</returns>
+		void* Insert(const Entity entity);
+
+		/// <returns>False if the entity wasn't in the set.</returns>
+		bool Remove(const Entity entity);
+
+		/// <returns>Nullptr if the entity isn't in the set or the component is a tag.</returns>
+		void* Get(const Entity entity) {
+			const uint32_t slot = Find(entity);
+			return slot != gNoSlot && mComponentSize > 0 ? mValues.data() + static_cast<size_t>(mComponentSize) * slot : nullptr;
+		}
+
+		void Clear();
+
+		ComponentTypeId Type() const { return mType; }
+		size_t Count() const { return mEntities.size(); }
+		std::span<const Entity> Entities() const { return mEntities; }
+
+		// Values in the order of Entities(), empty for tags
+		std::byte* Values() { return mValues.data(); }
+		const std::byte* Values() const { return mValues.data(); }
+
+		size_t PageCount() const;
+		// Allocated pages plus the capacity of the dense arrays
+		size_t ReservedBytes() const;
+
+	private:
+		static constexpr uint32_t gNoSlot = UINT32_MAX;
+		static constexpr size_t gPageShift = 10;
+		static constexpr size_t gPageSize = size_t{ 1 } << gPageShift;
+
+		uint32_t Find(const Entity entity) const {
+			const uint32_t index = Ecs::EntityIndex(entity);
+			const size_t page = index >> gPageShift;
+			if (page >= mPages.size() || !mPages[page]) {
+				return gNoSlot;
+			}
+
+			// The dense entity carries the generation, a stale handle to a recycled index doesn't match
+			const uint32_t slot = mPages[page][index & (gPageSize - 1)];
+			return slot != gNoSlot && mEntities[slot] == entity ? slot : gNoSlot;
+		}
+
+		uint32_t& SlotOf(const uint32_t index);
+
+		ComponentTypeId mType = 0;
+		uint32_t mComponentSize = 0;
+		std::vector<std::unique_ptr<uint32_t[]>> mPages;
+		std::vector<Entity> mEntities;
+		std::vector<std::byte> mValues;
+	};
+}
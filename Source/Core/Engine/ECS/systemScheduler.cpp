@@ -0,0 +1,253 @@
+#include "stdafx.h"
+#include "systemScheduler.h"
+#include "Engine/Metrics/metrics.h"
+#include "Engine/frameData.h"
+#include "Util/jsonUtil.h"
+#include "Util/scheduleTiming.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+	bool Conflicts(const RF::SystemDesc& lhs, const RF::SystemDesc& rhs) {
+		return lhs.exclusive || rhs.exclusive
+			|| (lhs.writes & (rhs.reads | rhs.writes)).any()
+			|| (rhs.writes & lhs.reads).any();
+	}
+}
+
+RF::SystemScheduler::SystemScheduler(World& world, JobSystem& jobSystem, Metrics* metrics)
+	: mWorld(world), mJobSystem(jobSystem), mMetrics(metrics) {}
+
+void RF::SystemScheduler::Add(const SystemDesc& desc) {
+	assert(desc.run && "SystemScheduler::Add received a system without a run function");
+	mDescs.push_back(desc);
+	mIsBuilt = false;
+}
+
+bool RF::SystemScheduler::Build() {
+	const size_t count = mDescs.size();
+	std::unordered_map<std::string, size_t> indices;
+	for (size_t i = 0; i < count; ++i) {
+		indices[mDescs[i].name] = i;
+	}
+
+	// Explicit constraints first, as "must run before" edges
+	std::vector<std::vector<size_t>> explicitDependencies(count);
+	std::vector<std::vector<size_t>> explicitDependents(count);
+	for (size_t i = 0; i < count; ++i) {
+		for (const std::string& name : mDescs[i].after) {
+			auto it = indices.find(name);
+			if (it == indices.end()) {
+				assert(false && "SystemScheduler received an ordering constraint on an unknown system");
+				return false;
+			}
+			explicitDependencies[i].push_back(it->second);
+			explicitDependents[it->second].push_back(i);
+		}
+		for (const std::string& name : mDescs[i].before) {
+			auto it = indices.find(name);
+			if (it == indices.end()) {
+				assert(false && "SystemScheduler received an ordering constraint on an unknown system");
+				return false;
+			}
+			explicitDependencies[it->second].push_back(i);
+			explicitDependents[i].push_back(it->second);
+		}
+	}
+
+	// Registration order, with systems pulled forward just far enough to satisfy the constraints.
+	// Conflicting systems are ordered by it, so every edge points forward and the graph can't get a cycle
+	enum class VisitState : uint8_t { New, Visiting, Done };
+	std::vector<VisitState> states(count, VisitState::New);
+	std::vector<size_t> order;
+	order.reserve(count);
+	std::function<bool(size_t)> visit = [&](const size_t index) {
+		if (states[index] == VisitState::Done) {
+			return true;
+		}
+		if (states[index] == VisitState::Visiting) {
+			return false;
+		}
+
+		states[index] = VisitState::Visiting;
+		for (const size_t dependency : explicitDependencies[index]) {
+			if (!visit(dependency)) {
+				return false;
+			}
+		}
+		states[index] = VisitState::Done;
+		order.push_back(index);
+		return true;
+	};
+
+	for (size_t i = 0; i < count; ++i) {
+		if (!visit(i)) {
+			assert(false && "SystemScheduler found a cycle in the ordering constraints");
+			return false;
+		}
+	}
+
+	mDependencies.assign(count, {});
+	mDependents.assign(count, {});
+	for (size_t first = 0; first < count; ++first) {
+		for (size_t second = first + 1; second < count; ++second) {
+			const size_t from = order[first];
+			const size_t to = order[second];
+			const bool isExplicit = std::find(explicitDependents[from].begin(), explicitDependents[from].end(), to) != explicitDependents[from].end();
+			if (isExplicit || Conflicts(mDescs[from], mDescs[to])) {
+				mDependencies[to].push_back(from);
+				mDependents[from].push_back(to);
+			}
+		}
+	}
+
+	mPendingDependencies = std::make_unique<std::atomic<int>[]>(count);
+	mIsBuilt = true;
+	return true;
+}
+
+void RF::SystemScheduler::Run(const FrameData& frameData) {
+	if (!mIsBuilt && !Build()) {
+		return;
+	}
+
+	const size_t count = mDescs.size();
+	mTimings.assign(count, {});
+	for (size_t i = 0; i < count; ++i) {
+		mTimings[i].name = mDescs[i].name;
+		mPendingDependencies[i].store(static_cast<int>(mDependencies[i].size()), std::memory_order_relaxed);
+	}
+
+	mFrameStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		if (mDependencies[i].empty()) {
+			Schedule(i, frameData);
+		}
+	}
+	mJobSystem.Wait(mCounter);
+	mFrameMs = ScheduleTiming::ElapsedMs(mFrameStart);
+
+	mCriticalPath = ScheduleTiming::MarkCriticalPath(mTimings, mDependencies);
+
+	if (mMetrics) {
+		double criticalPathMs = 0.0;
+		for (const SystemTiming& timing : mTimings) {
+			mMetrics->Record("Systems/" + timing.name, timing.endMs - timing.startMs);
+			if (timing.onCriticalPath) {
+				criticalPathMs += timing.endMs - timing.startMs;
+			}
+		}
+		mMetrics->Record("Systems/frameMs", mFrameMs);
+		mMetrics->Record("Systems/criticalPathMs", criticalPathMs);
+	}
+}
+
+const std::vector<RF::SystemTiming>& RF::SystemScheduler::Timings() const {
+	return mTimings;
+}
+
+std::vector<std::string> RF::SystemScheduler::CriticalPath() const {
+	std::vector<std::string> names;
+	names.reserve(mCriticalPath.size());
+	for (const size_t index : mCriticalPath) {
+		names.push_back(mDescs[index].name);
+	}
+
+	return names;
+}
+
+std::vector<std::string> RF::SystemScheduler::Dependencies(const std::string& name) const {
+	std::vector<std::string> names;
+	for (size_t i = 0; i < mDescs.size() && i < mDependencies.size(); ++i) {
+		if (mDescs[i].name != name) {
+			continue;
+		}
+
+		for (const size_t dependency : mDependencies[i]) {
+			names.push_back(mDescs[dependency].name);
+		}
+	}
+
+	return names;
+}
+
+nlohmann::json RF::SystemScheduler::BuildTrace() const {
+	nlohmann::json events = nlohmann::json::array();
+	double criticalPathMs = 0.0;
+
+	std::vector<unsigned int> threads;
+	for (size_t i = 0; i < mTimings.size(); ++i) {
+		const SystemTiming& timing = mTimings[i];
+		if (timing.onCriticalPath) {
+			criticalPathMs += timing.endMs - timing.startMs;
+		}
+		if (std::find(threads.begin(), threads.end(), timing.threadIndex) == threads.end()) {
+			threads.push_back(timing.threadIndex);
+		}
+
+		std::vector<std::string> dependencies;
+		for (const size_t dependency : mDependencies[i]) {
+			dependencies.push_back(mDescs[dependency].name);
+		}
+
+		nlohmann::json event = {
+			{ "name", timing.name },
+			{ "cat", "system" },
+			{ "ph", "X" },
+			{ "ts", timing.startMs * 1000.0 },
+			{ "dur", (timing.endMs - timing.startMs) * 1000.0 },
+			{ "pid", 0 },
+			{ "tid", timing.threadIndex },
+			{ "args", { { "dependencies", dependencies }, { "onCriticalPath", timing.onCriticalPath }, { "entities", timing.entityCount } } },
+		};
+		if (timing.onCriticalPath) {
+			event["cname"] = "terrible";
+		}
+		events.push_back(event);
+	}
+
+	for (const unsigned int thread : threads) {
+		events.push_back({
+			{ "name", "thread_name" },
+			{ "ph", "M" },
+			{ "pid", 0 },
+			{ "tid", thread },
+			{ "args", { { "name", thread == 0 ? std::string("Main") : "Worker " + std::to_string(thread) } } },
+		});
+	}
+
+	nlohmann::json trace;
+	trace["traceEvents"] = events;
+	trace["displayTimeUnit"] = "ms";
+	trace["otherData"] = {
+		{ "frameMs", mFrameMs },
+		{ "criticalPathMs", criticalPathMs },
+		{ "criticalPath", CriticalPath() },
+		{ "workerCount", mJobSystem.WorkerCount() },
+	};
+	return trace;
+}
+
+void RF::SystemScheduler::WriteTrace(const std::string& path) const {
+	RF::Json::Serialize(path, BuildTrace());
+}
+
+void RF::SystemScheduler::Schedule(const size_t index, const FrameData& frameData) {
+	mJobSystem.Run([this, index, &frameData]() { RunSystem(index, frameData); }, &mCounter);
+}
+
+void RF::SystemScheduler::RunSystem(const size_t index, const FrameData& frameData) {
+	SystemTiming& timing = mTimings[index];
+	timing.threadIndex = RF::JobSystem::CurrentThreadIndex();
+	timing.startMs = ScheduleTiming::ElapsedMs(mFrameStart);
+	mDescs[index].run(frameData);
+	timing.endMs = ScheduleTiming::ElapsedMs(mFrameStart);
+
+	// Dependents are counted on the frame's counter before this job's own decrement, so Run() can't return early
+	for (const size_t dependent : mDependents[index]) {
+		if (mPendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			Schedule(dependent, frameData);
+		}
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "component.h"
+#include "query.h"
+#include "Engine/Jobs/jobSystem.h"
+
+namespace RF {
+	struct FrameData;
+	class Metrics;
+
+	struct SystemDesc {
+		std::string name = "";
+		ComponentMask reads = {};
+		ComponentMask writes = {};
+		// Explicit ordering on top of what the component access implies
+		std::vector<std::string> after = {};
+		std::vector<std::string> before = {};
+		// Runs with no other system at the same time, e.g. for structural changes to the world
+		bool exclusive = false;
+		std::function<void(const FrameData& frameData)> run = nullptr;
+	};
+
+	struct SystemTiming {
+		std::string name = "";
+		double startMs = 0.0;
+		double endMs = 0.0;
+		unsigned int threadIndex = 0;
+		bool onCriticalPath = false;
+		// Entities a chunk system was handed while an EcsProfiler is attached, 0 otherwise and for other systems
+		size_t entityCount = 0;
+	};
+
+	/// <summary>
+	/// Runs ECS systems in parallel on the job system. Two systems conflict if one writes a component the other
+	/// reads or writes, conflicting systems run in registration order unless before/after says otherwise.
+	/// Everything else runs at the same time, and chunk systems split their query into chunk range jobs.
+	/// </summary>
+	class SystemScheduler {
+	public:
+		SystemScheduler(World& world, JobSystem& jobSystem, Metrics* metrics = nullptr);
+		SystemScheduler(const SystemScheduler&) = delete;
+		void operator=(const SystemScheduler&) = delete;
+
+		void Add(const SystemDesc& desc);
+
+		/// <summary>
+		/// Adds a system that runs func(frameData, entities, spans...) for every chunk of Query&lt;Terms...&gt;.
+		/// Reads and writes are taken from the terms, chunks are handed out to jobs chunksPerJob at a time.
+		/// </summary>
+		template <typename... Terms, typename Func>
+		void AddChunkSystem(SystemDesc desc, Func func, const size_t chunksPerJob = 8) {
+			using SystemQuery = Query<Terms...>;
+			desc.reads |= SystemQuery::ReadMask();
+			desc.writes |= SystemQuery::WriteMask();
+
+			std::shared_ptr<SystemQuery> query = std::make_shared<SystemQuery>(mWorld);
+			const size_t index = mDescs.size();
+			desc.run = [this, index, query, func, chunksPerJob](const FrameData& frameData) {
+				query->BeginIteration();
+				// Entity counts are only for the profiler, so nothing is counted without one
+				if (!mWorld.IsProfiled()) {
+					mJobSystem.ParallelFor(query->ChunkCount(), chunksPerJob, [&query, &func, &frameData](const size_t begin, const size_t end) {
+						query->ForEachChunkInRange(begin, end, [&func, &frameData](const std::span<const Entity> entities, auto... spans) {
+							func(frameData, entities, spans...);
+						});
+					});
+					query->EndIteration();
+					mTimings[index].entityCount = 0;
+					return;
+				}
+
+				std::atomic<size_t> entityCount = 0;
+				mJobSystem.ParallelFor(query->ChunkCount(), chunksPerJob, [&query, &func, &frameData, &entityCount](const size_t begin, const size_t end) {
+					size_t jobEntityCount = 0;
+					query->ForEachChunkInRange(begin, end, [&func, &frameData, &jobEntityCount](const std::span<const Entity> entities, auto... spans) {
+						jobEntityCount += entities.size();
+						func(frameData, entities, spans...);
+					});
+					entityCount.fetch_add(jobEntityCount, std::memory_order_relaxed);
+				});
+				query->EndIteration();
+				mTimings[index].entityCount = entityCount.load(std::memory_order_relaxed);
+			};
+			Add(desc);
+		}
+
+		/// <summary>
+		/// Builds the dependency graph. Run() calls it when systems were added since the last build.
+		/// </summary>
+		/// <returns>False if an ordering constraint names an unknown system or the constraints form a cycle.</returns>
+		bool Build();
+
+		/// <summary>
+		/// Runs every system once and blocks until all are done, the calling thread helps with jobs.
+		/// </summary>
+		void Run(const FrameData& frameData);
+
+		const std::vector<SystemTiming>& Timings() const;
+
+		/// <summary>
+		/// Systems that decided the frame's system time, first to last.
+		/// </summary>
+		std::vector<std::string> CriticalPath() const;
+
+		/// <returns>Names of the systems a system waits for.</returns>
+		std::vector<std::string> Dependencies(const std::string& name) const;
+
+		/// <summary>
+		/// The last frame's schedule in the Chrome trace event format, one row per thread. Open it in
+		/// chrome://tracing or ui.perfetto.dev, critical path systems are drawn red and list their dependencies.
+		/// </summary>
+		nlohmann::json BuildTrace() const;
+		void WriteTrace(const std::string& path) const;
+
+	private:
+		void Schedule(const size_t index, const FrameData& frameData);
+		void RunSystem(const size_t index, const FrameData& frameData);
+
+		World& mWorld;
+		JobSystem& mJobSystem;
+		Metrics* mMetrics = nullptr;
+
+		std::vector<SystemDesc> mDescs;
+		std::vector<std::vector<size_t>> mDependencies;
+		std::vector<std::vector<size_t>> mDependents;
+		bool mIsBuilt = false;
+
+		std::unique_ptr<std::atomic<int>[]> mPendingDependencies;
+		JobCounter mCounter;
+
+		std::vector<SystemTiming> mTimings;
+		std::vector<size_t> mCriticalPath;
+		std::chrono::steady_clock::time_point mFrameStart;
+		double mFrameMs = 0.0;
+	};
+}
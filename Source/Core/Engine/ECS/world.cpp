@@ -0,0 +1,346 @@
+#include "stdafx.h"
+#include "world.h"
+#include "ecsProfiler.h"
+#include "prefab.h"
+
+#include <algorithm>
+#include <cstring>
+
+RF::World::World() {
+	// Archetype 0 holds entities without components
+	GetOrCreateArchetype({});
+}
+
+RF::World::~World() = default;
+
+RF::Entity RF::World::Create() {
+	return CreateInArchetype(0);
+}
+
+void RF::World::CreateBatch(const uint32_t archetypeIndex, std::span<Entity> entities, const BatchFill& fill) {
+	Archetype& archetype = *mArchetypes[archetypeIndex];
+	const uint64_t version = ChangeVersion();
+	if (mFreeIndices.size() < entities.size()) {
+		mRecords.reserve(mRecords.size() + entities.size() - mFreeIndices.size());
+	}
+
+	size_t created = 0;
+	while (created < entities.size()) {
+		uint32_t chunkIndex = 0;
+		uint32_t firstRow = 0;
+		const uint32_t rowCount = archetype.AddRows(static_cast<uint32_t>(std::min<size_t>(entities.size() - created, UINT32_MAX)), chunkIndex, firstRow);
+		const Chunk& chunk = archetype.GetChunk(chunkIndex);
+		archetype.MarkAllAdded(chunkIndex, version);
+
+		Entity* chunkEntities = archetype.Entities(chunk);
+		for (uint32_t i = 0; i < rowCount; ++i) {
+			const uint32_t index = AllocateIndex();
+			EntityRecord& record = mRecords[index];
+			record.archetype = archetypeIndex;
+			record.chunk = chunkIndex;
+			record.row = firstRow + i;
+
+			const Entity entity = Ecs::MakeEntity(index, record.generation);
+			chunkEntities[firstRow + i] = entity;
+			entities[created + i] = entity;
+		}
+
+		if (fill) {
+			fill(archetype, chunk, firstRow, rowCount, created);
+		}
+		else {
+			for (const ComponentTypeId type : archetype.Types()) {
+				const ComponentInfo& info = Ecs::GetComponentInfo(type);
+				for (uint32_t row = firstRow; info.size > 0 && row < firstRow + rowCount; ++row) {
+					info.construct(archetype.Column(chunk, type) + static_cast<size_t>(info.size) * row);
+				}
+			}
+		}
+
+		created += rowCount;
+	}
+
+	mEntityCount += entities.size();
+}
+
+void RF::World::InstantiateBatch(const Prefab& prefab, std::span<Entity> entities, std::span<const ComponentOverride> overrides) {
+	// Per prefab component, where its per instance values come from, nullptr to use the template
+	const std::span<const ComponentTypeId> types = prefab.Types();
+	std::vector<const std::byte*> overrideData(types.size(), nullptr);
+	for (const ComponentOverride& componentOverride : overrides) {
+		auto it = std::find(types.begin(), types.end(), componentOverride.type);
+		assert(it != types.end() && "Override for a component the prefab doesn't have");
+		overrideData[static_cast<size_t>(it - types.begin())] = componentOverride.data;
+	}
+
+	CreateBatch(prefab.ArchetypeIndex(), entities, [&prefab, &types, &overrideData](const Archetype& archetype, const Chunk& chunk, const uint32_t firstRow, const uint32_t rowCount, const size_t firstEntity) {
+		for (size_t i = 0; i < types.size(); ++i) {
+			const size_t size = Ecs::GetComponentInfo(types[i]).size;
+			std::byte* destination = archetype.Column(chunk, types[i]) + size * firstRow;
+			if (overrideData[i]) {
+				std::memcpy(destination, overrideData[i] + size * firstEntity, size * rowCount);
+				continue;
+			}
+
+			// Broadcast by doubling the part already written, a handful of large copies instead of one per row
+			std::memcpy(destination, prefab.TemplateValue(i), size);
+			for (size_t written = 1; written < rowCount;) {
+				const size_t copied = std::min<size_t>(written, rowCount - written);
+				std::memcpy(destination + size * written, destination, size * copied);
+				written += copied;
+			}
+		}
+	});
+}
+
+std::vector<RF::Entity> RF::World::InstantiateBatch(const Prefab& prefab, const size_t count, std::span<const ComponentOverride> overrides) {
+	std::vector<Entity> entities(count);
+	InstantiateBatch(prefab, entities, overrides);
+	return entities;
+}
+
+void RF::World::Destroy(const Entity entity) {
+	const EntityRecord* record = FindRecord(entity);
+	if (!record) {
+		return;
+	}
+
+	for (const ComponentTypeId type : mSparseTypes) {
+		mSparseSets[type]->Remove(entity);
+	}
+
+	EntityRecord& entityRecord = mRecords[Ecs::EntityIndex(entity)];
+	Archetype& archetype = *mArchetypes[record->archetype];
+	const Entity moved = archetype.RemoveRow(record->chunk, record->row);
+	if (moved != Entity::Null) {
+		EntityRecord& movedRecord = mRecords[Ecs::EntityIndex(moved)];
+		movedRecord.chunk = entityRecord.chunk;
+		movedRecord.row = entityRecord.row;
+		archetype.MarkAllChanged(entityRecord.chunk, ChangeVersion());
+	}
+
+	// Generation 0 is never handed out so a wrapped handle can't become Entity::Null
+	entityRecord.generation = entityRecord.generation == UINT32_MAX ? 1 : entityRecord.generation + 1;
+	entityRecord.archetype = gNoArchetype;
+	mFreeIndices.push_back(Ecs::EntityIndex(entity));
+	--mEntityCount;
+}
+
+bool RF::World::IsAlive(const Entity entity) const {
+	return FindRecord(entity) != nullptr;
+}
+
+void RF::World::Clear() {
+	for (const std::unique_ptr<Archetype>& archetype : mArchetypes) {
+		archetype->Clear();
+	}
+	for (const ComponentTypeId type : mSparseTypes) {
+		mSparseSets[type]->Clear();
+	}
+
+	for (uint32_t index = 0; index < mRecords.size(); ++index) {
+		EntityRecord& record = mRecords[index];
+		if (record.archetype != gNoArchetype) {
+			record.generation = record.generation == UINT32_MAX ? 1 : record.generation + 1;
+			record.archetype = gNoArchetype;
+			mFreeIndices.push_back(index);
+		}
+	}
+	mEntityCount = 0;
+}
+
+void* RF::World::AddComponent(const Entity entity, const ComponentTypeId type) {
+	const EntityRecord* record = FindRecord(entity);
+	if (!record) {
+		return nullptr;
+	}
+	if (Ecs::GetComponentInfo(type).storage == ComponentStorage::Sparse) {
+		return GetSparseSet(type).Insert(entity);
+	}
+
+	if (!mArchetypes[record->archetype]->Has(type)) {
+		MoveEntity(entity, GetTransition(record->archetype, type, true));
+	}
+	return GetComponent(entity, type);
+}
+
+void RF::World::RemoveComponent(const Entity entity, const ComponentTypeId type) {
+	const EntityRecord* record = FindRecord(entity);
+	if (record && mSparseSets[type]) {
+		mSparseSets[type]->Remove(entity);
+		return;
+	}
+	if (!record || !mArchetypes[record->archetype]->Has(type)) {
+		return;
+	}
+
+	MoveEntity(entity, GetTransition(record->archetype, type, false));
+}
+
+bool RF::World::HasComponent(const Entity entity, const ComponentTypeId type) const {
+	const EntityRecord* record = FindRecord(entity);
+	if (record && mSparseSets[type]) {
+		return mSparseSets[type]->Contains(entity);
+	}
+	return record && mArchetypes[record->archetype]->Has(type);
+}
+
+void* RF::World::GetComponent(const Entity entity, const ComponentTypeId type) {
+	const EntityRecord* record = FindRecord(entity);
+	if (!record) {
+		return nullptr;
+	}
+	if (mSparseSets[type]) {
+		return mSparseSets[type]->Get(entity);
+	}
+
+	Archetype& archetype = *mArchetypes[record->archetype];
+	std::byte* column = archetype.Column(archetype.GetChunk(record->chunk), type);
+	if (!column) {
+		return nullptr;
+	}
+
+	archetype.MarkChanged(record->chunk, type, ChangeVersion());
+	return column + static_cast<size_t>(Ecs::GetComponentInfo(type).size) * record->row;
+}
+
+RF::SparseSet& RF::World::GetSparseSet(const ComponentTypeId type) {
+	assert(Ecs::GetComponentInfo(type).storage == ComponentStorage::Sparse && "Component type is stored in archetypes");
+	if (!mSparseSets[type]) {
+		mSparseSets[type] = std::make_unique<SparseSet>(type);
+		mSparseTypes.push_back(type);
+	}
+	return *mSparseSets[type];
+}
+
+bool RF::World::GetLocation(const Entity entity, Location& location) const {
+	const EntityRecord* record = FindRecord(entity);
+	if (!record) {
+		return false;
+	}
+
+	location = { record->archetype, record->chunk, record->row };
+	return true;
+}
+
+uint32_t RF::World::GetOrCreateArchetype(const ComponentMask& mask) {
+	auto it = mArchetypeLookup.find(mask);
+	if (it != mArchetypeLookup.end()) {
+		return it->second;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(mArchetypes.size());
+	mArchetypes.push_back(std::make_unique<Archetype>(mask, mChunkPool));
+	mArchetypeLookup.emplace(mask, index);
+	return index;
+}
+
+RF::Entity RF::World::CreateInArchetype(const uint32_t archetypeIndex) {
+	const uint32_t index = AllocateIndex();
+	EntityRecord& record = mRecords[index];
+	const Entity entity = Ecs::MakeEntity(index, record.generation);
+
+	Archetype& archetype = *mArchetypes[archetypeIndex];
+	record.archetype = archetypeIndex;
+	archetype.AddRow(entity, record.chunk, record.row);
+	archetype.MarkAllAdded(record.chunk, ChangeVersion());
+
+	const Chunk& chunk = archetype.GetChunk(record.chunk);
+	for (const ComponentTypeId type : archetype.Types()) {
+		const ComponentInfo& info = Ecs::GetComponentInfo(type);
+		if (info.size > 0) {
+			info.construct(archetype.Column(chunk, type) + static_cast<size_t>(info.size) * record.row);
+		}
+	}
+
+	++mEntityCount;
+	return entity;
+}
+
+uint32_t RF::World::AllocateIndex() {
+	if (mFreeIndices.empty()) {
+		mRecords.push_back({});
+		return static_cast<uint32_t>(mRecords.size() - 1);
+	}
+
+	const uint32_t index = mFreeIndices.back();
+	mFreeIndices.pop_back();
+	return index;
+}
+
+const RF::World::EntityRecord* RF::World::FindRecord(const Entity entity) const {
+	const uint32_t index = Ecs::EntityIndex(entity);
+	if (index >= mRecords.size()) {
+		return nullptr;
+	}
+
+	const EntityRecord& record = mRecords[index];
+	const bool isAlive = record.archetype != gNoArchetype && record.generation == Ecs::EntityGeneration(entity);
+	return isAlive ? &record : nullptr;
+}
+
+uint32_t RF::World::GetTransition(const uint32_t archetypeIndex, const ComponentTypeId type, const bool isAdd) {
+	const uint64_t key = (static_cast<uint64_t>(archetypeIndex) << 32) | (static_cast<uint64_t>(type) << 1) | (isAdd ? 1u : 0u);
+	auto it = mTransitions.find(key);
+	if (it != mTransitions.end()) {
+		return it->second;
+	}
+
+	ComponentMask mask = mArchetypes[archetypeIndex]->Mask();
+	mask.set(type, isAdd);
+	const uint32_t target = GetOrCreateArchetype(mask);
+	mTransitions.emplace(key, target);
+	return target;
+}
+
+void RF::World::MoveEntity(const Entity entity, const uint32_t targetArchetype) {
+	EntityRecord& record = mRecords[Ecs::EntityIndex(entity)];
+	Archetype& source = *mArchetypes[record.archetype];
+	Archetype& target = *mArchetypes[targetArchetype];
+	if (mProfiler) {
+		mProfiler->RecordTransition(record.archetype, targetArchetype);
+	}
+
+	uint32_t chunkIndex = 0;
+	uint32_t row = 0;
+	target.AddRow(entity, chunkIndex, row);
+
+	// Components both archetypes have are copied, new ones are default constructed
+	const uint64_t version = ChangeVersion();
+	const Chunk& sourceChunk = source.GetChunk(record.chunk);
+	const Chunk& targetChunk = target.GetChunk(chunkIndex);
+	for (const ComponentTypeId type : target.Types()) {
+		if (source.Has(type)) {
+			target.MarkChanged(chunkIndex, type, version);
+		}
+		else {
+			target.MarkAdded(chunkIndex, type, version);
+		}
+
+		const ComponentInfo& info = Ecs::GetComponentInfo(type);
+		if (info.size == 0) {
+			continue;
+		}
+
+		std::byte* destination = target.Column(targetChunk, type) + static_cast<size_t>(info.size) * row;
+		const std::byte* sourceColumn = source.Column(sourceChunk, type);
+		if (sourceColumn) {
+			std::memcpy(destination, sourceColumn + static_cast<size_t>(info.size) * record.row, info.size);
+		}
+		else {
+			info.construct(destination);
+		}
+	}
+
+	const Entity moved = source.RemoveRow(record.chunk, record.row);
+	if (moved != Entity::Null) {
+		EntityRecord& movedRecord = mRecords[Ecs::EntityIndex(moved)];
+		movedRecord.chunk = record.chunk;
+		movedRecord.row = record.row;
+		source.MarkAllChanged(record.chunk, version);
+	}
+
+	record.archetype = targetArchetype;
+	record.chunk = chunkIndex;
+	record.row = row;
+}
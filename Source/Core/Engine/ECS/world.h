@@ -0,0 +1,228 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "archetype.h"
+#include "component.h"
+#include "entity.h"
+#include "sparseSet.h"
+
+namespace RF {
+	class EcsProfiler;
+	class Prefab;
+	struct ComponentOverride;
+
+	/// <summary>
+	/// Owns entities and their components, grouped by archetype. Structural changes (creating, destroying,
+	/// adding or removing components) must happen on one thread and never while iterating, reading and writing
+	/// component data of different chunks from several threads is fine.
+	/// Every mutable access stamps the chunk's column with the current change version, see Changed and Added in query.h.
+	/// Sparse components (see ComponentStorage) aren't part of archetypes, they live in one SparseSet per type.
+	/// </summary>
+	class World {
+	public:
+		World();
+		~World();
+		World(const World&) = delete;
+		void operator=(const World&) = delete;
+
+		Entity Create();
+
+		template <typename... Ts>
+		Entity Create(const Ts&... components) {
+			const Entity entity = CreateInArchetype(GetOrCreateArchetype(Ecs::MakeArchetypeMask<Ts...>()));
+			(SetComponent(entity, components), ...);
+			return entity;
+		}
+
+		// Writes the components of rows [firstRow, firstRow + rowCount) of a chunk, which hold entities[firstEntity...]
+		using BatchFill = std::function<void(const Archetype& archetype, const Chunk& chunk, const uint32_t firstRow, const uint32_t rowCount, const size_t firstEntity)>;
+
+		/// <summary>
+		/// Creates entities.size() entities in one archetype, a chunk worth of rows at a time. fill is called once per
+		/// run of rows and has to write every component, when it is null components are default constructed instead.
+		/// </summary>
+		void CreateBatch(const uint32_t archetypeIndex, std::span<Entity> entities, const BatchFill& fill);
+
+		/// <summary>
+		/// Spawns entities.size() copies of a prefab compiled for this world. Components get the prefab's values,
+		/// broadcast into each chunk, except the ones in overrides, which hold one value per instance.
+		/// </summary>
+		void InstantiateBatch(const Prefab& prefab, std::span<Entity> entities, std::span<const ComponentOverride> overrides = {});
+		std::vector<Entity> InstantiateBatch(const Prefab& prefab, const size_t count, std::span<const ComponentOverride> overrides = {});
+
+		void Destroy(const Entity entity);
+		bool IsAlive(const Entity entity) const;
+
+		/// <summary>
+		/// Destroys every entity. Archetypes stay, so queries keep their matches.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Moves the entity to the archetype with the component added, sparse components are inserted into their set
+		/// instead. Overwrites the value if it already has it.
+		/// </summary>
+		template <typename T>
+		void Add(const Entity entity, const T& component = {}) {
+			void* data = AddComponent(entity, Ecs::TypeId<T>());
+			if (data) {
+				*static_cast<T*>(data) = component;
+			}
+		}
+
+		template <typename T>
+		void Remove(const Entity entity) { RemoveComponent(entity, Ecs::TypeId<T>()); }
+
+		template <typename T>
+		bool Has(const Entity entity) const { return HasComponent(entity, Ecs::TypeId<T>()); }
+
+		/// <returns>Nullptr if the entity is dead, doesn't have the component or the component is a tag.</returns>
+		/// <remarks>Counts as a write for change tracking, read through a Query to avoid that.</remarks>
+		template <typename T>
+		T* Get(const Entity entity) { return static_cast<T*>(GetComponent(entity, Ecs::TypeId<T>())); }
+
+		// Type erased versions of the above, for serialization and tools
+		// Returns the component's storage, nullptr for tags
+		void* AddComponent(const Entity entity, const ComponentTypeId type);
+		void RemoveComponent(const Entity entity, const ComponentTypeId type);
+		bool HasComponent(const Entity entity, const ComponentTypeId type) const;
+		void* GetComponent(const Entity entity, const ComponentTypeId type);
+
+		/// <summary>
+		/// Calls func(std::span&lt;const Entity&gt;, std::span&lt;Ts&gt;...) once per chunk of every archetype that has all Ts.
+		/// Const component types give read only spans, the others mark the chunk's column as changed.
+		/// </summary>
+		template <typename... Ts, typename Func>
+		void ForEachChunk(Func&& func) {
+			static_assert(((!std::is_empty_v<Ts>) && ...), "Tags have no data to iterate");
+			static_assert(((!Ecs::gIsSparse<Ts>) && ...), "Sparse components aren't stored in chunks, use a Query");
+			const ComponentMask mask = Ecs::MakeMask<Ts...>();
+			const uint64_t version = ChangeVersion();
+
+			for (const std::unique_ptr<Archetype>& archetype : mArchetypes) {
+				if ((archetype->Mask() & mask) != mask) {
+					continue;
+				}
+
+				for (size_t i = 0; i < archetype->ChunkCount(); ++i) {
+					const Chunk& chunk = archetype->GetChunk(i);
+					(MarkWritten<Ts>(*archetype, i, version), ...);
+					func(std::span<const Entity>(archetype->Entities(chunk), chunk.count), std::span<Ts>(archetype->Column<Ts>(chunk), chunk.count)...);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Calls func(Ts&amp;...) for every entity that has all Ts, chunk by chunk.
+		/// </summary>
+		template <typename... Ts, typename Func>
+		void Each(Func&& func) {
+			ForEachChunk<Ts...>([&func](std::span<const Entity> entities, std::span<Ts>... columns) {
+				for (size_t i = 0; i < entities.size(); ++i) {
+					func(columns[i]...);
+				}
+			});
+		}
+
+		// Archetypes are never removed, so their indices stay valid for the lifetime of the world
+		uint32_t GetOrCreateArchetype(const ComponentMask& mask);
+		size_t ArchetypeCount() const { return mArchetypes.size(); }
+		Archetype& GetArchetype(const size_t index) { return *mArchetypes[index]; }
+		const Archetype& GetArchetype(const size_t index) const { return *mArchetypes[index]; }
+
+		size_t EntityCount() const { return mEntityCount; }
+
+		/// <summary>
+		/// The set of a sparse component type, created on first use.
+		/// </summary>
+		SparseSet& GetSparseSet(const ComponentTypeId type);
+		/// <returns>Nullptr if no entity ever had the component.</returns>
+		const SparseSet* FindSparseSet(const ComponentTypeId type) const { return mSparseSets[type].get(); }
+		// Types that have a set, in creation order
+		std::span<const ComponentTypeId> SparseTypes() const { return mSparseTypes; }
+
+		// Where an entity's archetype components are
+		struct Location {
+			uint32_t archetype = 0;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+		};
+
+		/// <returns>False if the entity is dead.</returns>
+		bool GetLocation(const Entity entity, Location& location) const;
+
+		/// <summary>
+		/// The version writes are stamped with. Queries with change filters advance it around every iteration, so
+		/// writes made after an iteration compare newer than everything that iteration saw.
+		/// </summary>
+		uint64_t ChangeVersion() const { return mChangeVersion.load(std::memory_order_relaxed); }
+
+		/// <returns>The new version.</returns>
+		uint64_t AdvanceChangeVersion() { return mChangeVersion.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+		/// <summary>
+		/// Set by EcsProfiler to count archetype moves, nullptr when nothing is profiling.
+		/// </summary>
+		void SetProfiler(EcsProfiler* profiler) { mProfiler = profiler; }
+		bool IsProfiled() const { return mProfiler != nullptr; }
+
+	private:
+		friend class WorldSnapshot;
+
+		static constexpr uint32_t gNoArchetype = UINT32_MAX;
+
+		struct EntityRecord {
+			uint32_t generation = 1;
+			uint32_t archetype = gNoArchetype;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+		};
+
+		template <typename T>
+		void SetComponent(const Entity entity, const T& component) {
+			void* data = Ecs::gIsSparse<T> ? AddComponent(entity, Ecs::TypeId<T>()) : GetComponent(entity, Ecs::TypeId<T>());
+			if (data) {
+				*static_cast<T*>(data) = component;
+			}
+		}
+
+		template <typename T>
+		static void MarkWritten(Archetype& archetype, const size_t chunkIndex, const uint64_t version) {
+			if constexpr (!std::is_const_v<T>) {
+				archetype.MarkChanged(chunkIndex, Ecs::TypeId<T>(), version);
+			}
+		}
+
+		Entity CreateInArchetype(const uint32_t archetypeIndex);
+		uint32_t AllocateIndex();
+		const EntityRecord* FindRecord(const Entity entity) const;
+		uint32_t GetTransition(const uint32_t archetypeIndex, const ComponentTypeId type, const bool isAdd);
+		void MoveEntity(const Entity entity, const uint32_t targetArchetype);
+
+		ChunkPool mChunkPool;
+		std::vector<std::unique_ptr<Archetype>> mArchetypes;
+		std::unordered_map<ComponentMask, uint32_t> mArchetypeLookup;
+		// Cached archetype moves, keyed by source archetype, component type and direction
+		std::unordered_map<uint64_t, uint32_t> mTransitions;
+
+		std::vector<EntityRecord> mRecords;
+		std::vector<uint32_t> mFreeIndices;
+		size_t mEntityCount = 0;
+
+		std::array<std::unique_ptr<SparseSet>, gMaxComponentTypes> mSparseSets;
+		std::vector<ComponentTypeId> mSparseTypes;
+
+		// Starts above 0 so everything that exists counts as new to a query that never ran
+		std::atomic<uint64_t> mChangeVersion = 1;
+
+		EcsProfiler* mProfiler = nullptr;
+	};
+}
@@ -0,0 +1,401 @@
+#include "stdafx.h"
+#include "worldSnapshot.h"
+#include "world.h"
+#include "Platform/mappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+	constexpr size_t gTableAlignment = 8;
+	constexpr size_t gArrayAlignment = 16;
+
+	size_t AlignUp(const size_t value, const size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Entity array followed by the component arrays, in the order of sizes
+	size_t ArchetypeDataSize(const size_t entityCount, std::span<const uint32_t> sizes) {
+		size_t size = AlignUp(entityCount * sizeof(RF::Entity), gArrayAlignment);
+		for (const uint32_t componentSize : sizes) {
+			size += AlignUp(entityCount * componentSize, gArrayAlignment);
+		}
+		return size;
+	}
+
+	template <typename T>
+	T Read(std::span<const std::byte> data, const uint64_t offset) {
+		T value;
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+	bool InRange(std::span<const std::byte> data, const uint64_t offset, const uint64_t size) {
+		return offset <= data.size() && size <= data.size() - offset;
+	}
+}
+
+void RF::WorldSnapshot::Capture(const World& world) {
+	// Only archetypes with entities are written, the restoring world creates them as needed
+	std::vector<uint32_t> archetypes;
+	ComponentMask usedTypes;
+	size_t archetypeTypeCount = 0;
+	for (uint32_t i = 0; i < world.ArchetypeCount(); ++i) {
+		const Archetype& archetype = world.GetArchetype(i);
+		if (archetype.EntityCount() > 0) {
+			archetypes.push_back(i);
+			usedTypes |= archetype.Mask();
+			archetypeTypeCount += archetype.Types().size();
+		}
+	}
+
+	std::vector<const SparseSet*> sparseSets;
+	for (const ComponentTypeId type : world.SparseTypes()) {
+		const SparseSet* set = world.FindSparseSet(type);
+		if (set->Count() > 0) {
+			sparseSets.push_back(set);
+			usedTypes.set(type);
+		}
+	}
+
+	std::array<uint32_t, gMaxComponentTypes> tableIndices;
+	std::vector<ComponentTypeId> types;
+	std::string names;
+	for (size_t type = 0; type < gMaxComponentTypes; ++type) {
+		if (usedTypes.test(type)) {
+			tableIndices[type] = static_cast<uint32_t>(types.size());
+			types.push_back(static_cast<ComponentTypeId>(type));
+			names += Ecs::GetComponentInfo(static_cast<ComponentTypeId>(type)).name;
+		}
+	}
+
+	WorldSnapshotHeader header;
+	header.typeCount = static_cast<uint32_t>(types.size());
+	header.archetypeCount = static_cast<uint32_t>(archetypes.size());
+	header.archetypeTypeCount = static_cast<uint32_t>(archetypeTypeCount);
+	header.recordCount = static_cast<uint32_t>(world.mRecords.size());
+	header.freeIndexCount = static_cast<uint32_t>(world.mFreeIndices.size());
+	header.sparseSetCount = static_cast<uint32_t>(sparseSets.size());
+	header.typesOffset = AlignUp(sizeof(WorldSnapshotHeader), gTableAlignment);
+	header.archetypesOffset = AlignUp(header.typesOffset + types.size() * sizeof(WorldSnapshotType), gTableAlignment);
+	header.archetypeTypesOffset = AlignUp(header.archetypesOffset + archetypes.size() * sizeof(WorldSnapshotArchetype), gTableAlignment);
+	header.sparseSetsOffset = AlignUp(header.archetypeTypesOffset + archetypeTypeCount * sizeof(uint32_t), gTableAlignment);
+	header.generationsOffset = AlignUp(header.sparseSetsOffset + sparseSets.size() * sizeof(WorldSnapshotSparseSet), gTableAlignment);
+	header.freeIndicesOffset = AlignUp(header.generationsOffset + world.mRecords.size() * sizeof(uint32_t), gTableAlignment);
+	header.namesOffset = AlignUp(header.freeIndicesOffset + world.mFreeIndices.size() * sizeof(uint32_t), gTableAlignment);
+	header.namesSize = names.size();
+
+	std::vector<WorldSnapshotArchetype> archetypeEntries;
+	std::vector<uint32_t> componentSizes;
+	size_t size = AlignUp(header.namesOffset + names.size(), gArrayAlignment);
+	for (const uint32_t index : archetypes) {
+		const Archetype& archetype = world.GetArchetype(index);
+		componentSizes.clear();
+		for (const ComponentTypeId type : archetype.Types()) {
+			componentSizes.push_back(Ecs::GetComponentInfo(type).size);
+		}
+
+		WorldSnapshotArchetype entry;
+		entry.firstType = archetypeEntries.empty() ? 0 : archetypeEntries.back().firstType + archetypeEntries.back().typeCount;
+		entry.typeCount = static_cast<uint32_t>(componentSizes.size());
+		entry.entityCount = archetype.EntityCount();
+		entry.dataOffset = size;
+		archetypeEntries.push_back(entry);
+		size += ArchetypeDataSize(archetype.EntityCount(), componentSizes);
+	}
+
+	std::vector<WorldSnapshotSparseSet> sparseSetEntries;
+	for (const SparseSet* set : sparseSets) {
+		const uint32_t componentSize = Ecs::GetComponentInfo(set->Type()).size;
+		sparseSetEntries.push_back({ tableIndices[set->Type()], static_cast<uint32_t>(set->Count()), size });
+		size += ArchetypeDataSize(set->Count(), std::span<const uint32_t>(&componentSize, 1));
+	}
+	header.size = size;
+
+	// Resizing keeps the capacity, so capturing every frame stops allocating once the buffer has grown
+	mData.resize(size);
+	std::byte* data = mData.data();
+	std::memcpy(data, &header, sizeof(WorldSnapshotHeader));
+
+	uint32_t nameOffset = 0;
+	for (size_t i = 0; i < types.size(); ++i) {
+		const ComponentInfo& info = Ecs::GetComponentInfo(types[i]);
+		const WorldSnapshotType entry = { nameOffset, static_cast<uint32_t>(info.name.size()), info.size, info.alignment };
+		std::memcpy(data + header.typesOffset + i * sizeof(WorldSnapshotType), &entry, sizeof(WorldSnapshotType));
+		nameOffset += entry.nameLength;
+	}
+	if (!archetypeEntries.empty()) {
+		std::memcpy(data + header.archetypesOffset, archetypeEntries.data(), archetypeEntries.size() * sizeof(WorldSnapshotArchetype));
+	}
+
+	std::byte* archetypeTypes = data + header.archetypeTypesOffset;
+	for (const uint32_t index : archetypes) {
+		for (const ComponentTypeId type : world.GetArchetype(index).Types()) {
+			std::memcpy(archetypeTypes, &tableIndices[type], sizeof(uint32_t));
+			archetypeTypes += sizeof(uint32_t);
+		}
+	}
+
+	if (!sparseSetEntries.empty()) {
+		std::memcpy(data + header.sparseSetsOffset, sparseSetEntries.data(), sparseSetEntries.size() * sizeof(WorldSnapshotSparseSet));
+	}
+
+	std::byte* generations = data + header.generationsOffset;
+	for (size_t i = 0; i < world.mRecords.size(); ++i) {
+		std::memcpy(generations + i * sizeof(uint32_t), &world.mRecords[i].generation, sizeof(uint32_t));
+	}
+	if (!world.mFreeIndices.empty()) {
+		std::memcpy(data + header.freeIndicesOffset, world.mFreeIndices.data(), world.mFreeIndices.size() * sizeof(uint32_t));
+	}
+	if (!names.empty()) {
+		std::memcpy(data + header.namesOffset, names.data(), names.size());
+	}
+
+	for (size_t i = 0; i < archetypes.size(); ++i) {
+		const Archetype& archetype = world.GetArchetype(archetypes[i]);
+		const size_t entityCount = archetype.EntityCount();
+		std::byte* entities = data + archetypeEntries[i].dataOffset;
+		size_t row = 0;
+		for (size_t chunkIndex = 0; chunkIndex < archetype.ChunkCount(); ++chunkIndex) {
+			const Chunk& chunk = archetype.GetChunk(chunkIndex);
+			std::memcpy(entities + row * sizeof(Entity), archetype.Entities(chunk), chunk.count * sizeof(Entity));
+			row += chunk.count;
+		}
+
+		std::byte* column = entities + AlignUp(entityCount * sizeof(Entity), gArrayAlignment);
+		for (const ComponentTypeId type : archetype.Types()) {
+			const size_t componentSize = Ecs::GetComponentInfo(type).size;
+			if (componentSize == 0) {
+				continue;
+			}
+
+			row = 0;
+			for (size_t chunkIndex = 0; chunkIndex < archetype.ChunkCount(); ++chunkIndex) {
+				const Chunk& chunk = archetype.GetChunk(chunkIndex);
+				std::memcpy(column + row * componentSize, archetype.Column(chunk, type), chunk.count * componentSize);
+				row += chunk.count;
+			}
+			column += AlignUp(entityCount * componentSize, gArrayAlignment);
+		}
+	}
+
+	for (size_t i = 0; i < sparseSets.size(); ++i) {
+		const SparseSet& set = *sparseSets[i];
+		std::byte* entities = data + sparseSetEntries[i].dataOffset;
+		std::memcpy(entities, set.Entities().data(), set.Count() * sizeof(Entity));
+		const size_t componentSize = Ecs::GetComponentInfo(set.Type()).size;
+		if (componentSize > 0) {
+			std::memcpy(entities + AlignUp(set.Count() * sizeof(Entity), gArrayAlignment), set.Values(), set.Count() * componentSize);
+		}
+	}
+}
+
+bool RF::WorldSnapshot::Restore(World& world) const {
+	return Restore(world, mData);
+}
+
+bool RF::WorldSnapshot::Restore(World& world, std::span<const std::byte> data) {
+	if (data.size() < sizeof(WorldSnapshotHeader)) {
+		return false;
+	}
+
+	const WorldSnapshotHeader header = Read<WorldSnapshotHeader>(data, 0);
+	if (header.magic != gWorldSnapshotMagic || header.version != gWorldSnapshotVersion || header.size > data.size()) {
+		return false;
+	}
+	data = data.first(header.size);
+
+	if (!InRange(data, header.typesOffset, static_cast<uint64_t>(header.typeCount) * sizeof(WorldSnapshotType)) ||
+		!InRange(data, header.archetypesOffset, static_cast<uint64_t>(header.archetypeCount) * sizeof(WorldSnapshotArchetype)) ||
+		!InRange(data, header.archetypeTypesOffset, static_cast<uint64_t>(header.archetypeTypeCount) * sizeof(uint32_t)) ||
+		!InRange(data, header.sparseSetsOffset, static_cast<uint64_t>(header.sparseSetCount) * sizeof(WorldSnapshotSparseSet)) ||
+		!InRange(data, header.generationsOffset, static_cast<uint64_t>(header.recordCount) * sizeof(uint32_t)) ||
+		!InRange(data, header.freeIndicesOffset, static_cast<uint64_t>(header.freeIndexCount) * sizeof(uint32_t)) ||
+		!InRange(data, header.namesOffset, header.namesSize)) {
+		return false;
+	}
+
+	// Everything is checked before the world is touched, a bad snapshot leaves it as it was
+	std::vector<ComponentTypeId> localTypes(header.typeCount);
+	const std::string_view names(reinterpret_cast<const char*>(data.data() + header.namesOffset), header.namesSize);
+	for (uint32_t i = 0; i < header.typeCount; ++i) {
+		const WorldSnapshotType entry = Read<WorldSnapshotType>(data, header.typesOffset + static_cast<uint64_t>(i) * sizeof(WorldSnapshotType));
+		if (entry.nameOffset > names.size() || entry.nameLength > names.size() - entry.nameOffset ||
+			!Ecs::FindComponentType(names.substr(entry.nameOffset, entry.nameLength), localTypes[i])) {
+			return false;
+		}
+
+		const ComponentInfo& info = Ecs::GetComponentInfo(localTypes[i]);
+		if (info.size != entry.size || info.alignment != entry.alignment) {
+			return false;
+		}
+	}
+
+	std::vector<WorldSnapshotArchetype> archetypes(header.archetypeCount);
+	std::vector<ComponentMask> masks(header.archetypeCount);
+	std::vector<uint32_t> componentSizes;
+	uint64_t entityCount = 0;
+	for (uint32_t i = 0; i < header.archetypeCount; ++i) {
+		const WorldSnapshotArchetype& entry = archetypes[i] = Read<WorldSnapshotArchetype>(data, header.archetypesOffset + static_cast<uint64_t>(i) * sizeof(WorldSnapshotArchetype));
+		if (entry.firstType > header.archetypeTypeCount || entry.typeCount > header.archetypeTypeCount - entry.firstType || entry.entityCount > header.recordCount) {
+			return false;
+		}
+
+		componentSizes.clear();
+		for (uint32_t j = 0; j < entry.typeCount; ++j) {
+			const uint32_t typeIndex = Read<uint32_t>(data, header.archetypeTypesOffset + static_cast<uint64_t>(entry.firstType + j) * sizeof(uint32_t));
+			if (typeIndex >= header.typeCount || masks[i].test(localTypes[typeIndex]) ||
+				Ecs::GetComponentInfo(localTypes[typeIndex]).storage != ComponentStorage::Archetype) {
+				return false;
+			}
+			masks[i].set(localTypes[typeIndex]);
+			componentSizes.push_back(Ecs::GetComponentInfo(localTypes[typeIndex]).size);
+		}
+
+		if (entry.dataOffset % gArrayAlignment != 0 || !InRange(data, entry.dataOffset, ArchetypeDataSize(static_cast<size_t>(entry.entityCount), componentSizes))) {
+			return false;
+		}
+		entityCount += entry.entityCount;
+	}
+
+	// Live entities and free indices have to cover every record exactly once
+	if (entityCount + header.freeIndexCount != header.recordCount) {
+		return false;
+	}
+
+	std::vector<bool> seen(header.recordCount, false);
+	std::vector<bool> isLive(header.recordCount, false);
+	for (const WorldSnapshotArchetype& entry : archetypes) {
+		for (uint64_t row = 0; row < entry.entityCount; ++row) {
+			const Entity entity = Read<Entity>(data, entry.dataOffset + row * sizeof(Entity));
+			const uint32_t index = Ecs::EntityIndex(entity);
+			if (index >= header.recordCount || seen[index] || Ecs::EntityGeneration(entity) == 0 ||
+				Ecs::EntityGeneration(entity) != Read<uint32_t>(data, header.generationsOffset + static_cast<uint64_t>(index) * sizeof(uint32_t))) {
+				return false;
+			}
+			seen[index] = true;
+			isLive[index] = true;
+		}
+	}
+	for (uint32_t i = 0; i < header.freeIndexCount; ++i) {
+		const uint32_t index = Read<uint32_t>(data, header.freeIndicesOffset + static_cast<uint64_t>(i) * sizeof(uint32_t));
+		if (index >= header.recordCount || seen[index]) {
+			return false;
+		}
+		seen[index] = true;
+	}
+
+	// Sparse sets may only hold live entities
+	std::vector<WorldSnapshotSparseSet> sparseSets(header.sparseSetCount);
+	for (uint32_t i = 0; i < header.sparseSetCount; ++i) {
+		const WorldSnapshotSparseSet& entry = sparseSets[i] = Read<WorldSnapshotSparseSet>(data, header.sparseSetsOffset + static_cast<uint64_t>(i) * sizeof(WorldSnapshotSparseSet));
+		if (entry.typeIndex >= header.typeCount || Ecs::GetComponentInfo(localTypes[entry.typeIndex]).storage != ComponentStorage::Sparse) {
+			return false;
+		}
+
+		const uint32_t componentSize = Ecs::GetComponentInfo(localTypes[entry.typeIndex]).size;
+		if (entry.dataOffset % gArrayAlignment != 0 || !InRange(data, entry.dataOffset, ArchetypeDataSize(entry.entityCount, std::span<const uint32_t>(&componentSize, 1)))) {
+			return false;
+		}
+		for (uint64_t row = 0; row < entry.entityCount; ++row) {
+			const Entity entity = Read<Entity>(data, entry.dataOffset + row * sizeof(Entity));
+			const uint32_t index = Ecs::EntityIndex(entity);
+			if (index >= header.recordCount || !isLive[index] ||
+				Ecs::EntityGeneration(entity) != Read<uint32_t>(data, header.generationsOffset + static_cast<uint64_t>(index) * sizeof(uint32_t))) {
+				return false;
+			}
+		}
+	}
+
+	world.Clear();
+	world.mRecords.resize(header.recordCount);
+	for (uint32_t i = 0; i < header.recordCount; ++i) {
+		World::EntityRecord& record = world.mRecords[i];
+		record.generation = Read<uint32_t>(data, header.generationsOffset + static_cast<uint64_t>(i) * sizeof(uint32_t));
+		record.archetype = World::gNoArchetype;
+	}
+	world.mFreeIndices.resize(header.freeIndexCount);
+	if (header.freeIndexCount > 0) {
+		std::memcpy(world.mFreeIndices.data(), data.data() + header.freeIndicesOffset, header.freeIndexCount * sizeof(uint32_t));
+	}
+
+	// Columns are copied a chunk at a time, then the records are pointed at the rows the entities landed in
+	const uint64_t version = world.ChangeVersion();
+	for (uint32_t i = 0; i < header.archetypeCount; ++i) {
+		const WorldSnapshotArchetype& entry = archetypes[i];
+		const uint32_t archetypeIndex = world.GetOrCreateArchetype(masks[i]);
+		Archetype& archetype = world.GetArchetype(archetypeIndex);
+		const size_t count = static_cast<size_t>(entry.entityCount);
+		const std::byte* entities = data.data() + entry.dataOffset;
+
+		// Column sources in the archetype's type order, which can differ from the snapshot's if ids differ
+		std::array<const std::byte*, gMaxComponentTypes> columns = {};
+		const std::byte* column = entities + AlignUp(count * sizeof(Entity), gArrayAlignment);
+		for (uint32_t j = 0; j < entry.typeCount; ++j) {
+			const uint32_t typeIndex = Read<uint32_t>(data, header.archetypeTypesOffset + static_cast<uint64_t>(entry.firstType + j) * sizeof(uint32_t));
+			const size_t componentSize = Ecs::GetComponentInfo(localTypes[typeIndex]).size;
+			columns[localTypes[typeIndex]] = column;
+			column += AlignUp(count * componentSize, gArrayAlignment);
+		}
+
+		size_t restored = 0;
+		while (restored < count) {
+			uint32_t chunkIndex = 0;
+			uint32_t firstRow = 0;
+			const uint32_t rowCount = archetype.AddRows(static_cast<uint32_t>(std::min<size_t>(count - restored, UINT32_MAX)), chunkIndex, firstRow);
+			const Chunk& chunk = archetype.GetChunk(chunkIndex);
+			archetype.MarkAllAdded(chunkIndex, version);
+
+			Entity* chunkEntities = archetype.Entities(chunk) + firstRow;
+			std::memcpy(chunkEntities, entities + restored * sizeof(Entity), rowCount * sizeof(Entity));
+			for (const ComponentTypeId type : archetype.Types()) {
+				const size_t componentSize = Ecs::GetComponentInfo(type).size;
+				if (componentSize > 0) {
+					std::memcpy(archetype.Column(chunk, type) + componentSize * firstRow, columns[type] + componentSize * restored, componentSize * rowCount);
+				}
+			}
+
+			for (uint32_t row = 0; row < rowCount; ++row) {
+				World::EntityRecord& record = world.mRecords[Ecs::EntityIndex(chunkEntities[row])];
+				record.archetype = archetypeIndex;
+				record.chunk = chunkIndex;
+				record.row = firstRow + row;
+			}
+			restored += rowCount;
+		}
+	}
+	world.mEntityCount = static_cast<size_t>(entityCount);
+
+	for (const WorldSnapshotSparseSet& entry : sparseSets) {
+		SparseSet& set = world.GetSparseSet(localTypes[entry.typeIndex]);
+		const size_t componentSize = Ecs::GetComponentInfo(set.Type()).size;
+		const std::byte* entities = data.data() + entry.dataOffset;
+		const std::byte* values = entities + AlignUp(entry.entityCount * sizeof(Entity), gArrayAlignment);
+		for (uint32_t row = 0; row < entry.entityCount; ++row) {
+			void* value = set.Insert(Read<Entity>(data, entry.dataOffset + static_cast<uint64_t>(row) * sizeof(Entity)));
+			if (value) {
+				std::memcpy(value, values + componentSize * row, componentSize);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool RF::WorldSnapshot::RestoreFromFile(World& world, const std::filesystem::path& path) {
+	MappedFile file;
+	return file.Open(path) && Restore(world, file.Data());
+}
+
+bool RF::WorldSnapshot::WriteFile(const std::filesystem::path& path) const {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.good()) {
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(mData.data()), static_cast<std::streamsize>(mData.size()));
+	return file.good();
+}
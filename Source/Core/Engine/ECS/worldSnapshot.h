@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace RF {
+	class World;
+
+	constexpr uint32_t gWorldSnapshotMagic = 0x53574652; // "RFWS"
+	constexpr uint32_t gWorldSnapshotVersion = 2;
+
+	// Layout: header, component type table, archetype table, archetype type lists, sparse set table, entity
+	// generations, free indices, type names, then per archetype its entity array followed by one packed array per
+	// component and per sparse set its entity array and value array.
+	// Tables are 8 byte aligned and arrays 16 byte aligned
+	struct WorldSnapshotHeader {
+		uint32_t magic = gWorldSnapshotMagic;
+		uint32_t version = gWorldSnapshotVersion;
+		uint32_t typeCount = 0;
+		uint32_t archetypeCount = 0;
+		uint32_t archetypeTypeCount = 0;
+		uint32_t recordCount = 0;
+		uint32_t freeIndexCount = 0;
+		uint32_t sparseSetCount = 0;
+		uint64_t typesOffset = 0;
+		uint64_t archetypesOffset = 0;
+		uint64_t archetypeTypesOffset = 0;
+		uint64_t sparseSetsOffset = 0;
+		uint64_t generationsOffset = 0;
+		uint64_t freeIndicesOffset = 0;
+		uint64_t namesOffset = 0;
+		uint64_t namesSize = 0;
+		uint64_t size = 0;
+	};
+
+	// Components are matched by name on load, ids depend on registration order
+	struct WorldSnapshotType {
+		uint32_t nameOffset = 0;
+		uint32_t nameLength = 0;
+		uint32_t size = 0;
+		uint32_t alignment = 0;
+	};
+
+	struct WorldSnapshotArchetype {
+		// Range in the archetype type list, which holds indices into the type table
+		uint32_t firstType = 0;
+		uint32_t typeCount = 0;
+		uint64_t entityCount = 0;
+		uint64_t dataOffset = 0;
+	};
+
+	struct WorldSnapshotSparseSet {
+		uint32_t typeIndex = 0;
+		uint32_t entityCount = 0;
+		uint64_t dataOffset = 0;
+	};
+
+	/// <summary>
+	/// A binary image of a World: its archetypes, their raw component columns and the entity table. Entities keep
+	/// their index and generation, so handles stored in components or outside the world stay valid after a restore.
+	/// Sparse sets are written as their entity and value arrays.
+	/// Restoring checks the tables, then copies columns into chunks with one memcpy per column and chunk and
+	/// rebuilds the entity records from the entity arrays, nothing is parsed per entity.
+	/// Keep a ring of snapshots and Capture() into them every frame for rewind or rollback, a snapshot reuses
+	/// its memory once it has grown to the size of the world.
+	/// </summary>
+	class WorldSnapshot {
+	public:
+		void Capture(const World& world);
+
+		/// <summary>
+		/// Replaces everything in the world. Change versions restart, restored chunks count as added.
+		/// </summary>
+		/// <returns>False, leaving the world untouched, if the data is not a valid snapshot or has components
+		/// that aren't registered or changed size.</returns>
+		bool Restore(World& world) const;
+		static bool Restore(World& world, std::span<const std::byte> data);
+
+		/// <summary>
+		/// Restores from a memory mapped snapshot file, columns are copied straight out of the mapping.
+		/// </summary>
+		static bool RestoreFromFile(World& world, const std::filesystem::path& path);
+		bool WriteFile(const std::filesystem::path& path) const;
+
+		std::span<const std::byte> Data() const { return mData; }
+
+	private:
+		std::vector<std::byte> mData;
+	};
+}
@@ -1,40 +1,122 @@
 #include "stdafx.h"
 #include "Engine.h"
-#include "Window/Window.h"
-#include "frameData.h"
+#include "Engine/Window/Window.h"
+#include "Engine/frameData.h"
+#include "Engine/Assets/assetStreamer.h"
+#include "Engine/ECS/ecsProfiler.h"
+#include "Engine/ECS/systemScheduler.h"
+#include "Engine/ECS/world.h"
+#include "Engine/FileSystem/virtualFileSystem.h"
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Metrics/metrics.h"
+#include "Engine/Startup/subsystemRegistry.h"
+#include "Engine/Tasks/taskScheduler.h"
 #include "Util/jsonUtil.h"
 
 #include <nlohmann/json.hpp>
 
 namespace {
-	constexpr std::string_view gConfigFilePath = "../engineConfig.json";
+	// The project root is mounted as the VFS root, pak archives in the assets folder are mounted on top of it
+	constexpr std::string_view gRootPath = "../";
+	constexpr std::wstring_view gAssetsPath = L"../Assets/";
+	constexpr std::string_view gAssetsMountPoint = "Assets";
+	constexpr std::string_view gConfigFilePath = "engineConfig.json";
+	constexpr std::string_view gStartupReportPath = "startupReport.json";
+	constexpr std::string_view gMetricsReportPath = "metrics.json";
+	constexpr std::string_view gSystemTracePath = "systemTrace.json";
+	constexpr std::string_view gEcsReportPath = "ecsReport.json";
+	// Frames between refreshes of the ECS stats in the window title and the metrics
+	constexpr size_t gEcsProfilerInterval = 60;
 }
 
-RF::Engine::Engine(const RF::EngineCreationParams& params) {
+RF::Engine::Engine(const RF::EngineCreationParams& params) : mAssetsPath(gAssetsPath) {
 	RF::WindowCreationParams windowParams;
 	windowParams.hInstance = params.hInstance;
 	windowParams.cmdShow = params.cmdShow;
 	windowParams.engine = this;
 	windowParams.windowProc = params.windowProc;
 
-	LoadConfigFile(windowParams);
+	mJobSystem = std::make_unique<RF::JobSystem>();
+	mMetrics = std::make_unique<RF::Metrics>();
+	mFileSystem = std::make_unique<RF::VirtualFileSystem>();
+	mTaskScheduler = std::make_unique<RF::TaskScheduler>(*mJobSystem);
+	mWorld = std::make_unique<RF::World>();
+	mSystems = std::make_unique<RF::SystemScheduler>(*mWorld, *mJobSystem, mMetrics.get());
 
-	mWindow = std::make_unique<RF::Window>();
-	mWindow->Init(windowParams);
+	// Subsystems without a dependency between them are initialized in parallel
+	RF::SubsystemRegistry startup;
+	startup.Register({
+		.name = "FileSystem",
+		.init = [this]() {
+			mFileSystem->MountDirectory(gRootPath);
+			mFileSystem->MountPaksInDirectory(mAssetsPath, gAssetsMountPoint);
+		},
+	});
+	startup.Register({
+		.name = "AssetStreamer",
+		.dependencies = { "FileSystem" },
+		.init = [this]() { mAssetStreamer = std::make_unique<RF::AssetStreamer>(*mFileSystem, *mJobSystem, mMetrics.get()); },
+	});
+	startup.Register({
+		.name = "Config",
+		.dependencies = { "FileSystem" },
+		.init = [this, &windowParams]() { LoadConfigFile(windowParams); },
+	});
+	startup.Register({
+		.name = "Window",
+		.dependencies = { "Config" },
+		.init = [this, &windowParams]() {
+			mWindow = std::make_unique<RF::Window>();
+			mWindow->Init(windowParams);
+		},
+		.mainThreadOnly = true,
+	});
+
+	startup.InitializeAll(*mJobSystem);
+	startup.WriteReport(static_cast<std::string>(gStartupReportPath));
 }
 
-void RF::Engine::Update(const FrameData& frameData) { frameData; }
+RF::Engine::~Engine() = default;
+
+void RF::Engine::Update(const FrameData& frameData) {
+	// Frame boundary, finished loads are handed to gameplay before anything else runs
+	mAssetStreamer->ProcessCompletions();
+	mTaskScheduler->Update(frameData);
+	mSystems->Run(frameData);
+
+	if (mEcsProfiler) {
+		mEcsProfiler->Sample();
+		if (mEcsProfiler->SampleCount() % gEcsProfilerInterval == 0) {
+			mWindow->SetCustomText(mEcsProfiler->Summary());
+			mEcsProfiler->RecordMetrics(*mMetrics);
+		}
+	}
+}
 
 void RF::Engine::Render(const FrameData& frameData) { frameData; }
 
-void RF::Engine::Shutdown() {}
+void RF::Engine::Shutdown() {
+	// Tasks can be waiting on the streamer, it goes first so no completion resumes a destroyed task
+	mAssetStreamer.reset();
+	mTaskScheduler.reset();
+	mSystems->WriteTrace(static_cast<std::string>(gSystemTracePath));
+	if (mEcsProfiler) {
+		mEcsProfiler->WriteReport(static_cast<std::string>(gEcsReportPath));
+	}
+	mMetrics->WriteReport(static_cast<std::string>(gMetricsReportPath));
+}
 
 void RF::Engine::OnResize(const unsigned int width, const unsigned int height) {
 	mWindow->SetSize(width, height);
 }
 
 void RF::Engine::LoadConfigFile(RF::WindowCreationParams& windowParams) {
-	auto json = RF::Json::Parse(static_cast<std::string>(gConfigFilePath));
+	auto json = RF::Json::Parse(mFileSystem->Read(gConfigFilePath));
+
+	auto ecsProfilerJson = RF::Json::TryGet<nlohmann::json>(json, "ecsProfiler", {});
+	if (RF::Json::TryGet(ecsProfilerJson, "enabled", false)) {
+		mEcsProfiler = std::make_unique<RF::EcsProfiler>(*mWorld, mSystems.get(), RF::Json::TryGet<size_t>(ecsProfilerJson, "topSystems", 5));
+	}
 
 	auto windowSettingsJson = RF::Json::TryGet<nlohmann::json>(json, "windowSettings", {});
 	if (windowSettingsJson.empty()) {
@@ -3,6 +3,14 @@ namespace RF {
     struct FrameData;
 	struct WindowCreationParams;
     class Window;
+    class JobSystem;
+    class VirtualFileSystem;
+    class Metrics;
+    class AssetStreamer;
+    class TaskScheduler;
+    class World;
+    class SystemScheduler;
+    class EcsProfiler;
 
     struct EngineCreationParams {
         WNDPROC windowProc = nullptr;
@@ -14,7 +22,7 @@ namespace RF {
     public:
         Engine() = delete;
         Engine(const EngineCreationParams& params);
-        ~Engine() = default;
+        ~Engine();
 		Engine(const Engine&) = delete;
 		void operator=(const Engine&) = delete;
 
@@ -28,6 +36,15 @@ namespace RF {
     private:
 		void LoadConfigFile(RF::WindowCreationParams& windowParams);
 
+        std::unique_ptr<JobSystem> mJobSystem;
+        std::unique_ptr<Metrics> mMetrics;
+        std::unique_ptr<VirtualFileSystem> mFileSystem;
+        std::unique_ptr<AssetStreamer> mAssetStreamer;
+        std::unique_ptr<TaskScheduler> mTaskScheduler;
+        std::unique_ptr<World> mWorld;
+        std::unique_ptr<SystemScheduler> mSystems;
+        // Only exists when enabled in the config file
+        std::unique_ptr<EcsProfiler> mEcsProfiler;
         std::unique_ptr<Window> mWindow;
 
         std::wstring mAssetsPath;
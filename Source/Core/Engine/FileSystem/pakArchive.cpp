@@ -0,0 +1,198 @@
+#include "stdafx.h"
+#include "pakArchive.h"
+#include "Util/hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	uint64_t AlignUp(const uint64_t value, const uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+std::string RF::Pak::NormalizePath(std::string_view path) {
+	std::string normalized(path);
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+
+	size_t start = 0;
+	while (true) {
+		if (normalized.compare(start, 2, "./") == 0) {
+			start += 2;
+		}
+		else if (normalized.compare(start, 1, "/") == 0) {
+			start += 1;
+		}
+		else {
+			break;
+		}
+	}
+
+	return normalized.substr(start);
+}
+
+bool RF::PakArchive::Open(const std::filesystem::path& path) {
+	mEntries = {};
+	mNames = {};
+	mPath = path;
+	if (!mFile.Open(path)) {
+		return false;
+	}
+
+	const std::span<const std::byte> data = mFile.Data();
+	if (data.size() < sizeof(PakHeader)) {
+		mFile.Close();
+		return false;
+	}
+
+	PakHeader header;
+	std::memcpy(&header, data.data(), sizeof(PakHeader));
+
+	// Bounds are checked by subtracting, so crafted offsets and counts can't wrap around
+	const bool isValid = header.magic == gPakMagic
+		&& header.version == gPakVersion
+		&& header.tableOffset % alignof(PakEntry) == 0
+		&& header.tableOffset <= header.namesOffset
+		&& header.namesOffset <= data.size()
+		&& header.entryCount <= (header.namesOffset - header.tableOffset) / sizeof(PakEntry);
+	if (!isValid) {
+		mFile.Close();
+		return false;
+	}
+
+	// The table is aligned in the file and the mapping is page aligned, so it can be used in place
+	mEntries = { reinterpret_cast<const PakEntry*>(data.data() + header.tableOffset), static_cast<size_t>(header.entryCount) };
+	mNames = { reinterpret_cast<const char*>(data.data() + header.namesOffset), static_cast<size_t>(data.size() - header.namesOffset) };
+
+	// Find() binary searches the table, so it has to be sorted by hash
+	for (size_t i = 0; i < mEntries.size(); ++i) {
+		const PakEntry& entry = mEntries[i];
+		const bool isEntryValid = entry.offset <= header.tableOffset
+			&& entry.size <= header.tableOffset - entry.offset
+			&& entry.nameLength <= mNames.size()
+			&& entry.nameOffset <= mNames.size() - entry.nameLength
+			&& (i == 0 || mEntries[i - 1].pathHash <= entry.pathHash);
+		if (!isEntryValid) {
+			mEntries = {};
+			mNames = {};
+			mFile.Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const RF::PakEntry* RF::PakArchive::Find(std::string_view normalizedPath) const {
+	const uint64_t hash = RF::Hash::Fnv1a64(normalizedPath);
+
+	auto it = std::lower_bound(mEntries.begin(), mEntries.end(), hash, [](const PakEntry& entry, const uint64_t value) {
+		return entry.pathHash < value;
+	});
+
+	// Entries with colliding hashes sit next to each other, the stored path settles it
+	for (; it != mEntries.end() && it->pathHash == hash; ++it) {
+		if (EntryPath(*it) == normalizedPath) {
+			return &*it;
+		}
+	}
+
+	return nullptr;
+}
+
+std::span<const std::byte> RF::PakArchive::Read(const PakEntry& entry) const {
+	return mFile.Data().subspan(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+}
+
+std::string_view RF::PakArchive::EntryPath(const PakEntry& entry) const {
+	return { mNames.data() + entry.nameOffset, entry.nameLength };
+}
+
+std::span<const RF::PakEntry> RF::PakArchive::Entries() const {
+	return mEntries;
+}
+
+const std::filesystem::path& RF::PakArchive::Path() const {
+	return mPath;
+}
+
+void RF::PakWriter::Add(std::string_view virtualPath, std::span<const std::byte> data) {
+	std::string path = RF::Pak::NormalizePath(virtualPath);
+
+	auto it = std::find_if(mFiles.begin(), mFiles.end(), [&path](const PendingFile& file) { return file.path == path; });
+	if (it != mFiles.end()) {
+		it->data.assign(data.begin(), data.end());
+		return;
+	}
+
+	mFiles.push_back({ std::move(path), std::vector<std::byte>(data.begin(), data.end()) });
+}
+
+bool RF::PakWriter::AddFile(std::string_view virtualPath, const std::filesystem::path& sourcePath) {
+	std::ifstream file(sourcePath, std::ios::binary | std::ios::ate);
+	if (!file.good()) {
+		return false;
+	}
+
+	std::vector<std::byte> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	if (!file.good()) {
+		return false;
+	}
+
+	Add(virtualPath, data);
+	return true;
+}
+
+bool RF::PakWriter::Write(const std::filesystem::path& path) const {
+	std::vector<PakEntry> entries;
+	entries.reserve(mFiles.size());
+
+	std::string names;
+	uint64_t offset = AlignUp(sizeof(PakHeader), gPakDataAlignment);
+	for (const PendingFile& file : mFiles) {
+		PakEntry entry;
+		entry.pathHash = RF::Hash::Fnv1a64(file.path);
+		entry.offset = offset;
+		entry.size = file.data.size();
+		entry.nameOffset = static_cast<uint32_t>(names.size());
+		entry.nameLength = static_cast<uint32_t>(file.path.size());
+		entries.push_back(entry);
+
+		names += file.path;
+		offset = AlignUp(offset + entry.size, gPakDataAlignment);
+	}
+
+	PakHeader header;
+	header.entryCount = entries.size();
+	header.tableOffset = offset;
+	header.namesOffset = offset + entries.size() * sizeof(PakEntry);
+
+	// Data is written in insertion order, only the table is sorted
+	std::vector<PakEntry> sortedEntries = entries;
+	std::sort(sortedEntries.begin(), sortedEntries.end(), [](const PakEntry& lhs, const PakEntry& rhs) {
+		return lhs.pathHash < rhs.pathHash;
+	});
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.good()) {
+		return false;
+	}
+
+	const char padding[gPakDataAlignment] = {};
+	auto writeAt = [&file, &padding](const uint64_t position, const void* data, const size_t size) {
+		const uint64_t current = static_cast<uint64_t>(file.tellp());
+		file.write(padding, static_cast<std::streamsize>(position - current));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(PakHeader));
+	for (size_t i = 0; i < mFiles.size(); ++i) {
+		writeAt(entries[i].offset, mFiles[i].data.data(), mFiles[i].data.size());
+	}
+	writeAt(header.tableOffset, sortedEntries.data(), sortedEntries.size() * sizeof(PakEntry));
+	writeAt(header.namesOffset, names.data(), names.size());
+
+	return file.good();
+}
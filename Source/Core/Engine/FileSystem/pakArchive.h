@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Platform/mappedFile.h"
+
+namespace RF {
+	constexpr uint32_t gPakMagic = 0x4B504652; // "RFPK"
+	constexpr uint32_t gPakVersion = 1;
+	constexpr uint64_t gPakDataAlignment = 16;
+
+	// On disk layout: PakHeader, file data (each blob 16 byte aligned), PakEntry table sorted by path hash, path strings
+	struct PakHeader {
+		uint32_t magic = gPakMagic;
+		uint32_t version = gPakVersion;
+		uint64_t entryCount = 0;
+		uint64_t tableOffset = 0;
+		uint64_t namesOffset = 0;
+	};
+
+	struct PakEntry {
+		uint64_t pathHash = 0;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		uint32_t nameOffset = 0;
+		uint32_t nameLength = 0;
+	};
+
+	namespace Pak {
+		/// <summary>
+		/// Turns a path into the form used as key inside archives and the VFS: forward slashes, no leading "./" or "/".
+		/// </summary>
+		std::string NormalizePath(std::string_view path);
+	}
+
+	/// <summary>
+	/// A pak file mapped into memory. Lookups are a binary search in the table of contents
+	/// and reads are views straight into the mapping.
+	/// </summary>
+	class PakArchive {
+	public:
+		bool Open(const std::filesystem::path& path);
+
+		/// <returns>Nullptr if the archive doesn't contain the (normalized) path.</returns>
+		const PakEntry* Find(std::string_view normalizedPath) const;
+		std::span<const std::byte> Read(const PakEntry& entry) const;
+		std::string_view EntryPath(const PakEntry& entry) const;
+
+		std::span<const PakEntry> Entries() const;
+		const std::filesystem::path& Path() const;
+
+	private:
+		std::filesystem::path mPath;
+		MappedFile mFile;
+		std::span<const PakEntry> mEntries;
+		std::span<const char> mNames;
+	};
+
+	/// <summary>
+	/// Collects files in memory and writes them out as a pak archive.
+	/// </summary>
+	class PakWriter {
+	public:
+		void Add(std::string_view virtualPath, std::span<const std::byte> data);
+		bool AddFile(std::string_view virtualPath, const std::filesystem::path& sourcePath);
+		bool Write(const std::filesystem::path& path) const;
+
+	private:
+		struct PendingFile {
+			std::string path;
+			std::vector<std::byte> data;
+		};
+
+		std::vector<PendingFile> mFiles;
+	};
+}
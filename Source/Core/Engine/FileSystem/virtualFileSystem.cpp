@@ -0,0 +1,203 @@
+#include "stdafx.h"
+#include "virtualFileSystem.h"
+#include "pakArchive.h"
+#include "Platform/mappedFile.h"
+
+#include <algorithm>
+
+namespace {
+	std::string NormalizeMountPoint(std::string_view mountPoint) {
+		std::string normalized = RF::Pak::NormalizePath(mountPoint);
+		while (!normalized.empty() && normalized.back() == '/') {
+			normalized.pop_back();
+		}
+		return normalized;
+	}
+
+	// Paths into directory mounts can't climb out of the mounted directory with ".." or replace it with a root
+	bool IsInsideDirectory(std::string_view relativePath) {
+		if (std::filesystem::path(relativePath).has_root_path()) {
+			return false;
+		}
+		size_t start = 0;
+		while (start <= relativePath.size()) {
+			const size_t end = std::min(relativePath.find('/', start), relativePath.size());
+			if (relativePath.substr(start, end - start) == "..") {
+				return false;
+			}
+			start = end + 1;
+		}
+		return true;
+	}
+}
+
+RF::VirtualFileSystem::VirtualFileSystem() = default;
+
+RF::VirtualFileSystem::~VirtualFileSystem() = default;
+
+bool RF::VirtualFileSystem::MountDirectory(const std::filesystem::path& directory, std::string_view mountPoint) {
+	std::error_code error;
+	if (!std::filesystem::is_directory(directory, error)) {
+		return false;
+	}
+
+	mMounts.push_back({ NormalizeMountPoint(mountPoint), directory, nullptr });
+	return true;
+}
+
+bool RF::VirtualFileSystem::MountPak(const std::filesystem::path& pakPath, std::string_view mountPoint) {
+	auto pak = std::make_unique<PakArchive>();
+	if (!pak->Open(pakPath)) {
+		return false;
+	}
+
+	mMounts.push_back({ NormalizeMountPoint(mountPoint), {}, std::move(pak) });
+	return true;
+}
+
+size_t RF::VirtualFileSystem::MountPaksInDirectory(const std::filesystem::path& directory, std::string_view mountPoint) {
+	std::error_code error;
+	std::vector<std::filesystem::path> paks;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".pak") {
+			paks.push_back(entry.path());
+		}
+	}
+
+	std::sort(paks.begin(), paks.end());
+
+	size_t mounted = 0;
+	for (const std::filesystem::path& pak : paks) {
+		if (MountPak(pak, mountPoint)) {
+			++mounted;
+		}
+	}
+
+	return mounted;
+}
+
+void RF::VirtualFileSystem::UnmountAll() {
+	std::lock_guard lock(mLooseFilesMutex);
+	mLooseFiles.clear();
+	mMounts.clear();
+}
+
+std::span<const std::byte> RF::VirtualFileSystem::Read(std::string_view virtualPath) {
+	const std::string path = RF::Pak::NormalizePath(virtualPath);
+
+	for (auto mount = mMounts.rbegin(); mount != mMounts.rend(); ++mount) {
+		std::string_view relativePath;
+		if (!StripMountPoint(*mount, path, relativePath)) {
+			continue;
+		}
+
+		if (mount->pak) {
+			if (const PakEntry* entry = mount->pak->Find(relativePath)) {
+				return mount->pak->Read(*entry);
+			}
+			continue;
+		}
+		if (!IsInsideDirectory(relativePath)) {
+			continue;
+		}
+
+		const std::filesystem::path fullPath = mount->directory / relativePath;
+		const std::string key = fullPath.generic_string();
+
+		std::lock_guard lock(mLooseFilesMutex);
+		auto cached = mLooseFiles.find(key);
+		if (cached != mLooseFiles.end()) {
+			return cached->second->Data();
+		}
+
+		auto file = std::make_unique<MappedFile>();
+		if (!file->Open(fullPath)) {
+			continue;
+		}
+
+		const std::span<const std::byte> data = file->Data();
+		mLooseFiles.emplace(key, std::move(file));
+		return data;
+	}
+
+	return {};
+}
+
+bool RF::VirtualFileSystem::Exists(std::string_view virtualPath) const {
+	const std::string path = RF::Pak::NormalizePath(virtualPath);
+
+	for (auto mount = mMounts.rbegin(); mount != mMounts.rend(); ++mount) {
+		std::string_view relativePath;
+		if (!StripMountPoint(*mount, path, relativePath)) {
+			continue;
+		}
+
+		if (mount->pak) {
+			if (mount->pak->Find(relativePath)) {
+				return true;
+			}
+			continue;
+		}
+		if (!IsInsideDirectory(relativePath)) {
+			continue;
+		}
+
+		std::error_code error;
+		if (std::filesystem::is_regular_file(mount->directory / relativePath, error)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool RF::VirtualFileSystem::Resolve(std::string_view virtualPath, FileLocation& location) const {
+	const std::string path = RF::Pak::NormalizePath(virtualPath);
+
+	for (auto mount = mMounts.rbegin(); mount != mMounts.rend(); ++mount) {
+		std::string_view relativePath;
+		if (!StripMountPoint(*mount, path, relativePath)) {
+			continue;
+		}
+
+		if (mount->pak) {
+			if (const PakEntry* entry = mount->pak->Find(relativePath)) {
+				location = { mount->pak->Path(), entry->offset, entry->size };
+				return true;
+			}
+			continue;
+		}
+		if (!IsInsideDirectory(relativePath)) {
+			continue;
+		}
+
+		std::error_code error;
+		const std::filesystem::path fullPath = mount->directory / relativePath;
+		const uintmax_t size = std::filesystem::file_size(fullPath, error);
+		if (!error && std::filesystem::is_regular_file(fullPath, error)) {
+			location = { fullPath, 0, static_cast<uint64_t>(size) };
+			return true;
+		}
+	}
+
+	return false;
+}
+
+size_t RF::VirtualFileSystem::MountCount() const {
+	return mMounts.size();
+}
+
+bool RF::VirtualFileSystem::StripMountPoint(const Mount& mount, std::string_view path, std::string_view& relativePath) {
+	if (mount.mountPoint.empty()) {
+		relativePath = path;
+		return true;
+	}
+
+	const std::string_view mountPoint = mount.mountPoint;
+	if (path.size() <= mountPoint.size() || path.substr(0, mountPoint.size()) != mountPoint || path[mountPoint.size()] != '/') {
+		return false;
+	}
+
+	relativePath = path.substr(mountPoint.size() + 1);
+	return true;
+}
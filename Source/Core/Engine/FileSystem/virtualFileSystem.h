@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace RF {
+	class MappedFile;
+	class PakArchive;
+
+	// Where the bytes of a virtual file live on disk
+	struct FileLocation {
+		std::filesystem::path file = {};
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	/// <summary>
+	/// Serves files from a stack of mounted directories and pak archives.
+	/// Mounts are overlays, a file in a later mount shadows the same path in earlier ones, so patches are mounted last.
+	/// Reads are views into memory mapped files and stay valid until UnmountAll() or destruction.
+	/// Mounting is not thread safe, reading from several threads is.
+	/// </summary>
+	class VirtualFileSystem {
+	public:
+		VirtualFileSystem();
+		~VirtualFileSystem();
+		VirtualFileSystem(const VirtualFileSystem&) = delete;
+		void operator=(const VirtualFileSystem&) = delete;
+
+		/// <param name="mountPoint">Virtual folder the content shows up under, empty for the root.</param>
+		bool MountDirectory(const std::filesystem::path& directory, std::string_view mountPoint = "");
+		bool MountPak(const std::filesystem::path& pakPath, std::string_view mountPoint = "");
+
+		/// <summary>
+		/// Mounts every .pak file in a directory in name order, so "base.pak" comes before "patch01.pak".
+		/// </summary>
+		/// <returns>Number of mounted archives.</returns>
+		size_t MountPaksInDirectory(const std::filesystem::path& directory, std::string_view mountPoint = "");
+
+		void UnmountAll();
+
+		/// <returns>A view of the file contents, empty if the file doesn't exist.</returns>
+		std::span<const std::byte> Read(std::string_view virtualPath);
+		bool Exists(std::string_view virtualPath) const;
+
+		/// <summary>
+		/// Finds the physical file and byte range behind a virtual path, for reading it with an AsyncFileBackend instead of the mapping.
+		/// </summary>
+		bool Resolve(std::string_view virtualPath, FileLocation& location) const;
+
+		size_t MountCount() const;
+
+	private:
+		struct Mount {
+			std::string mountPoint;
+			std::filesystem::path directory;
+			std::unique_ptr<PakArchive> pak;
+		};
+
+		static bool StripMountPoint(const Mount& mount, std::string_view path, std::string_view& relativePath);
+
+		std::vector<Mount> mMounts;
+
+		// Loose files are mapped on first read and kept so the returned views stay valid
+		std::unordered_map<std::string, std::unique_ptr<MappedFile>> mLooseFiles;
+		mutable std::mutex mLooseFilesMutex;
+	};
+}
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "jobSystem.h"
+
+namespace {
+	thread_local unsigned int gThreadIndex = 0;
+}
+
+RF::JobSystem::JobSystem(const unsigned int workerCount) {
+	unsigned int count = workerCount;
+	if (count == 0) {
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		count = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mWorkers.reserve(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		mWorkers.emplace_back([this, i]() { WorkerLoop(i + 1); });
+	}
+}
+
+RF::JobSystem::~JobSystem() {
+	{
+		std::lock_guard lock(mQueueMutex);
+		mIsRunning = false;
+	}
+	mQueueCondition.notify_all();
+
+	for (std::thread& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+void RF::JobSystem::Run(Job job, JobCounter* counter) {
+	if (counter) {
+		counter->Add(1);
+	}
+
+	{
+		std::lock_guard lock(mQueueMutex);
+		mQueue.push_back({ std::move(job), counter });
+	}
+	mQueueCondition.notify_one();
+}
+
+void RF::JobSystem::Wait(const JobCounter& counter) {
+	while (!counter.IsDone()) {
+		if (!TryRunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool RF::JobSystem::TryRunPendingJob() {
+	QueuedJob queuedJob;
+	{
+		std::lock_guard lock(mQueueMutex);
+		if (mQueue.empty()) {
+			return false;
+		}
+
+		queuedJob = std::move(mQueue.front());
+		mQueue.pop_front();
+	}
+
+	Execute(queuedJob);
+	return true;
+}
+
+void RF::JobSystem::ParallelFor(const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+	if (count == 0) {
+		return;
+	}
+
+	const size_t batch = batchSize > 0 ? batchSize : 1;
+	if (count <= batch) {
+		func(0, count);
+		return;
+	}
+
+	// The first batch is kept for the calling thread so it does useful work before waiting
+	JobCounter counter;
+	for (size_t begin = batch; begin < count; begin += batch) {
+		const size_t end = begin + batch < count ? begin + batch : count;
+		Run([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+
+	func(0, batch);
+	Wait(counter);
+}
+
+unsigned int RF::JobSystem::WorkerCount() const {
+	return static_cast<unsigned int>(mWorkers.size());
+}
+
+unsigned int RF::JobSystem::CurrentThreadIndex() {
+	return gThreadIndex;
+}
+
+void RF::JobSystem::WorkerLoop(const unsigned int threadIndex) {
+	gThreadIndex = threadIndex;
+
+	while (true) {
+		QueuedJob queuedJob;
+		{
+			std::unique_lock lock(mQueueMutex);
+			mQueueCondition.wait(lock, [this]() { return !mIsRunning || !mQueue.empty(); });
+
+			if (mQueue.empty()) {
+				return;
+			}
+
+			queuedJob = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		Execute(queuedJob);
+	}
+}
+
+void RF::JobSystem::Execute(QueuedJob& queuedJob) {
+	queuedJob.job();
+
+	if (queuedJob.counter) {
+		queuedJob.counter->Decrement();
+	}
+}
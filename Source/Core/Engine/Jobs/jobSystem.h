@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RF {
+	using Job = std::function<void()>;
+
+	/// <summary>
+	/// Counts outstanding jobs. A counter is done when it reaches zero.
+	/// </summary>
+	class JobCounter {
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		void operator=(const JobCounter&) = delete;
+
+		void Add(const int amount) { mValue.fetch_add(amount, std::memory_order_relaxed); }
+		void Decrement() { mValue.fetch_sub(1, std::memory_order_acq_rel); }
+
+		int Value() const { return mValue.load(std::memory_order_acquire); }
+		bool IsDone() const { return Value() == 0; }
+
+	private:
+		std::atomic<int> mValue = 0;
+	};
+
+	/// <summary>
+	/// Fixed pool of worker threads pulling jobs from a shared queue.
+	/// Threads that wait on a counter help out by running queued jobs instead of sleeping.
+	/// </summary>
+	class JobSystem {
+	public:
+		/// <param name="workerCount">Number of worker threads, 0 picks hardware threads - 1.</param>
+		explicit JobSystem(const unsigned int workerCount = 0);
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		void operator=(const JobSystem&) = delete;
+
+		void Run(Job job, JobCounter* counter = nullptr);
+		void Wait(const JobCounter& counter);
+
+		/// <summary>
+		/// Pops and runs one queued job on the calling thread.
+		/// </summary>
+		/// <returns>False if the queue was empty.</returns>
+		bool TryRunPendingJob();
+
+		/// <summary>
+		/// Splits [0, count) into batches of batchSize and runs them across the workers.
+		/// Blocks until every batch is done, the calling thread runs batches as well.
+		/// </summary>
+		void ParallelFor(const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func);
+
+		unsigned int WorkerCount() const;
+
+		/// <summary>
+		/// 0 for threads not owned by a JobSystem (e.g. the main thread), 1..WorkerCount() for workers.
+		/// </summary>
+		static unsigned int CurrentThreadIndex();
+
+	private:
+		struct QueuedJob {
+			Job job;
+			JobCounter* counter = nullptr;
+		};
+
+		void WorkerLoop(const unsigned int threadIndex);
+		static void Execute(QueuedJob& queuedJob);
+
+		std::vector<std::thread> mWorkers;
+		std::deque<QueuedJob> mQueue;
+		std::mutex mQueueMutex;
+		std::condition_variable mQueueCondition;
+		bool mIsRunning = true;
+	};
+}
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "tickLodScheduler.h"
+
+#include <algorithm>
+
+RF::TickLodScheduler::TickLodScheduler(const TickLodSettings& settings) : mSettings(settings) {
+	assert(BucketCount() <= gMaxBuckets && "TickLodSettings has too many buckets");
+	assert(std::is_sorted(mSettings.bucketDistances.begin(), mSettings.bucketDistances.end()) && "TickLodSettings bucketDistances aren't sorted");
+	assert(mSettings.maxVisibleBucket < BucketCount() && "TickLodSettings maxVisibleBucket is out of range");
+	mLists.resize(FirstList(static_cast<uint32_t>(BucketCount())));
+}
+
+RF::TickLodId RF::TickLodScheduler::Add(const uint32_t userData) {
+	TickLodId id = static_cast<TickLodId>(mEntities.size());
+	if (mFreeIds.empty()) {
+		mEntities.push_back({});
+	}
+	else {
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+
+	Entity& entity = mEntities[id];
+	entity.userData = userData;
+	entity.lastTickTime = mTime;
+	entity.isAlive = true;
+	Insert(id, 0);
+	return id;
+}
+
+void RF::TickLodScheduler::Remove(const TickLodId id) {
+	assert(mEntities[id].isAlive && "TickLodScheduler::Remove on a removed id");
+	Erase(id);
+	mEntities[id].isAlive = false;
+	mFreeIds.push_back(id);
+}
+
+void RF::TickLodScheduler::SetLod(const TickLodId id, const float distance, const bool isVisible) {
+	const uint32_t current = mEntities[id].bucket;
+	uint32_t bucket = BucketFor(distance);
+	if (bucket > current) {
+		bucket = std::max(current, BucketFor(distance - mSettings.hysteresis));
+	}
+	if (isVisible) {
+		bucket = std::min(bucket, mSettings.maxVisibleBucket);
+	}
+	if (bucket != current) {
+		Erase(id);
+		Insert(id, bucket);
+	}
+}
+
+std::span<const RF::TickLodItem> RF::TickLodScheduler::Tick(const float deltaTime) {
+	mTime += deltaTime;
+	mDue.clear();
+	for (uint32_t bucket = 0; bucket < BucketCount(); ++bucket) {
+		const uint32_t frame = static_cast<uint32_t>(mFrame & ((1u << bucket) - 1));
+		for (const TickLodId id : mLists[FirstList(bucket) + frame]) {
+			Entity& entity = mEntities[id];
+			mDue.push_back({ id, entity.userData, static_cast<float>(mTime - entity.lastTickTime) });
+			entity.lastTickTime = mTime;
+		}
+	}
+	++mFrame;
+	return mDue;
+}
+
+size_t RF::TickLodScheduler::CountInBucket(const uint32_t bucket) const {
+	size_t count = 0;
+	for (uint32_t list = FirstList(bucket); list < FirstList(bucket + 1); ++list) {
+		count += mLists[list].size();
+	}
+	return count;
+}
+
+uint32_t RF::TickLodScheduler::BucketFor(const float distance) const {
+	const auto& distances = mSettings.bucketDistances;
+	return static_cast<uint32_t>(std::lower_bound(distances.begin(), distances.end(), distance) - distances.begin());
+}
+
+void RF::TickLodScheduler::Insert(const TickLodId id, const uint32_t bucket) {
+	// The frame of the cycle with the fewest entities, so every frame gets the same share of the bucket
+	uint32_t list = FirstList(bucket);
+	for (uint32_t candidate = list + 1; candidate < FirstList(bucket + 1); ++candidate) {
+		if (mLists[candidate].size() < mLists[list].size()) {
+			list = candidate;
+		}
+	}
+
+	Entity& entity = mEntities[id];
+	entity.bucket = bucket;
+	entity.list = list;
+	entity.listIndex = static_cast<uint32_t>(mLists[list].size());
+	mLists[list].push_back(id);
+}
+
+void RF::TickLodScheduler::Erase(const TickLodId id) {
+	const Entity& entity = mEntities[id];
+	std::vector<TickLodId>& list = mLists[entity.list];
+	// The last entity of the list takes the erased one's place
+	const TickLodId moved = list.back();
+	list[entity.listIndex] = moved;
+	mEntities[moved].listIndex = entity.listIndex;
+	list.pop_back();
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace RF {
+	using TickLodId = uint32_t;
+
+	struct TickLodSettings {
+		// Upper distance of every bucket but the last, bucket i ticks every 2^i frames
+		std::vector<float> bucketDistances = { 25.0f, 50.0f, 100.0f };
+		// Slowest bucket entities on screen can be in
+		uint32_t maxVisibleBucket = 0;
+		// How far past a bucket's distance an entity has to be before it moves to a slower bucket, so entities at
+		// the boundary don't flip every frame
+		float hysteresis = 2.0f;
+	};
+
+	// An entity due this frame, and the time since it last ticked
+	struct TickLodItem {
+		TickLodId id = 0;
+		uint32_t userData = 0;
+		float deltaTime = 0.0f;
+	};
+
+	/// <summary>
+	/// Ticks far and off screen entities less often. Entities go into rate buckets by distance and visibility, bucket i
+	/// ticks every 2^i frames, and each bucket's entities are spread over those frames by giving every new member the
+	/// least used frame of the cycle, so the work per frame stays flat instead of spiking. A ticking entity gets all
+	/// the time since its last tick, so rate changes don't speed up or slow down its simulation. Ids are reused after
+	/// Remove().
+	/// </summary>
+	class TickLodScheduler {
+	public:
+		explicit TickLodScheduler(const TickLodSettings& settings = {});
+		TickLodScheduler(const TickLodScheduler&) = delete;
+		void operator=(const TickLodScheduler&) = delete;
+
+		// New entities tick every frame until their first SetLod()
+		TickLodId Add(const uint32_t userData = 0);
+		void Remove(const TickLodId id);
+
+		/// <summary>
+		/// Moves the entity to the bucket for its distance from the camera or player. A faster bucket applies right
+		/// away, a slower one only once distance is past the current bucket's by the hysteresis.
+		/// </summary>
+		void SetLod(const TickLodId id, const float distance, const bool isVisible);
+
+		/// <summary>
+		/// Advances time by deltaTime and returns the entities due this frame, valid until the next call.
+		/// </summary>
+		std::span<const TickLodItem> Tick(const float deltaTime);
+
+		uint32_t GetBucket(const TickLodId id) const { return mEntities[id].bucket; }
+		size_t Count() const { return mEntities.size() - mFreeIds.size(); }
+		size_t BucketCount() const { return mSettings.bucketDistances.size() + 1; }
+		size_t CountInBucket(const uint32_t bucket) const;
+
+		static constexpr uint32_t gMaxBuckets = 8;
+
+	private:
+		struct Entity {
+			uint32_t userData = 0;
+			uint32_t bucket = 0;
+			// Index of the entity's list, the bucket's frame it ticks on
+			uint32_t list = 0;
+			// Index in that list
+			uint32_t listIndex = 0;
+			double lastTickTime = 0.0;
+			bool isAlive = false;
+		};
+
+		// Bucket i has 2^i lists, one for each frame of its cycle, stored after the lists of the faster buckets
+		static uint32_t FirstList(const uint32_t bucket) { return (1u << bucket) - 1; }
+		uint32_t BucketFor(const float distance) const;
+		void Insert(const TickLodId id, const uint32_t bucket);
+		void Erase(const TickLodId id);
+
+		TickLodSettings mSettings;
+		std::vector<Entity> mEntities;
+		std::vector<TickLodId> mFreeIds;
+		std::vector<std::vector<TickLodId>> mLists;
+		std::vector<TickLodItem> mDue;
+		uint64_t mFrame = 0;
+		double mTime = 0.0;
+	};
+}
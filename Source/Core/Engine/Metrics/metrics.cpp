@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#include "metrics.h"
+#include "Util/jsonUtil.h"
+
+#include <algorithm>
+
+RF::Metrics::Metrics(const size_t samplesPerStat) : mSamplesPerStat(samplesPerStat > 0 ? samplesPerStat : 1) {}
+
+void RF::Metrics::Record(std::string_view name, const double value) {
+	std::lock_guard lock(mMutex);
+	Stat& stat = mStats[std::string(name)];
+
+	stat.min = stat.count == 0 ? value : std::min(stat.min, value);
+	stat.max = stat.count == 0 ? value : std::max(stat.max, value);
+	stat.sum += value;
+	stat.last = value;
+	++stat.count;
+
+	// Ring buffer of recent samples for the percentiles
+	if (stat.recent.size() < mSamplesPerStat) {
+		stat.recent.push_back(value);
+	}
+	else {
+		stat.recent[stat.nextRecent] = value;
+		stat.nextRecent = (stat.nextRecent + 1) % mSamplesPerStat;
+	}
+}
+
+void RF::Metrics::Increment(std::string_view name, const int64_t amount) {
+	std::lock_guard lock(mMutex);
+	mCounters[std::string(name)] += amount;
+}
+
+RF::MetricSummary RF::Metrics::Summarize(std::string_view name) const {
+	std::lock_guard lock(mMutex);
+	auto it = mStats.find(std::string(name));
+	if (it == mStats.end()) {
+		return {};
+	}
+
+	return Summarize(it->second);
+}
+
+int64_t RF::Metrics::Counter(std::string_view name) const {
+	std::lock_guard lock(mMutex);
+	auto it = mCounters.find(std::string(name));
+	return it != mCounters.end() ? it->second : 0;
+}
+
+nlohmann::json RF::Metrics::BuildReport() const {
+	std::lock_guard lock(mMutex);
+	nlohmann::json report;
+
+	nlohmann::json stats = nlohmann::json::object();
+	for (const auto& [name, stat] : mStats) {
+		const MetricSummary summary = Summarize(stat);
+		stats[name] = {
+			{ "count", summary.count },
+			{ "min", summary.min },
+			{ "max", summary.max },
+			{ "mean", summary.mean },
+			{ "p50", summary.p50 },
+			{ "p95", summary.p95 },
+			{ "last", summary.last },
+		};
+	}
+
+	nlohmann::json counters = nlohmann::json::object();
+	for (const auto& [name, value] : mCounters) {
+		counters[name] = value;
+	}
+
+	report["stats"] = stats;
+	report["counters"] = counters;
+	return report;
+}
+
+void RF::Metrics::WriteReport(const std::string& path) const {
+	RF::Json::Serialize(path, BuildReport());
+}
+
+RF::MetricSummary RF::Metrics::Summarize(const Stat& stat) {
+	MetricSummary summary;
+	summary.count = stat.count;
+	summary.min = stat.min;
+	summary.max = stat.max;
+	summary.last = stat.last;
+	summary.mean = stat.count > 0 ? stat.sum / static_cast<double>(stat.count) : 0.0;
+
+	if (stat.recent.empty()) {
+		return summary;
+	}
+
+	std::vector<double> sorted = stat.recent;
+	std::sort(sorted.begin(), sorted.end());
+	auto percentile = [&sorted](const double fraction) {
+		const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+		return sorted[index];
+	};
+
+	summary.p50 = percentile(0.50);
+	summary.p95 = percentile(0.95);
+	return summary;
+}
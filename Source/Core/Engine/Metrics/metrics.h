@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace RF {
+	struct MetricSummary {
+		uint64_t count = 0;
+		double min = 0.0;
+		double max = 0.0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double last = 0.0;
+	};
+
+	/// <summary>
+	/// Thread safe named samples (timings, sizes) and counters. Percentiles are taken
+	/// over the most recent samples, count/min/max/mean over everything recorded.
+	/// </summary>
+	class Metrics {
+	public:
+		explicit Metrics(const size_t samplesPerStat = 1024);
+
+		void Record(std::string_view name, const double value);
+		void Increment(std::string_view name, const int64_t amount = 1);
+
+		MetricSummary Summarize(std::string_view name) const;
+		int64_t Counter(std::string_view name) const;
+
+		nlohmann::json BuildReport() const;
+		void WriteReport(const std::string& path) const;
+
+	private:
+		struct Stat {
+			uint64_t count = 0;
+			double sum = 0.0;
+			double min = 0.0;
+			double max = 0.0;
+			double last = 0.0;
+			std::vector<double> recent;
+			size_t nextRecent = 0;
+		};
+
+		static MetricSummary Summarize(const Stat& stat);
+
+		const size_t mSamplesPerStat;
+		std::unordered_map<std::string, Stat> mStats;
+		std::unordered_map<std::string, int64_t> mCounters;
+		mutable std::mutex mMutex;
+	};
+}
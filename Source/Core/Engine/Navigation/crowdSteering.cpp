@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "crowdSteering.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+	// Below this squared length a vector has no usable direction
+	constexpr float gEpsilonSquared = 1e-12f;
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	Vector2 ClampLength(const Vector2& vector, const float maxLength) {
+		const float lengthSquared = vector.LengthSquared();
+		return lengthSquared > maxLength * maxLength ? vector * (maxLength / std::sqrt(lengthSquared)) : vector;
+	}
+}
+
+RF::CrowdSteering::CrowdSteering(const SteeringSettings& settings, JobSystem* jobSystem)
+	: mSettings(settings), mJobSystem(jobSystem),
+	mAgentGrid(std::max(settings.separationRadius, settings.alignmentRadius), jobSystem),
+	mObstacleGrid(std::max(1.0f, settings.maxSpeed * settings.lookAheadTime)) {}
+
+void RF::CrowdSteering::SetObstacles(std::span<const float> xs, std::span<const float> ys, std::span<const float> radii) {
+	assert(xs.size() == ys.size() && xs.size() == radii.size() && "CrowdSteering obstacle spans have different sizes");
+	mObstacleGrid.Build(xs, ys);
+	mObstacleRadii.assign(radii.begin(), radii.end());
+	mMaxObstacleRadius = radii.empty() ? 0.0f : *std::max_element(radii.begin(), radii.end());
+}
+
+void RF::CrowdSteering::Update(const CrowdAgents& agents, const Vector2& target, const float deltaTime) {
+	const size_t count = agents.xs.size();
+	assert(agents.ys.size() == count && agents.velocityXs.size() == count && agents.velocityYs.size() == count && "CrowdSteering agent spans have different sizes");
+	assert((agents.directionXs.empty() || (agents.directionXs.size() == count && agents.directionYs.size() == count)) && "CrowdSteering direction spans don't match the agents");
+
+	mAgentGrid.Build(agents.xs, agents.ys);
+	mNextVelocityXs.resize(count);
+	mNextVelocityYs.resize(count);
+	ParallelFor(mJobSystem, count, gAgentsPerJob, [this, &agents, &target, deltaTime](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const Vector2 velocity(agents.velocityXs[i], agents.velocityYs[i]);
+			const Vector2 next = ClampLength(velocity + Steer(agents, i, target) * deltaTime, mSettings.maxSpeed);
+			mNextVelocityXs[i] = next.x;
+			mNextVelocityYs[i] = next.y;
+		}
+	});
+
+	// Every agent has been steered, positions and velocities can change now
+	ParallelFor(mJobSystem, count, gAgentsPerJob, [this, &agents, deltaTime](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			agents.velocityXs[i] = mNextVelocityXs[i];
+			agents.velocityYs[i] = mNextVelocityYs[i];
+			agents.xs[i] += mNextVelocityXs[i] * deltaTime;
+			agents.ys[i] += mNextVelocityYs[i] * deltaTime;
+		}
+	});
+}
+
+Vector2 RF::CrowdSteering::Steer(const CrowdAgents& agents, const size_t agent, const Vector2& target) const {
+	const Vector2 position(agents.xs[agent], agents.ys[agent]);
+	const Vector2 velocity(agents.velocityXs[agent], agents.velocityYs[agent]);
+
+	Vector2 desired;
+	if (!agents.directionXs.empty()) {
+		desired = Vector2(agents.directionXs[agent], agents.directionYs[agent]) * mSettings.maxSpeed;
+	}
+	else {
+		const Vector2 offset = target - position;
+		const float distanceSquared = offset.LengthSquared();
+		// Slows down inside the arrival radius instead of overshooting the target
+		const float distance = std::sqrt(distanceSquared);
+		desired = distance > 0.0f ? offset * (mSettings.maxSpeed * std::min(1.0f, distance / mSettings.arrivalRadius) / distance) : Vector2::Zero;
+	}
+	Vector2 force = (desired - velocity) * mSettings.seekWeight;
+
+	// One lookup covers both neighbourhoods
+	const float separationSquared = mSettings.separationRadius * mSettings.separationRadius;
+	const float alignmentSquared = mSettings.alignmentRadius * mSettings.alignmentRadius;
+	const float inverseSeparation = 1.0f / mSettings.separationRadius;
+	const uint32_t self = static_cast<uint32_t>(agent);
+	Vector2 separation;
+	Vector2 alignment;
+	int alignmentCount = 0;
+	mAgentGrid.ForEachInRadius(position, std::max(mSettings.separationRadius, mSettings.alignmentRadius), [&agents, &position, self, separationSquared, alignmentSquared, inverseSeparation, &separation, &alignment, &alignmentCount](const uint32_t id, const float x, const float y) {
+		if (id == self) {
+			return;
+		}
+
+		const float dx = position.x - x;
+		const float dy = position.y - y;
+		const float distanceSquared = dx * dx + dy * dy;
+		if (distanceSquared < separationSquared) {
+			if (distanceSquared > gEpsilonSquared) {
+				// Falls off linearly from 1 when touching to 0 at the separation radius
+				const float distance = std::sqrt(distanceSquared);
+				const float push = (1.0f - distance * inverseSeparation) / distance;
+				separation.x += dx * push;
+				separation.y += dy * push;
+			}
+			else {
+				// Agents on the same spot split along x, the lower id to the left
+				separation.x += id < self ? 1.0f : -1.0f;
+			}
+		}
+
+		if (distanceSquared < alignmentSquared) {
+			alignment.x += agents.velocityXs[id];
+			alignment.y += agents.velocityYs[id];
+			++alignmentCount;
+		}
+	});
+
+	force += separation * (mSettings.separationWeight * mSettings.maxSpeed);
+	if (alignmentCount > 0) {
+		force += (alignment / static_cast<float>(alignmentCount) - velocity) * mSettings.alignmentWeight;
+	}
+	force += Avoid(position, velocity) * mSettings.avoidanceWeight;
+	return ClampLength(force, mSettings.maxForce);
+}
+
+Vector2 RF::CrowdSteering::Avoid(const Vector2& position, const Vector2& velocity) const {
+	const Vector2 ahead = velocity * mSettings.lookAheadTime;
+	const float aheadSquared = ahead.LengthSquared();
+	if (mObstacleRadii.empty() || aheadSquared <= gEpsilonSquared) {
+		return Vector2::Zero;
+	}
+
+	// Obstacles that can touch the path from position to position + ahead
+	const float reach = 0.5f * std::sqrt(aheadSquared) + mMaxObstacleRadius + mSettings.agentRadius;
+	float closest = 2.0f;
+	Vector2 away;
+	// Right of the heading, obstacles are passed on the side away from their center, head-on ones on the right
+	const Vector2 side = Vector2(ahead.y, -ahead.x) * (1.0f / std::sqrt(aheadSquared));
+	mObstacleGrid.ForEachInRadius(position + ahead * 0.5f, reach, [this, &position, &ahead, aheadSquared, &side, &closest, &away](const uint32_t id, const float x, const float y) {
+		const Vector2 toObstacle(x - position.x, y - position.y);
+		const float t = std::clamp(toObstacle.Dot(ahead) / aheadSquared, 0.0f, 1.0f);
+		const float clearance = mObstacleRadii[id] + mSettings.agentRadius;
+		if ((toObstacle - ahead * t).LengthSquared() >= clearance * clearance || t >= closest) {
+			return;
+		}
+
+		closest = t;
+		away = toObstacle.Dot(side) > 0.0f ? side * -1.0f : side;
+	});
+
+	// The sooner the hit, the harder the push, obstacles at the end of the look ahead still get half
+	return closest > 1.0f ? Vector2::Zero : away * (mSettings.maxSpeed * (1.0f - 0.5f * closest));
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Engine/Spatial/spatialHashGrid.h"
+#include "Math/Vector2.h"
+
+namespace RF {
+	class JobSystem;
+
+	struct SteeringSettings {
+		float maxSpeed = 6.0f;
+		// Largest change of velocity per second the weighted behaviours add up to
+		float maxForce = 30.0f;
+		float agentRadius = 0.5f;
+		// Agents closer than this push each other apart, harder the closer they are
+		float separationRadius = 1.5f;
+		// Agents closer than this match each other's velocity
+		float alignmentRadius = 3.0f;
+		// Agents seeking a target slow down within this distance of it
+		float arrivalRadius = 2.0f;
+		// How many seconds ahead agents look for obstacles
+		float lookAheadTime = 1.0f;
+
+		float seekWeight = 1.0f;
+		float separationWeight = 2.0f;
+		float alignmentWeight = 0.3f;
+		float avoidanceWeight = 3.0f;
+	};
+
+	// Agents as SoA, all spans the same length. Positions and velocities are updated in place
+	struct CrowdAgents {
+		std::span<float> xs;
+		std::span<float> ys;
+		std::span<float> velocityXs;
+		std::span<float> velocityYs;
+		// Optional unit directions to follow instead of seeking the target, e.g. sampled from a flow field
+		std::span<const float> directionXs;
+		std::span<const float> directionYs;
+	};
+
+	/// <summary>
+	/// Batched seek, separation, alignment and obstacle avoidance for large crowds. Every update builds a
+	/// SpatialHashGrid over the agents for neighbour lookups, then steers them in chunks over the job system.
+	/// Steering reads the positions and velocities the update started with and writes new velocities to a separate
+	/// buffer, and neighbours are visited in grid order, so every agent's result is the same however the chunks
+	/// were spread over threads.
+	/// </summary>
+	class CrowdSteering {
+	public:
+		explicit CrowdSteering(const SteeringSettings& settings = {}, JobSystem* jobSystem = nullptr);
+		CrowdSteering(const CrowdSteering&) = delete;
+		void operator=(const CrowdSteering&) = delete;
+
+		const SteeringSettings& GetSettings() const { return mSettings; }
+
+		/// <summary>
+		/// Replaces the static circular obstacles agents steer around.
+		/// </summary>
+		void SetObstacles(std::span<const float> xs, std::span<const float> ys, std::span<const float> radii);
+
+		/// <summary>
+		/// Steers every agent toward target, or along its direction if agents has them, then moves it by its new
+		/// velocity.
+		/// </summary>
+		void Update(const CrowdAgents& agents, const Vector2& target, const float deltaTime);
+
+		// The grid over the agents from the last update
+		const SpatialHashGrid& GetAgentGrid() const { return mAgentGrid; }
+
+		static constexpr size_t gAgentsPerJob = 256;
+
+	private:
+		Vector2 Steer(const CrowdAgents& agents, const size_t agent, const Vector2& target) const;
+		// Sideways push away from the closest obstacle the agent would run into within the look ahead time
+		Vector2 Avoid(const Vector2& position, const Vector2& velocity) const;
+
+		SteeringSettings mSettings;
+		JobSystem* mJobSystem = nullptr;
+
+		SpatialHashGrid mAgentGrid;
+		SpatialHashGrid mObstacleGrid;
+		std::vector<float> mObstacleRadii;
+		float mMaxObstacleRadius = 0.0f;
+
+		// New velocities, written while every job still reads the old ones
+		std::vector<float> mNextVelocityXs;
+		std::vector<float> mNextVelocityYs;
+	};
+}
@@ -0,0 +1,447 @@
+#include "stdafx.h"
+#include "flowField.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+	constexpr float gDiagonal = 1.41421356f;
+	constexpr float gInverseDiagonal = 0.70710678f;
+	constexpr size_t gSamplesPerJob = 1024;
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+}
+
+const std::array<Vector2i, 8> RF::FlowField::gNeighbourOffsets = {
+	Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1),
+	Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1)
+};
+
+const std::array<Vector2, 9> RF::FlowField::gDirectionVectors = {
+	Vector2(1.0f, 0.0f), Vector2(-1.0f, 0.0f), Vector2(0.0f, 1.0f), Vector2(0.0f, -1.0f),
+	Vector2(gInverseDiagonal, gInverseDiagonal), Vector2(-gInverseDiagonal, gInverseDiagonal), Vector2(gInverseDiagonal, -gInverseDiagonal), Vector2(-gInverseDiagonal, -gInverseDiagonal),
+	Vector2(0.0f, 0.0f)
+};
+
+RF::FlowField::FlowField(const Vector2i& size, const float tileSize, const Vector2& origin, JobSystem* jobSystem)
+	: mSize(size), mInverseTileSize(1.0f / tileSize), mOrigin(origin), mJobSystem(jobSystem) {
+	assert(size.x > 0 && size.y > 0 && "FlowField needs at least one tile");
+	mSectorColumns = (size.x + gSectorSize - 1) / gSectorSize;
+	mSectorRows = (size.y + gSectorSize - 1) / gSectorSize;
+
+	const size_t tileCount = static_cast<size_t>(size.x) * static_cast<size_t>(size.y);
+	mCosts.assign(tileCount, 1);
+	mIntegration.assign(tileCount, gUnreachable);
+	mPrevious.assign(tileCount, gUnreachable);
+	mDirections.assign(tileCount, gNoDirection);
+
+	const size_t sectorCount = static_cast<size_t>(mSectorColumns) * static_cast<size_t>(mSectorRows);
+	mSeeds.resize(sectorCount);
+	mWakeValues.assign(sectorCount, gUnreachable);
+	mIsDirectionDirty.assign(sectorCount, 0);
+}
+
+void RF::FlowField::SetCost(const Vector2i& tile, const uint8_t cost) {
+	assert(IsInside(tile) && "FlowField::SetCost tile outside the grid");
+	assert(cost > 0 && "FlowField costs start at 1");
+	const size_t index = Index(tile);
+	if (mCosts[index] != cost) {
+		mCostChanges.push_back({ static_cast<uint32_t>(index), mCosts[index] });
+		mCosts[index] = cost;
+	}
+}
+
+void RF::FlowField::SetGoal(const Vector2i& tile) {
+	assert(IsInside(tile) && "FlowField::SetGoal tile outside the grid");
+	if (tile != mGoal) {
+		mGoal = tile;
+		mGoalChanged = true;
+	}
+}
+
+size_t RF::FlowField::Update() {
+	if (mGoalChanged) {
+		if (!mCostChanges.empty() || !MoveGoal()) {
+			ResetAll();
+		}
+	}
+	else if (!mCostChanges.empty()) {
+		ApplyCostChanges();
+	}
+	else {
+		return 0;
+	}
+	mFieldGoal = mGoal;
+	mGoalChanged = false;
+	mCostChanges.clear();
+
+	size_t passes = 0;
+	std::vector<uint32_t> active;
+	std::vector<SectorResult> results;
+	for (;;) {
+		const float lowest = *std::min_element(mWakeValues.begin(), mWakeValues.end());
+		if (lowest == gUnreachable) {
+			break;
+		}
+		active.clear();
+		for (uint32_t sector = 0; sector < mWakeValues.size(); ++sector) {
+			if (mWakeValues[sector] <= lowest + gRoundBand) {
+				active.push_back(sector);
+				mWakeValues[sector] = gUnreachable;
+			}
+		}
+
+		results.assign(active.size(), {});
+		ParallelFor(mJobSystem, active.size(), 1, [this, &active, &results](const size_t begin, const size_t end) {
+			std::vector<WaveEntry> heap;
+			for (size_t i = begin; i < end; ++i) {
+				results[i] = RelaxSector(active[i], heap);
+			}
+		});
+		passes += active.size();
+
+		// Publishes the round's values and wakes the neighbours of sectors whose border tiles improved
+		for (size_t i = 0; i < active.size(); ++i) {
+			const uint32_t sector = active[i];
+			mSeeds[sector].clear();
+			if (!results[i].changed) {
+				continue;
+			}
+
+			const int sectorX = static_cast<int>(sector) % mSectorColumns;
+			const int sectorY = static_cast<int>(sector) / mSectorColumns;
+			const int x0 = sectorX * gSectorSize;
+			const int x1 = std::min(x0 + gSectorSize, mSize.x);
+			for (int y = sectorY * gSectorSize; y < std::min((sectorY + 1) * gSectorSize, mSize.y); ++y) {
+				const size_t row = Index(Vector2i(x0, y));
+				std::copy_n(mIntegration.data() + row, x1 - x0, mPrevious.data() + row);
+			}
+
+			for (int y = std::max(sectorY - 1, 0); y <= std::min(sectorY + 1, mSectorRows - 1); ++y) {
+				for (int x = std::max(sectorX - 1, 0); x <= std::min(sectorX + 1, mSectorColumns - 1); ++x) {
+					const size_t neighbour = static_cast<size_t>(y * mSectorColumns + x);
+					mIsDirectionDirty[neighbour] = 1;
+					Wake(neighbour, results[i].borderValues[static_cast<size_t>((y - sectorY + 1) * 3 + x - sectorX + 1)]);
+				}
+			}
+		}
+	}
+
+	active.clear();
+	for (uint32_t sector = 0; sector < mIsDirectionDirty.size(); ++sector) {
+		if (mIsDirectionDirty[sector]) {
+			active.push_back(sector);
+			mIsDirectionDirty[sector] = 0;
+		}
+	}
+	ParallelFor(mJobSystem, active.size(), 1, [this, &active](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			UpdateDirections(active[i]);
+		}
+	});
+	return passes;
+}
+
+void RF::FlowField::SampleDirections(std::span<const float> xs, std::span<const float> ys, std::span<float> directionXs, std::span<float> directionYs) const {
+	assert(xs.size() == ys.size() && xs.size() == directionXs.size() && xs.size() == directionYs.size() && "FlowField::SampleDirections spans have different sizes");
+	ParallelFor(mJobSystem, xs.size(), gSamplesPerJob, [this, &xs, &ys, &directionXs, &directionYs](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const Vector2 direction = SampleDirection(Vector2(xs[i], ys[i]));
+			directionXs[i] = direction.x;
+			directionYs[i] = direction.y;
+		}
+	});
+}
+
+bool RF::FlowField::CanStep(const Vector2i& tile, const int neighbour) const {
+	const Vector2i& offset = gNeighbourOffsets[static_cast<size_t>(neighbour)];
+	const Vector2i next = tile + offset;
+	if (!IsInside(next) || IsWall(next)) {
+		return false;
+	}
+	// Diagonal steps can't squeeze between two walls or around a wall's corner
+	return neighbour < 4 || (!IsWall(Vector2i(next.x, tile.y)) && !IsWall(Vector2i(tile.x, next.y)));
+}
+
+float RF::FlowField::StepCost(const Vector2i& tile, const int neighbour) const {
+	const float cost = static_cast<float>(mCosts[Index(tile)]);
+	return neighbour < 4 ? cost : cost * gDiagonal;
+}
+
+void RF::FlowField::Seed(const size_t index, const float value) {
+	mIntegration[index] = value;
+	mPrevious[index] = value;
+	const uint32_t sector = SectorOf(TileAt(index));
+	mSeeds[sector].push_back(static_cast<uint32_t>(index));
+	Wake(sector, value);
+}
+
+void RF::FlowField::ResetAll() {
+	std::fill(mIntegration.begin(), mIntegration.end(), gUnreachable);
+	std::fill(mPrevious.begin(), mPrevious.end(), gUnreachable);
+	std::fill(mIsDirectionDirty.begin(), mIsDirectionDirty.end(), static_cast<uint8_t>(1));
+	std::fill(mWakeValues.begin(), mWakeValues.end(), gUnreachable);
+	for (std::vector<uint32_t>& seeds : mSeeds) {
+		seeds.clear();
+	}
+	if (!IsWall(mGoal)) {
+		Seed(Index(mGoal), 0.0f);
+	}
+}
+
+bool RF::FlowField::MoveGoal() {
+	if (IsWall(mGoal) || !IsReachable(mGoal) || !IsReachable(mFieldGoal)) {
+		return false;
+	}
+
+	// Walking the old directions from the new goal to the old one, backwards, is a way from the old goal to the new
+	// one. Every tile's old value plus its cost is then the cost of a real path to the new goal, so the new goal's
+	// wave only has to lower values, and stops at the tiles that are no closer to it than through the old goal.
+	float moveCost = 0.0f;
+	Vector2i tile = mGoal;
+	for (size_t step = 0; tile != mFieldGoal; ++step) {
+		const uint8_t direction = mDirections[Index(tile)];
+		if (direction == gNoDirection || step == mIntegration.size()) {
+			return false;
+		}
+		tile += gNeighbourOffsets[direction];
+		moveCost += StepCost(tile, direction);
+	}
+
+	// Directions stay the same where values only went up by moveCost, the old goal gets one now
+	for (size_t index = 0; index < mIntegration.size(); ++index) {
+		mIntegration[index] += moveCost;
+	}
+	mPrevious = mIntegration;
+	mIsDirectionDirty[SectorOf(mFieldGoal)] = 1;
+	Seed(Index(mGoal), 0.0f);
+	return true;
+}
+
+void RF::FlowField::ApplyCostChanges() {
+	const size_t goal = Index(mGoal);
+	auto markDirectionsAround = [this](const Vector2i& tile) {
+		const int sectorX = tile.x / gSectorSize;
+		const int sectorY = tile.y / gSectorSize;
+		for (int y = std::max(sectorY - 1, 0); y <= std::min(sectorY + 1, mSectorRows - 1); ++y) {
+			for (int x = std::max(sectorX - 1, 0); x <= std::min(sectorX + 1, mSectorColumns - 1); ++x) {
+				mIsDirectionDirty[static_cast<size_t>(y * mSectorColumns + x)] = 1;
+			}
+		}
+	};
+
+	// More expensive tiles invalidate every tile whose path went through them, new walls also the diagonal steps
+	// around their corners
+	std::vector<uint32_t> invalid;
+	std::vector<uint32_t> cheaper;
+	for (const auto& [index, oldCost] : mCostChanges) {
+		const Vector2i tile = TileAt(index);
+		markDirectionsAround(tile);
+		if (mCosts[index] < oldCost) {
+			cheaper.push_back(index);
+			continue;
+		}
+
+		if (index == goal) {
+			// The goal's own cost doesn't count, unless it became unreachable
+			if (IsWall(mGoal)) {
+				ResetAll();
+				return;
+			}
+			continue;
+		}
+
+		invalid.push_back(index);
+		if (!IsWall(tile)) {
+			continue;
+		}
+		for (const Vector2i& offset : gNeighbourOffsets) {
+			const Vector2i from = tile + offset;
+			if (!IsInside(from)) {
+				continue;
+			}
+			const uint8_t direction = mDirections[Index(from)];
+			if (direction >= 4 && direction != gNoDirection) {
+				const Vector2i to = from + gNeighbourOffsets[direction];
+				if (Vector2i(to.x, from.y) == tile || Vector2i(from.x, to.y) == tile) {
+					invalid.push_back(static_cast<uint32_t>(Index(from)));
+				}
+			}
+		}
+	}
+
+	// Adds the invalid tiles' subtrees in the direction field, the tiles whose step leads into an invalid tile
+	std::vector<uint8_t> isInvalid(mIntegration.size(), 0);
+	for (size_t i = 0; i < invalid.size(); ++i) {
+		const uint32_t index = invalid[i];
+		if (isInvalid[index]) {
+			continue;
+		}
+		isInvalid[index] = 1;
+		mIntegration[index] = gUnreachable;
+		mPrevious[index] = gUnreachable;
+		const Vector2i tile = TileAt(index);
+		markDirectionsAround(tile);
+		for (const Vector2i& offset : gNeighbourOffsets) {
+			const Vector2i child = tile + offset;
+			if (!IsInside(child)) {
+				continue;
+			}
+			const size_t childIndex = Index(child);
+			const uint8_t direction = mDirections[childIndex];
+			if (!isInvalid[childIndex] && direction != gNoDirection && child + gNeighbourOffsets[direction] == tile) {
+				invalid.push_back(static_cast<uint32_t>(childIndex));
+			}
+		}
+	}
+
+	// Cheapest way into a tile from the neighbours that stayed valid
+	auto bestFromNeighbours = [this](const Vector2i& tile) {
+		float best = gUnreachable;
+		for (int neighbour = 0; neighbour < gNeighbourCount; ++neighbour) {
+			if (CanStep(tile, neighbour)) {
+				best = std::min(best, mIntegration[Index(tile + gNeighbourOffsets[static_cast<size_t>(neighbour)])] + StepCost(tile, neighbour));
+			}
+		}
+		return best;
+	};
+
+	// Invalid tiles wave out again from their valid neighbours, cheaper tiles and those whose diagonals opened up
+	// from themselves
+	for (size_t index = 0; index < isInvalid.size(); ++index) {
+		if (isInvalid[index] && !IsWall(TileAt(index))) {
+			const float best = bestFromNeighbours(TileAt(index));
+			if (best != gUnreachable) {
+				Seed(index, best);
+			}
+		}
+	}
+
+	for (const uint32_t index : cheaper) {
+		const Vector2i tile = TileAt(index);
+		for (int neighbour = -1; neighbour < gNeighbourCount; ++neighbour) {
+			const Vector2i around = neighbour < 0 ? tile : tile + gNeighbourOffsets[static_cast<size_t>(neighbour)];
+			if (!IsInside(around) || IsWall(around) || Index(around) == goal) {
+				continue;
+			}
+			const float best = bestFromNeighbours(around);
+			if (best < mIntegration[Index(around)]) {
+				Seed(Index(around), best);
+			}
+		}
+	}
+}
+
+RF::FlowField::SectorResult RF::FlowField::RelaxSector(const uint32_t sector, std::vector<WaveEntry>& heap) {
+	const int x0 = static_cast<int>(sector) % mSectorColumns * gSectorSize;
+	const int y0 = static_cast<int>(sector) / mSectorColumns * gSectorSize;
+	const int x1 = std::min(x0 + gSectorSize, mSize.x);
+	const int y1 = std::min(y0 + gSectorSize, mSize.y);
+	auto isInSector = [x0, y0, x1, y1](const Vector2i& tile) { return tile.x >= x0 && tile.y >= y0 && tile.x < x1 && tile.y < y1; };
+	auto isOnBorder = [x0, y0, x1, y1](const Vector2i& tile) { return tile.x == x0 || tile.y == y0 || tile.x == x1 - 1 || tile.y == y1 - 1; };
+	// Min heap on value, ties by tile so the wavefront is the same every run
+	auto isLater = [](const WaveEntry& a, const WaveEntry& b) { return a.value > b.value || (a.value == b.value && a.tile > b.tile); };
+
+	SectorResult result;
+	heap.clear();
+	auto improve = [this, x0, y0, x1, y1, &heap, &result, &isOnBorder, &isLater](const Vector2i& tile, const float value) {
+		const size_t index = Index(tile);
+		mIntegration[index] = value;
+		heap.push_back({ value, static_cast<uint32_t>(index) });
+		std::push_heap(heap.begin(), heap.end(), isLater);
+		result.changed = true;
+		if (isOnBorder(tile)) {
+			// Only the sectors the tile touches see it
+			const int sideX = tile.x == x0 ? -1 : tile.x == x1 - 1 ? 1 : 0;
+			const int sideY = tile.y == y0 ? -1 : tile.y == y1 - 1 ? 1 : 0;
+			for (const Vector2i& side : { Vector2i(sideX, 0), Vector2i(0, sideY), Vector2i(sideX, sideY) }) {
+				if (side != Vector2i(0, 0)) {
+					float& borderValue = result.borderValues[static_cast<size_t>((side.y + 1) * 3 + side.x + 1)];
+					borderValue = std::min(borderValue, value);
+				}
+			}
+		}
+	};
+
+	for (const uint32_t seed : mSeeds[sector]) {
+		improve(TileAt(seed), mIntegration[seed]);
+	}
+
+	// Border tiles against what the neighbouring sectors had at the end of the last round
+	for (int y = y0; y < y1; ++y) {
+		for (int x = x0; x < x1; ++x) {
+			const Vector2i tile(x, y);
+			if (!isOnBorder(tile) || IsWall(tile)) {
+				continue;
+			}
+			float best = mIntegration[Index(tile)];
+			for (int neighbour = 0; neighbour < gNeighbourCount; ++neighbour) {
+				const Vector2i from = tile + gNeighbourOffsets[static_cast<size_t>(neighbour)];
+				if (!isInSector(from) && CanStep(tile, neighbour)) {
+					best = std::min(best, mPrevious[Index(from)] + StepCost(tile, neighbour));
+				}
+			}
+			if (best < mIntegration[Index(tile)]) {
+				improve(tile, best);
+			}
+		}
+	}
+
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), isLater);
+		const WaveEntry entry = heap.back();
+		heap.pop_back();
+		if (entry.value > mIntegration[entry.tile]) {
+			continue;
+		}
+
+		const Vector2i tile = TileAt(entry.tile);
+		for (int neighbour = 0; neighbour < gNeighbourCount; ++neighbour) {
+			const Vector2i next = tile + gNeighbourOffsets[static_cast<size_t>(neighbour)];
+			if (!isInSector(next) || !CanStep(tile, neighbour)) {
+				continue;
+			}
+			const float value = entry.value + StepCost(next, neighbour);
+			if (value < mIntegration[Index(next)]) {
+				improve(next, value);
+			}
+		}
+	}
+	return result;
+}
+
+void RF::FlowField::UpdateDirections(const uint32_t sector) {
+	const int x0 = static_cast<int>(sector) % mSectorColumns * gSectorSize;
+	const int y0 = static_cast<int>(sector) / mSectorColumns * gSectorSize;
+	const size_t goal = Index(mGoal);
+	for (int y = y0; y < std::min(y0 + gSectorSize, mSize.y); ++y) {
+		for (int x = x0; x < std::min(x0 + gSectorSize, mSize.x); ++x) {
+			const Vector2i tile(x, y);
+			const size_t index = Index(tile);
+			uint8_t direction = gNoDirection;
+			if (index != goal && mIntegration[index] != gUnreachable && !IsWall(tile)) {
+				// The neighbour the tile's value came from, the first one on ties
+				float best = gUnreachable;
+				for (int neighbour = 0; neighbour < gNeighbourCount; ++neighbour) {
+					if (!CanStep(tile, neighbour)) {
+						continue;
+					}
+					const float value = mIntegration[Index(tile + gNeighbourOffsets[static_cast<size_t>(neighbour)])] + StepCost(tile, neighbour);
+					if (value < best) {
+						best = value;
+						direction = static_cast<uint8_t>(neighbour);
+					}
+				}
+			}
+			mDirections[index] = direction;
+		}
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Math/Vector2.h"
+
+namespace RF {
+	class JobSystem;
+
+	/// <summary>
+	/// Flow field toward one goal tile over a grid of tiles, for crowds sharing a destination. Every tile has a cost
+	/// to walk through, the integration field holds the cheapest cost from each tile to the goal and the direction
+	/// field the neighbour to step to, so agents look their direction up in O(1) instead of searching a path.
+	/// The grid is split into square sectors processed in parallel: each round, the sectors with work near the lowest
+	/// pending value run a Dijkstra wavefront over their own tiles, seeded from what their neighbours had at the end of
+	/// the previous round, and sectors whose border tiles improved wake their neighbours. Taking sectors roughly in
+	/// value order, like delta stepping does with tiles, keeps them from running again and again on values a shorter
+	/// way around is about to beat. Rounds only read the last round's values, so the result is the same however
+	/// sectors were spread over threads.
+	/// Update() only redoes what changed: cheaper tiles wave out from themselves, tiles that got more expensive reset
+	/// just the tiles whose path went through them, and a goal move starts from the old field raised by the cost of
+	/// walking from the old goal to the new one, so only tiles the new goal is closer to wave again.
+	/// </summary>
+	class FlowField {
+	public:
+		/// <param name="tileSize">World units per tile, origin is the world position of tile (0, 0)'s corner.</param>
+		FlowField(const Vector2i& size, const float tileSize = 1.0f, const Vector2& origin = Vector2::Zero, JobSystem* jobSystem = nullptr);
+		FlowField(const FlowField&) = delete;
+		void operator=(const FlowField&) = delete;
+
+		const Vector2i& GetSize() const { return mSize; }
+		bool IsInside(const Vector2i& tile) const { return tile.x >= 0 && tile.y >= 0 && tile.x < mSize.x && tile.y < mSize.y; }
+		Vector2i TileOf(const Vector2& position) const {
+			return Vector2i(static_cast<int>(std::floor((position.x - mOrigin.x) * mInverseTileSize)), static_cast<int>(std::floor((position.y - mOrigin.y) * mInverseTileSize)));
+		}
+
+		/// <summary>
+		/// Sets how expensive a tile is to walk through, from 1 for open ground up to gWall for impassable tiles.
+		/// Takes effect on the next Update().
+		/// </summary>
+		void SetCost(const Vector2i& tile, const uint8_t cost);
+		uint8_t GetCost(const Vector2i& tile) const { return mCosts[Index(tile)]; }
+		// Takes effect on the next Update(), moves inside a tile are free. Moving it together with cost changes, or to a
+		// tile the old goal couldn't be reached from, recomputes the whole field.
+		void SetGoal(const Vector2i& tile);
+		const Vector2i& GetGoal() const { return mGoal; }
+
+		/// <summary>
+		/// Brings the integration and direction fields up to date with the costs and goal.
+		/// </summary>
+		/// <returns>Number of sector passes it took, 0 if nothing changed.</returns>
+		size_t Update();
+
+		// Cheapest cost from tile to the goal, gUnreachable if there is no way
+		float GetIntegration(const Vector2i& tile) const { return mIntegration[Index(tile)]; }
+		bool IsReachable(const Vector2i& tile) const { return mIntegration[Index(tile)] != gUnreachable; }
+		// Unit step toward the goal, zero at the goal and on tiles that can't reach it
+		Vector2 GetDirection(const Vector2i& tile) const { return gDirectionVectors[mDirections[Index(tile)]]; }
+		Vector2 SampleDirection(const Vector2& position) const {
+			const Vector2i tile = TileOf(position);
+			return IsInside(tile) ? GetDirection(tile) : Vector2::Zero;
+		}
+
+		/// <summary>
+		/// Samples the direction at every position, e.g. for CrowdAgents' directions.
+		/// </summary>
+		void SampleDirections(std::span<const float> xs, std::span<const float> ys, std::span<float> directionXs, std::span<float> directionYs) const;
+
+		static constexpr uint8_t gWall = 255;
+		static constexpr float gUnreachable = std::numeric_limits<float>::infinity();
+		static constexpr int gSectorSize = 16;
+		// Sectors woken with values up to a sector's width of open ground above the lowest one run in the same round
+		static constexpr float gRoundBand = static_cast<float>(gSectorSize);
+
+	private:
+		// Eight neighbours, orthogonal first, then the direction of "no step"
+		static constexpr int gNeighbourCount = 8;
+		static constexpr uint8_t gNoDirection = 8;
+		static const std::array<Vector2, gNeighbourCount + 1> gDirectionVectors;
+		static const std::array<Vector2i, gNeighbourCount> gNeighbourOffsets;
+
+		// What a sector's wavefront did in a round
+		struct SectorResult {
+			bool changed = false;
+			// Per neighbouring sector, 3 x 3 around this one, the lowest improved value on the border tiles next to it
+			std::array<float, 9> borderValues = { gUnreachable, gUnreachable, gUnreachable, gUnreachable, gUnreachable, gUnreachable, gUnreachable, gUnreachable, gUnreachable };
+		};
+
+		// Tentative integration value of a tile in the sector wavefront
+		struct WaveEntry {
+			float value = 0.0f;
+			uint32_t tile = 0;
+		};
+
+		size_t Index(const Vector2i& tile) const { return static_cast<size_t>(tile.y) * static_cast<size_t>(mSize.x) + static_cast<size_t>(tile.x); }
+		Vector2i TileAt(const size_t index) const { return Vector2i(static_cast<int>(index % static_cast<size_t>(mSize.x)), static_cast<int>(index / static_cast<size_t>(mSize.x))); }
+		uint32_t SectorOf(const Vector2i& tile) const { return static_cast<uint32_t>((tile.y / gSectorSize) * mSectorColumns + tile.x / gSectorSize); }
+		bool IsWall(const Vector2i& tile) const { return mCosts[Index(tile)] == gWall; }
+		// Whether a step from tile along neighbour offset n stays inside, isn't a wall and doesn't cut a wall's corner
+		bool CanStep(const Vector2i& tile, const int neighbour) const;
+		// Cost of stepping into tile from a neighbour along offset n
+		float StepCost(const Vector2i& tile, const int neighbour) const;
+
+		void Seed(const size_t index, const float value);
+		void Wake(const size_t sector, const float value) { mWakeValues[sector] = std::min(mWakeValues[sector], value); }
+		void ResetAll();
+		// Repairs the field for a goal moved since the last update, false if it has to be recomputed instead
+		bool MoveGoal();
+		void ApplyCostChanges();
+		// Runs the wavefront of one sector against the last round's values
+		SectorResult RelaxSector(const uint32_t sector, std::vector<WaveEntry>& heap);
+		void UpdateDirections(const uint32_t sector);
+
+		Vector2i mSize;
+		float mInverseTileSize = 1.0f;
+		Vector2 mOrigin;
+		JobSystem* mJobSystem = nullptr;
+		int mSectorColumns = 0;
+		int mSectorRows = 0;
+
+		std::vector<uint8_t> mCosts;
+		std::vector<float> mIntegration;
+		// The integration field as the last round left it, what sectors read their neighbours' tiles from
+		std::vector<float> mPrevious;
+		// Index into gDirectionVectors per tile
+		std::vector<uint8_t> mDirections;
+
+		Vector2i mGoal;
+		// Goal the integration field leads to
+		Vector2i mFieldGoal;
+		bool mGoalChanged = true;
+		// Tiles whose cost changed since the last update, with their cost back then
+		std::vector<std::pair<uint32_t, uint8_t>> mCostChanges;
+
+		// Per sector tiles seeded outside the wavefront, and the lowest value the sector was woken with since it last
+		// ran, gUnreachable while it has nothing to do
+		std::vector<std::vector<uint32_t>> mSeeds;
+		std::vector<float> mWakeValues;
+		std::vector<uint8_t> mIsDirectionDirty;
+	};
+}
@@ -0,0 +1,647 @@
+#include "stdafx.h"
+#include "hierarchicalPathfinder.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+	constexpr float gDiagonal = 1.41421356f;
+	constexpr float gInfinity = std::numeric_limits<float>::infinity();
+	constexpr uint32_t gNoParent = std::numeric_limits<uint32_t>::max();
+	// Walkable spans across a border shorter than this get one entrance in the middle, longer ones one at each end
+	constexpr int gEntranceSplitLength = 6;
+	constexpr size_t gClustersPerJob = 4;
+	constexpr size_t gRequestsPerJob = 2;
+
+	// Orthogonal first
+	const std::array<Vector2i, 8> gNeighbourOffsets = {
+		Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1),
+		Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1)
+	};
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	// Cheapest possible cost between two tiles, every tile costs at least 1
+	float OctileDistance(const Vector2i& a, const Vector2i& b) {
+		const int dx = std::abs(a.x - b.x);
+		const int dy = std::abs(a.y - b.y);
+		return static_cast<float>(std::max(dx, dy)) + (gDiagonal - 1.0f) * static_cast<float>(std::min(dx, dy));
+	}
+}
+
+RF::HierarchicalPathfinder::HierarchicalPathfinder(const Vector2i& size, const PathfinderSettings& settings, JobSystem* jobSystem)
+	: mSize(size), mSettings(settings), mJobSystem(jobSystem), mClusterSize(settings.clusterSize) {
+	assert(size.x > 0 && size.y > 0 && "HierarchicalPathfinder needs at least one tile");
+	assert(settings.clusterSize > 1 && "HierarchicalPathfinder clusters need at least 2 tiles per side");
+	mClusterColumns = (size.x + mClusterSize - 1) / mClusterSize;
+	mClusterRows = (size.y + mClusterSize - 1) / mClusterSize;
+	mCosts.assign(static_cast<size_t>(size.x) * static_cast<size_t>(size.y), 1);
+
+	const size_t clusterCount = static_cast<size_t>(mClusterColumns) * static_cast<size_t>(mClusterRows);
+	mClusters.resize(clusterCount);
+	for (size_t i = 0; i < clusterCount; ++i) {
+		const Vector2i min(static_cast<int>(i % static_cast<size_t>(mClusterColumns)) * mClusterSize, static_cast<int>(i / static_cast<size_t>(mClusterColumns)) * mClusterSize);
+		mClusters[i].min = min;
+		mClusters[i].max = Vector2i(std::min(min.x + mClusterSize, size.x), std::min(min.y + mClusterSize, size.y));
+	}
+	mEastTransitions.resize(clusterCount);
+	mSouthTransitions.resize(clusterCount);
+	mIsClusterDirty.assign(clusterCount, 1);
+	mNodeOffsets.assign(clusterCount, 0);
+
+	// Thread index 0 is every thread outside the job system, workers are 1..WorkerCount()
+	const unsigned int scratchCount = jobSystem ? jobSystem->WorkerCount() + 1 : 1;
+	for (unsigned int i = 0; i < scratchCount; ++i) {
+		mScratch.push_back(std::make_unique<SearchScratch>());
+	}
+}
+
+void RF::HierarchicalPathfinder::SetCost(const Vector2i& tile, const uint8_t cost) {
+	assert(IsInside(tile) && "HierarchicalPathfinder::SetCost tile outside the grid");
+	assert(cost > 0 && "HierarchicalPathfinder costs start at 1");
+	const size_t index = Index(tile);
+	if (mCosts[index] != cost) {
+		mCosts[index] = cost;
+		mIsClusterDirty[ClusterOf(tile)] = 1;
+		mIsGraphDirty = true;
+	}
+}
+
+size_t RF::HierarchicalPathfinder::UpdateGraph() {
+	if (!mIsGraphDirty) {
+		return 0;
+	}
+	mIsGraphDirty = false;
+
+	const size_t clusterCount = mClusters.size();
+	const uint32_t columns = static_cast<uint32_t>(mClusterColumns);
+	const auto markWithNeighbours = [columns](std::vector<uint8_t>& marks, const uint32_t cluster) {
+		const uint32_t x = cluster % columns;
+		marks[cluster] = 1;
+		if (x > 0) {
+			marks[cluster - 1] = 1;
+		}
+		if (x + 1 < columns) {
+			marks[cluster + 1] = 1;
+		}
+		if (cluster >= columns) {
+			marks[cluster - columns] = 1;
+		}
+		if (cluster + columns < marks.size()) {
+			marks[cluster + columns] = 1;
+		}
+	};
+
+	// A changed cluster gets new intra edges, and where its entrances moved the cluster across the border gets new nodes
+	std::vector<uint8_t> isRebuilt(clusterCount, 0);
+	for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+		if (!mIsClusterDirty[cluster]) {
+			continue;
+		}
+		isRebuilt[cluster] = 1;
+		if (UpdateEastTransitions(cluster)) {
+			isRebuilt[cluster + 1] = 1;
+		}
+		if (UpdateSouthTransitions(cluster)) {
+			isRebuilt[cluster + columns] = 1;
+		}
+		if (cluster % columns > 0 && UpdateEastTransitions(cluster - 1)) {
+			isRebuilt[cluster - 1] = 1;
+		}
+		if (cluster >= columns && UpdateSouthTransitions(cluster - columns)) {
+			isRebuilt[cluster - columns] = 1;
+		}
+	}
+
+	// Rebuilt clusters renumber their nodes and may have new border costs, so their neighbours' edges into them are relinked too
+	std::vector<uint8_t> isRelinked(clusterCount, 0);
+	std::vector<uint32_t> rebuilt;
+	for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+		if (isRebuilt[cluster]) {
+			rebuilt.push_back(cluster);
+			markWithNeighbours(isRelinked, cluster);
+		}
+	}
+	std::vector<uint32_t> relinked;
+	for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+		if (isRelinked[cluster]) {
+			relinked.push_back(cluster);
+		}
+	}
+
+	ParallelFor(mJobSystem, rebuilt.size(), gClustersPerJob, [this, &rebuilt](const size_t begin, const size_t end) {
+		SearchScratch& scratch = GetScratch();
+		for (size_t i = begin; i < end; ++i) {
+			RebuildCluster(rebuilt[i], scratch);
+		}
+	});
+	ParallelFor(mJobSystem, relinked.size(), gClustersPerJob, [this, &relinked](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			LinkCluster(relinked[i]);
+		}
+	});
+
+	mNodeClusters.clear();
+	for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+		mNodeOffsets[cluster] = static_cast<uint32_t>(mNodeClusters.size());
+		mNodeClusters.insert(mNodeClusters.end(), mClusters[cluster].nodes.size(), cluster);
+	}
+
+	InvalidateCache(mIsClusterDirty);
+	std::fill(mIsClusterDirty.begin(), mIsClusterDirty.end(), static_cast<uint8_t>(0));
+	return rebuilt.size();
+}
+
+RF::PathResult RF::HierarchicalPathfinder::FindPath(const Vector2i& start, const Vector2i& goal) {
+	assert(IsInside(start) && IsInside(goal) && "HierarchicalPathfinder::FindPath tile outside the grid");
+	UpdateGraph();
+	PathResult result;
+	result.start = start;
+	result.goal = goal;
+	const uint64_t key = CacheKey(start, goal);
+	if (!TryGetCached(key, result)) {
+		Search(start, goal, GetScratch(), result);
+		AddToCache(key, result);
+	}
+	return result;
+}
+
+RF::PathRequestId RF::HierarchicalPathfinder::Request(PathRequest request) {
+	assert(IsInside(request.start) && IsInside(request.goal) && "HierarchicalPathfinder::Request tile outside the grid");
+	const PathRequestId id = mNextId++;
+	mQueue.push_back({ id, std::move(request) });
+	return id;
+}
+
+bool RF::HierarchicalPathfinder::Cancel(const PathRequestId id) {
+	const auto found = std::find_if(mQueue.begin(), mQueue.end(), [id](const PendingPath& pending) { return pending.id == id; });
+	if (found == mQueue.end()) {
+		return false;
+	}
+	mQueue.erase(found);
+	return true;
+}
+
+size_t RF::HierarchicalPathfinder::ProcessRequests() {
+	UpdateGraph();
+	if (mQueue.empty()) {
+		return 0;
+	}
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(mSettings.frameBudgetMs));
+
+	std::vector<PendingPath> batch(std::make_move_iterator(mQueue.begin()), std::make_move_iterator(mQueue.end()));
+	mQueue.clear();
+	std::vector<PathResult> results(batch.size());
+	std::vector<uint8_t> isDone(batch.size(), 0);
+	std::vector<size_t> misses;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		PathResult& result = results[i];
+		result.id = batch[i].id;
+		result.start = batch[i].request.start;
+		result.goal = batch[i].request.goal;
+		if (TryGetCached(CacheKey(result.start, result.goal), result)) {
+			isDone[i] = 1;
+		}
+		else {
+			misses.push_back(i);
+		}
+	}
+
+	// Searches run until the budget is gone, the first miss always runs so the queue keeps moving
+	ParallelFor(mJobSystem, misses.size(), gRequestsPerJob, [this, &misses, &results, &isDone, &deadline](const size_t begin, const size_t end) {
+		SearchScratch& scratch = GetScratch();
+		for (size_t i = begin; i < end; ++i) {
+			if (i > 0 && std::chrono::steady_clock::now() >= deadline) {
+				continue;
+			}
+			PathResult& result = results[misses[i]];
+			Search(result.start, result.goal, scratch, result);
+			isDone[misses[i]] = 1;
+		}
+	});
+
+	// Callbacks may queue new requests, those go after the ones that didn't make it this frame
+	std::deque<PendingPath> remaining;
+	size_t delivered = 0;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		if (!isDone[i]) {
+			remaining.push_back(std::move(batch[i]));
+			continue;
+		}
+		if (!results[i].isCached) {
+			AddToCache(CacheKey(results[i].start, results[i].goal), results[i]);
+		}
+		if (batch[i].request.onComplete) {
+			batch[i].request.onComplete(results[i]);
+		}
+		++delivered;
+	}
+	remaining.insert(remaining.end(), std::make_move_iterator(mQueue.begin()), std::make_move_iterator(mQueue.end()));
+	mQueue.swap(remaining);
+	return delivered;
+}
+
+bool RF::HierarchicalPathfinder::FindTransitions(const Vector2i& first, const Vector2i& along, const Vector2i& across, const int length, std::vector<Transition>& transitions) const {
+	const std::vector<Transition> previous = std::move(transitions);
+	transitions.clear();
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i) {
+		const Vector2i borderTile(first.x + along.x * i, first.y + along.y * i);
+		const bool isOpen = i < length && IsOpen(borderTile) && IsOpen(borderTile + across);
+		if (isOpen && runStart < 0) {
+			runStart = i;
+		}
+		else if (!isOpen && runStart >= 0) {
+			const int runLength = i - runStart;
+			const auto addTransition = [&first, &along, &across, &transitions](const int offset) {
+				const Vector2i tile(first.x + along.x * offset, first.y + along.y * offset);
+				transitions.push_back({ tile, tile + across });
+			};
+			if (runLength < gEntranceSplitLength) {
+				addTransition(runStart + runLength / 2);
+			}
+			else {
+				addTransition(runStart);
+				addTransition(i - 1);
+			}
+			runStart = -1;
+		}
+	}
+	return transitions.size() != previous.size() || !std::equal(transitions.begin(), transitions.end(), previous.begin(), [](const Transition& a, const Transition& b) {
+		return a.first == b.first && a.second == b.second;
+	});
+}
+
+bool RF::HierarchicalPathfinder::UpdateEastTransitions(const uint32_t cluster) {
+	const Cluster& bounds = mClusters[cluster];
+	if (bounds.max.x >= mSize.x) {
+		return false;
+	}
+	return FindTransitions(Vector2i(bounds.max.x - 1, bounds.min.y), Vector2i(0, 1), Vector2i(1, 0), bounds.max.y - bounds.min.y, mEastTransitions[cluster]);
+}
+
+bool RF::HierarchicalPathfinder::UpdateSouthTransitions(const uint32_t cluster) {
+	const Cluster& bounds = mClusters[cluster];
+	if (bounds.max.y >= mSize.y) {
+		return false;
+	}
+	return FindTransitions(Vector2i(bounds.min.x, bounds.max.y - 1), Vector2i(1, 0), Vector2i(0, 1), bounds.max.x - bounds.min.x, mSouthTransitions[cluster]);
+}
+
+void RF::HierarchicalPathfinder::RebuildCluster(const uint32_t cluster, SearchScratch& scratch) {
+	Cluster& rebuilt = mClusters[cluster];
+	const uint32_t columns = static_cast<uint32_t>(mClusterColumns);
+	rebuilt.nodes.clear();
+	const auto addNode = [&rebuilt](const Vector2i& tile) {
+		const bool isKnown = std::any_of(rebuilt.nodes.begin(), rebuilt.nodes.end(), [&tile](const AbstractNode& node) { return node.tile == tile; });
+		if (!isKnown) {
+			rebuilt.nodes.push_back({ tile, {}, {} });
+		}
+	};
+	if (cluster % columns > 0) {
+		for (const Transition& transition : mEastTransitions[cluster - 1]) {
+			addNode(transition.second);
+		}
+	}
+	for (const Transition& transition : mEastTransitions[cluster]) {
+		addNode(transition.first);
+	}
+	if (cluster >= columns) {
+		for (const Transition& transition : mSouthTransitions[cluster - columns]) {
+			addNode(transition.second);
+		}
+	}
+	for (const Transition& transition : mSouthTransitions[cluster]) {
+		addNode(transition.first);
+	}
+
+	for (uint32_t from = 0; from < rebuilt.nodes.size(); ++from) {
+		SearchCluster(rebuilt, rebuilt.nodes[from].tile, nullptr, false, scratch);
+		for (uint32_t to = 0; to < rebuilt.nodes.size(); ++to) {
+			const float cost = scratch.localCosts[LocalIndex(rebuilt, rebuilt.nodes[to].tile)];
+			if (to != from && cost != gInfinity) {
+				rebuilt.nodes[from].intraEdges.push_back({ cluster, to, cost });
+			}
+		}
+	}
+}
+
+void RF::HierarchicalPathfinder::LinkCluster(const uint32_t cluster) {
+	Cluster& linked = mClusters[cluster];
+	const uint32_t columns = static_cast<uint32_t>(mClusterColumns);
+	for (AbstractNode& node : linked.nodes) {
+		node.interEdges.clear();
+	}
+	// Crossing a border is an orthogonal step into the other side's tile
+	const auto link = [this, cluster, &linked](const Vector2i& own, const uint32_t otherCluster, const Vector2i& other) {
+		const uint32_t otherNode = FindNode(otherCluster, other);
+		linked.nodes[FindNode(cluster, own)].interEdges.push_back({ otherCluster, otherNode, static_cast<float>(mCosts[Index(other)]) });
+	};
+	if (cluster % columns > 0) {
+		for (const Transition& transition : mEastTransitions[cluster - 1]) {
+			link(transition.second, cluster - 1, transition.first);
+		}
+	}
+	for (const Transition& transition : mEastTransitions[cluster]) {
+		link(transition.first, cluster + 1, transition.second);
+	}
+	if (cluster >= columns) {
+		for (const Transition& transition : mSouthTransitions[cluster - columns]) {
+			link(transition.second, cluster - columns, transition.first);
+		}
+	}
+	for (const Transition& transition : mSouthTransitions[cluster]) {
+		link(transition.first, cluster + columns, transition.second);
+	}
+}
+
+uint32_t RF::HierarchicalPathfinder::FindNode(const uint32_t cluster, const Vector2i& tile) const {
+	const std::vector<AbstractNode>& nodes = mClusters[cluster].nodes;
+	const auto found = std::find_if(nodes.begin(), nodes.end(), [&tile](const AbstractNode& node) { return node.tile == tile; });
+	assert(found != nodes.end() && "HierarchicalPathfinder transition without a node");
+	return static_cast<uint32_t>(found - nodes.begin());
+}
+
+void RF::HierarchicalPathfinder::SearchCluster(const Cluster& cluster, const Vector2i& source, const Vector2i* target, const bool backwards, SearchScratch& scratch) const {
+	const int width = cluster.max.x - cluster.min.x;
+	const int height = cluster.max.y - cluster.min.y;
+	const int stride = width + 2;
+	const size_t localCount = static_cast<size_t>(stride * (height + 2));
+	const auto localTile = [stride](const uint32_t index) { return Vector2i(static_cast<int>(index) % stride, static_cast<int>(index) / stride); };
+	const auto isLater = [](const OpenEntry& a, const OpenEntry& b) { return a.priority > b.priority; };
+
+	// The cluster's costs with a ring of walls around them, so steps never leave the cluster
+	scratch.localTiles.assign(localCount, gWall);
+	for (int y = 0; y < height; ++y) {
+		std::copy_n(mCosts.data() + Index(Vector2i(cluster.min.x, cluster.min.y + y)), width, scratch.localTiles.data() + (y + 1) * stride + 1);
+	}
+	std::array<int, 8> neighbourSteps;
+	for (size_t i = 0; i < gNeighbourOffsets.size(); ++i) {
+		neighbourSteps[i] = gNeighbourOffsets[i].y * stride + gNeighbourOffsets[i].x;
+	}
+
+	scratch.localCosts.assign(localCount, gInfinity);
+	scratch.localParents.assign(localCount, gNoParent);
+	scratch.open.clear();
+	const uint32_t sourceIndex = LocalIndex(cluster, source);
+	const uint32_t targetIndex = target ? LocalIndex(cluster, *target) : gNoParent;
+	const Vector2i targetTile = target ? localTile(targetIndex) : Vector2i();
+	scratch.localCosts[sourceIndex] = 0.0f;
+	scratch.open.push_back({ target ? OctileDistance(localTile(sourceIndex), targetTile) : 0.0f, 0.0f, sourceIndex });
+
+	while (!scratch.open.empty()) {
+		std::pop_heap(scratch.open.begin(), scratch.open.end(), isLater);
+		const OpenEntry entry = scratch.open.back();
+		scratch.open.pop_back();
+		if (entry.cost > scratch.localCosts[entry.index]) {
+			continue;
+		}
+		if (entry.index == targetIndex) {
+			break;
+		}
+
+		for (size_t i = 0; i < neighbourSteps.size(); ++i) {
+			const uint32_t nextIndex = static_cast<uint32_t>(static_cast<int>(entry.index) + neighbourSteps[i]);
+			const bool isDiagonal = i >= 4;
+			if (scratch.localTiles[nextIndex] == gWall || (isDiagonal
+				&& (scratch.localTiles[static_cast<size_t>(static_cast<int>(entry.index) + gNeighbourOffsets[i].x)] == gWall
+					|| scratch.localTiles[static_cast<size_t>(static_cast<int>(entry.index) + gNeighbourOffsets[i].y * stride)] == gWall))) {
+				continue;
+			}
+			// Forward pays for entering the next tile, backwards walks the path the other way and pays for entering this one
+			const float step = static_cast<float>(scratch.localTiles[backwards ? entry.index : nextIndex]) * (isDiagonal ? gDiagonal : 1.0f);
+			const float cost = entry.cost + step;
+			if (cost < scratch.localCosts[nextIndex]) {
+				scratch.localCosts[nextIndex] = cost;
+				scratch.localParents[nextIndex] = entry.index;
+				scratch.open.push_back({ cost + (target ? OctileDistance(localTile(nextIndex), targetTile) : 0.0f), cost, nextIndex });
+				std::push_heap(scratch.open.begin(), scratch.open.end(), isLater);
+			}
+		}
+	}
+}
+
+bool RF::HierarchicalPathfinder::RefineStep(const Vector2i& from, const Vector2i& to, SearchScratch& scratch, std::vector<Vector2i>& tiles) const {
+	const Cluster& cluster = mClusters[ClusterOf(from)];
+	SearchCluster(cluster, from, &to, false, scratch);
+	const int stride = cluster.max.x - cluster.min.x + 2;
+	uint32_t index = LocalIndex(cluster, to);
+	if (scratch.localCosts[index] == gInfinity) {
+		return false;
+	}
+	const size_t first = tiles.size();
+	while (scratch.localParents[index] != gNoParent) {
+		tiles.push_back(Vector2i(cluster.min.x + static_cast<int>(index) % stride - 1, cluster.min.y + static_cast<int>(index) / stride - 1));
+		index = scratch.localParents[index];
+	}
+	std::reverse(tiles.begin() + static_cast<std::ptrdiff_t>(first), tiles.end());
+	return true;
+}
+
+void RF::HierarchicalPathfinder::Search(const Vector2i& start, const Vector2i& goal, SearchScratch& scratch, PathResult& result) const {
+	result.status = PathStatus::NotFound;
+	result.tiles.clear();
+	result.cost = 0.0f;
+	if (!IsOpen(start) || !IsOpen(goal)) {
+		return;
+	}
+	if (start == goal) {
+		result.status = PathStatus::Found;
+		result.tiles.push_back(start);
+		return;
+	}
+
+	// The start and goal join the abstract graph as two extra nodes after the real ones
+	const uint32_t nodeCount = static_cast<uint32_t>(mNodeClusters.size());
+	const uint32_t startNode = nodeCount;
+	const uint32_t goalNode = nodeCount + 1;
+	if (scratch.nodeVisits.size() < nodeCount + 2) {
+		scratch.nodeCosts.resize(nodeCount + 2);
+		scratch.nodeParents.resize(nodeCount + 2);
+		scratch.nodeVisits.resize(nodeCount + 2, 0);
+	}
+	if (++scratch.visit == 0) {
+		std::fill(scratch.nodeVisits.begin(), scratch.nodeVisits.end(), 0u);
+		scratch.visit = 1;
+	}
+
+	const auto tileOf = [this, &start, &goal, startNode, goalNode](const uint32_t node) {
+		if (node == startNode) {
+			return start;
+		}
+		if (node == goalNode) {
+			return goal;
+		}
+		const uint32_t cluster = mNodeClusters[node];
+		return mClusters[cluster].nodes[node - mNodeOffsets[cluster]].tile;
+	};
+	const auto isLater = [](const OpenEntry& a, const OpenEntry& b) { return a.priority > b.priority; };
+	const auto relax = [&scratch, &goal, goalNode, &tileOf, &isLater](const uint32_t node, const float cost, const uint32_t parent) {
+		if (scratch.nodeVisits[node] == scratch.visit && cost >= scratch.nodeCosts[node]) {
+			return;
+		}
+		scratch.nodeVisits[node] = scratch.visit;
+		scratch.nodeCosts[node] = cost;
+		scratch.nodeParents[node] = parent;
+		scratch.open.push_back({ cost + (node == goalNode ? 0.0f : OctileDistance(tileOf(node), goal)), cost, node });
+		std::push_heap(scratch.open.begin(), scratch.open.end(), isLater);
+	};
+
+	// Backwards from the goal through its cluster, for the cost from each of its nodes to the goal
+	const uint32_t startCluster = ClusterOf(start);
+	const uint32_t goalCluster = ClusterOf(goal);
+	const Cluster& goalBounds = mClusters[goalCluster];
+	SearchCluster(goalBounds, goal, nullptr, true, scratch);
+	scratch.goalCosts.clear();
+	for (const AbstractNode& node : goalBounds.nodes) {
+		scratch.goalCosts.push_back(scratch.localCosts[LocalIndex(goalBounds, node.tile)]);
+	}
+	const float directCost = startCluster == goalCluster ? scratch.localCosts[LocalIndex(goalBounds, start)] : gInfinity;
+
+	// Forward from the start through its cluster to its nodes
+	const Cluster& startBounds = mClusters[startCluster];
+	SearchCluster(startBounds, start, nullptr, false, scratch);
+	scratch.open.clear();
+	scratch.nodeVisits[startNode] = scratch.visit;
+	scratch.nodeCosts[startNode] = 0.0f;
+	scratch.nodeParents[startNode] = gNoParent;
+	for (uint32_t i = 0; i < startBounds.nodes.size(); ++i) {
+		const float cost = scratch.localCosts[LocalIndex(startBounds, startBounds.nodes[i].tile)];
+		if (cost != gInfinity) {
+			relax(mNodeOffsets[startCluster] + i, cost, startNode);
+		}
+	}
+	if (directCost != gInfinity) {
+		relax(goalNode, directCost, startNode);
+	}
+
+	bool isFound = false;
+	while (!scratch.open.empty()) {
+		std::pop_heap(scratch.open.begin(), scratch.open.end(), isLater);
+		const OpenEntry entry = scratch.open.back();
+		scratch.open.pop_back();
+		if (entry.cost > scratch.nodeCosts[entry.index]) {
+			continue;
+		}
+		if (entry.index == goalNode) {
+			isFound = true;
+			break;
+		}
+		const uint32_t cluster = mNodeClusters[entry.index];
+		const uint32_t local = entry.index - mNodeOffsets[cluster];
+		const AbstractNode& node = mClusters[cluster].nodes[local];
+		for (const AbstractEdge& edge : node.intraEdges) {
+			relax(mNodeOffsets[edge.cluster] + edge.node, entry.cost + edge.cost, entry.index);
+		}
+		for (const AbstractEdge& edge : node.interEdges) {
+			relax(mNodeOffsets[edge.cluster] + edge.node, entry.cost + edge.cost, entry.index);
+		}
+		if (cluster == goalCluster && scratch.goalCosts[local] != gInfinity) {
+			relax(goalNode, entry.cost + scratch.goalCosts[local], entry.index);
+		}
+	}
+	if (!isFound) {
+		return;
+	}
+
+	std::vector<Vector2i> waypoints;
+	for (uint32_t node = goalNode; node != gNoParent; node = scratch.nodeParents[node]) {
+		waypoints.push_back(tileOf(node));
+	}
+	std::reverse(waypoints.begin(), waypoints.end());
+
+	// Abstract steps across a border are one tile, the others are searched again inside their cluster
+	result.tiles.push_back(start);
+	for (size_t i = 1; i < waypoints.size(); ++i) {
+		const Vector2i& from = waypoints[i - 1];
+		const Vector2i& to = waypoints[i];
+		if (from == to) {
+			continue;
+		}
+		if (ClusterOf(from) != ClusterOf(to)) {
+			result.tiles.push_back(to);
+		}
+		else if (!RefineStep(from, to, scratch, result.tiles)) {
+			assert(false && "HierarchicalPathfinder abstract edge without a path");
+			result.tiles.clear();
+			return;
+		}
+	}
+	result.status = PathStatus::Found;
+	result.cost = scratch.nodeCosts[goalNode];
+}
+
+RF::HierarchicalPathfinder::SearchScratch& RF::HierarchicalPathfinder::GetScratch() {
+	const unsigned int threadIndex = mJobSystem ? JobSystem::CurrentThreadIndex() : 0;
+	assert(threadIndex < mScratch.size() && "HierarchicalPathfinder searched from another job system's worker");
+	return *mScratch[threadIndex];
+}
+
+bool RF::HierarchicalPathfinder::TryGetCached(const uint64_t key, PathResult& result) {
+	const auto found = mCacheLookup.find(key);
+	if (found == mCacheLookup.end()) {
+		return false;
+	}
+	mCache.splice(mCache.begin(), mCache, found->second);
+	const CachedPath& cached = *found->second;
+	result.status = cached.status;
+	result.tiles = cached.tiles;
+	result.cost = cached.cost;
+	result.isCached = true;
+	++mCacheStats.hits;
+	return true;
+}
+
+void RF::HierarchicalPathfinder::AddToCache(const uint64_t key, const PathResult& result) {
+	++mCacheStats.misses;
+	if (mSettings.cacheCapacity == 0) {
+		return;
+	}
+	const auto found = mCacheLookup.find(key);
+	if (found != mCacheLookup.end()) {
+		mCache.erase(found->second);
+		mCacheLookup.erase(found);
+	}
+
+	CachedPath cached = { key, result.status, result.tiles, result.cost, {} };
+	for (const Vector2i& tile : result.tiles) {
+		const uint32_t cluster = ClusterOf(tile);
+		if (cached.clusters.empty() || cached.clusters.back() != cluster) {
+			cached.clusters.push_back(cluster);
+		}
+	}
+	mCache.push_front(std::move(cached));
+	mCacheLookup[key] = mCache.begin();
+	while (mCache.size() > mSettings.cacheCapacity) {
+		mCacheLookup.erase(mCache.back().key);
+		mCache.pop_back();
+	}
+	mCacheStats.size = mCache.size();
+}
+
+void RF::HierarchicalPathfinder::InvalidateCache(const std::vector<uint8_t>& isChanged) {
+	// Failed searches may succeed after any change, found paths only break when a cluster they cross changed
+	for (auto it = mCache.begin(); it != mCache.end();) {
+		const bool isStale = it->status == PathStatus::NotFound
+			|| std::any_of(it->clusters.begin(), it->clusters.end(), [&isChanged](const uint32_t cluster) { return isChanged[cluster] != 0; });
+		if (isStale) {
+			mCacheLookup.erase(it->key);
+			it = mCache.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	mCacheStats.size = mCache.size();
+}
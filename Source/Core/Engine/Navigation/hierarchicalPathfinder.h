@@ -0,0 +1,234 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Math/Vector2.h"
+
+namespace RF {
+	class JobSystem;
+
+	enum class PathStatus : uint8_t {
+		Found,
+		NotFound
+	};
+
+	using PathRequestId = uint64_t;
+	constexpr PathRequestId gInvalidPathRequest = 0;
+
+	struct PathResult {
+		PathRequestId id = gInvalidPathRequest;
+		Vector2i start;
+		Vector2i goal;
+		PathStatus status = PathStatus::NotFound;
+		// Tiles from start to goal, both included
+		std::vector<Vector2i> tiles = {};
+		float cost = 0.0f;
+		bool isCached = false;
+	};
+
+	struct PathRequest {
+		Vector2i start;
+		Vector2i goal;
+		// Runs on the thread calling ProcessRequests()
+		std::function<void(const PathResult& result)> onComplete = nullptr;
+	};
+
+	struct PathfinderSettings {
+		// Tiles per cluster side, the abstract graph has a few nodes on every cluster border
+		int clusterSize = 16;
+		// Paths kept for repeated queries, least recently used are dropped first
+		size_t cacheCapacity = 256;
+		// Time ProcessRequests() may spend searching, at least one request is served every call
+		double frameBudgetMs = 1.0;
+	};
+
+	struct PathCacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t size = 0;
+	};
+
+	/// <summary>
+	/// Point to point paths over a large tile grid with hierarchical A* (HPA*). The grid is cut into clusters, the
+	/// walkable spans across each cluster border become entrances, and the abstract graph links entrances across
+	/// borders and, with the cheapest cost inside the cluster, to each other. A query searches the abstract graph and
+	/// refines each abstract step with a search inside one cluster, so long paths touch a small part of the map.
+	/// Costs work like FlowField's: stepping into a tile costs its cost, times sqrt(2) diagonally, without cutting corners.
+	/// Cost changes only rebuild the clusters around them and drop cached paths through them.
+	/// Not thread safe, requests are searched on the job system but everything is called from one thread.
+	/// </summary>
+	class HierarchicalPathfinder {
+	public:
+		HierarchicalPathfinder(const Vector2i& size, const PathfinderSettings& settings = {}, JobSystem* jobSystem = nullptr);
+		HierarchicalPathfinder(const HierarchicalPathfinder&) = delete;
+		void operator=(const HierarchicalPathfinder&) = delete;
+
+		const Vector2i& GetSize() const { return mSize; }
+		bool IsInside(const Vector2i& tile) const { return tile.x >= 0 && tile.y >= 0 && tile.x < mSize.x && tile.y < mSize.y; }
+
+		/// <summary>
+		/// Sets how expensive a tile is to walk through, from 1 for open ground up to gWall for impassable tiles.
+		/// The abstract graph catches up on the next UpdateGraph(), FindPath() or ProcessRequests().
+		/// </summary>
+		void SetCost(const Vector2i& tile, const uint8_t cost);
+		uint8_t GetCost(const Vector2i& tile) const { return mCosts[Index(tile)]; }
+
+		/// <summary>
+		/// Rebuilds the clusters touched by cost changes, in parallel on the job system.
+		/// </summary>
+		/// <returns>Number of rebuilt clusters.</returns>
+		size_t UpdateGraph();
+
+		/// <summary>
+		/// Searches a path right away on the calling thread, going through the cache.
+		/// </summary>
+		PathResult FindPath(const Vector2i& start, const Vector2i& goal);
+
+		PathRequestId Request(PathRequest request);
+
+		/// <returns>False if the request is unknown or already delivered.</returns>
+		bool Cancel(const PathRequestId id);
+
+		/// <summary>
+		/// Serves queued requests from the cache or searches them on the job system until the frame budget is spent,
+		/// then delivers them in request order. Requests past the budget stay queued for the next call.
+		/// </summary>
+		/// <returns>Number of delivered requests.</returns>
+		size_t ProcessRequests();
+
+		size_t PendingCount() const { return mQueue.size(); }
+		const PathCacheStats& GetCacheStats() const { return mCacheStats; }
+		size_t GetAbstractNodeCount() const { return mNodeClusters.size(); }
+
+		static constexpr uint8_t gWall = 255;
+
+	private:
+		// Walkable tile pair across a cluster border, first in the west or north cluster
+		struct Transition {
+			Vector2i first;
+			Vector2i second;
+		};
+
+		// Edge to node `node` of cluster `cluster`
+		struct AbstractEdge {
+			uint32_t cluster = 0;
+			uint32_t node = 0;
+			float cost = 0.0f;
+		};
+
+		struct AbstractNode {
+			Vector2i tile;
+			// To the other nodes of the same cluster, with the cheapest cost inside the cluster
+			std::vector<AbstractEdge> intraEdges;
+			// One step across a border
+			std::vector<AbstractEdge> interEdges;
+		};
+
+		struct Cluster {
+			Vector2i min;
+			// Exclusive
+			Vector2i max;
+			std::vector<AbstractNode> nodes;
+		};
+
+		struct OpenEntry {
+			float priority = 0.0f;
+			float cost = 0.0f;
+			uint32_t index = 0;
+		};
+
+		// Per thread search memory, so concurrent searches don't allocate
+		struct SearchScratch {
+			// Inside one cluster and a ring of walls around it, see LocalIndex()
+			std::vector<uint8_t> localTiles;
+			std::vector<float> localCosts;
+			std::vector<uint32_t> localParents;
+			// Over the abstract graph, indexed by node id, plus the start and goal
+			std::vector<float> nodeCosts;
+			std::vector<uint32_t> nodeParents;
+			std::vector<uint32_t> nodeVisits;
+			uint32_t visit = 0;
+			// Cost from each node of the goal cluster to the goal
+			std::vector<float> goalCosts;
+			std::vector<OpenEntry> open;
+		};
+
+		struct CachedPath {
+			uint64_t key = 0;
+			PathStatus status = PathStatus::NotFound;
+			std::vector<Vector2i> tiles;
+			float cost = 0.0f;
+			// Clusters the path walks through, to drop it when one of them changes
+			std::vector<uint32_t> clusters;
+		};
+
+		struct PendingPath {
+			PathRequestId id = gInvalidPathRequest;
+			PathRequest request;
+		};
+
+		size_t Index(const Vector2i& tile) const { return static_cast<size_t>(tile.y) * static_cast<size_t>(mSize.x) + static_cast<size_t>(tile.x); }
+		bool IsOpen(const Vector2i& tile) const { return IsInside(tile) && mCosts[Index(tile)] != gWall; }
+		uint32_t ClusterOf(const Vector2i& tile) const { return static_cast<uint32_t>((tile.y / mClusterSize) * mClusterColumns + tile.x / mClusterSize); }
+		static uint32_t LocalIndex(const Cluster& cluster, const Vector2i& tile) {
+			return static_cast<uint32_t>((tile.y - cluster.min.y + 1) * (cluster.max.x - cluster.min.x + 2) + tile.x - cluster.min.x + 1);
+		}
+		uint64_t CacheKey(const Vector2i& start, const Vector2i& goal) const { return (static_cast<uint64_t>(Index(start)) << 32) | static_cast<uint64_t>(Index(goal)); }
+
+		// Finds the entrances along a border, returns whether they moved
+		bool FindTransitions(const Vector2i& first, const Vector2i& along, const Vector2i& across, const int length, std::vector<Transition>& transitions) const;
+		bool UpdateEastTransitions(const uint32_t cluster);
+		bool UpdateSouthTransitions(const uint32_t cluster);
+		void RebuildCluster(const uint32_t cluster, SearchScratch& scratch);
+		void LinkCluster(const uint32_t cluster);
+		uint32_t FindNode(const uint32_t cluster, const Vector2i& tile) const;
+
+		/// <summary>
+		/// Dijkstra, or A* when a target is given, over the tiles of one cluster. Fills the scratch's local costs and
+		/// parents. Backwards, costs are from each tile to the source instead of from the source.
+		/// </summary>
+		void SearchCluster(const Cluster& cluster, const Vector2i& source, const Vector2i* target, const bool backwards, SearchScratch& scratch) const;
+		// Appends the tiles after from up to to, both in the same cluster
+		bool RefineStep(const Vector2i& from, const Vector2i& to, SearchScratch& scratch, std::vector<Vector2i>& tiles) const;
+		void Search(const Vector2i& start, const Vector2i& goal, SearchScratch& scratch, PathResult& result) const;
+		SearchScratch& GetScratch();
+
+		bool TryGetCached(const uint64_t key, PathResult& result);
+		void AddToCache(const uint64_t key, const PathResult& result);
+		void InvalidateCache(const std::vector<uint8_t>& isChanged);
+
+		Vector2i mSize;
+		PathfinderSettings mSettings;
+		JobSystem* mJobSystem = nullptr;
+		int mClusterSize = 16;
+		int mClusterColumns = 0;
+		int mClusterRows = 0;
+
+		std::vector<uint8_t> mCosts;
+		std::vector<Cluster> mClusters;
+		// Per cluster, the transitions across its east and south borders
+		std::vector<std::vector<Transition>> mEastTransitions;
+		std::vector<std::vector<Transition>> mSouthTransitions;
+		std::vector<uint8_t> mIsClusterDirty;
+		bool mIsGraphDirty = true;
+		// Node ids are the cluster's offset plus the node's index in the cluster
+		std::vector<uint32_t> mNodeOffsets;
+		std::vector<uint32_t> mNodeClusters;
+
+		std::vector<std::unique_ptr<SearchScratch>> mScratch;
+
+		// Most recently used first
+		std::list<CachedPath> mCache;
+		std::unordered_map<uint64_t, std::list<CachedPath>::iterator> mCacheLookup;
+		PathCacheStats mCacheStats;
+
+		std::deque<PendingPath> mQueue;
+		PathRequestId mNextId = 1;
+	};
+}
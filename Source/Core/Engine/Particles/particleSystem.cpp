@@ -0,0 +1,393 @@
+#include "stdafx.h"
+#include "particleSystem.h"
+#include "Engine/Collision/narrowphase.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <immintrin.h>
+#include <limits>
+#ifdef _MSC_VER
+// MSVC compiles AVX intrinsics anywhere, other compilers need the functions using them marked
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace {
+	constexpr size_t gLanes = 8;
+	// Three passes of 11 bits cover a 32 bit depth key, with histograms that stay in L1
+	constexpr size_t gRadixBits = 11;
+	constexpr size_t gRadixPasses = 3;
+	constexpr size_t gRadixBuckets = size_t(1) << gRadixBits;
+	constexpr size_t gInstancesPerJob = 16 * 1024;
+	constexpr float gLastCurveIndex = static_cast<float>(RF::ParticleSystem::gCurveResolution - 1);
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	// xorshift32, in [0, 1)
+	float NextRandom(uint32_t& state) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// In [-1, 1)
+	float NextSigned(uint32_t& state) {
+		return NextRandom(state) * 2.0f - 1.0f;
+	}
+
+	uint32_t PackColor(const float r, const float g, const float b, const float a) {
+		auto channel = [](const float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+		return channel(r) | channel(g) << 8 | channel(b) << 16 | channel(a) << 24;
+	}
+
+	// The keys around a time on a curve, and how far the time is from the first to the second
+	struct CurveSpan {
+		size_t previous = 0;
+		size_t next = 0;
+		float weight = 0.0f;
+	};
+
+	// Before the first key or after the last, both are that key
+	template<typename Key>
+	CurveSpan FindCurveSpan(const std::vector<Key>& keys, const float time) {
+		const auto next = std::find_if(keys.begin(), keys.end(), [time](const Key& key) { return key.time >= time; });
+		if (next == keys.begin() || next == keys.end()) {
+			const size_t end = next == keys.begin() ? 0 : keys.size() - 1;
+			return { end, end, 0.0f };
+		}
+		const size_t nextIndex = static_cast<size_t>(next - keys.begin());
+		const Key& previous = keys[nextIndex - 1];
+		const float span = next->time - previous.time;
+		return { nextIndex - 1, nextIndex, span > 0.0f ? (time - previous.time) / span : 1.0f };
+	}
+
+	float Lerp(const float from, const float to, const float weight) {
+		return from + (to - from) * weight;
+	}
+
+	// Flips floats so that their bits sort like the values, largest first
+	uint32_t DescendingKey(const float value) {
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint32_t ascending = bits ^ ((bits >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+		return ~ascending;
+	}
+
+	struct ParticleArrays {
+		float* xs = nullptr;
+		float* ys = nullptr;
+		float* zs = nullptr;
+		float* velocityXs = nullptr;
+		float* velocityYs = nullptr;
+		float* velocityZs = nullptr;
+		float* ages = nullptr;
+		const float* inverseLifetimes = nullptr;
+		float* sizes = nullptr;
+		uint32_t* colors = nullptr;
+		const float* sizeCurve = nullptr;
+		const uint32_t* colorCurve = nullptr;
+	};
+
+	// The same for every particle of an emitter in one update
+	struct StepConstants {
+		float deltaTime = 0.0f;
+		// Velocity kept over the step after drag
+		float dragFactor = 1.0f;
+		// Velocity added over the step by the emitter's acceleration
+		float velocityStepX = 0.0f;
+		float velocityStepY = 0.0f;
+		float velocityStepZ = 0.0f;
+	};
+
+	// Drag, forces, motion, ageing and the curves for particles [begin, end)
+	void SimulateScalar(const ParticleArrays& particles, const StepConstants& step, const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			particles.velocityXs[i] = particles.velocityXs[i] * step.dragFactor + step.velocityStepX;
+			particles.velocityYs[i] = particles.velocityYs[i] * step.dragFactor + step.velocityStepY;
+			particles.velocityZs[i] = particles.velocityZs[i] * step.dragFactor + step.velocityStepZ;
+			particles.xs[i] += particles.velocityXs[i] * step.deltaTime;
+			particles.ys[i] += particles.velocityYs[i] * step.deltaTime;
+			particles.zs[i] += particles.velocityZs[i] * step.deltaTime;
+			particles.ages[i] += step.deltaTime;
+
+			const float time = std::min(std::max(particles.ages[i] * particles.inverseLifetimes[i], 0.0f), 1.0f);
+			const int index = static_cast<int>(time * gLastCurveIndex);
+			particles.sizes[i] = particles.sizeCurve[index];
+			particles.colors[i] = particles.colorCurve[index];
+		}
+	}
+
+	AVX2_FUNCTION void SimulateAvx2(const ParticleArrays& particles, const StepConstants& step, const size_t begin, const size_t end) {
+		const __m256 deltaTime = _mm256_set1_ps(step.deltaTime);
+		const __m256 dragFactor = _mm256_set1_ps(step.dragFactor);
+		const __m256 velocityStepX = _mm256_set1_ps(step.velocityStepX);
+		const __m256 velocityStepY = _mm256_set1_ps(step.velocityStepY);
+		const __m256 velocityStepZ = _mm256_set1_ps(step.velocityStepZ);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 lastCurveIndex = _mm256_set1_ps(gLastCurveIndex);
+
+		const size_t vectorEnd = begin + (end - begin) / gLanes * gLanes;
+		for (size_t i = begin; i < vectorEnd; i += gLanes) {
+			const __m256 velocityX = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(particles.velocityXs + i), dragFactor), velocityStepX);
+			const __m256 velocityY = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(particles.velocityYs + i), dragFactor), velocityStepY);
+			const __m256 velocityZ = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(particles.velocityZs + i), dragFactor), velocityStepZ);
+			_mm256_storeu_ps(particles.velocityXs + i, velocityX);
+			_mm256_storeu_ps(particles.velocityYs + i, velocityY);
+			_mm256_storeu_ps(particles.velocityZs + i, velocityZ);
+			_mm256_storeu_ps(particles.xs + i, _mm256_add_ps(_mm256_loadu_ps(particles.xs + i), _mm256_mul_ps(velocityX, deltaTime)));
+			_mm256_storeu_ps(particles.ys + i, _mm256_add_ps(_mm256_loadu_ps(particles.ys + i), _mm256_mul_ps(velocityY, deltaTime)));
+			_mm256_storeu_ps(particles.zs + i, _mm256_add_ps(_mm256_loadu_ps(particles.zs + i), _mm256_mul_ps(velocityZ, deltaTime)));
+			const __m256 age = _mm256_add_ps(_mm256_loadu_ps(particles.ages + i), deltaTime);
+			_mm256_storeu_ps(particles.ages + i, age);
+
+			const __m256 time = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(age, _mm256_loadu_ps(particles.inverseLifetimes + i)), zero), one);
+			const __m256i index = _mm256_cvttps_epi32(_mm256_mul_ps(time, lastCurveIndex));
+			_mm256_storeu_ps(particles.sizes + i, _mm256_i32gather_ps(particles.sizeCurve, index, 4));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(particles.colors + i), _mm256_i32gather_epi32(reinterpret_cast<const int*>(particles.colorCurve), index, 4));
+		}
+		SimulateScalar(particles, step, vectorEnd, end);
+	}
+}
+
+template<typename Func>
+void RF::ParticleSystem::ForEachArray(Emitter& emitter, const Func& func) {
+	func(emitter.xs);
+	func(emitter.ys);
+	func(emitter.zs);
+	func(emitter.velocityXs);
+	func(emitter.velocityYs);
+	func(emitter.velocityZs);
+	func(emitter.ages);
+	func(emitter.inverseLifetimes);
+	func(emitter.sizes);
+	func(emitter.colors);
+}
+
+RF::ParticleSystem::ParticleSystem(JobSystem* jobSystem)
+	: mJobSystem(jobSystem), mUseAvx2(Narrowphase::IsAvx2Supported()) {}
+
+RF::ParticleEmitterId RF::ParticleSystem::AddEmitter(const EmitterSettings& settings, const Vector3& position) {
+	assert(settings.lifetime > 0.0f && "EmitterSettings lifetime has to be positive");
+	assert(settings.lifetimeVariance >= 0.0f && settings.lifetimeVariance < 1.0f && "EmitterSettings lifetimeVariance has to be in [0, 1)");
+	assert(!settings.colors.empty() && !settings.sizes.empty() && "EmitterSettings curves need at least one key");
+	assert(std::is_sorted(settings.colors.begin(), settings.colors.end(), [](const ColorKey& a, const ColorKey& b) { return a.time < b.time; }) && "EmitterSettings colors aren't sorted by time");
+	assert(std::is_sorted(settings.sizes.begin(), settings.sizes.end(), [](const SizeKey& a, const SizeKey& b) { return a.time < b.time; }) && "EmitterSettings sizes aren't sorted by time");
+
+	mEmitters.push_back({});
+	Emitter& emitter = mEmitters.back();
+	emitter.settings = settings;
+	emitter.position = position;
+	emitter.random = settings.seed != 0 ? settings.seed : 1;
+
+	for (size_t i = 0; i < gCurveResolution; ++i) {
+		const float time = static_cast<float>(i) / gLastCurveIndex;
+		const CurveSpan sizeSpan = FindCurveSpan(settings.sizes, time);
+		emitter.sizeCurve[i] = Lerp(settings.sizes[sizeSpan.previous].size, settings.sizes[sizeSpan.next].size, sizeSpan.weight);
+		const CurveSpan colorSpan = FindCurveSpan(settings.colors, time);
+		const ColorKey& from = settings.colors[colorSpan.previous];
+		const ColorKey& to = settings.colors[colorSpan.next];
+		emitter.colorCurve[i] = PackColor(Lerp(from.r, to.r, colorSpan.weight), Lerp(from.g, to.g, colorSpan.weight),
+			Lerp(from.b, to.b, colorSpan.weight), Lerp(from.a, to.a, colorSpan.weight));
+	}
+
+	// The arrays never grow past maxParticles, so emitting doesn't allocate
+	ForEachArray(emitter, [&settings](auto& values) { values.reserve(settings.maxParticles); });
+	return static_cast<ParticleEmitterId>(mEmitters.size() - 1);
+}
+
+void RF::ParticleSystem::Update(const float deltaTime) {
+	BuildRanges();
+	ParallelFor(mJobSystem, mRanges.size(), 1, [this, deltaTime](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			Simulate(mRanges[i], deltaTime);
+		}
+	});
+	// New particles go in after the dead ones are gone, so they don't count against maxParticles
+	ParallelFor(mJobSystem, mEmitters.size(), 1, [this, deltaTime](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			Compact(i);
+			Emit(mEmitters[i], deltaTime);
+		}
+	});
+}
+
+size_t RF::ParticleSystem::WriteInstances(const Vector3& cameraPosition, const Vector3& cameraForward, std::span<ParticleInstance> instances) {
+	const size_t count = Count();
+	assert(count <= std::numeric_limits<uint32_t>::max() && "ParticleSystem has too many particles to sort");
+	mStaged.resize(count);
+	mSortEntries.resize(count);
+
+	// Depth along the view for every particle, gathered from the emitters into one list
+	BuildRanges();
+	ParallelFor(mJobSystem, mRanges.size(), 1, [this, &cameraPosition, &cameraForward](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const ParticleRange& range = mRanges[i];
+			const Emitter& emitter = mEmitters[range.emitter];
+			for (uint32_t particle = range.begin, staged = range.offset; particle < range.end; ++particle, ++staged) {
+				const float x = emitter.xs[particle];
+				const float y = emitter.ys[particle];
+				const float z = emitter.zs[particle];
+				mStaged[staged] = { x, y, z, emitter.sizes[particle], emitter.colors[particle] };
+				const float depth = (x - cameraPosition.x) * cameraForward.x + (y - cameraPosition.y) * cameraForward.y + (z - cameraPosition.z) * cameraForward.z;
+				mSortEntries[staged] = static_cast<uint64_t>(DescendingKey(depth)) << 32 | staged;
+			}
+		}
+	});
+	RadixSort(count);
+
+	const size_t written = std::min(count, instances.size());
+	ParallelFor(mJobSystem, written, gInstancesPerJob, [this, instances](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			instances[i] = mStaged[static_cast<uint32_t>(mSortEntries[i])];
+		}
+	});
+	return written;
+}
+
+size_t RF::ParticleSystem::Count() const {
+	size_t count = 0;
+	for (const Emitter& emitter : mEmitters) {
+		count += emitter.xs.size();
+	}
+	return count;
+}
+
+void RF::ParticleSystem::SetAvx2Enabled(const bool enabled) {
+	mUseAvx2 = enabled && Narrowphase::IsAvx2Supported();
+}
+
+void RF::ParticleSystem::Emit(Emitter& emitter, const float deltaTime) {
+	const EmitterSettings& settings = emitter.settings;
+	const float spawns = emitter.isEmitting ? emitter.spawnCarry + settings.spawnRate * deltaTime : 0.0f;
+	const float wholeSpawns = std::floor(spawns);
+	emitter.spawnCarry = spawns - wholeSpawns;
+
+	const size_t first = emitter.xs.size();
+	const size_t room = settings.maxParticles > first ? settings.maxParticles - first : 0;
+	const size_t spawnCount = std::min(static_cast<size_t>(wholeSpawns) + emitter.burstCount, room);
+	emitter.burstCount = 0;
+	if (spawnCount == 0) {
+		return;
+	}
+
+	ForEachArray(emitter, [first, spawnCount](auto& values) { values.resize(first + spawnCount); });
+	for (size_t i = first; i < first + spawnCount; ++i) {
+		emitter.xs[i] = emitter.position.x + settings.spawnExtent.x * NextSigned(emitter.random);
+		emitter.ys[i] = emitter.position.y + settings.spawnExtent.y * NextSigned(emitter.random);
+		emitter.zs[i] = emitter.position.z + settings.spawnExtent.z * NextSigned(emitter.random);
+		emitter.velocityXs[i] = settings.velocity.x + settings.velocitySpread.x * NextSigned(emitter.random);
+		emitter.velocityYs[i] = settings.velocity.y + settings.velocitySpread.y * NextSigned(emitter.random);
+		emitter.velocityZs[i] = settings.velocity.z + settings.velocitySpread.z * NextSigned(emitter.random);
+		emitter.ages[i] = 0.0f;
+		emitter.inverseLifetimes[i] = 1.0f / (settings.lifetime * (1.0f + settings.lifetimeVariance * NextSigned(emitter.random)));
+		emitter.sizes[i] = emitter.sizeCurve[0];
+		emitter.colors[i] = emitter.colorCurve[0];
+	}
+}
+
+void RF::ParticleSystem::Simulate(ParticleRange& range, const float deltaTime) {
+	Emitter& emitter = mEmitters[range.emitter];
+	const ParticleArrays particles = {
+		emitter.xs.data(), emitter.ys.data(), emitter.zs.data(), emitter.velocityXs.data(), emitter.velocityYs.data(), emitter.velocityZs.data(),
+		emitter.ages.data(), emitter.inverseLifetimes.data(), emitter.sizes.data(), emitter.colors.data(), emitter.sizeCurve.data(), emitter.colorCurve.data()
+	};
+	const Vector3& acceleration = emitter.settings.acceleration;
+	const StepConstants step = {
+		deltaTime, 1.0f / (1.0f + emitter.settings.drag * deltaTime), acceleration.x * deltaTime, acceleration.y * deltaTime, acceleration.z * deltaTime
+	};
+	const auto simulate = mUseAvx2 ? SimulateAvx2 : SimulateScalar;
+	simulate(particles, step, range.begin, range.end);
+
+	// Stream compaction, every particle is copied to the next free slot and that slot is only taken if it's alive
+	uint32_t alive = range.begin;
+	for (uint32_t i = range.begin; i < range.end; ++i) {
+		const bool isAlive = emitter.ages[i] * emitter.inverseLifetimes[i] < 1.0f;
+		emitter.xs[alive] = emitter.xs[i];
+		emitter.ys[alive] = emitter.ys[i];
+		emitter.zs[alive] = emitter.zs[i];
+		emitter.velocityXs[alive] = emitter.velocityXs[i];
+		emitter.velocityYs[alive] = emitter.velocityYs[i];
+		emitter.velocityZs[alive] = emitter.velocityZs[i];
+		emitter.ages[alive] = emitter.ages[i];
+		emitter.inverseLifetimes[alive] = emitter.inverseLifetimes[i];
+		emitter.sizes[alive] = emitter.sizes[i];
+		emitter.colors[alive] = emitter.colors[i];
+		alive += isAlive;
+	}
+	range.aliveCount = alive - range.begin;
+}
+
+void RF::ParticleSystem::Compact(const size_t emitter) {
+	size_t count = 0;
+	for (size_t i = mFirstRanges[emitter]; i < mFirstRanges[emitter + 1]; ++i) {
+		const ParticleRange& range = mRanges[i];
+		if (range.begin != count) {
+			ForEachArray(mEmitters[emitter], [&range, count](auto& values) {
+				std::copy(values.data() + range.begin, values.data() + range.begin + range.aliveCount, values.data() + count);
+			});
+		}
+		count += range.aliveCount;
+	}
+	ForEachArray(mEmitters[emitter], [count](auto& values) { values.resize(count); });
+}
+
+void RF::ParticleSystem::BuildRanges() {
+	mRanges.clear();
+	mFirstRanges.clear();
+	size_t offset = 0;
+	for (size_t emitter = 0; emitter < mEmitters.size(); ++emitter) {
+		mFirstRanges.push_back(mRanges.size());
+		const size_t count = mEmitters[emitter].xs.size();
+		for (size_t begin = 0; begin < count; begin += gParticlesPerJob) {
+			const size_t end = std::min(begin + gParticlesPerJob, count);
+			mRanges.push_back({ static_cast<uint32_t>(emitter), static_cast<uint32_t>(begin), static_cast<uint32_t>(end), static_cast<uint32_t>(offset + begin), 0 });
+		}
+		offset += count;
+	}
+	mFirstRanges.push_back(mRanges.size());
+}
+
+void RF::ParticleSystem::RadixSort(const size_t count) {
+	// Least significant digit first, every pass is stable so equal depths keep their emitter order
+	std::array<std::array<uint32_t, gRadixBuckets>, gRadixPasses> histograms = {};
+	for (size_t i = 0; i < count; ++i) {
+		const uint64_t key = mSortEntries[i] >> 32;
+		for (size_t pass = 0; pass < gRadixPasses; ++pass) {
+			++histograms[pass][(key >> (pass * gRadixBits)) & (gRadixBuckets - 1)];
+		}
+	}
+
+	mSwapEntries.resize(count);
+	for (size_t pass = 0; pass < gRadixPasses; ++pass) {
+		std::array<uint32_t, gRadixBuckets>& histogram = histograms[pass];
+		// Particles close together in depth often share the high bits, a pass where they all do changes nothing
+		if (std::ranges::find(histogram, static_cast<uint32_t>(count)) != histogram.end()) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram) {
+			const uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+		const size_t shift = 32 + pass * gRadixBits;
+		for (size_t i = 0; i < count; ++i) {
+			const uint64_t entry = mSortEntries[i];
+			mSwapEntries[histogram[(entry >> shift) & (gRadixBuckets - 1)]++] = entry;
+		}
+		mSortEntries.swap(mSwapEntries);
+	}
+}
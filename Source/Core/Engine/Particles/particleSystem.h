@@ -0,0 +1,159 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Math/Vector3.h"
+
+namespace RF {
+	class JobSystem;
+
+	using ParticleEmitterId = uint32_t;
+
+	// Colour at a point of a particle's life, time goes from 0 at spawn to 1 at death
+	struct ColorKey {
+		float time = 0.0f;
+		float r = 1.0f;
+		float g = 1.0f;
+		float b = 1.0f;
+		float a = 1.0f;
+	};
+
+	struct SizeKey {
+		float time = 0.0f;
+		float size = 1.0f;
+	};
+
+	struct EmitterSettings {
+		uint32_t maxParticles = 4096;
+		// Particles per second while emitting
+		float spawnRate = 100.0f;
+		// Seconds, each particle's is off by up to lifetimeVariance times that either way
+		float lifetime = 1.0f;
+		float lifetimeVariance = 0.0f;
+		// Particles spawn in a box this far from the emitter's position along each axis
+		Vector3 spawnExtent = Vector3::Zero;
+		// Velocity at spawn, off by up to velocitySpread along each axis
+		Vector3 velocity = Vector3::Zero;
+		Vector3 velocitySpread = Vector3::Zero;
+		// Gravity, wind and other constant forces per unit of mass
+		Vector3 acceleration = Vector3::Zero;
+		// Fraction of the velocity lost per second
+		float drag = 0.0f;
+		// Linear between keys, sorted by time
+		std::vector<ColorKey> colors = { { 0.0f, 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f, 0.0f } };
+		std::vector<SizeKey> sizes = { { 0.0f, 1.0f }, { 1.0f, 1.0f } };
+		uint32_t seed = 1;
+	};
+
+	// One particle for the renderer's instance buffer, colour is RGBA8 with red in the lowest byte
+	struct ParticleInstance {
+		float x = 0.0f;
+		float y = 0.0f;
+		float z = 0.0f;
+		float size = 0.0f;
+		uint32_t color = 0;
+	};
+	static_assert(sizeof(ParticleInstance) == 20, "ParticleInstance is uploaded as is");
+
+	/// <summary>
+	/// CPU particles for hit, death and aura effects. Every emitter keeps its particles as SoA arrays, and an update
+	/// spawns new ones, applies drag and forces, integrates positions and looks colour and size up in curves baked into
+	/// small tables, eight particles at a time with AVX2 where the CPU has it. Dead particles are removed by a stream
+	/// compaction that keeps the others in order, so the result is the same however the work was split, and then the
+	/// emitters spawn new ones.
+	/// Emitters run in parallel and large emitters are split into ranges of particles on the job system.
+	/// WriteInstances() radix sorts every emitter's particles together back to front for alpha blending.
+	/// </summary>
+	class ParticleSystem {
+	public:
+		explicit ParticleSystem(JobSystem* jobSystem = nullptr);
+		ParticleSystem(const ParticleSystem&) = delete;
+		void operator=(const ParticleSystem&) = delete;
+
+		ParticleEmitterId AddEmitter(const EmitterSettings& settings, const Vector3& position);
+		void SetEmitterPosition(const ParticleEmitterId emitter, const Vector3& position) { mEmitters[emitter].position = position; }
+		// A stopped emitter keeps its live particles until they die
+		void SetEmitting(const ParticleEmitterId emitter, const bool isEmitting) { mEmitters[emitter].isEmitting = isEmitting; }
+		// Spawns count particles at once at the end of the next update, e.g. for a hit
+		void Burst(const ParticleEmitterId emitter, const uint32_t count) { mEmitters[emitter].burstCount += count; }
+
+		void Update(const float deltaTime);
+
+		/// <summary>
+		/// Writes every particle into instances sorted back to front along cameraForward.
+		/// </summary>
+		/// <returns>Number of written instances, at most instances.size(), size the buffer with Count().</returns>
+		size_t WriteInstances(const Vector3& cameraPosition, const Vector3& cameraForward, std::span<ParticleInstance> instances);
+
+		size_t Count() const;
+		size_t Count(const ParticleEmitterId emitter) const { return mEmitters[emitter].xs.size(); }
+
+		void SetAvx2Enabled(const bool enabled);
+
+		static constexpr size_t gParticlesPerJob = 4096;
+		static constexpr size_t gCurveResolution = 64;
+
+	private:
+		struct Emitter {
+			EmitterSettings settings;
+			Vector3 position;
+			bool isEmitting = true;
+			uint32_t burstCount = 0;
+			// Fraction of a particle left over from the spawn rate
+			float spawnCarry = 0.0f;
+			uint32_t random = 1;
+			// The curves sampled evenly over a particle's life
+			std::array<float, gCurveResolution> sizeCurve = {};
+			std::array<uint32_t, gCurveResolution> colorCurve = {};
+
+			std::vector<float> xs;
+			std::vector<float> ys;
+			std::vector<float> zs;
+			std::vector<float> velocityXs;
+			std::vector<float> velocityYs;
+			std::vector<float> velocityZs;
+			std::vector<float> ages;
+			std::vector<float> inverseLifetimes;
+			std::vector<float> sizes;
+			std::vector<uint32_t> colors;
+		};
+
+		// Particles [begin, end) of an emitter, the unit of work on the job system
+		struct ParticleRange {
+			uint32_t emitter = 0;
+			uint32_t begin = 0;
+			uint32_t end = 0;
+			// Index of the range's first particle over every emitter, for WriteInstances()
+			uint32_t offset = 0;
+			// Particles still alive after Simulate(), moved to the front of the range
+			uint32_t aliveCount = 0;
+		};
+
+		// Spawns the update's new particles at age 0, they start moving on the next update
+		void Emit(Emitter& emitter, const float deltaTime);
+		void Simulate(ParticleRange& range, const float deltaTime);
+		// Closes the gaps Simulate() left between an emitter's ranges
+		void Compact(const size_t emitter);
+		// Splits every emitter's particles into ranges of at most gParticlesPerJob
+		void BuildRanges();
+		void RadixSort(const size_t count);
+		template<typename Func>
+		static void ForEachArray(Emitter& emitter, const Func& func);
+
+		JobSystem* mJobSystem = nullptr;
+		bool mUseAvx2 = false;
+		std::vector<Emitter> mEmitters;
+		std::vector<ParticleRange> mRanges;
+		// Index of every emitter's first range, and the range count at the end
+		std::vector<size_t> mFirstRanges;
+
+		// WriteInstances() scratch: every particle in emitter order, and its depth key above its index in mStaged,
+		// twice for the radix passes
+		std::vector<ParticleInstance> mStaged;
+		std::vector<uint64_t> mSortEntries;
+		std::vector<uint64_t> mSwapEntries;
+	};
+}
@@ -0,0 +1,234 @@
+#include "stdafx.h"
+#include "projectileSystem.h"
+#include "Engine/Collision/narrowphase.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <immintrin.h>
+#include <limits>
+#ifdef _MSC_VER
+// MSVC compiles AVX intrinsics anywhere, other compilers need the functions using them marked
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace {
+	constexpr size_t gLanes = 8;
+	// Every projectile queries the target grid each tick, a big table keeps far away targets out of the queried buckets
+	constexpr size_t gTargetBucketCount = 64 * 1024;
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	// Moves and ages projectiles [0, count) of the arrays, marking the ones whose lifetime ran out
+	void IntegrateScalar(float* xs, float* ys, const float* velocityXs, const float* velocityYs, float* lifetimes, uint8_t* isDead, const size_t count, const float deltaTime) {
+		for (size_t i = 0; i < count; ++i) {
+			xs[i] += velocityXs[i] * deltaTime;
+			ys[i] += velocityYs[i] * deltaTime;
+			lifetimes[i] -= deltaTime;
+			isDead[i] = lifetimes[i] <= 0.0f;
+		}
+	}
+
+	AVX2_FUNCTION void IntegrateAvx2(float* xs, float* ys, const float* velocityXs, const float* velocityYs, float* lifetimes, uint8_t* isDead, const size_t count, const float deltaTime) {
+		const __m256 step = _mm256_set1_ps(deltaTime);
+		const __m256 zero = _mm256_setzero_ps();
+		const size_t vectorCount = count / gLanes * gLanes;
+		for (size_t i = 0; i < vectorCount; i += gLanes) {
+			_mm256_storeu_ps(xs + i, _mm256_add_ps(_mm256_loadu_ps(xs + i), _mm256_mul_ps(_mm256_loadu_ps(velocityXs + i), step)));
+			_mm256_storeu_ps(ys + i, _mm256_add_ps(_mm256_loadu_ps(ys + i), _mm256_mul_ps(_mm256_loadu_ps(velocityYs + i), step)));
+			const __m256 lifetime = _mm256_sub_ps(_mm256_loadu_ps(lifetimes + i), step);
+			_mm256_storeu_ps(lifetimes + i, lifetime);
+
+			const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(lifetime, zero, _CMP_LE_OQ)));
+			for (size_t lane = 0; lane < gLanes; ++lane) {
+				isDead[i + lane] = static_cast<uint8_t>((mask >> lane) & 1u);
+			}
+		}
+		IntegrateScalar(xs + vectorCount, ys + vectorCount, velocityXs + vectorCount, velocityYs + vectorCount, lifetimes + vectorCount, isDead + vectorCount, count - vectorCount, deltaTime);
+	}
+}
+
+RF::ProjectileSystem::ProjectileSystem(const float targetCellSize, JobSystem* jobSystem)
+	: mJobSystem(jobSystem), mUseAvx2(Narrowphase::IsAvx2Supported()), mTargetGrid(targetCellSize, jobSystem, gTargetBucketCount) {}
+
+RF::ProjectileTypeId RF::ProjectileSystem::AddType(const ProjectileType& type) {
+	assert(mPools.size() < std::numeric_limits<ProjectileTypeId>::max() && "ProjectileSystem has too many types");
+	assert(type.radius >= 0.0f && "ProjectileType radius can't be negative");
+	mPools.push_back({});
+	mPools.back().type = type;
+	return static_cast<ProjectileTypeId>(mPools.size() - 1);
+}
+
+void RF::ProjectileSystem::Reserve(const ProjectileTypeId type, const size_t count) {
+	Pool& pool = mPools[type];
+	pool.xs.reserve(count);
+	pool.ys.reserve(count);
+	pool.velocityXs.reserve(count);
+	pool.velocityYs.reserve(count);
+	pool.lifetimes.reserve(count);
+	pool.owners.reserve(count);
+	pool.piercesLeft.reserve(count);
+	pool.isNew.reserve(count);
+	pool.isDead.reserve(count);
+}
+
+void RF::ProjectileSystem::Spawn(const ProjectileTypeId type, const Vector2& position, const Vector2& velocity, const uint32_t owner) {
+	assert(type < mPools.size() && "ProjectileSystem::Spawn unknown type");
+	Pool& pool = mPools[type];
+	pool.xs.push_back(position.x);
+	pool.ys.push_back(position.y);
+	pool.velocityXs.push_back(velocity.x);
+	pool.velocityYs.push_back(velocity.y);
+	pool.lifetimes.push_back(pool.type.lifetime);
+	pool.owners.push_back(owner);
+	pool.piercesLeft.push_back(pool.type.pierceCount);
+	pool.isNew.push_back(1);
+	pool.isDead.push_back(0);
+}
+
+void RF::ProjectileSystem::SetTargets(std::span<const float> xs, std::span<const float> ys, std::span<const float> radii) {
+	assert(xs.size() == ys.size() && xs.size() == radii.size() && "ProjectileSystem target spans have different sizes");
+	mTargetGrid.Build(xs, ys);
+	mTargetRadii.assign(radii.begin(), radii.end());
+	mMaxTargetRadius = radii.empty() ? 0.0f : *std::max_element(radii.begin(), radii.end());
+}
+
+void RF::ProjectileSystem::Tick(const float deltaTime) {
+	mHits.clear();
+	for (size_t type = 0; type < mPools.size(); ++type) {
+		Pool& pool = mPools[type];
+		const size_t count = pool.xs.size();
+		if (count == 0) {
+			continue;
+		}
+
+		const size_t rangeCount = (count + gProjectilesPerJob - 1) / gProjectilesPerJob;
+		if (mRangeHits.size() < rangeCount) {
+			mRangeHits.resize(rangeCount);
+		}
+		ParallelFor(mJobSystem, count, gProjectilesPerJob, [this, &pool, type, deltaTime](const size_t begin, const size_t end) {
+			std::vector<ProjectileHit>& hits = mRangeHits[begin / gProjectilesPerJob];
+			hits.clear();
+			Integrate(pool, begin, end, deltaTime);
+			if (mTargetGrid.Count() > 0) {
+				std::vector<PathHit> pathHits;
+				for (size_t i = begin; i < end; ++i) {
+					Collide(pool, static_cast<ProjectileTypeId>(type), i, deltaTime, pathHits, hits);
+				}
+			}
+			std::fill(pool.isNew.data() + begin, pool.isNew.data() + end, uint8_t(0));
+		});
+		for (size_t range = 0; range < rangeCount; ++range) {
+			mHits.insert(mHits.end(), mRangeHits[range].begin(), mRangeHits[range].end());
+		}
+		Compact(pool);
+	}
+}
+
+size_t RF::ProjectileSystem::Count() const {
+	size_t count = 0;
+	for (const Pool& pool : mPools) {
+		count += pool.xs.size();
+	}
+	return count;
+}
+
+void RF::ProjectileSystem::SetAvx2Enabled(const bool enabled) {
+	mUseAvx2 = enabled && Narrowphase::IsAvx2Supported();
+}
+
+void RF::ProjectileSystem::Integrate(Pool& pool, const size_t begin, const size_t end, const float deltaTime) const {
+	const auto integrate = mUseAvx2 ? IntegrateAvx2 : IntegrateScalar;
+	integrate(pool.xs.data() + begin, pool.ys.data() + begin, pool.velocityXs.data() + begin, pool.velocityYs.data() + begin,
+		pool.lifetimes.data() + begin, pool.isDead.data() + begin, end - begin, deltaTime);
+}
+
+void RF::ProjectileSystem::Collide(Pool& pool, const ProjectileTypeId type, const size_t i, const float deltaTime, std::vector<PathHit>& pathHits, std::vector<ProjectileHit>& hits) const {
+	// The path over the tick, back from where the projectile is now
+	const Vector2 end(pool.xs[i], pool.ys[i]);
+	const Vector2 path(pool.velocityXs[i] * deltaTime, pool.velocityYs[i] * deltaTime);
+	const Vector2 start = end - path;
+	const float reach = pool.type.radius + mMaxTargetRadius;
+	const Vector2 min(std::min(start.x, end.x) - reach, std::min(start.y, end.y) - reach);
+	const Vector2 max(std::max(start.x, end.x) + reach, std::max(start.y, end.y) + reach);
+
+	// Earliest t in [0, 1] where the projectile enters each target, solving |start + t * path - center| = radius.
+	// A straight path enters a circle once, so a piercing projectile inside a target, or inside several overlapping
+	// ones, doesn't hit them again. Starting inside only counts on the tick the projectile was spawned in
+	pathHits.clear();
+	const float pathLengthSquared = path.LengthSquared();
+	mTargetGrid.ForEachInAabb(min, max, [this, &pool, i, &start, &path, pathLengthSquared, &pathHits](const uint32_t target, const float x, const float y) {
+		const float radius = mTargetRadii[target] + pool.type.radius;
+		const Vector2 offset(start.x - x, start.y - y);
+		const float c = offset.LengthSquared() - radius * radius;
+		if (c <= 0.0f) {
+			if (pool.isNew[i]) {
+				pathHits.push_back({ 0.0f, target });
+			}
+			return;
+		}
+		const float b = offset.Dot(path);
+		const float discriminant = b * b - pathLengthSquared * c;
+		if (pathLengthSquared == 0.0f || b >= 0.0f || discriminant < 0.0f) {
+			return;
+		}
+		const float t = (-b - std::sqrt(discriminant)) / pathLengthSquared;
+		if (t <= 1.0f) {
+			pathHits.push_back({ t, target });
+		}
+	});
+	if (pathHits.empty()) {
+		return;
+	}
+
+	std::sort(pathHits.begin(), pathHits.end(), [](const PathHit& a, const PathHit& b) { return a.t < b.t || (a.t == b.t && a.target < b.target); });
+	for (const PathHit& pathHit : pathHits) {
+		const Vector2 point = start + path * pathHit.t;
+		hits.push_back({ pathHit.target, pool.owners[i], type, point.x, point.y });
+		if (pool.piercesLeft[i] == 0) {
+			pool.isDead[i] = 1;
+			break;
+		}
+		--pool.piercesLeft[i];
+	}
+}
+
+void RF::ProjectileSystem::Compact(Pool& pool) {
+	size_t count = pool.xs.size();
+	for (size_t i = 0; i < count;) {
+		if (!pool.isDead[i]) {
+			++i;
+			continue;
+		}
+		// The last projectile takes the dead one's slot, it is checked next
+		--count;
+		pool.xs[i] = pool.xs[count];
+		pool.ys[i] = pool.ys[count];
+		pool.velocityXs[i] = pool.velocityXs[count];
+		pool.velocityYs[i] = pool.velocityYs[count];
+		pool.lifetimes[i] = pool.lifetimes[count];
+		pool.owners[i] = pool.owners[count];
+		pool.piercesLeft[i] = pool.piercesLeft[count];
+		pool.isNew[i] = pool.isNew[count];
+		pool.isDead[i] = pool.isDead[count];
+	}
+	pool.xs.resize(count);
+	pool.ys.resize(count);
+	pool.velocityXs.resize(count);
+	pool.velocityYs.resize(count);
+	pool.lifetimes.resize(count);
+	pool.owners.resize(count);
+	pool.piercesLeft.resize(count);
+	pool.isNew.resize(count);
+	pool.isDead.resize(count);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Engine/Spatial/spatialHashGrid.h"
+#include "Math/Vector2.h"
+
+namespace RF {
+	class JobSystem;
+
+	using ProjectileTypeId = uint16_t;
+
+	struct ProjectileType {
+		float radius = 0.1f;
+		// Seconds until the projectile expires
+		float lifetime = 2.0f;
+		// Targets it flies through before it is used up, 0 stops at the first one
+		uint32_t pierceCount = 0;
+	};
+
+	// A projectile touching a target this tick
+	struct ProjectileHit {
+		// Index into the spans passed to SetTargets()
+		uint32_t target = 0;
+		// Whatever was passed to Spawn(), e.g. the shooting entity
+		uint32_t owner = 0;
+		ProjectileTypeId type = 0;
+		// Where the projectile's center was on touching the target
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	/// <summary>
+	/// Simulates large numbers of projectiles outside the ECS. Every type has its own SoA pool, so a tick walks
+	/// contiguous arrays of projectiles sharing radius and lifetime: positions and lifetimes are integrated eight at
+	/// a time with AVX2 where the CPU has it, then each projectile's path over the tick is swept as a circle against
+	/// the target grid, so fast projectiles can't skip over targets. Expired and used up projectiles are swap
+	/// removed, so pools stay dense but don't keep their spawn order.
+	/// Ranges of each pool run on the job system, hits come out in the same order however the ranges were spread.
+	/// </summary>
+	class ProjectileSystem {
+	public:
+		/// <param name="targetCellSize">Cell size of the target grid, best around the typical target diameter.</param>
+		explicit ProjectileSystem(const float targetCellSize = 2.0f, JobSystem* jobSystem = nullptr);
+		ProjectileSystem(const ProjectileSystem&) = delete;
+		void operator=(const ProjectileSystem&) = delete;
+
+		ProjectileTypeId AddType(const ProjectileType& type);
+		const ProjectileType& GetType(const ProjectileTypeId type) const { return mPools[type].type; }
+		void Reserve(const ProjectileTypeId type, const size_t count);
+
+		void Spawn(const ProjectileTypeId type, const Vector2& position, const Vector2& velocity, const uint32_t owner = 0);
+
+		/// <summary>
+		/// Sets the circles projectiles hit from the next Tick() on, e.g. the enemies' positions this frame.
+		/// </summary>
+		void SetTargets(std::span<const float> xs, std::span<const float> ys, std::span<const float> radii);
+
+		/// <summary>
+		/// Moves every projectile, finds what it hit on the way and removes the expired and used up ones.
+		/// </summary>
+		void Tick(const float deltaTime);
+
+		// Hits of the last Tick(), by type, then by position in the pool, then along the projectile's path
+		std::span<const ProjectileHit> GetHits() const { return mHits; }
+
+		size_t Count() const;
+		size_t Count(const ProjectileTypeId type) const { return mPools[type].xs.size(); }
+		// Current state of a type's pool, in pool order
+		std::span<const float> Xs(const ProjectileTypeId type) const { return mPools[type].xs; }
+		std::span<const float> Ys(const ProjectileTypeId type) const { return mPools[type].ys; }
+
+		void SetAvx2Enabled(const bool enabled);
+
+		static constexpr size_t gProjectilesPerJob = 4096;
+
+	private:
+		struct Pool {
+			ProjectileType type;
+			std::vector<float> xs;
+			std::vector<float> ys;
+			std::vector<float> velocityXs;
+			std::vector<float> velocityYs;
+			// Seconds left
+			std::vector<float> lifetimes;
+			std::vector<uint32_t> owners;
+			std::vector<uint32_t> piercesLeft;
+			// Set until the projectile's first tick is done, the only tick starting inside a target counts as a hit
+			std::vector<uint8_t> isNew;
+			// Set during a tick for projectiles to remove
+			std::vector<uint8_t> isDead;
+		};
+
+		// Target the path touches, t is how far along the tick
+		struct PathHit {
+			float t = 0.0f;
+			uint32_t target = 0;
+		};
+
+		void Integrate(Pool& pool, const size_t begin, const size_t end, const float deltaTime) const;
+		// Sweeps projectile i from where it was before the tick to where it is now
+		void Collide(Pool& pool, const ProjectileTypeId type, const size_t i, const float deltaTime, std::vector<PathHit>& pathHits, std::vector<ProjectileHit>& hits) const;
+		static void Compact(Pool& pool);
+
+		JobSystem* mJobSystem = nullptr;
+		bool mUseAvx2 = false;
+		std::vector<Pool> mPools;
+
+		SpatialHashGrid mTargetGrid;
+		std::vector<float> mTargetRadii;
+		float mMaxTargetRadius = 0.0f;
+
+		std::vector<ProjectileHit> mHits;
+		// Per job range hits, joined in range order
+		std::vector<std::vector<ProjectileHit>> mRangeHits;
+	};
+}
@@ -0,0 +1,402 @@
+#include "stdafx.h"
+#include "transformHierarchy.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <xmmintrin.h>
+
+namespace {
+	// Levels with fewer dirty nodes are cheaper to do on the calling thread than to hand out
+	constexpr size_t gParallelNodeCount = 16 * 1024;
+	constexpr uint32_t gNodesPerJob = 4 * 1024;
+}
+
+RF::Affine2D RF::Transforms::ToAffine(const Transform2D& transform) {
+	const float cos = std::cos(transform.rotation);
+	const float sin = std::sin(transform.rotation);
+	return {
+		.m00 = cos * transform.scaleX,
+		.m01 = -sin * transform.scaleY,
+		.m10 = sin * transform.scaleX,
+		.m11 = cos * transform.scaleY,
+		.tx = transform.x,
+		.ty = transform.y,
+	};
+}
+
+RF::Affine2D RF::Transforms::Multiply(const Affine2D& parent, const Affine2D& child) {
+	return {
+		.m00 = parent.m00 * child.m00 + parent.m01 * child.m10,
+		.m01 = parent.m00 * child.m01 + parent.m01 * child.m11,
+		.m10 = parent.m10 * child.m00 + parent.m11 * child.m10,
+		.m11 = parent.m10 * child.m01 + parent.m11 * child.m11,
+		.tx = parent.m00 * child.tx + parent.m01 * child.ty + parent.tx,
+		.ty = parent.m10 * child.tx + parent.m11 * child.ty + parent.ty,
+	};
+}
+
+RF::TransformHierarchy::TransformHierarchy(JobSystem* jobSystem) : mJobSystem(jobSystem) {}
+
+RF::TransformId RF::TransformHierarchy::Create(const TransformId parent, const Transform2D& local) {
+	TransformId id = 0;
+	if (mFreeIds.empty()) {
+		id = static_cast<TransformId>(mIndices.size());
+		mIndices.push_back(gNone);
+	}
+	else {
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+
+	// Appended out of order, the next Update() sorts it into its level
+	const uint32_t index = static_cast<uint32_t>(mParents.size());
+	mIndices[id] = index;
+	mParents.push_back(parent == gNoTransform ? gNone : IndexOf(parent));
+	mIds.push_back(id);
+	mFirstChildren.push_back(0);
+	mChildCounts.push_back(0);
+	mIsDirty.push_back(0);
+	for (AffineColumns* columns : { &mLocal, &mWorld }) {
+		columns->m00.push_back(1.0f);
+		columns->m01.push_back(0.0f);
+		columns->m10.push_back(0.0f);
+		columns->m11.push_back(1.0f);
+		columns->tx.push_back(0.0f);
+		columns->ty.push_back(0.0f);
+	}
+
+	SetLocal(id, local);
+	mIsSorted = false;
+	++mLiveCount;
+	return id;
+}
+
+void RF::TransformHierarchy::Destroy(const TransformId id) {
+	const uint32_t index = IndexOf(id);
+	mIds[index] = gNoTransform;
+	mIndices[id] = gNone;
+	mFreeIds.push_back(id);
+	mIsSorted = false;
+	--mLiveCount;
+}
+
+bool RF::TransformHierarchy::IsAlive(const TransformId id) const {
+	return id < mIndices.size() && mIndices[id] != gNone;
+}
+
+void RF::TransformHierarchy::SetParent(const TransformId id, const TransformId parent) {
+	const uint32_t index = IndexOf(id);
+	const uint32_t parentIndex = parent == gNoTransform ? gNone : IndexOf(parent);
+	for (uint32_t ancestor = parentIndex; ancestor != gNone; ancestor = mParents[ancestor]) {
+		assert(ancestor != index && "TransformHierarchy: a node can't be parented to its own subtree");
+	}
+
+	mParents[index] = parentIndex;
+	MarkDirty(index);
+	mIsSorted = false;
+}
+
+RF::TransformId RF::TransformHierarchy::GetParent(const TransformId id) const {
+	const uint32_t parentIndex = mParents[IndexOf(id)];
+	return parentIndex == gNone ? gNoTransform : mIds[parentIndex];
+}
+
+void RF::TransformHierarchy::SetLocal(const TransformId id, const Transform2D& local) {
+	SetLocal(id, Transforms::ToAffine(local));
+}
+
+void RF::TransformHierarchy::SetLocal(const TransformId id, const Affine2D& local) {
+	const uint32_t index = IndexOf(id);
+	mLocal.m00[index] = local.m00;
+	mLocal.m01[index] = local.m01;
+	mLocal.m10[index] = local.m10;
+	mLocal.m11[index] = local.m11;
+	mLocal.tx[index] = local.tx;
+	mLocal.ty[index] = local.ty;
+	MarkDirty(index);
+}
+
+RF::Affine2D RF::TransformHierarchy::GetLocal(const TransformId id) const {
+	const uint32_t index = IndexOf(id);
+	return { mLocal.m00[index], mLocal.m01[index], mLocal.m10[index], mLocal.m11[index], mLocal.tx[index], mLocal.ty[index] };
+}
+
+RF::Affine2D RF::TransformHierarchy::GetWorld(const TransformId id) const {
+	const uint32_t index = IndexOf(id);
+	return { mWorld.m00[index], mWorld.m01[index], mWorld.m10[index], mWorld.m11[index], mWorld.tx[index], mWorld.ty[index] };
+}
+
+void RF::TransformHierarchy::Update() {
+	if (!mIsSorted) {
+		Sort();
+	}
+
+	std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+	auto dirty = mDirtyNodes.cbegin();
+
+	size_t updatedCount = 0;
+	std::vector<Range> parentRanges;
+	std::vector<Range> ranges;
+	std::vector<Range> jobRanges;
+	for (size_t level = 0; level < LevelCount(); ++level) {
+		CollectRanges(level, parentRanges, dirty, ranges);
+		if (ranges.empty() && dirty == mDirtyNodes.cend()) {
+			break;
+		}
+
+		size_t nodeCount = 0;
+		for (const Range& range : ranges) {
+			nodeCount += range.end - range.begin;
+		}
+		updatedCount += nodeCount;
+
+		if (!mJobSystem || nodeCount < gParallelNodeCount) {
+			for (const Range& range : ranges) {
+				UpdateRange(range);
+			}
+		}
+		else {
+			// Long runs are cut so every job gets about the same number of nodes
+			jobRanges.clear();
+			for (const Range& range : ranges) {
+				for (uint32_t begin = range.begin; begin < range.end; begin += gNodesPerJob) {
+					jobRanges.push_back({ begin, std::min(begin + gNodesPerJob, range.end) });
+				}
+			}
+
+			const size_t rangesPerJob = std::max<size_t>(1, jobRanges.size() * gNodesPerJob / nodeCount);
+			mJobSystem->ParallelFor(jobRanges.size(), rangesPerJob, [this, &jobRanges](const size_t begin, const size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					UpdateRange(jobRanges[i]);
+				}
+			});
+		}
+
+		parentRanges.swap(ranges);
+	}
+
+	for (const uint32_t index : mDirtyNodes) {
+		mIsDirty[index] = 0;
+	}
+	mDirtyNodes.clear();
+	mLastUpdatedCount = updatedCount;
+}
+
+uint32_t RF::TransformHierarchy::IndexOf(const TransformId id) const {
+	assert(IsAlive(id) && "TransformHierarchy: the node was destroyed");
+	return mIndices[id];
+}
+
+void RF::TransformHierarchy::MarkDirty(const uint32_t index) {
+	if (!mIsDirty[index]) {
+		mIsDirty[index] = 1;
+		mDirtyNodes.push_back(index);
+	}
+}
+
+void RF::TransformHierarchy::Sort() {
+	const uint32_t nodeCount = static_cast<uint32_t>(mParents.size());
+
+	// Children of every node, in their current order
+	std::vector<uint32_t> childStarts(nodeCount + 1, 0);
+	for (uint32_t i = 0; i < nodeCount; ++i) {
+		if (mIds[i] != gNoTransform && mParents[i] != gNone) {
+			++childStarts[mParents[i] + 1];
+		}
+	}
+	for (uint32_t i = 0; i < nodeCount; ++i) {
+		childStarts[i + 1] += childStarts[i];
+	}
+	std::vector<uint32_t> children(childStarts[nodeCount]);
+	std::vector<uint32_t> childEnds(childStarts.begin(), childStarts.end() - 1);
+	for (uint32_t i = 0; i < nodeCount; ++i) {
+		if (mIds[i] != gNoTransform && mParents[i] != gNone) {
+			children[childEnds[mParents[i]]++] = i;
+		}
+	}
+
+	// Breadth first from the roots. Destroyed nodes are never reached and neither is anything below them
+	std::vector<uint32_t> order;
+	order.reserve(nodeCount);
+	for (uint32_t i = 0; i < nodeCount; ++i) {
+		if (mIds[i] != gNoTransform && mParents[i] == gNone) {
+			order.push_back(i);
+		}
+	}
+
+	std::vector<uint32_t> firstChildren(order.size());
+	std::vector<uint32_t> childCounts(order.size());
+	mLevelStarts.assign(1, 0);
+	size_t levelBegin = 0;
+	while (levelBegin < order.size()) {
+		const size_t levelEnd = order.size();
+		for (size_t i = levelBegin; i < levelEnd; ++i) {
+			const uint32_t node = order[i];
+			firstChildren[i] = static_cast<uint32_t>(order.size());
+			childCounts[i] = childStarts[node + 1] - childStarts[node];
+			order.insert(order.end(), children.begin() + childStarts[node], children.begin() + childStarts[node + 1]);
+		}
+		firstChildren.resize(order.size());
+		childCounts.resize(order.size());
+		mLevelStarts.push_back(static_cast<uint32_t>(levelEnd));
+		levelBegin = levelEnd;
+	}
+
+	std::vector<uint32_t> newIndices(nodeCount, gNone);
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		newIndices[order[i]] = i;
+	}
+
+	// Nodes below a destroyed one go with it
+	for (uint32_t i = 0; i < nodeCount; ++i) {
+		if (mIds[i] != gNoTransform && newIndices[i] == gNone) {
+			mIndices[mIds[i]] = gNone;
+			mFreeIds.push_back(mIds[i]);
+			--mLiveCount;
+		}
+	}
+
+	auto permute = [&order](auto& values) {
+		std::remove_reference_t<decltype(values)> sorted(order.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			sorted[i] = values[order[i]];
+		}
+		values.swap(sorted);
+	};
+
+	permute(mParents);
+	permute(mIds);
+	permute(mIsDirty);
+	for (AffineColumns* columns : { &mLocal, &mWorld }) {
+		permute(columns->m00);
+		permute(columns->m01);
+		permute(columns->m10);
+		permute(columns->m11);
+		permute(columns->tx);
+		permute(columns->ty);
+	}
+
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		if (mParents[i] != gNone) {
+			mParents[i] = newIndices[mParents[i]];
+		}
+		mIndices[mIds[i]] = i;
+	}
+	mFirstChildren.swap(firstChildren);
+	mChildCounts.swap(childCounts);
+
+	std::vector<uint32_t> dirtyNodes;
+	for (const uint32_t index : mDirtyNodes) {
+		if (newIndices[index] != gNone) {
+			dirtyNodes.push_back(newIndices[index]);
+		}
+	}
+	mDirtyNodes.swap(dirtyNodes);
+
+	mIsSorted = true;
+}
+
+void RF::TransformHierarchy::CollectRanges(const size_t level, const std::vector<Range>& parentRanges, std::vector<uint32_t>::const_iterator& dirty, std::vector<Range>& ranges) const {
+	ranges.clear();
+	auto append = [&ranges](const Range& range) {
+		if (!ranges.empty() && range.begin <= ranges.back().end) {
+			ranges.back().end = std::max(ranges.back().end, range.end);
+		}
+		else {
+			ranges.push_back(range);
+		}
+	};
+
+	// Everything below a recomputed node is recomputed, the children of a range of parents are one range too.
+	// Both lists are sorted, merging them keeps the result sorted
+	const uint32_t levelEnd = mLevelStarts[level + 1];
+	auto parentRange = parentRanges.begin();
+	while (parentRange != parentRanges.end() || (dirty != mDirtyNodes.cend() && *dirty < levelEnd)) {
+		const bool isDirtyNext = dirty != mDirtyNodes.cend() && *dirty < levelEnd
+			&& (parentRange == parentRanges.end() || *dirty < mFirstChildren[parentRange->begin]);
+		if (isDirtyNext) {
+			append({ *dirty, *dirty + 1 });
+			++dirty;
+			continue;
+		}
+
+		const uint32_t last = parentRange->end - 1;
+		const Range childRange = { mFirstChildren[parentRange->begin], mFirstChildren[last] + mChildCounts[last] };
+		if (childRange.begin < childRange.end) {
+			append(childRange);
+		}
+		++parentRange;
+	}
+}
+
+void RF::TransformHierarchy::UpdateRange(const Range& range) {
+	const float* localM00 = mLocal.m00.data();
+	const float* localM01 = mLocal.m01.data();
+	const float* localM10 = mLocal.m10.data();
+	const float* localM11 = mLocal.m11.data();
+	const float* localTx = mLocal.tx.data();
+	const float* localTy = mLocal.ty.data();
+	float* worldM00 = mWorld.m00.data();
+	float* worldM01 = mWorld.m01.data();
+	float* worldM10 = mWorld.m10.data();
+	float* worldM11 = mWorld.m11.data();
+	float* worldTx = mWorld.tx.data();
+	float* worldTy = mWorld.ty.data();
+
+	// A range never spans levels, roots are copied
+	if (mParents[range.begin] == gNone) {
+		const size_t count = range.end - range.begin;
+		std::copy_n(localM00 + range.begin, count, worldM00 + range.begin);
+		std::copy_n(localM01 + range.begin, count, worldM01 + range.begin);
+		std::copy_n(localM10 + range.begin, count, worldM10 + range.begin);
+		std::copy_n(localM11 + range.begin, count, worldM11 + range.begin);
+		std::copy_n(localTx + range.begin, count, worldTx + range.begin);
+		std::copy_n(localTy + range.begin, count, worldTy + range.begin);
+		return;
+	}
+
+	// Four children at a time, their parents are in the previous level and already done
+	const uint32_t* parents = mParents.data();
+	uint32_t i = range.begin;
+	for (; i + 4 <= range.end; i += 4) {
+		const uint32_t p0 = parents[i];
+		const uint32_t p1 = parents[i + 1];
+		const uint32_t p2 = parents[i + 2];
+		const uint32_t p3 = parents[i + 3];
+		const __m128 parentM00 = _mm_setr_ps(worldM00[p0], worldM00[p1], worldM00[p2], worldM00[p3]);
+		const __m128 parentM01 = _mm_setr_ps(worldM01[p0], worldM01[p1], worldM01[p2], worldM01[p3]);
+		const __m128 parentM10 = _mm_setr_ps(worldM10[p0], worldM10[p1], worldM10[p2], worldM10[p3]);
+		const __m128 parentM11 = _mm_setr_ps(worldM11[p0], worldM11[p1], worldM11[p2], worldM11[p3]);
+		const __m128 parentTx = _mm_setr_ps(worldTx[p0], worldTx[p1], worldTx[p2], worldTx[p3]);
+		const __m128 parentTy = _mm_setr_ps(worldTy[p0], worldTy[p1], worldTy[p2], worldTy[p3]);
+
+		const __m128 childM00 = _mm_loadu_ps(localM00 + i);
+		const __m128 childM01 = _mm_loadu_ps(localM01 + i);
+		const __m128 childM10 = _mm_loadu_ps(localM10 + i);
+		const __m128 childM11 = _mm_loadu_ps(localM11 + i);
+		const __m128 childTx = _mm_loadu_ps(localTx + i);
+		const __m128 childTy = _mm_loadu_ps(localTy + i);
+
+		_mm_storeu_ps(worldM00 + i, _mm_add_ps(_mm_mul_ps(parentM00, childM00), _mm_mul_ps(parentM01, childM10)));
+		_mm_storeu_ps(worldM01 + i, _mm_add_ps(_mm_mul_ps(parentM00, childM01), _mm_mul_ps(parentM01, childM11)));
+		_mm_storeu_ps(worldM10 + i, _mm_add_ps(_mm_mul_ps(parentM10, childM00), _mm_mul_ps(parentM11, childM10)));
+		_mm_storeu_ps(worldM11 + i, _mm_add_ps(_mm_mul_ps(parentM10, childM01), _mm_mul_ps(parentM11, childM11)));
+		_mm_storeu_ps(worldTx + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(parentM00, childTx), _mm_mul_ps(parentM01, childTy)), parentTx));
+		_mm_storeu_ps(worldTy + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(parentM10, childTx), _mm_mul_ps(parentM11, childTy)), parentTy));
+	}
+
+	for (; i < range.end; ++i) {
+		const uint32_t p = parents[i];
+		const Affine2D world = Transforms::Multiply(
+			{ worldM00[p], worldM01[p], worldM10[p], worldM11[p], worldTx[p], worldTy[p] },
+			{ localM00[i], localM01[i], localM10[i], localM11[i], localTx[i], localTy[i] });
+		worldM00[i] = world.m00;
+		worldM01[i] = world.m01;
+		worldM10[i] = world.m10;
+		worldM11[i] = world.m11;
+		worldTx[i] = world.tx;
+		worldTy[i] = world.ty;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RF {
+	class JobSystem;
+
+	using TransformId = uint32_t;
+	constexpr TransformId gNoTransform = UINT32_MAX;
+
+	// Local transform, scale is applied first, then rotation (radians, counter clockwise), then translation
+	struct Transform2D {
+		float x = 0.0f;
+		float y = 0.0f;
+		float rotation = 0.0f;
+		float scaleX = 1.0f;
+		float scaleY = 1.0f;
+	};
+
+	// 2D affine matrix, a point p maps to (m00 * p.x + m01 * p.y + tx, m10 * p.x + m11 * p.y + ty)
+	struct Affine2D {
+		float m00 = 1.0f;
+		float m01 = 0.0f;
+		float m10 = 0.0f;
+		float m11 = 1.0f;
+		float tx = 0.0f;
+		float ty = 0.0f;
+	};
+
+	namespace Transforms {
+		Affine2D ToAffine(const Transform2D& transform);
+		/// <returns>The transform that applies child first and then parent.</returns>
+		Affine2D Multiply(const Affine2D& parent, const Affine2D& child);
+	}
+
+	/// <summary>
+	/// Parent/child transforms stored as SoA arrays sorted by depth, breadth first, so every parent comes before its
+	/// children and the children of consecutive parents are consecutive too. Update() recomputes world transforms
+	/// level by level and only visits the subtrees below nodes whose local transform was set, four nodes at a time
+	/// with SSE. Large levels are split over the job system.
+	/// Structural changes (create, destroy, reparent) re-sort the arrays on the next Update(), which is linear in
+	/// the node count, so they are meant to be occasional and batched, not every node every frame.
+	/// </summary>
+	class TransformHierarchy {
+	public:
+		explicit TransformHierarchy(JobSystem* jobSystem = nullptr);
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		void operator=(const TransformHierarchy&) = delete;
+
+		/// <summary>
+		/// Ids of destroyed nodes are reused.
+		/// </summary>
+		TransformId Create(const TransformId parent = gNoTransform, const Transform2D& local = {});
+
+		/// <summary>
+		/// Destroys the node and, on the next Update(), everything below it.
+		/// </summary>
+		void Destroy(const TransformId id);
+		bool IsAlive(const TransformId id) const;
+
+		/// <summary>
+		/// Keeps the local transform, so the node moves with its new parent. A node can't become its own ancestor.
+		/// </summary>
+		void SetParent(const TransformId id, const TransformId parent);
+		TransformId GetParent(const TransformId id) const;
+
+		void SetLocal(const TransformId id, const Transform2D& local);
+		void SetLocal(const TransformId id, const Affine2D& local);
+		Affine2D GetLocal(const TransformId id) const;
+
+		/// <returns>The world transform as of the last Update().</returns>
+		Affine2D GetWorld(const TransformId id) const;
+
+		void Update();
+
+		size_t Count() const { return mLiveCount; }
+		size_t LevelCount() const { return mLevelStarts.empty() ? 0 : mLevelStarts.size() - 1; }
+		/// <returns>Number of world transforms the last Update() computed.</returns>
+		size_t LastUpdatedCount() const { return mLastUpdatedCount; }
+
+	private:
+		static constexpr uint32_t gNone = UINT32_MAX;
+
+		// Nodes [begin, end) of one level to recompute
+		struct Range {
+			uint32_t begin = 0;
+			uint32_t end = 0;
+		};
+
+		struct AffineColumns {
+			std::vector<float> m00;
+			std::vector<float> m01;
+			std::vector<float> m10;
+			std::vector<float> m11;
+			std::vector<float> tx;
+			std::vector<float> ty;
+		};
+
+		uint32_t IndexOf(const TransformId id) const;
+		void MarkDirty(const uint32_t index);
+		void Sort();
+		void CollectRanges(const size_t level, const std::vector<Range>& parentRanges, std::vector<uint32_t>::const_iterator& dirty, std::vector<Range>& ranges) const;
+		void UpdateRange(const Range& range);
+
+		JobSystem* mJobSystem = nullptr;
+
+		// Per node, in depth order. Nodes created since the last sort are appended at the end
+		std::vector<uint32_t> mParents;
+		std::vector<TransformId> mIds;
+		// Index of the first child, children of a node are consecutive in the next level
+		std::vector<uint32_t> mFirstChildren;
+		std::vector<uint32_t> mChildCounts;
+		std::vector<uint8_t> mIsDirty;
+		AffineColumns mLocal;
+		AffineColumns mWorld;
+		std::vector<uint32_t> mLevelStarts;
+
+		// Per id, its node index, gNone for free ids
+		std::vector<uint32_t> mIndices;
+		std::vector<TransformId> mFreeIds;
+		size_t mLiveCount = 0;
+
+		std::vector<uint32_t> mDirtyNodes;
+		bool mIsSorted = true;
+		size_t mLastUpdatedCount = 0;
+	};
+}
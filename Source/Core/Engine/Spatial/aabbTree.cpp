@@ -0,0 +1,407 @@
+#include "stdafx.h"
+#include "aabbTree.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+	// Moving leaves get a fat box stretched this many frames of displacement ahead
+	constexpr float gDisplacementMultiplier = 2.0f;
+	// A fat box this many margins larger than a fresh one is shrunk on the next move
+	constexpr float gShrinkMargins = 4.0f;
+	constexpr size_t gCastsPerJob = 256;
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+
+	Vector2 Center(const RF::Aabb& bounds) {
+		return Vector2(0.5f * (bounds.min.x + bounds.max.x), 0.5f * (bounds.min.y + bounds.max.y));
+	}
+}
+
+RF::AabbTree::AabbTree(const float margin, JobSystem* jobSystem) : mMargin(margin), mJobSystem(jobSystem) {}
+
+RF::ProxyId RF::AabbTree::Create(const Aabb& bounds, const uint32_t userData) {
+	const uint32_t leaf = AllocateNode();
+	mNodes[leaf].bounds = Bounds::Expanded(bounds, mMargin);
+	mNodes[leaf].userData = userData;
+	InsertLeaf(leaf);
+	++mProxyCount;
+	return leaf;
+}
+
+void RF::AabbTree::Destroy(const ProxyId proxy) {
+	assert(proxy < mNodes.size() && mNodes[proxy].height == 0 && "AabbTree::Destroy received an invalid proxy");
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--mProxyCount;
+}
+
+bool RF::AabbTree::Move(const ProxyId proxy, const Aabb& bounds, const Vector2& displacement) {
+	assert(proxy < mNodes.size() && mNodes[proxy].height == 0 && "AabbTree::Move received an invalid proxy");
+
+	Aabb fat = Bounds::Expanded(bounds, mMargin);
+	const Vector2 stretch(displacement.x * gDisplacementMultiplier, displacement.y * gDisplacementMultiplier);
+	(stretch.x < 0.0f ? fat.min.x : fat.max.x) += stretch.x;
+	(stretch.y < 0.0f ? fat.min.y : fat.max.y) += stretch.y;
+
+	const Aabb& current = mNodes[proxy].bounds;
+	if (Bounds::Contains(current, bounds)) {
+		// Still holds the collider, but a box much larger than needed reports overlaps that aren't there
+		if (Bounds::Contains(Bounds::Expanded(fat, gShrinkMargins * mMargin), current)) {
+			return false;
+		}
+	}
+
+	RemoveLeaf(proxy);
+	mNodes[proxy].bounds = fat;
+	InsertLeaf(proxy);
+	return true;
+}
+
+void RF::AabbTree::Build(std::span<const Aabb> bounds, std::span<const uint32_t> userData) {
+	assert((userData.empty() || userData.size() == bounds.size()) && "AabbTree::Build received a different number of bounds and user data");
+	Clear();
+	mNodes.reserve(bounds.size() * 2);
+	mNodes.resize(bounds.size());
+
+	std::vector<uint32_t> leaves(bounds.size());
+	for (uint32_t i = 0; i < bounds.size(); ++i) {
+		mNodes[i].bounds = Bounds::Expanded(bounds[i], mMargin);
+		mNodes[i].userData = userData.empty() ? i : userData[i];
+		mNodes[i].height = 0;
+		leaves[i] = i;
+	}
+
+	mProxyCount = bounds.size();
+	mRoot = leaves.empty() ? gNullProxy : BuildTopDown(leaves, gNullProxy);
+}
+
+void RF::AabbTree::Rebuild() {
+	std::vector<uint32_t> leaves;
+	leaves.reserve(mProxyCount);
+	for (uint32_t i = 0; i < mNodes.size(); ++i) {
+		if (mNodes[i].height == 0) {
+			leaves.push_back(i);
+		}
+		else if (mNodes[i].height > 0) {
+			FreeNode(i);
+		}
+	}
+
+	mRoot = leaves.empty() ? gNullProxy : BuildTopDown(leaves, gNullProxy);
+}
+
+void RF::AabbTree::Clear() {
+	mNodes.clear();
+	mRoot = gNullProxy;
+	mFreeList = gNullProxy;
+	mProxyCount = 0;
+}
+
+float RF::AabbTree::AreaRatio() const {
+	if (mRoot == gNullProxy) {
+		return 0.0f;
+	}
+
+	float total = 0.0f;
+	for (const Node& node : mNodes) {
+		if (node.height > 0) {
+			total += Bounds::Perimeter(node.bounds);
+		}
+	}
+	return total / Bounds::Perimeter(mNodes[mRoot].bounds);
+}
+
+bool RF::AabbTree::Validate() const {
+	if (mRoot == gNullProxy) {
+		return mProxyCount == 0;
+	}
+	if (mNodes[mRoot].parent != gNullProxy) {
+		return false;
+	}
+
+	size_t leafCount = 0;
+	std::vector<uint32_t> stack = { mRoot };
+	while (!stack.empty()) {
+		const uint32_t index = stack.back();
+		stack.pop_back();
+		const Node& node = mNodes[index];
+		if (IsLeaf(node)) {
+			if (node.height != 0 || node.child2 != gNullProxy) {
+				return false;
+			}
+			++leafCount;
+			continue;
+		}
+
+		const Node& child1 = mNodes[node.child1];
+		const Node& child2 = mNodes[node.child2];
+		if (child1.parent != index || child2.parent != index || node.height != 1 + std::max(child1.height, child2.height)) {
+			return false;
+		}
+		if (!Bounds::Contains(node.bounds, child1.bounds) || !Bounds::Contains(node.bounds, child2.bounds)) {
+			return false;
+		}
+		stack.push_back(node.child1);
+		stack.push_back(node.child2);
+	}
+
+	size_t freeCount = 0;
+	for (uint32_t index = mFreeList; index != gNullProxy; index = mNodes[index].parent) {
+		++freeCount;
+	}
+	return leafCount == mProxyCount && 2 * leafCount - 1 + freeCount == mNodes.size();
+}
+
+void RF::AabbTree::QueryOverlaps(std::span<const Aabb> bounds, SpatialQueryBatch& results) const {
+	results.Run<int>(mJobSystem, bounds.size(), [this, &bounds](const size_t query, int&, std::vector<uint32_t>& out) {
+		Query(bounds[query], [&out](const ProxyId proxy) {
+			out.push_back(proxy);
+			return true;
+		});
+	});
+}
+
+void RF::AabbTree::RayCast(std::span<const Vector2> origins, std::span<const Vector2> displacements, std::span<AabbTreeHit> hits) const {
+	CastBatch(origins, displacements, {}, hits);
+}
+
+void RF::AabbTree::Sweep(std::span<const Aabb> boxes, std::span<const Vector2> displacements, std::span<AabbTreeHit> hits) const {
+	std::vector<Vector2> centers(boxes.size());
+	std::vector<Vector2> halfExtents(boxes.size());
+	for (size_t i = 0; i < boxes.size(); ++i) {
+		centers[i] = Center(boxes[i]);
+		halfExtents[i] = Vector2(0.5f * (boxes[i].max.x - boxes[i].min.x), 0.5f * (boxes[i].max.y - boxes[i].min.y));
+	}
+	CastBatch(centers, displacements, halfExtents, hits);
+}
+
+uint32_t RF::AabbTree::AllocateNode() {
+	if (mFreeList == gNullProxy) {
+		mFreeList = static_cast<uint32_t>(mNodes.size());
+		mNodes.push_back({});
+	}
+
+	const uint32_t index = mFreeList;
+	mFreeList = mNodes[index].parent;
+	mNodes[index] = { .height = 0 };
+	return index;
+}
+
+void RF::AabbTree::FreeNode(const uint32_t index) {
+	mNodes[index].parent = mFreeList;
+	mNodes[index].child1 = gNullProxy;
+	mNodes[index].child2 = gNullProxy;
+	mNodes[index].height = -1;
+	mFreeList = index;
+}
+
+void RF::AabbTree::InsertLeaf(const uint32_t leaf) {
+	if (mRoot == gNullProxy) {
+		mRoot = leaf;
+		mNodes[leaf].parent = gNullProxy;
+		return;
+	}
+
+	// Walks down while splitting a child costs less than making the leaf a sibling of the whole subtree. Every
+	// node on the way grows by the leaf's box, which is the inherited cost of going deeper
+	const Aabb leafBounds = mNodes[leaf].bounds;
+	uint32_t index = mRoot;
+	while (!IsLeaf(mNodes[index])) {
+		const Node& node = mNodes[index];
+		const float perimeter = Bounds::Perimeter(node.bounds);
+		const float combinedPerimeter = Bounds::Perimeter(Bounds::Union(node.bounds, leafBounds));
+		const float siblingCost = 2.0f * combinedPerimeter;
+		const float inheritedCost = 2.0f * (combinedPerimeter - perimeter);
+
+		auto descendCost = [this, &leafBounds, inheritedCost](const uint32_t child) {
+			const float grown = Bounds::Perimeter(Bounds::Union(leafBounds, mNodes[child].bounds));
+			return (IsLeaf(mNodes[child]) ? grown : grown - Bounds::Perimeter(mNodes[child].bounds)) + inheritedCost;
+		};
+		const float cost1 = descendCost(node.child1);
+		const float cost2 = descendCost(node.child2);
+		if (siblingCost < cost1 && siblingCost < cost2) {
+			break;
+		}
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	const uint32_t sibling = index;
+	const uint32_t oldParent = mNodes[sibling].parent;
+	const uint32_t newParent = AllocateNode();
+	mNodes[newParent].parent = oldParent;
+	mNodes[newParent].bounds = Bounds::Union(leafBounds, mNodes[sibling].bounds);
+	mNodes[newParent].height = mNodes[sibling].height + 1;
+	mNodes[newParent].child1 = sibling;
+	mNodes[newParent].child2 = leaf;
+	mNodes[sibling].parent = newParent;
+	mNodes[leaf].parent = newParent;
+
+	if (oldParent == gNullProxy) {
+		mRoot = newParent;
+	}
+	else if (mNodes[oldParent].child1 == sibling) {
+		mNodes[oldParent].child1 = newParent;
+	}
+	else {
+		mNodes[oldParent].child2 = newParent;
+	}
+
+	for (index = mNodes[leaf].parent; index != gNullProxy; index = mNodes[index].parent) {
+		Rotate(index);
+		Node& node = mNodes[index];
+		node.height = 1 + std::max(mNodes[node.child1].height, mNodes[node.child2].height);
+		node.bounds = Bounds::Union(mNodes[node.child1].bounds, mNodes[node.child2].bounds);
+	}
+}
+
+void RF::AabbTree::RemoveLeaf(const uint32_t leaf) {
+	if (leaf == mRoot) {
+		mRoot = gNullProxy;
+		return;
+	}
+
+	const uint32_t parent = mNodes[leaf].parent;
+	const uint32_t grandParent = mNodes[parent].parent;
+	const uint32_t sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+	FreeNode(parent);
+
+	mNodes[sibling].parent = grandParent;
+	if (grandParent == gNullProxy) {
+		mRoot = sibling;
+		return;
+	}
+
+	(mNodes[grandParent].child1 == parent ? mNodes[grandParent].child1 : mNodes[grandParent].child2) = sibling;
+	for (uint32_t index = grandParent; index != gNullProxy; index = mNodes[index].parent) {
+		Rotate(index);
+		Node& node = mNodes[index];
+		node.height = 1 + std::max(mNodes[node.child1].height, mNodes[node.child2].height);
+		node.bounds = Bounds::Union(mNodes[node.child1].bounds, mNodes[node.child2].bounds);
+	}
+}
+
+void RF::AabbTree::Rotate(const uint32_t indexA) {
+	const Node& a = mNodes[indexA];
+	if (a.height < 2) {
+		return;
+	}
+
+	// A's box holds the same leaves whatever happens below it, so a rotation only changes the perimeters of A's
+	// children. Candidates swap one child with a grandchild under the other child, or a grandchild from each side.
+	const uint32_t indexB = a.child1;
+	const uint32_t indexC = a.child2;
+	const Node& b = mNodes[indexB];
+	const Node& c = mNodes[indexC];
+	const float perimeterB = Bounds::Perimeter(b.bounds);
+	const float perimeterC = Bounds::Perimeter(c.bounds);
+	auto unionPerimeter = [this](const uint32_t x, const uint32_t y) { return Bounds::Perimeter(Bounds::Union(mNodes[x].bounds, mNodes[y].bounds)); };
+
+	auto pairHeight = [this](const uint32_t x, const uint32_t y) { return 1 + std::max(mNodes[x].height, mNodes[y].height); };
+
+	// Ties go to the lower tree, so boxes the heuristic can't tell apart, like a stack of identical crates, don't
+	// pile up into a list
+	float bestGain = 0.0f;
+	int32_t bestHeight = std::max(b.height, c.height);
+	uint32_t swapX = gNullProxy;
+	uint32_t swapY = gNullProxy;
+	auto consider = [&bestGain, &bestHeight, &swapX, &swapY](const float gain, const int32_t height, const uint32_t x, const uint32_t y) {
+		if (gain > bestGain || (gain == bestGain && height < bestHeight)) {
+			bestGain = gain;
+			bestHeight = height;
+			swapX = x;
+			swapY = y;
+		}
+	};
+
+	if (!IsLeaf(c)) {
+		// B swapped with F leaves C holding B and G
+		consider(perimeterC - unionPerimeter(indexB, c.child2), std::max(mNodes[c.child1].height, pairHeight(indexB, c.child2)), indexB, c.child1);
+		consider(perimeterC - unionPerimeter(indexB, c.child1), std::max(mNodes[c.child2].height, pairHeight(indexB, c.child1)), indexB, c.child2);
+	}
+	if (!IsLeaf(b)) {
+		consider(perimeterB - unionPerimeter(indexC, b.child2), std::max(mNodes[b.child1].height, pairHeight(indexC, b.child2)), indexC, b.child1);
+		consider(perimeterB - unionPerimeter(indexC, b.child1), std::max(mNodes[b.child2].height, pairHeight(indexC, b.child1)), indexC, b.child2);
+	}
+	if (!IsLeaf(b) && !IsLeaf(c)) {
+		// D swapped with F leaves B holding F and E, and C holding D and G
+		consider(perimeterB + perimeterC - unionPerimeter(c.child1, b.child2) - unionPerimeter(b.child1, c.child2),
+			std::max(pairHeight(c.child1, b.child2), pairHeight(b.child1, c.child2)), b.child1, c.child1);
+		consider(perimeterB + perimeterC - unionPerimeter(c.child2, b.child2) - unionPerimeter(b.child1, c.child1),
+			std::max(pairHeight(c.child2, b.child2), pairHeight(b.child1, c.child1)), b.child1, c.child2);
+	}
+	if (swapX == gNullProxy) {
+		return;
+	}
+
+	const uint32_t parentX = mNodes[swapX].parent;
+	const uint32_t parentY = mNodes[swapY].parent;
+	(mNodes[parentX].child1 == swapX ? mNodes[parentX].child1 : mNodes[parentX].child2) = swapY;
+	(mNodes[parentY].child1 == swapY ? mNodes[parentY].child1 : mNodes[parentY].child2) = swapX;
+	mNodes[swapX].parent = parentY;
+	mNodes[swapY].parent = parentX;
+
+	for (const uint32_t index : { mNodes[indexA].child1, mNodes[indexA].child2 }) {
+		Node& node = mNodes[index];
+		if (!IsLeaf(node)) {
+			node.height = 1 + std::max(mNodes[node.child1].height, mNodes[node.child2].height);
+			node.bounds = Bounds::Union(mNodes[node.child1].bounds, mNodes[node.child2].bounds);
+		}
+	}
+}
+
+uint32_t RF::AabbTree::BuildTopDown(std::span<uint32_t> leaves, const uint32_t parent) {
+	if (leaves.size() == 1) {
+		mNodes[leaves[0]].parent = parent;
+		return leaves[0];
+	}
+
+	Aabb centers = { Center(mNodes[leaves[0]].bounds), Center(mNodes[leaves[0]].bounds) };
+	for (const uint32_t leaf : leaves) {
+		const Vector2 center = Center(mNodes[leaf].bounds);
+		centers = Bounds::Union(centers, { center, center });
+	}
+
+	const bool isXAxis = centers.max.x - centers.min.x >= centers.max.y - centers.min.y;
+	const size_t middle = leaves.size() / 2;
+	std::nth_element(leaves.begin(), leaves.begin() + static_cast<std::ptrdiff_t>(middle), leaves.end(), [this, isXAxis](const uint32_t lhs, const uint32_t rhs) {
+		const Vector2 lhsCenter = Center(mNodes[lhs].bounds);
+		const Vector2 rhsCenter = Center(mNodes[rhs].bounds);
+		return isXAxis ? lhsCenter.x < rhsCenter.x : lhsCenter.y < rhsCenter.y;
+	});
+
+	const uint32_t index = AllocateNode();
+	const uint32_t child1 = BuildTopDown(leaves.first(middle), index);
+	const uint32_t child2 = BuildTopDown(leaves.subspan(middle), index);
+	Node& node = mNodes[index];
+	node.parent = parent;
+	node.child1 = child1;
+	node.child2 = child2;
+	node.bounds = Bounds::Union(mNodes[child1].bounds, mNodes[child2].bounds);
+	node.height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+	return index;
+}
+
+void RF::AabbTree::CastBatch(std::span<const Vector2> origins, std::span<const Vector2> displacements, std::span<const Vector2> halfExtents, std::span<AabbTreeHit> hits) const {
+	assert(origins.size() == displacements.size() && origins.size() == hits.size() && "AabbTree cast batch received spans of different sizes");
+	ParallelFor(mJobSystem, origins.size(), gCastsPerJob, [this, &origins, &displacements, &halfExtents, &hits](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			AabbTreeHit& hit = hits[i];
+			hit = {};
+			Cast(origins[i], displacements[i], halfExtents.empty() ? Vector2::Zero : halfExtents[i], 1.0f, [this, &hit](const ProxyId proxy, const float fraction) {
+				if (hit.proxy == gNullProxy || fraction < hit.fraction) {
+					hit = { proxy, mNodes[proxy].userData, fraction };
+				}
+				return fraction;
+			});
+		}
+	});
+}
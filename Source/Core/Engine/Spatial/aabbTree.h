@@ -0,0 +1,231 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "spatialQueryBatch.h"
+#include "Math/Vector2.h"
+
+namespace RF {
+	class JobSystem;
+
+	using ProxyId = uint32_t;
+	constexpr ProxyId gNullProxy = UINT32_MAX;
+
+	struct Aabb {
+		Vector2 min = {};
+		Vector2 max = {};
+	};
+
+	namespace Bounds {
+		inline Aabb Union(const Aabb& a, const Aabb& b) {
+			return { Vector2(std::fmin(a.min.x, b.min.x), std::fmin(a.min.y, b.min.y)), Vector2(std::fmax(a.max.x, b.max.x), std::fmax(a.max.y, b.max.y)) };
+		}
+		// The 2D surface area heuristic uses the perimeter
+		inline float Perimeter(const Aabb& bounds) { return 2.0f * ((bounds.max.x - bounds.min.x) + (bounds.max.y - bounds.min.y)); }
+		inline bool Overlaps(const Aabb& a, const Aabb& b) {
+			return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+		}
+		inline bool Contains(const Aabb& outer, const Aabb& inner) {
+			return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+		}
+		inline Aabb Expanded(const Aabb& bounds, const float margin) {
+			return { Vector2(bounds.min.x - margin, bounds.min.y - margin), Vector2(bounds.max.x + margin, bounds.max.y + margin) };
+		}
+	}
+
+	// Closest hit of a ray or sweep, fraction of the displacement at which it starts touching the proxy's box
+	struct AabbTreeHit {
+		ProxyId proxy = gNullProxy;
+		uint32_t userData = 0;
+		float fraction = 1.0f;
+	};
+
+	/// <summary>
+	/// Incremental bounding volume tree for colliders that are large or rarely move, like level geometry and boss
+	/// hitboxes. Leaves store fat boxes, grown by a margin and the predicted displacement, so small moves don't touch
+	/// the tree. Inserting descends toward the sibling with the least added perimeter (the 2D surface area heuristic),
+	/// and every node on the path back up takes the tree rotation that lowers its children's perimeters the most, as
+	/// in Bittner et al.'s incremental BVH optimization. Nodes live in one flat array and refer to each other
+	/// by index, freed nodes are reused.
+	/// Batched overlap, raycast and sweep queries run over the job system.
+	/// </summary>
+	class AabbTree {
+	public:
+		/// <param name="margin">How far a leaf's box reaches beyond its collider on every side.</param>
+		explicit AabbTree(const float margin = 0.1f, JobSystem* jobSystem = nullptr);
+		AabbTree(const AabbTree&) = delete;
+		void operator=(const AabbTree&) = delete;
+
+		ProxyId Create(const Aabb& bounds, const uint32_t userData = 0);
+		void Destroy(const ProxyId proxy);
+
+		/// <summary>
+		/// Updates a proxy's collider. The leaf is only reinserted when the collider left its fat box, or when the
+		/// fat box became much larger than needed.
+		/// </summary>
+		/// <param name="displacement">Expected movement until the next call, the fat box is stretched along it.</param>
+		/// <returns>True if the leaf was reinserted.</returns>
+		bool Move(const ProxyId proxy, const Aabb& bounds, const Vector2& displacement = Vector2::Zero);
+
+		/// <summary>
+		/// Replaces every proxy, bounds[i] becomes proxy i, and builds the tree top down in one go.
+		/// </summary>
+		/// <param name="userData">Empty to use the proxy ids.</param>
+		void Build(std::span<const Aabb> bounds, std::span<const uint32_t> userData = {});
+
+		/// <summary>
+		/// Throws the internal nodes away and builds them again top down from the leaves, splitting at the median of
+		/// the longest axis. Worth it after many moves left the tree worse than a fresh one.
+		/// </summary>
+		void Rebuild();
+		void Clear();
+
+		const Aabb& GetFatBounds(const ProxyId proxy) const { return mNodes[proxy].bounds; }
+		uint32_t GetUserData(const ProxyId proxy) const { return mNodes[proxy].userData; }
+		size_t ProxyCount() const { return mProxyCount; }
+		// 0 for a single leaf, -1 for an empty tree
+		int Height() const { return mRoot == gNullProxy ? -1 : mNodes[mRoot].height; }
+		/// <summary>
+		/// Sum of the internal nodes' perimeters over the root's, lower is a better tree.
+		/// </summary>
+		float AreaRatio() const;
+
+		/// <summary>
+		/// Checks parent links, heights and that every node's box holds its children.
+		/// </summary>
+		bool Validate() const;
+
+		/// <summary>
+		/// Calls func(proxy) for every proxy whose fat box overlaps bounds, stops early if func returns false.
+		/// </summary>
+		template <typename Func>
+		void Query(const Aabb& bounds, Func&& func) const {
+			Stack stack;
+			stack.Push(mRoot);
+			while (!stack.IsEmpty()) {
+				const uint32_t index = stack.Pop();
+				if (index == gNullProxy || !Bounds::Overlaps(mNodes[index].bounds, bounds)) {
+					continue;
+				}
+
+				if (IsLeaf(mNodes[index])) {
+					if (!func(index)) {
+						return;
+					}
+				}
+				else {
+					stack.Push(mNodes[index].child1);
+					stack.Push(mNodes[index].child2);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Casts a box with the given half extents (zero for a ray) from origin along displacement. Calls
+		/// func(proxy, fraction) for every fat box it touches with the fraction where it starts touching it, func
+		/// returns the new maximum fraction: 0 to stop, fraction to only look for closer hits, or the old maximum to
+		/// keep going.
+		/// </summary>
+		template <typename Func>
+		void Cast(const Vector2& origin, const Vector2& displacement, const Vector2& halfExtents, float maxFraction, Func&& func) const {
+			const Vector2 inverse(1.0f / displacement.x, 1.0f / displacement.y);
+			Stack stack;
+			stack.Push(mRoot);
+			while (!stack.IsEmpty()) {
+				const uint32_t index = stack.Pop();
+				if (index == gNullProxy) {
+					continue;
+				}
+
+				const Node& node = mNodes[index];
+				const float fraction = EntryFraction(node.bounds, origin, inverse, halfExtents, maxFraction);
+				if (fraction > maxFraction) {
+					continue;
+				}
+
+				if (IsLeaf(node)) {
+					maxFraction = func(index, fraction);
+					if (maxFraction <= 0.0f) {
+						return;
+					}
+				}
+				else {
+					stack.Push(node.child1);
+					stack.Push(node.child2);
+				}
+			}
+		}
+
+		// Batched queries, run over the job system. Overlaps are reported as proxy ids
+		void QueryOverlaps(std::span<const Aabb> bounds, SpatialQueryBatch& results) const;
+		void RayCast(std::span<const Vector2> origins, std::span<const Vector2> displacements, std::span<AabbTreeHit> hits) const;
+		void Sweep(std::span<const Aabb> boxes, std::span<const Vector2> displacements, std::span<AabbTreeHit> hits) const;
+
+	private:
+		static constexpr size_t gStackSize = 256;
+
+		struct Node {
+			Aabb bounds = {};
+			// The next free node while the node is free
+			uint32_t parent = gNullProxy;
+			uint32_t child1 = gNullProxy;
+			uint32_t child2 = gNullProxy;
+			// 0 for leaves, -1 for free nodes
+			int32_t height = -1;
+			uint32_t userData = 0;
+		};
+
+		// Traversal stack, balanced trees of any size the array can address stay far below its depth
+		class Stack {
+		public:
+			void Push(const uint32_t index) {
+				assert(mCount < gStackSize && "AabbTree traversal stack overflow");
+				mItems[mCount++] = index;
+			}
+			uint32_t Pop() { return mItems[--mCount]; }
+			bool IsEmpty() const { return mCount == 0; }
+
+		private:
+			std::array<uint32_t, gStackSize> mItems;
+			size_t mCount = 0;
+		};
+
+		static bool IsLeaf(const Node& node) { return node.child1 == gNullProxy; }
+
+		// Slab test of origin + t * displacement against bounds grown by halfExtents, returns above maxFraction on a miss
+		static float EntryFraction(const Aabb& bounds, const Vector2& origin, const Vector2& inverse, const Vector2& halfExtents, const float maxFraction) {
+			const float x1 = (bounds.min.x - halfExtents.x - origin.x) * inverse.x;
+			const float x2 = (bounds.max.x + halfExtents.x - origin.x) * inverse.x;
+			const float y1 = (bounds.min.y - halfExtents.y - origin.y) * inverse.y;
+			const float y2 = (bounds.max.y + halfExtents.y - origin.y) * inverse.y;
+			// fmin/fmax drop the NaN of a zero axis whose origin lies on the slab boundary
+			const float entry = std::fmax(std::fmax(std::fmin(x1, x2), std::fmin(y1, y2)), 0.0f);
+			const float exit = std::fmin(std::fmin(std::fmax(x1, x2), std::fmax(y1, y2)), maxFraction);
+			return entry <= exit ? entry : maxFraction + 1.0f;
+		}
+
+		uint32_t AllocateNode();
+		void FreeNode(const uint32_t index);
+		void InsertLeaf(const uint32_t leaf);
+		void RemoveLeaf(const uint32_t leaf);
+		// Swaps a child and a grandchild, or two grandchildren, of the node if that lowers the sum of its children's
+		// perimeters the most, the node itself stays where it is
+		void Rotate(const uint32_t index);
+		uint32_t BuildTopDown(std::span<uint32_t> leaves, const uint32_t parent);
+		// Closest hit for every cast, halfExtents is empty for rays
+		void CastBatch(std::span<const Vector2> origins, std::span<const Vector2> displacements, std::span<const Vector2> halfExtents, std::span<AabbTreeHit> hits) const;
+
+		float mMargin = 0.1f;
+		JobSystem* mJobSystem = nullptr;
+
+		std::vector<Node> mNodes;
+		uint32_t mRoot = gNullProxy;
+		uint32_t mFreeList = gNullProxy;
+		size_t mProxyCount = 0;
+	};
+}
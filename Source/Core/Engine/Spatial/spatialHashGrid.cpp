@@ -0,0 +1,246 @@
+#include "stdafx.h"
+#include "spatialHashGrid.h"
+#include "Engine/Jobs/jobSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace {
+	constexpr size_t gMinBucketCount = 1024;
+	// Fewer points than this per range are cheaper to sort on the calling thread than to hand out
+	constexpr size_t gPointsPerRange = 8 * 1024;
+	constexpr size_t gBucketsPerJob = 16 * 1024;
+
+	void ParallelFor(RF::JobSystem* jobSystem, const size_t count, const size_t batchSize, const std::function<void(size_t begin, size_t end)>& func) {
+		if (jobSystem) {
+			jobSystem->ParallelFor(count, batchSize, func);
+		}
+		else if (count > 0) {
+			func(0, count);
+		}
+	}
+}
+
+RF::SpatialHashGrid::SpatialHashGrid(const float cellSize, JobSystem* jobSystem, const size_t minBucketCount)
+	: mCellSize(cellSize), mInverseCellSize(1.0f / cellSize), mJobSystem(jobSystem), mMinBucketCount(std::max(gMinBucketCount, std::bit_ceil(minBucketCount))) {
+	assert(cellSize > 0.0f && "SpatialHashGrid needs a positive cell size");
+}
+
+void RF::SpatialHashGrid::Build(std::span<const float> xs, std::span<const float> ys, std::span<const uint32_t> ids) {
+	assert(xs.size() == ys.size() && "SpatialHashGrid::Build received a different number of xs and ys");
+	assert((ids.empty() || ids.size() == xs.size()) && "SpatialHashGrid::Build received a different number of ids and positions");
+	assert(xs.size() < UINT32_MAX && "SpatialHashGrid::Build received too many points");
+
+	const size_t count = xs.size();
+	const size_t bucketCount = std::max(mMinBucketCount, std::bit_ceil(count));
+	const uint32_t bucketBits = static_cast<uint32_t>(std::bit_width(bucketCount) - 1);
+	mColumnShift = (bucketBits + 1) / 2;
+	mColumnMask = (1u << mColumnShift) - 1;
+	mRowMask = (1u << (bucketBits - mColumnShift)) - 1;
+	mBucketStarts.resize(bucketCount + 1);
+	mXs.resize(count);
+	mYs.resize(count);
+	mIds.resize(count);
+	mPointBuckets.resize(count);
+
+	const size_t maxRangeCount = mJobSystem ? mJobSystem->WorkerCount() + size_t{ 1 } : 1;
+	const size_t rangeCount = std::clamp<size_t>(count / gPointsPerRange, 1, maxRangeCount);
+	const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+	mRangeCounts.resize(rangeCount * bucketCount);
+
+	// Count how many points of each range land in each bucket
+	ParallelFor(mJobSystem, rangeCount, 1, [this, &xs, &ys, count, bucketCount, rangeSize](const size_t begin, const size_t end) {
+		for (size_t range = begin; range < end; ++range) {
+			uint32_t* counts = mRangeCounts.data() + range * bucketCount;
+			std::fill(counts, counts + bucketCount, 0u);
+			for (size_t i = range * rangeSize; i < std::min(count, (range + 1) * rangeSize); ++i) {
+				const Vector2i cell = CellOf(Vector2(xs[i], ys[i]));
+				const uint32_t bucket = BucketOf(cell.x, cell.y);
+				mPointBuckets[i] = bucket;
+				++counts[bucket];
+			}
+		}
+	});
+
+	ParallelFor(mJobSystem, bucketCount, gBucketsPerJob, [this, bucketCount, rangeCount](const size_t begin, const size_t end) {
+		for (size_t bucket = begin; bucket < end; ++bucket) {
+			uint32_t total = 0;
+			for (size_t range = 0; range < rangeCount; ++range) {
+				total += mRangeCounts[range * bucketCount + bucket];
+			}
+			mBucketStarts[bucket] = total;
+		}
+	});
+
+	uint32_t start = 0;
+	for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+		const uint32_t bucketSize = mBucketStarts[bucket];
+		mBucketStarts[bucket] = start;
+		start += bucketSize;
+	}
+	mBucketStarts[bucketCount] = start;
+
+	// Each range writes its points of a bucket after those of the ranges before it
+	ParallelFor(mJobSystem, bucketCount, gBucketsPerJob, [this, bucketCount, rangeCount](const size_t begin, const size_t end) {
+		for (size_t bucket = begin; bucket < end; ++bucket) {
+			uint32_t offset = mBucketStarts[bucket];
+			for (size_t range = 0; range < rangeCount; ++range) {
+				const uint32_t rangeBucketSize = mRangeCounts[range * bucketCount + bucket];
+				mRangeCounts[range * bucketCount + bucket] = offset;
+				offset += rangeBucketSize;
+			}
+		}
+	});
+
+	ParallelFor(mJobSystem, rangeCount, 1, [this, &xs, &ys, &ids, count, bucketCount, rangeSize](const size_t begin, const size_t end) {
+		for (size_t range = begin; range < end; ++range) {
+			uint32_t* offsets = mRangeCounts.data() + range * bucketCount;
+			for (size_t i = range * rangeSize; i < std::min(count, (range + 1) * rangeSize); ++i) {
+				const uint32_t slot = offsets[mPointBuckets[i]]++;
+				mXs[slot] = xs[i];
+				mYs[slot] = ys[i];
+				mIds[slot] = ids.empty() ? static_cast<uint32_t>(i) : ids[i];
+			}
+		}
+	});
+}
+
+// The collecting queries write every point they test and only advance past the ones inside, the test fails too
+// unpredictably for a branch
+void RF::SpatialHashGrid::QueryRadius(const Vector2& center, const float radius, std::vector<uint32_t>& out) const {
+	const float radiusSquared = radius * radius;
+	size_t count = out.size();
+	ForEachSlotRange(Vector2(center.x - radius, center.y - radius), Vector2(center.x + radius, center.y + radius), [this, &center, radiusSquared, &out, &count](const uint32_t begin, const uint32_t end) {
+		out.resize(count + (end - begin));
+		uint32_t* ids = out.data();
+		for (uint32_t i = begin; i < end; ++i) {
+			const float dx = mXs[i] - center.x;
+			const float dy = mYs[i] - center.y;
+			ids[count] = mIds[i];
+			count += static_cast<size_t>(dx * dx + dy * dy <= radiusSquared);
+		}
+	});
+	out.resize(count);
+}
+
+void RF::SpatialHashGrid::QueryAabb(const Vector2& min, const Vector2& max, std::vector<uint32_t>& out) const {
+	size_t count = out.size();
+	ForEachSlotRange(min, max, [this, &min, &max, &out, &count](const uint32_t begin, const uint32_t end) {
+		out.resize(count + (end - begin));
+		uint32_t* ids = out.data();
+		for (uint32_t i = begin; i < end; ++i) {
+			ids[count] = mIds[i];
+			count += static_cast<size_t>((mXs[i] >= min.x) & (mXs[i] <= max.x) & (mYs[i] >= min.y) & (mYs[i] <= max.y));
+		}
+	});
+	out.resize(count);
+}
+
+void RF::SpatialHashGrid::QueryNearest(const Vector2& center, const size_t count, const float maxRadius, std::vector<uint32_t>& out) const {
+	std::vector<Candidate> candidates;
+	FindNearest(center, count, maxRadius, candidates, out);
+}
+
+void RF::SpatialHashGrid::QueryRadius(std::span<const Vector2> centers, const float radius, SpatialQueryBatch& results) const {
+	results.Run<std::vector<Candidate>>(mJobSystem, centers.size(), [this, &centers, radius](const size_t query, std::vector<Candidate>&, std::vector<uint32_t>& out) {
+		QueryRadius(centers[query], radius, out);
+	});
+}
+
+void RF::SpatialHashGrid::QueryAabb(std::span<const Vector2> mins, std::span<const Vector2> maxs, SpatialQueryBatch& results) const {
+	assert(mins.size() == maxs.size() && "SpatialHashGrid::QueryAabb received a different number of mins and maxs");
+	results.Run<std::vector<Candidate>>(mJobSystem, mins.size(), [this, &mins, &maxs](const size_t query, std::vector<Candidate>&, std::vector<uint32_t>& out) {
+		QueryAabb(mins[query], maxs[query], out);
+	});
+}
+
+void RF::SpatialHashGrid::QueryNearest(std::span<const Vector2> centers, const size_t count, const float maxRadius, SpatialQueryBatch& results) const {
+	results.Run<std::vector<Candidate>>(mJobSystem, centers.size(), [this, &centers, count, maxRadius](const size_t query, std::vector<Candidate>& candidates, std::vector<uint32_t>& out) {
+		FindNearest(centers[query], count, maxRadius, candidates, out);
+	});
+}
+
+void RF::SpatialHashGrid::FindNearest(const Vector2& center, const size_t count, const float maxRadius, std::vector<Candidate>& candidates, std::vector<uint32_t>& out) const {
+	if (count == 0 || mIds.empty()) {
+		return;
+	}
+
+	auto keyOf = [](const float distanceSquared, const uint32_t id) { return (static_cast<uint64_t>(std::bit_cast<uint32_t>(distanceSquared)) << 32) | id; };
+	size_t found = 0;
+	uint64_t maxKey = 0;
+	auto addSlots = [this, &center, &keyOf, &maxKey, &candidates, &found](const uint32_t begin, const uint32_t end) {
+		// Locals, so the stores into candidates don't make the compiler reload them
+		size_t added = found;
+		const uint64_t keyLimit = maxKey;
+		candidates.resize(added + (end - begin));
+		Candidate* slots = candidates.data();
+		for (uint32_t i = begin; i < end; ++i) {
+			const float dx = mXs[i] - center.x;
+			const float dy = mYs[i] - center.y;
+			slots[added].key = keyOf(dx * dx + dy * dy, mIds[i]);
+			added += static_cast<size_t>(slots[added].key <= keyLimit);
+		}
+		found = added;
+		candidates.resize(found);
+	};
+
+	// Usually the center's cell and its neighbours hold enough points within a cell size, and those are then the
+	// nearest ones overall, the same as a radius query
+	const Vector2i cell = CellOf(center);
+	const float firstRadius = std::min(mCellSize, maxRadius);
+	maxKey = keyOf(firstRadius * firstRadius, UINT32_MAX);
+	candidates.clear();
+	ForEachSlotRangeInCells(Vector2i(cell.x - 1, cell.y - 1), Vector2i(cell.x + 1, cell.y + 1), addSlots);
+
+	// Otherwise visits rings of cells around the center's cell, taking every point within maxRadius, until count
+	// of them are closer than the nearest point outside the rings visited so far, or that point is beyond
+	// maxRadius. A ring as wide or high as the table would visit buckets twice, then every point is checked instead.
+	if (found < count && firstRadius < maxRadius) {
+		const int64_t tableSize = std::min<int64_t>(mColumnMask + 1, mRowMask + 1);
+		// Points right at maxRadius count, whatever their id
+		maxKey = keyOf(maxRadius * maxRadius, UINT32_MAX);
+		found = 0;
+		for (int ring = 1; true; ++ring) {
+			if (2 * static_cast<int64_t>(ring) + 1 > tableSize) {
+				found = 0;
+				addSlots(0, static_cast<uint32_t>(mIds.size()));
+				break;
+			}
+
+			const Vector2i first(cell.x - ring, cell.y - ring);
+			const Vector2i last(cell.x + ring, cell.y + ring);
+			if (ring == 1) {
+				ForEachSlotRangeInCells(first, last, addSlots);
+			}
+			else {
+				ForEachSlotRangeInCells(first, Vector2i(last.x, first.y), addSlots);
+				ForEachSlotRangeInCells(Vector2i(first.x, last.y), last, addSlots);
+				ForEachSlotRangeInCells(Vector2i(first.x, first.y + 1), Vector2i(first.x, last.y - 1), addSlots);
+				ForEachSlotRangeInCells(Vector2i(last.x, first.y + 1), Vector2i(last.x, last.y - 1), addSlots);
+			}
+
+			const float gap = std::min(
+				std::min(center.x - static_cast<float>(first.x) * mCellSize, static_cast<float>(last.x + 1) * mCellSize - center.x),
+				std::min(center.y - static_cast<float>(first.y) * mCellSize, static_cast<float>(last.y + 1) * mCellSize - center.y));
+			if (gap > maxRadius) {
+				break;
+			}
+			// The gap is negative when the center is beyond the cells CellOf() clamps to
+			const uint64_t settledKey = keyOf(gap > 0.0f ? gap * gap : 0.0f, 0);
+			size_t settled = 0;
+			for (const Candidate& candidate : candidates) {
+				settled += static_cast<size_t>(candidate.key < settledKey);
+			}
+			if (settled >= count) {
+				break;
+			}
+		}
+	}
+
+	found = std::min(count, found);
+	std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(found), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) { return lhs.key < rhs.key; });
+	for (size_t i = 0; i < found; ++i) {
+		out.push_back(static_cast<uint32_t>(candidates[i].key));
+	}
+}
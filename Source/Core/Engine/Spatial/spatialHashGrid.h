@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "spatialQueryBatch.h"
+#include "Math/Vector2.h"
+
+namespace RF {
+	/// <summary>
+	/// Uniform grid over points that move every frame, rebuilt from scratch with a counting sort: every point's cell
+	/// is mapped to a bucket, buckets are counted, prefix summed and the points scattered into flat arrays sorted by
+	/// bucket. Counting and scattering are split into contiguous ranges of points over the job system, and each
+	/// range scatters at its own offsets, so points in a bucket stay in input order however many jobs run.
+	/// The world isn't bounded, the bucket table is a power of two wide and high and wraps around, so cell (x, y)
+	/// shares its bucket with cells a table width or height away and queries filter by position. Neighbouring cells
+	/// of a row are neighbouring buckets, a query reads one contiguous range of points per row of cells.
+	/// Ids are uint32_t, by default the index of the point passed to Build(), e.g. an entity index or a slot in
+	/// the caller's SoA arrays.
+	/// </summary>
+	class SpatialHashGrid {
+	public:
+		/// <param name="cellSize">Best around the typical query radius.</param>
+		/// <param name="minBucketCount">Grids queried far more often than they are built, e.g. a few thousand enemies hit
+		/// by a couple hundred thousand projectiles, want a bigger table so fewer far away points share the queried buckets.</param>
+		explicit SpatialHashGrid(const float cellSize, JobSystem* jobSystem = nullptr, const size_t minBucketCount = 0);
+		SpatialHashGrid(const SpatialHashGrid&) = delete;
+		void operator=(const SpatialHashGrid&) = delete;
+
+		/// <param name="ids">Empty to use the indices into xs and ys.</param>
+		void Build(std::span<const float> xs, std::span<const float> ys, std::span<const uint32_t> ids = {});
+
+		size_t Count() const { return mIds.size(); }
+		float CellSize() const { return mCellSize; }
+		size_t BucketCount() const { return mBucketStarts.empty() ? 0 : mBucketStarts.size() - 1; }
+
+		/// <summary>
+		/// Clamped to +-2^30 cells, so infinite or far away query bounds stay valid ints.
+		/// </summary>
+		Vector2i CellOf(const Vector2& position) const {
+			return Vector2i(CellCoordinate(position.x), CellCoordinate(position.y));
+		}
+
+		/// <summary>
+		/// Calls func(id, x, y) for every point within radius of center, in bucket order.
+		/// </summary>
+		template <typename Func>
+		void ForEachInRadius(const Vector2& center, const float radius, Func&& func) const {
+			const float radiusSquared = radius * radius;
+			ForEachSlotRange(Vector2(center.x - radius, center.y - radius), Vector2(center.x + radius, center.y + radius), [this, &center, radiusSquared, &func](const uint32_t begin, const uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					const float dx = mXs[i] - center.x;
+					const float dy = mYs[i] - center.y;
+					if (dx * dx + dy * dy <= radiusSquared) {
+						func(mIds[i], mXs[i], mYs[i]);
+					}
+				}
+			});
+		}
+
+		/// <summary>
+		/// Calls func(id, x, y) for every point inside [min, max].
+		/// </summary>
+		template <typename Func>
+		void ForEachInAabb(const Vector2& min, const Vector2& max, Func&& func) const {
+			ForEachSlotRange(min, max, [this, &min, &max, &func](const uint32_t begin, const uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					if (mXs[i] >= min.x && mXs[i] <= max.x && mYs[i] >= min.y && mYs[i] <= max.y) {
+						func(mIds[i], mXs[i], mYs[i]);
+					}
+				}
+			});
+		}
+
+		// Single queries append to out
+		void QueryRadius(const Vector2& center, const float radius, std::vector<uint32_t>& out) const;
+		void QueryAabb(const Vector2& min, const Vector2& max, std::vector<uint32_t>& out) const;
+		/// <summary>
+		/// Up to count ids within maxRadius, nearest first, ties broken by id. maxRadius may be infinite.
+		/// </summary>
+		void QueryNearest(const Vector2& center, const size_t count, const float maxRadius, std::vector<uint32_t>& out) const;
+
+		// Batched queries run over the job system, results are the same as running the single queries in order
+		void QueryRadius(std::span<const Vector2> centers, const float radius, SpatialQueryBatch& results) const;
+		void QueryAabb(std::span<const Vector2> mins, std::span<const Vector2> maxs, SpatialQueryBatch& results) const;
+		void QueryNearest(std::span<const Vector2> centers, const size_t count, const float maxRadius, SpatialQueryBatch& results) const;
+
+	private:
+		// Squared distance bits above the id, non-negative floats order like their bits so keys sort by distance
+		// and then by id
+		struct Candidate {
+			uint64_t key = 0;
+		};
+
+		int CellCoordinate(const float coordinate) const {
+			constexpr float maxCell = 1073741824.0f;
+			return static_cast<int>(std::clamp(std::floor(coordinate * mInverseCellSize), -maxCell, maxCell));
+		}
+
+		uint32_t BucketOf(const int cellX, const int cellY) const {
+			return ((static_cast<uint32_t>(cellY) & mRowMask) << mColumnShift) | (static_cast<uint32_t>(cellX) & mColumnMask);
+		}
+
+		// Calls func(begin, end) with the ranges of sorted points in the buckets of the cells overlapping [min, max],
+		// one range per row of cells, two where the row wraps around the table
+		template <typename Func>
+		void ForEachSlotRange(const Vector2& min, const Vector2& max, Func&& func) const {
+			ForEachSlotRangeInCells(CellOf(min), CellOf(max), func);
+		}
+
+		// The same over the cells from first to last
+		template <typename Func>
+		void ForEachSlotRangeInCells(const Vector2i& first, const Vector2i& last, Func&& func) const {
+			if (mIds.empty() || last.x < first.x || last.y < first.y) {
+				return;
+			}
+
+			// Ranges as wide or high as the table cover every bucket of a row or every row once
+			const uint32_t columnCount = mColumnMask + 1;
+			const bool isAllColumns = static_cast<int64_t>(last.x) - first.x + 1 >= columnCount;
+			const bool isAllRows = static_cast<int64_t>(last.y) - first.y + 1 > mRowMask;
+			const uint32_t firstColumn = static_cast<uint32_t>(first.x) & mColumnMask;
+			const uint32_t lastColumn = static_cast<uint32_t>(last.x) & mColumnMask;
+			const uint32_t rowCount = isAllRows ? mRowMask + 1 : static_cast<uint32_t>(last.y - first.y + 1);
+			for (uint32_t i = 0; i < rowCount; ++i) {
+				const uint32_t row = ((isAllRows ? 0u : static_cast<uint32_t>(first.y)) + i) & mRowMask;
+				const uint32_t rowStart = row << mColumnShift;
+				if (isAllColumns) {
+					func(mBucketStarts[rowStart], mBucketStarts[rowStart + columnCount]);
+				}
+				else if (firstColumn <= lastColumn) {
+					func(mBucketStarts[rowStart + firstColumn], mBucketStarts[rowStart + lastColumn + 1]);
+				}
+				else {
+					func(mBucketStarts[rowStart + firstColumn], mBucketStarts[rowStart + columnCount]);
+					func(mBucketStarts[rowStart], mBucketStarts[rowStart + lastColumn + 1]);
+				}
+			}
+		}
+
+		void FindNearest(const Vector2& center, const size_t count, const float maxRadius, std::vector<Candidate>& candidates, std::vector<uint32_t>& out) const;
+
+		float mCellSize = 1.0f;
+		float mInverseCellSize = 1.0f;
+		JobSystem* mJobSystem = nullptr;
+		size_t mMinBucketCount = 0;
+
+		// The table is (mColumnMask + 1) buckets wide and (mRowMask + 1) high
+		uint32_t mColumnShift = 0;
+		uint32_t mColumnMask = 0;
+		uint32_t mRowMask = 0;
+		// Points of bucket b are [mBucketStarts[b], mBucketStarts[b + 1]) in the sorted arrays
+		std::vector<uint32_t> mBucketStarts;
+		std::vector<float> mXs;
+		std::vector<float> mYs;
+		std::vector<uint32_t> mIds;
+
+		// Build scratch: each point's bucket, and per job range bucket counts that become scatter offsets
+		std::vector<uint32_t> mPointBuckets;
+		std::vector<uint32_t> mRangeCounts;
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+
+namespace RF {
+	/// <summary>
+	/// Ids found by a batch of spatial queries, Results(i) are the ones for the i-th query. Reusing a batch across
+	/// frames keeps its buffers.
+	/// </summary>
+	class SpatialQueryBatch {
+	public:
+		size_t QueryCount() const { return mOffsets.empty() ? 0 : mOffsets.size() - 1; }
+		std::span<const uint32_t> Results(const size_t query) const {
+			return std::span<const uint32_t>(mIds).subspan(mOffsets[query], mOffsets[query + 1] - mOffsets[query]);
+		}
+		// Every query's results back to back
+		std::span<const uint32_t> Ids() const { return mIds; }
+
+		/// <summary>
+		/// Refills the batch by calling query(i, scratch, ids) for every query, which appends its results to ids.
+		/// Queries run in jobs of gQueriesPerJob over the job system if there is one, each job has its own default
+		/// constructed Scratch. Results end up in query order however the jobs ran.
+		/// </summary>
+		template <typename Scratch, typename Query>
+		void Run(JobSystem* jobSystem, const size_t queryCount, const Query& query) {
+			const size_t jobCount = (queryCount + gQueriesPerJob - 1) / gQueriesPerJob;
+			mOffsets.resize(queryCount + 1);
+			if (mJobIds.size() < jobCount) {
+				mJobIds.resize(jobCount);
+			}
+
+			// Every job collects the results of its queries, they are stitched together afterwards
+			ParallelFor(jobSystem, jobCount, [this, &query, queryCount](const size_t begin, const size_t end) {
+				Scratch scratch{};
+				for (size_t job = begin; job < end; ++job) {
+					std::vector<uint32_t>& ids = mJobIds[job];
+					ids.clear();
+					for (size_t i = job * gQueriesPerJob; i < std::min(queryCount, (job + 1) * gQueriesPerJob); ++i) {
+						const size_t before = ids.size();
+						query(i, scratch, ids);
+						mOffsets[i + 1] = static_cast<uint32_t>(ids.size() - before);
+					}
+				}
+			});
+
+			mOffsets[0] = 0;
+			for (size_t i = 0; i < queryCount; ++i) {
+				mOffsets[i + 1] += mOffsets[i];
+			}
+
+			mIds.resize(mOffsets[queryCount]);
+			ParallelFor(jobSystem, jobCount, [this](const size_t begin, const size_t end) {
+				for (size_t job = begin; job < end; ++job) {
+					std::copy(mJobIds[job].begin(), mJobIds[job].end(), mIds.begin() + mOffsets[job * gQueriesPerJob]);
+				}
+			});
+		}
+
+		static constexpr size_t gQueriesPerJob = 512;
+
+	private:
+		template <typename Func>
+		static void ParallelFor(JobSystem* jobSystem, const size_t jobCount, const Func& func) {
+			if (jobSystem) {
+				jobSystem->ParallelFor(jobCount, 1, func);
+			}
+			else if (jobCount > 0) {
+				func(0, jobCount);
+			}
+		}
+
+		std::vector<uint32_t> mOffsets;
+		std::vector<uint32_t> mIds;
+		// Per job results before they are stitched together
+		std::vector<std::vector<uint32_t>> mJobIds;
+	};
+}
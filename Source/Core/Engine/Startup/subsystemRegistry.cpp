@@ -0,0 +1,211 @@
+#include "stdafx.h"
+#include "subsystemRegistry.h"
+#include "Engine/Jobs/jobSystem.h"
+#include "Util/jsonUtil.h"
+#include "Util/scheduleTiming.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+void RF::SubsystemRegistry::Register(const SubsystemDesc& desc) {
+	assert(desc.init && "SubsystemRegistry::Register received a subsystem without an init function");
+	mDescs.push_back(desc);
+}
+
+bool RF::SubsystemRegistry::InitializeAll(JobSystem& jobSystem) {
+	if (!ResolveDependencies()) {
+		return false;
+	}
+
+	const size_t count = mDescs.size();
+	mTimings.assign(count, {});
+	mPendingDependencies.assign(count, 0);
+	mMainThreadQueue.clear();
+	mFinishedCount = 0;
+	mWorkerCount = jobSystem.WorkerCount();
+
+	for (size_t i = 0; i < count; ++i) {
+		mTimings[i].name = mDescs[i].name;
+		mPendingDependencies[i] = static_cast<int>(mDependencies[i].size());
+	}
+
+	mStartTime = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < count; ++i) {
+		if (mPendingDependencies[i] == 0) {
+			Schedule(i, jobSystem);
+		}
+	}
+
+	while (true) {
+		size_t mainThreadIndex = count;
+		{
+			std::unique_lock lock(mMutex);
+			if (mFinishedCount == count) {
+				break;
+			}
+
+			if (!mMainThreadQueue.empty()) {
+				mainThreadIndex = mMainThreadQueue.front();
+				mMainThreadQueue.pop_front();
+			}
+		}
+
+		if (mainThreadIndex != count) {
+			RunSubsystem(mainThreadIndex, jobSystem);
+			continue;
+		}
+
+		if (jobSystem.TryRunPendingJob()) {
+			continue;
+		}
+
+		std::unique_lock lock(mMutex);
+		mCondition.wait(lock, [this, count]() { return mFinishedCount == count || !mMainThreadQueue.empty(); });
+	}
+
+	mTotalMs = ScheduleTiming::ElapsedMs(mStartTime);
+	mCriticalPath = ScheduleTiming::MarkCriticalPath(mTimings, mDependencies);
+	return true;
+}
+
+const std::vector<RF::SubsystemTiming>& RF::SubsystemRegistry::Timings() const {
+	return mTimings;
+}
+
+std::vector<std::string> RF::SubsystemRegistry::CriticalPath() const {
+	std::vector<std::string> names;
+	names.reserve(mCriticalPath.size());
+	for (const size_t index : mCriticalPath) {
+		names.push_back(mDescs[index].name);
+	}
+
+	return names;
+}
+
+nlohmann::json RF::SubsystemRegistry::BuildReport() const {
+	nlohmann::json report;
+	double serialMs = 0.0;
+	double criticalPathMs = 0.0;
+
+	nlohmann::json subsystems = nlohmann::json::array();
+	for (size_t i = 0; i < mTimings.size(); ++i) {
+		const SubsystemTiming& timing = mTimings[i];
+		const double durationMs = timing.endMs - timing.startMs;
+		serialMs += durationMs;
+		if (timing.onCriticalPath) {
+			criticalPathMs += durationMs;
+		}
+
+		subsystems.push_back({
+			{ "name", timing.name },
+			{ "dependencies", mDescs[i].dependencies },
+			{ "startMs", timing.startMs },
+			{ "endMs", timing.endMs },
+			{ "durationMs", durationMs },
+			{ "thread", timing.threadIndex },
+			{ "onCriticalPath", timing.onCriticalPath },
+		});
+	}
+
+	report["workerCount"] = mWorkerCount;
+	report["totalMs"] = mTotalMs;
+	report["serialMs"] = serialMs;
+	report["criticalPathMs"] = criticalPathMs;
+	report["criticalPath"] = CriticalPath();
+	report["subsystems"] = subsystems;
+	return report;
+}
+
+void RF::SubsystemRegistry::WriteReport(const std::string& path) const {
+	RF::Json::Serialize(path, BuildReport());
+}
+
+bool RF::SubsystemRegistry::ResolveDependencies() {
+	const size_t count = mDescs.size();
+	std::unordered_map<std::string, size_t> indices;
+	for (size_t i = 0; i < count; ++i) {
+		indices[mDescs[i].name] = i;
+	}
+
+	mDependencies.assign(count, {});
+	mDependents.assign(count, {});
+	for (size_t i = 0; i < count; ++i) {
+		for (const std::string& dependency : mDescs[i].dependencies) {
+			auto it = indices.find(dependency);
+			if (it == indices.end()) {
+				assert(false && "SubsystemRegistry received a dependency on an unregistered subsystem");
+				return false;
+			}
+
+			mDependencies[i].push_back(it->second);
+			mDependents[it->second].push_back(i);
+		}
+	}
+
+	// Kahn's algorithm, if not every subsystem can be visited there is a cycle
+	std::vector<size_t> remaining(count);
+	std::vector<size_t> ready;
+	for (size_t i = 0; i < count; ++i) {
+		remaining[i] = mDependencies[i].size();
+		if (remaining[i] == 0) {
+			ready.push_back(i);
+		}
+	}
+
+	size_t visited = 0;
+	while (!ready.empty()) {
+		const size_t index = ready.back();
+		ready.pop_back();
+		++visited;
+
+		for (const size_t dependent : mDependents[index]) {
+			if (--remaining[dependent] == 0) {
+				ready.push_back(dependent);
+			}
+		}
+	}
+
+	assert(visited == count && "SubsystemRegistry found a dependency cycle");
+	return visited == count;
+}
+
+void RF::SubsystemRegistry::Schedule(const size_t index, JobSystem& jobSystem) {
+	if (mDescs[index].mainThreadOnly) {
+		{
+			std::lock_guard lock(mMutex);
+			mMainThreadQueue.push_back(index);
+		}
+		mCondition.notify_all();
+		return;
+	}
+
+	jobSystem.Run([this, index, &jobSystem]() { RunSubsystem(index, jobSystem); });
+}
+
+void RF::SubsystemRegistry::RunSubsystem(const size_t index, JobSystem& jobSystem) {
+	SubsystemTiming& timing = mTimings[index];
+	timing.threadIndex = RF::JobSystem::CurrentThreadIndex();
+	timing.startMs = ScheduleTiming::ElapsedMs(mStartTime);
+	mDescs[index].init();
+	timing.endMs = ScheduleTiming::ElapsedMs(mStartTime);
+
+	std::vector<size_t> ready;
+	{
+		std::lock_guard lock(mMutex);
+		for (const size_t dependent : mDependents[index]) {
+			if (--mPendingDependencies[dependent] == 0) {
+				ready.push_back(dependent);
+			}
+		}
+	}
+
+	for (const size_t dependent : ready) {
+		Schedule(dependent, jobSystem);
+	}
+
+	// Notify under the lock, InitializeAll may return (and the registry go away) as soon as the count is complete
+	std::lock_guard lock(mMutex);
+	++mFinishedCount;
+	mCondition.notify_all();
+}
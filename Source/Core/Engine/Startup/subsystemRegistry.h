@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace RF {
+	class JobSystem;
+
+	struct SubsystemDesc {
+		std::string name = "";
+		std::vector<std::string> dependencies = {};
+		std::function<void()> init = nullptr;
+		// Win32 windows belong to the thread that created them, so e.g. the window has to be made on the main thread
+		bool mainThreadOnly = false;
+	};
+
+	struct SubsystemTiming {
+		std::string name = "";
+		double startMs = 0.0;
+		double endMs = 0.0;
+		unsigned int threadIndex = 0;
+		bool onCriticalPath = false;
+	};
+
+	/// <summary>
+	/// Initializes engine subsystems in dependency order. Subsystems whose dependencies are
+	/// done are started right away on the job system, so independent subsystems run in parallel.
+	/// </summary>
+	class SubsystemRegistry {
+	public:
+		void Register(const SubsystemDesc& desc);
+
+		/// <summary>
+		/// Runs every registered init function and blocks until all of them are done.
+		/// The calling thread runs the main thread only subsystems and helps with queued jobs otherwise.
+		/// </summary>
+		/// <returns>False, without running anything, if a dependency is missing or there is a cycle.</returns>
+		bool InitializeAll(JobSystem& jobSystem);
+
+		const std::vector<SubsystemTiming>& Timings() const;
+
+		/// <summary>
+		/// The chain of subsystems that decided the total startup time, first to last.
+		/// </summary>
+		std::vector<std::string> CriticalPath() const;
+
+		nlohmann::json BuildReport() const;
+		void WriteReport(const std::string& path) const;
+
+	private:
+		bool ResolveDependencies();
+		void Schedule(const size_t index, JobSystem& jobSystem);
+		void RunSubsystem(const size_t index, JobSystem& jobSystem);
+
+		std::vector<SubsystemDesc> mDescs;
+		std::vector<SubsystemTiming> mTimings;
+		std::vector<std::vector<size_t>> mDependencies;
+		std::vector<std::vector<size_t>> mDependents;
+		std::vector<size_t> mCriticalPath;
+
+		std::vector<int> mPendingDependencies;
+		std::deque<size_t> mMainThreadQueue;
+		size_t mFinishedCount = 0;
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+
+		std::chrono::steady_clock::time_point mStartTime;
+		double mTotalMs = 0.0;
+		unsigned int mWorkerCount = 0;
+	};
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "taskFramePool.h"
+
+namespace RF {
+	class TaskScheduler;
+	template <typename T>
+	class Task;
+
+	/// <summary>
+	/// Shared part of every task promise. Frames come from the TaskFramePool and a finished task resumes
+	/// whoever awaited it, or destroys itself when it was spawned on a TaskScheduler.
+	/// </summary>
+	class TaskPromiseBase {
+	public:
+		static void* operator new(const size_t size) { return TaskFramePool::Allocate(size); }
+		static void operator delete(void* memory, const size_t size) { TaskFramePool::Free(memory, size); }
+
+		// Tasks are lazy, nothing runs until the task is awaited or spawned
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		class FinalAwaiter {
+		public:
+			bool await_ready() noexcept { return false; }
+
+			template <typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+				TaskPromiseBase& promise = handle.promise();
+				if (promise.mContinuation) {
+					return promise.mContinuation;
+				}
+				if (promise.mScheduler) {
+					OnSpawnedTaskFinished(*promise.mScheduler, handle);
+				}
+				return std::noop_coroutine();
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		FinalAwaiter final_suspend() noexcept { return {}; }
+
+		void unhandled_exception() noexcept {
+			assert(false && "Exceptions are not supported in tasks");
+			std::terminate();
+		}
+
+		void SetContinuation(std::coroutine_handle<> continuation) { mContinuation = continuation; }
+		void SetScheduler(TaskScheduler* scheduler) { mScheduler = scheduler; }
+
+	private:
+		// Defined in taskScheduler.cpp, destroys the frame of a spawned task
+		static void OnSpawnedTaskFinished(TaskScheduler& scheduler, std::coroutine_handle<> handle);
+
+		std::coroutine_handle<> mContinuation = nullptr;
+		TaskScheduler* mScheduler = nullptr;
+	};
+
+	template <typename T>
+	class TaskPromise : public TaskPromiseBase {
+	public:
+		Task<T> get_return_object() noexcept;
+
+		template <typename U>
+		void return_value(U&& value) { mResult.emplace(std::forward<U>(value)); }
+
+		T TakeResult() { return std::move(*mResult); }
+
+	private:
+		std::optional<T> mResult;
+	};
+
+	template <>
+	class TaskPromise<void> : public TaskPromiseBase {
+	public:
+		Task<void> get_return_object() noexcept;
+
+		void return_void() noexcept {}
+		void TakeResult() {}
+	};
+
+	/// <summary>
+	/// Coroutine that produces a T. Awaiting a task starts it and resumes the awaiting coroutine when it finishes,
+	/// top level tasks are started with TaskScheduler::Spawn(). Where a task continues after a co_await depends on
+	/// what it awaited, the TaskScheduler awaitables resume it on the job system.
+	/// </summary>
+	template <typename T = void>
+	class Task {
+	public:
+		using promise_type = TaskPromise<T>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() = default;
+		explicit Task(Handle handle) : mHandle(handle) {}
+		~Task() {
+			if (mHandle) {
+				mHandle.destroy();
+			}
+		}
+		Task(const Task&) = delete;
+		void operator=(const Task&) = delete;
+		Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+		Task& operator=(Task&& other) noexcept {
+			if (this != &other) {
+				if (mHandle) {
+					mHandle.destroy();
+				}
+				mHandle = std::exchange(other.mHandle, nullptr);
+			}
+			return *this;
+		}
+
+		bool IsValid() const { return static_cast<bool>(mHandle); }
+		bool IsDone() const { return !mHandle || mHandle.done(); }
+
+		/// <summary>
+		/// Gives up ownership of the coroutine frame.
+		/// </summary>
+		Handle Release() { return std::exchange(mHandle, nullptr); }
+
+		auto operator co_await() const noexcept {
+			class Awaiter {
+			public:
+				explicit Awaiter(Handle handle) : mHandle(handle) {}
+
+				bool await_ready() const noexcept { return !mHandle || mHandle.done(); }
+
+				// Symmetric transfer, the awaited task starts right away on the current thread
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+					mHandle.promise().SetContinuation(awaiting);
+					return mHandle;
+				}
+
+				T await_resume() { return mHandle.promise().TakeResult(); }
+
+			private:
+				Handle mHandle;
+			};
+			assert(mHandle && "Awaiting an empty task");
+			return Awaiter(mHandle);
+		}
+
+	private:
+		Handle mHandle = nullptr;
+	};
+
+	template <typename T>
+	Task<T> TaskPromise<T>::get_return_object() noexcept {
+		return Task<T>(Task<T>::Handle::from_promise(*this));
+	}
+
+	inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+		return Task<void>(Task<void>::Handle::from_promise(*this));
+	}
+}
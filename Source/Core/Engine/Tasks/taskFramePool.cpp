@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "taskFramePool.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace {
+	constexpr size_t gSizeClassGranularity = 64;
+	constexpr size_t gSizeClassCount = 16;
+	constexpr size_t gMaxPooledSize = gSizeClassGranularity * gSizeClassCount;
+	constexpr size_t gBlocksPerSlab = 32;
+
+	struct FreeBlock {
+		FreeBlock* next = nullptr;
+	};
+
+	struct SizeClass {
+		std::mutex mutex;
+		FreeBlock* freeList = nullptr;
+		std::vector<void*> slabs;
+	};
+
+	class FramePool {
+	public:
+		FramePool() = default;
+		~FramePool() {
+			for (SizeClass& sizeClass : mSizeClasses) {
+				for (void* slab : sizeClass.slabs) {
+					::operator delete(slab);
+				}
+			}
+		}
+		FramePool(const FramePool&) = delete;
+		void operator=(const FramePool&) = delete;
+
+		std::array<SizeClass, gSizeClassCount> mSizeClasses;
+		std::atomic<size_t> mLiveFrameCount = 0;
+	};
+
+	// Function local so tasks created during static initialization still find a constructed pool
+	FramePool& GetPool() {
+		static FramePool pool;
+		return pool;
+	}
+
+	size_t SizeClassIndex(const size_t size) {
+		return (size + gSizeClassGranularity - 1) / gSizeClassGranularity - 1;
+	}
+}
+
+void* RF::TaskFramePool::Allocate(const size_t size) {
+	FramePool& pool = GetPool();
+	pool.mLiveFrameCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (size == 0 || size > gMaxPooledSize) {
+		return ::operator new(size);
+	}
+
+	const size_t index = SizeClassIndex(size);
+	SizeClass& sizeClass = pool.mSizeClasses[index];
+	std::lock_guard lock(sizeClass.mutex);
+
+	if (!sizeClass.freeList) {
+		// Carves a new slab into blocks and threads them onto the free list
+		const size_t blockSize = (index + 1) * gSizeClassGranularity;
+		std::byte* slab = static_cast<std::byte*>(::operator new(blockSize * gBlocksPerSlab));
+		sizeClass.slabs.push_back(slab);
+
+		for (size_t i = gBlocksPerSlab; i > 0; --i) {
+			FreeBlock* block = new (slab + (i - 1) * blockSize) FreeBlock();
+			block->next = sizeClass.freeList;
+			sizeClass.freeList = block;
+		}
+	}
+
+	FreeBlock* block = sizeClass.freeList;
+	sizeClass.freeList = block->next;
+	return block;
+}
+
+void RF::TaskFramePool::Free(void* memory, const size_t size) {
+	if (!memory) {
+		return;
+	}
+
+	FramePool& pool = GetPool();
+	pool.mLiveFrameCount.fetch_sub(1, std::memory_order_relaxed);
+
+	if (size == 0 || size > gMaxPooledSize) {
+		::operator delete(memory);
+		return;
+	}
+
+	SizeClass& sizeClass = pool.mSizeClasses[SizeClassIndex(size)];
+	std::lock_guard lock(sizeClass.mutex);
+	FreeBlock* block = new (memory) FreeBlock();
+	block->next = sizeClass.freeList;
+	sizeClass.freeList = block;
+}
+
+size_t RF::TaskFramePool::LiveFrameCount() {
+	return GetPool().mLiveFrameCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+namespace RF {
+	/// <summary>
+	/// Allocator for coroutine frames. Frames are rounded up to 64 byte size classes and recycled through free lists,
+	/// so spawning a task doesn't go through the global heap after warm up. Frames over 1KB fall back to operator new.
+	/// </summary>
+	namespace TaskFramePool {
+		void* Allocate(const size_t size);
+		void Free(void* memory, const size_t size);
+
+		/// <returns>Frames currently handed out, for leak checks.</returns>
+		size_t LiveFrameCount();
+	}
+}
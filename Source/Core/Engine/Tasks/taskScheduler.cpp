@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "taskScheduler.h"
+#include "Engine/frameData.h"
+
+#include <algorithm>
+
+void RF::TaskPromiseBase::OnSpawnedTaskFinished(TaskScheduler& scheduler, std::coroutine_handle<> handle) {
+	scheduler.OnSpawnedTaskFinished(handle);
+}
+
+void RF::NextFrameAwaiter::await_suspend(std::coroutine_handle<> handle) {
+	mScheduler.ParkUntilNextFrame(handle);
+}
+
+void RF::DelayAwaiter::await_suspend(std::coroutine_handle<> handle) {
+	mScheduler.ParkUntil(mSeconds, handle);
+}
+
+void RF::JobCounterAwaiter::await_suspend(std::coroutine_handle<> handle) {
+	mScheduler.ParkUntilDone(mCounter, handle);
+}
+
+void RF::AssetAwaiter::await_suspend(std::coroutine_handle<> handle) {
+	std::function<void(const StreamResult&)> onComplete = std::move(mRequest.onComplete);
+	mRequest.onComplete = [this, handle, onComplete = std::move(onComplete)](const StreamResult& result) {
+		if (onComplete) {
+			onComplete(result);
+		}
+		mResult = result;
+		mResult.data = {};
+		mScheduler.Schedule(handle);
+	};
+
+	// The completion can resume the task on another thread before Request() returns, nothing may touch this afterwards
+	mStreamer.Request(std::move(mRequest));
+}
+
+RF::TaskScheduler::TaskScheduler(JobSystem& jobSystem) : mJobSystem(jobSystem) {}
+
+RF::TaskScheduler::~TaskScheduler() {
+	WaitUntilSuspended();
+
+	// Destroying the spawned frames also destroys the child tasks they own
+	std::lock_guard lock(mMutex);
+	mNextFrame.clear();
+	mTimers = {};
+	mCounterWaits.clear();
+	for (void* address : mSpawnedTasks) {
+		std::coroutine_handle<>::from_address(address).destroy();
+	}
+	mSpawnedTasks.clear();
+}
+
+void RF::TaskScheduler::Spawn(Task<void> task) {
+	Task<void>::Handle handle = task.Release();
+	if (!handle) {
+		return;
+	}
+
+	handle.promise().SetScheduler(this);
+	{
+		std::lock_guard lock(mMutex);
+		mSpawnedTasks.insert(handle.address());
+	}
+	Schedule(handle);
+}
+
+void RF::TaskScheduler::Update(const FrameData& frameData) {
+	std::vector<std::coroutine_handle<>> ready;
+	{
+		std::lock_guard lock(mMutex);
+		++mFrameIndex;
+		mSimTime += frameData.deltaTime;
+
+		// Tasks that park for the next frame while these run end up in the new, empty list
+		ready.swap(mNextFrame);
+
+		while (!mTimers.empty() && mTimers.top().resumeTime <= mSimTime) {
+			ready.push_back(mTimers.top().handle);
+			mTimers.pop();
+		}
+
+		auto firstWaiting = std::stable_partition(mCounterWaits.begin(), mCounterWaits.end(), [](const CounterWait& wait) {
+			return !wait.counter->IsDone();
+		});
+		for (auto it = firstWaiting; it != mCounterWaits.end(); ++it) {
+			ready.push_back(it->handle);
+		}
+		mCounterWaits.erase(firstWaiting, mCounterWaits.end());
+	}
+
+	for (std::coroutine_handle<> handle : ready) {
+		Schedule(handle);
+	}
+}
+
+void RF::TaskScheduler::WaitUntilSuspended() {
+	mJobSystem.Wait(mRunningCounter);
+}
+
+void RF::TaskScheduler::Schedule(std::coroutine_handle<> handle) {
+	mJobSystem.Run([handle]() { handle.resume(); }, &mRunningCounter);
+}
+
+size_t RF::TaskScheduler::ActiveCount() const {
+	std::lock_guard lock(mMutex);
+	return mSpawnedTasks.size();
+}
+
+double RF::TaskScheduler::SimTime() const {
+	std::lock_guard lock(mMutex);
+	return mSimTime;
+}
+
+uint64_t RF::TaskScheduler::FrameIndex() const {
+	std::lock_guard lock(mMutex);
+	return mFrameIndex;
+}
+
+void RF::TaskScheduler::OnSpawnedTaskFinished(std::coroutine_handle<> handle) {
+	{
+		std::lock_guard lock(mMutex);
+		mSpawnedTasks.erase(handle.address());
+	}
+
+	// The task is suspended at its final suspend point, so the frame can be freed from inside it
+	handle.destroy();
+}
+
+void RF::TaskScheduler::ParkUntilNextFrame(std::coroutine_handle<> handle) {
+	std::lock_guard lock(mMutex);
+	mNextFrame.push_back(handle);
+}
+
+void RF::TaskScheduler::ParkUntil(const double seconds, std::coroutine_handle<> handle) {
+	std::lock_guard lock(mMutex);
+	mTimers.push({ mSimTime + seconds, mNextTimerSequence++, handle });
+}
+
+void RF::TaskScheduler::ParkUntilDone(const JobCounter& counter, std::coroutine_handle<> handle) {
+	std::lock_guard lock(mMutex);
+	mCounterWaits.push_back({ &counter, handle });
+}
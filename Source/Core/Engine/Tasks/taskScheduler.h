@@ -0,0 +1,170 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+#include "task.h"
+#include "Engine/Assets/assetStreamer.h"
+#include "Engine/Jobs/jobSystem.h"
+
+namespace RF {
+	struct FrameData;
+	class TaskScheduler;
+
+	class NextFrameAwaiter {
+	public:
+		explicit NextFrameAwaiter(TaskScheduler& scheduler) : mScheduler(scheduler) {}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+
+	private:
+		TaskScheduler& mScheduler;
+	};
+
+	class DelayAwaiter {
+	public:
+		DelayAwaiter(TaskScheduler& scheduler, const double seconds) : mScheduler(scheduler), mSeconds(seconds) {}
+
+		bool await_ready() const noexcept { return mSeconds <= 0.0; }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+
+	private:
+		TaskScheduler& mScheduler;
+		double mSeconds = 0.0;
+	};
+
+	class JobCounterAwaiter {
+	public:
+		JobCounterAwaiter(TaskScheduler& scheduler, const JobCounter& counter) : mScheduler(scheduler), mCounter(counter) {}
+
+		bool await_ready() const noexcept { return mCounter.IsDone(); }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+
+	private:
+		TaskScheduler& mScheduler;
+		const JobCounter& mCounter;
+	};
+
+	class AssetAwaiter {
+	public:
+		AssetAwaiter(TaskScheduler& scheduler, AssetStreamer& streamer, StreamRequest request)
+			: mScheduler(scheduler), mStreamer(streamer), mRequest(std::move(request)) {}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+
+		// The data view is cleared since it is only valid inside the streamer callbacks, the decoded asset is kept
+		StreamResult await_resume() { return std::move(mResult); }
+
+	private:
+		TaskScheduler& mScheduler;
+		AssetStreamer& mStreamer;
+		StreamRequest mRequest;
+		StreamResult mResult;
+	};
+
+	/// <summary>
+	/// Runs tasks spawned from gameplay or loading code. Suspended tasks are parked until what they wait for happens
+	/// and are then resumed on the job system, so a task may continue on a different thread after every co_await.
+	/// Update() is the frame boundary and releases tasks waiting for the next frame, sim time or a job counter.
+	/// </summary>
+	class TaskScheduler {
+	public:
+		explicit TaskScheduler(JobSystem& jobSystem);
+
+		/// <summary>
+		/// Destroys tasks that are still suspended. Destroy the scheduler after the AssetStreamer tasks load through,
+		/// so no completion callback can resume a destroyed task.
+		/// </summary>
+		~TaskScheduler();
+		TaskScheduler(const TaskScheduler&) = delete;
+		void operator=(const TaskScheduler&) = delete;
+
+		/// <summary>
+		/// Takes ownership of the task and starts it on the job system. The frame is freed when the task finishes.
+		/// </summary>
+		void Spawn(Task<void> task);
+
+		/// <summary>
+		/// Advances sim time by the frame's delta time and resumes the tasks that became ready. Call once per frame.
+		/// </summary>
+		void Update(const FrameData& frameData);
+
+		/// <summary>
+		/// Blocks, helping the job system, until every resumed task has suspended again or finished.
+		/// </summary>
+		void WaitUntilSuspended();
+
+		NextFrameAwaiter NextFrame() { return NextFrameAwaiter(*this); }
+		DelayAwaiter Delay(const double simSeconds) { return DelayAwaiter(*this, simSeconds); }
+
+		/// <summary>
+		/// Counters are polled in Update(), a task waiting on one resumes at the first frame boundary after it reached zero.
+		/// </summary>
+		JobCounterAwaiter WaitFor(const JobCounter& counter) { return JobCounterAwaiter(*this, counter); }
+
+		/// <summary>
+		/// Requests the asset and resumes with its StreamResult once the streamer delivered it.
+		/// </summary>
+		AssetAwaiter LoadAsset(AssetStreamer& streamer, StreamRequest request) { return AssetAwaiter(*this, streamer, std::move(request)); }
+
+		/// <summary>
+		/// Resumes a suspended coroutine on the job system.
+		/// </summary>
+		void Schedule(std::coroutine_handle<> handle);
+
+		/// <returns>Spawned tasks that haven't finished yet.</returns>
+		size_t ActiveCount() const;
+		double SimTime() const;
+		uint64_t FrameIndex() const;
+
+	private:
+		friend class TaskPromiseBase;
+		friend class NextFrameAwaiter;
+		friend class DelayAwaiter;
+		friend class JobCounterAwaiter;
+
+		struct Timer {
+			double resumeTime = 0.0;
+			// Timers due in the same frame resume in the order they were started
+			uint64_t sequence = 0;
+			std::coroutine_handle<> handle = nullptr;
+		};
+
+		struct CounterWait {
+			const JobCounter* counter = nullptr;
+			std::coroutine_handle<> handle = nullptr;
+		};
+
+		class TimerLater {
+		public:
+			bool operator()(const Timer& lhs, const Timer& rhs) const {
+				return lhs.resumeTime != rhs.resumeTime ? lhs.resumeTime > rhs.resumeTime : lhs.sequence > rhs.sequence;
+			}
+		};
+
+		void OnSpawnedTaskFinished(std::coroutine_handle<> handle);
+		void ParkUntilNextFrame(std::coroutine_handle<> handle);
+		void ParkUntil(const double seconds, std::coroutine_handle<> handle);
+		void ParkUntilDone(const JobCounter& counter, std::coroutine_handle<> handle);
+
+		JobSystem& mJobSystem;
+		JobCounter mRunningCounter;
+
+		std::unordered_set<void*> mSpawnedTasks;
+		std::vector<std::coroutine_handle<>> mNextFrame;
+		std::priority_queue<Timer, std::vector<Timer>, TimerLater> mTimers;
+		std::vector<CounterWait> mCounterWaits;
+		uint64_t mNextTimerSequence = 0;
+		double mSimTime = 0.0;
+		uint64_t mFrameIndex = 0;
+		mutable std::mutex mMutex;
+	};
+}
@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "timingWheel.h"
+#include "Engine/frameData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	// totalTime is a sum of float deltas, a frame landing a hair short of a tick boundary still counts as reaching it
+	constexpr double gTickEpsilon = 1e-3;
+}
+
+RF::TimingWheel::TimingWheel(const float tickDuration) : mTickDuration(tickDuration) {
+	assert(tickDuration > 0.0f && "TimingWheel tickDuration has to be positive");
+}
+
+RF::TimerKindId RF::TimingWheel::AddKind(std::function<void(std::span<const TimerExpiry> expired)> onExpired) {
+	assert(!mIsUpdating && "TimingWheel::AddKind from a timer callback");
+	assert(mKinds.size() < std::numeric_limits<TimerKindId>::max() && "TimingWheel has too many kinds");
+	mKinds.push_back({ std::move(onExpired), {} });
+	return static_cast<TimerKindId>(mKinds.size() - 1);
+}
+
+void RF::TimingWheel::Reserve(const size_t count) {
+	mNodes.reserve(count);
+}
+
+RF::TimerId RF::TimingWheel::Schedule(const TimerKindId kind, const float delay, const uint32_t userData, const float interval) {
+	assert(kind < mKinds.size() && "TimingWheel::Schedule unknown kind");
+	uint32_t node = mFreeNodes;
+	if (node == gNoNode) {
+		node = static_cast<uint32_t>(mNodes.size());
+		mNodes.push_back({});
+	}
+	else {
+		mFreeNodes = mNodes[node].next;
+	}
+
+	// Counted from the tick being processed, or the last processed one outside Update()
+	Node& timer = mNodes[node];
+	timer.expiryTick = mNextTick - 1 + std::max(ToTicks(delay), 1u);
+	timer.intervalTicks = interval > 0.0f ? std::max(ToTicks(interval), 1u) : 0;
+	timer.userData = userData;
+	timer.kind = kind;
+	Insert(node);
+	++mCount;
+	return MakeId(node, timer.generation);
+}
+
+bool RF::TimingWheel::Cancel(const TimerId id) {
+	if (!IsPending(id)) {
+		return false;
+	}
+	const uint32_t node = static_cast<uint32_t>(id);
+	Unlink(node);
+	FreeNode(node);
+	return true;
+}
+
+bool RF::TimingWheel::IsPending(const TimerId id) const {
+	const uint32_t node = static_cast<uint32_t>(id);
+	return node < mNodes.size() && mNodes[node].generation == static_cast<uint32_t>(id >> 32) && mNodes[node].slot != gNoNode;
+}
+
+void RF::TimingWheel::Update(const FrameData& frameData) {
+	assert(!mIsUpdating && "TimingWheel::Update from a timer callback");
+	const uint64_t lastTick = static_cast<uint64_t>(std::max(std::floor(static_cast<double>(frameData.totalTime) / mTickDuration + gTickEpsilon), 0.0));
+	mIsUpdating = true;
+	while (mNextTick <= lastTick) {
+		ProcessTick();
+	}
+	mIsUpdating = false;
+}
+
+uint32_t RF::TimingWheel::ToTicks(const float seconds) const {
+	const double ticks = std::round(static_cast<double>(seconds) / mTickDuration);
+	return static_cast<uint32_t>(std::clamp(ticks, 0.0, static_cast<double>(std::numeric_limits<uint32_t>::max())));
+}
+
+void RF::TimingWheel::Insert(const uint32_t node) {
+	Node& timer = mNodes[node];
+	const uint64_t distance = timer.expiryTick - mNextTick;
+	uint32_t level = 0;
+	while (level + 1 < gLevelCount && distance >= uint64_t(1) << (gLevelBits * (level + 1))) {
+		++level;
+	}
+	const uint32_t slot = level * gSlotsPerLevel + static_cast<uint32_t>((timer.expiryTick >> (gLevelBits * level)) & (gSlotsPerLevel - 1));
+
+	// Appended, so timers of a slot expire in the order they got there
+	Slot& list = mSlots[slot];
+	timer.slot = slot;
+	timer.previous = list.last;
+	timer.next = gNoNode;
+	if (list.last == gNoNode) {
+		list.first = node;
+	}
+	else {
+		mNodes[list.last].next = node;
+	}
+	list.last = node;
+}
+
+void RF::TimingWheel::Unlink(const uint32_t node) {
+	Node& timer = mNodes[node];
+	Slot& list = mSlots[timer.slot];
+	if (timer.previous == gNoNode) {
+		list.first = timer.next;
+	}
+	else {
+		mNodes[timer.previous].next = timer.next;
+	}
+	if (timer.next == gNoNode) {
+		list.last = timer.previous;
+	}
+	else {
+		mNodes[timer.next].previous = timer.previous;
+	}
+	timer.slot = gNoNode;
+}
+
+uint32_t RF::TimingWheel::Detach(const uint32_t slot) {
+	const uint32_t first = mSlots[slot].first;
+	mSlots[slot] = {};
+	for (uint32_t node = first; node != gNoNode; node = mNodes[node].next) {
+		mNodes[node].slot = gNoNode;
+	}
+	return first;
+}
+
+void RF::TimingWheel::FreeNode(const uint32_t node) {
+	Node& timer = mNodes[node];
+	// Ids of the node's old timers stop matching, 0 is skipped so no id is gInvalidTimer
+	if (++timer.generation == 0) {
+		timer.generation = 1;
+	}
+	timer.slot = gNoNode;
+	timer.next = mFreeNodes;
+	mFreeNodes = node;
+	--mCount;
+}
+
+void RF::TimingWheel::Cascade(const uint32_t level, const uint32_t index) {
+	for (uint32_t node = Detach(level * gSlotsPerLevel + index); node != gNoNode;) {
+		const uint32_t next = mNodes[node].next;
+		Insert(node);
+		node = next;
+	}
+}
+
+void RF::TimingWheel::ProcessTick() {
+	const uint64_t tick = mNextTick;
+	// Each time a level wraps around, the next coarser slot is due to move down
+	for (uint32_t level = 1; level < gLevelCount; ++level) {
+		if ((tick & ((uint64_t(1) << (gLevelBits * level)) - 1)) != 0) {
+			break;
+		}
+		Cascade(level, static_cast<uint32_t>((tick >> (gLevelBits * level)) & (gSlotsPerLevel - 1)));
+	}
+
+	uint32_t node = Detach(static_cast<uint32_t>(tick & (gSlotsPerLevel - 1)));
+	++mNextTick;
+	while (node != gNoNode) {
+		Node& timer = mNodes[node];
+		const uint32_t next = timer.next;
+		mKinds[timer.kind].expired.push_back({ MakeId(node, timer.generation), timer.userData });
+		if (timer.intervalTicks > 0) {
+			timer.expiryTick += timer.intervalTicks;
+			Insert(node);
+		}
+		else {
+			FreeNode(node);
+		}
+		node = next;
+	}
+
+	for (Kind& kind : mKinds) {
+		if (!kind.expired.empty()) {
+			kind.onExpired(kind.expired);
+			kind.expired.clear();
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace RF {
+	struct FrameData;
+
+	// Index of the timer's node in the low 32 bits and the node's generation in the high ones, never 0
+	using TimerId = uint64_t;
+	constexpr TimerId gInvalidTimer = 0;
+	using TimerKindId = uint16_t;
+
+	struct TimerExpiry {
+		TimerId id = gInvalidTimer;
+		// Whatever was passed to Schedule(), e.g. the entity whose buff ran out
+		uint32_t userData = 0;
+	};
+
+	/// <summary>
+	/// Gameplay timers for cooldowns, buffs, damage over time and spawns, as a hierarchical timing wheel over fixed
+	/// ticks of sim time. Four levels of 256 slots each cover 2^8, 2^16, 2^24 and 2^32 ticks ahead, a timer goes into
+	/// the slot for its expiry tick on the coarsest level it needs, and a coarse slot's timers move down a level when
+	/// the finer level wraps around to it. Schedule() and Cancel() are O(1), timers live in pooled nodes linked into
+	/// their slot, so neither allocates once the pool is big enough.
+	/// Every kind of timer has one callback, which gets all timers of that kind expiring on a tick in one call.
+	/// Not thread safe, timers are scheduled and updated from gameplay code on one thread.
+	/// </summary>
+	class TimingWheel {
+	public:
+		explicit TimingWheel(const float tickDuration = 1.0f / 60.0f);
+		TimingWheel(const TimingWheel&) = delete;
+		void operator=(const TimingWheel&) = delete;
+
+		/// <summary>
+		/// Adds a kind of timer. onExpired may schedule and cancel timers, new timers expire on a later tick.
+		/// </summary>
+		TimerKindId AddKind(std::function<void(std::span<const TimerExpiry> expired)> onExpired);
+		void Reserve(const size_t count);
+
+		/// <summary>
+		/// Starts a timer expiring delay seconds from now, rounded to ticks and at least one tick away. Repeating
+		/// timers expire every interval seconds after that, with the same id, until cancelled.
+		/// </summary>
+		TimerId Schedule(const TimerKindId kind, const float delay, const uint32_t userData = 0, const float interval = 0.0f);
+
+		/// <returns>False if the timer already expired or was cancelled.</returns>
+		bool Cancel(const TimerId id);
+		bool IsPending(const TimerId id) const;
+
+		/// <summary>
+		/// Expires every tick up to frameData.totalTime in order, calling the callbacks once per tick and kind.
+		/// </summary>
+		void Update(const FrameData& frameData);
+
+		size_t Count() const { return mCount; }
+		// The next tick Update() expires timers for
+		uint64_t NextTick() const { return mNextTick; }
+		float TickDuration() const { return mTickDuration; }
+
+		static constexpr uint32_t gLevelBits = 8;
+		static constexpr uint32_t gSlotsPerLevel = 1u << gLevelBits;
+		static constexpr uint32_t gLevelCount = 4;
+
+	private:
+		static constexpr uint32_t gNoNode = UINT32_MAX;
+
+		struct Node {
+			uint64_t expiryTick = 0;
+			// 0 for one shot timers
+			uint32_t intervalTicks = 0;
+			uint32_t userData = 0;
+			uint32_t generation = 1;
+			// Neighbours in the slot's list, next also links free nodes
+			uint32_t previous = gNoNode;
+			uint32_t next = gNoNode;
+			// Slot holding the node, gNoNode while it's free or expiring
+			uint32_t slot = gNoNode;
+			TimerKindId kind = 0;
+		};
+
+		struct Slot {
+			uint32_t first = gNoNode;
+			uint32_t last = gNoNode;
+		};
+
+		struct Kind {
+			std::function<void(std::span<const TimerExpiry> expired)> onExpired;
+			// Timers of the kind expiring on the tick being processed
+			std::vector<TimerExpiry> expired;
+		};
+
+		static TimerId MakeId(const uint32_t node, const uint32_t generation) { return static_cast<TimerId>(generation) << 32 | node; }
+		uint32_t ToTicks(const float seconds) const;
+		// Links the node into the slot for its expiry tick, on the coarsest level its distance from mNextTick needs
+		void Insert(const uint32_t node);
+		void Unlink(const uint32_t node);
+		// Takes the slot's whole list, returns its first node
+		uint32_t Detach(const uint32_t slot);
+		void FreeNode(const uint32_t node);
+		// Moves a coarse slot's timers down to the finer levels when those wrap around to it
+		void Cascade(const uint32_t level, const uint32_t index);
+		void ProcessTick();
+
+		float mTickDuration = 0.0f;
+		uint64_t mNextTick = 1;
+		size_t mCount = 0;
+		bool mIsUpdating = false;
+		std::vector<Node> mNodes;
+		uint32_t mFreeNodes = gNoNode;
+		std::array<Slot, gLevelCount * gSlotsPerLevel> mSlots = {};
+		std::vector<Kind> mKinds;
+	};
+}
@@ -14,6 +14,8 @@ int RF::WindowsApplication::Run(HINSTANCE hInstance, int cmdShow) {
 	RF::Engine engine(engineParams);
 
 	MSG msg = { 0 };
+	// Lives across frames so totalTime keeps adding up, timers run on it
+	RF::FrameData frameData;
 	while (msg.message != WM_QUIT) {
 
 		// Process queued messages
@@ -22,7 +24,6 @@ int RF::WindowsApplication::Run(HINSTANCE hInstance, int cmdShow) {
 			DispatchMessage(&msg);
 		}
 
-		RF::FrameData frameData;
 		frameData.deltaTime = 0.016f; // Simulated delta time TODO replace with actual time calculation
 		frameData.totalTime += frameData.deltaTime;
 		engine.Update(frameData);
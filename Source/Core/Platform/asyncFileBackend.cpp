@@ -0,0 +1,259 @@
+#include "stdafx.h"
+#include "asyncFileBackend.h"
+
+#ifdef __linux__
+#include "ioUringFileBackend.h"
+#endif
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <new>
+
+namespace {
+	size_t AlignUp(const size_t value, const size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Clamps the wanted range to the file, size 0 means until the end of the file
+	uint64_t RangeSize(const uint64_t fileSize, const uint64_t offset, const uint64_t size) {
+		if (offset >= fileSize) {
+			return 0;
+		}
+
+		const uint64_t available = fileSize - offset;
+		return size == 0 ? available : std::min(size, available);
+	}
+}
+
+RF::AlignedBuffer::AlignedBuffer(const size_t size, const size_t alignment)
+	: mSize(size), mCapacity(AlignUp(size > 0 ? size : 1, alignment)), mAlignment(alignment) {
+	mData = static_cast<std::byte*>(::operator new[](mCapacity, std::align_val_t(mAlignment)));
+}
+
+RF::AlignedBuffer::~AlignedBuffer() {
+	Release();
+}
+
+RF::AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept {
+	*this = std::move(other);
+}
+
+RF::AlignedBuffer& RF::AlignedBuffer::operator=(AlignedBuffer&& other) noexcept {
+	if (this != &other) {
+		Release();
+		mData = std::exchange(other.mData, nullptr);
+		mSize = std::exchange(other.mSize, 0);
+		mCapacity = std::exchange(other.mCapacity, 0);
+		mAlignment = std::exchange(other.mAlignment, 0);
+	}
+	return *this;
+}
+
+std::span<std::byte> RF::AlignedBuffer::Span() const {
+	return { mData, mSize };
+}
+
+size_t RF::AlignedBuffer::Capacity() const {
+	return mCapacity;
+}
+
+void RF::AlignedBuffer::Release() {
+	if (mData) {
+		::operator delete[](mData, std::align_val_t(mAlignment));
+	}
+	mData = nullptr;
+	mSize = 0;
+	mCapacity = 0;
+}
+
+std::unique_ptr<RF::AsyncFileBackend> RF::CreateAsyncFileBackend(const AsyncFileSettings& settings) {
+#ifdef __linux__
+	if (!settings.forceFallback) {
+		auto ioUring = std::make_unique<RF::IoUringFileBackend>();
+		if (ioUring->Init(settings)) {
+			return ioUring;
+		}
+	}
+#endif
+
+	return std::make_unique<RF::ThreadPoolFileBackend>(settings.fallbackThreadCount);
+}
+
+RF::ThreadPoolFileBackend::ThreadPoolFileBackend(const unsigned int threadCount) {
+	const unsigned int count = threadCount > 0 ? threadCount : 1;
+	mThreads.reserve(count);
+	for (unsigned int i = 0; i < count; ++i) {
+		mThreads.emplace_back([this]() { ThreadLoop(); });
+	}
+}
+
+RF::ThreadPoolFileBackend::~ThreadPoolFileBackend() {
+	{
+		std::lock_guard lock(mMutex);
+		mIsStopping = true;
+	}
+	mWorkCondition.notify_all();
+
+	for (std::thread& thread : mThreads) {
+		thread.join();
+	}
+}
+
+void RF::ThreadPoolFileBackend::Submit(std::vector<FileReadRequest> requests) {
+	{
+		std::lock_guard lock(mMutex);
+		for (FileReadRequest& request : requests) {
+			mQueue.push_back(std::move(request));
+		}
+	}
+	mWorkCondition.notify_all();
+}
+
+void RF::ThreadPoolFileBackend::WaitIdle() {
+	std::unique_lock lock(mMutex);
+	mIdleCondition.wait(lock, [this]() { return mQueue.empty() && mActiveCount == 0; });
+}
+
+const char* RF::ThreadPoolFileBackend::Name() const {
+	return "ThreadPool";
+}
+
+void RF::ThreadPoolFileBackend::ThreadLoop() {
+	std::vector<std::byte> scratch;
+
+	while (true) {
+		FileReadRequest request;
+		{
+			std::unique_lock lock(mMutex);
+			mWorkCondition.wait(lock, [this]() { return mIsStopping || !mQueue.empty(); });
+			if (mQueue.empty()) {
+				return;
+			}
+
+			request = std::move(mQueue.front());
+			mQueue.pop_front();
+			++mActiveCount;
+		}
+
+		Read(request, scratch);
+
+		{
+			std::lock_guard lock(mMutex);
+			--mActiveCount;
+		}
+		mIdleCondition.notify_all();
+	}
+}
+
+#ifdef _WIN32
+
+void RF::ThreadPoolFileBackend::Read(const FileReadRequest& request, std::vector<std::byte>& scratch) {
+	FileReadResult result;
+	result.userData = request.userData;
+
+	HANDLE file = CreateFileW(request.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize = {};
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+		result.error = static_cast<int>(GetLastError());
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+		if (request.onComplete) {
+			request.onComplete(result);
+		}
+		return;
+	}
+
+	const uint64_t readSize = RangeSize(static_cast<uint64_t>(fileSize.QuadPart), request.offset, request.size);
+	std::span<std::byte> buffer = request.destination;
+	if (buffer.empty()) {
+		scratch.resize(static_cast<size_t>(readSize));
+		buffer = scratch;
+	}
+	assert(buffer.size() >= readSize && "FileReadRequest destination is smaller than the file range");
+
+	uint64_t done = 0;
+	while (done < readSize) {
+		const uint64_t position = request.offset + done;
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFull);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		const DWORD toRead = static_cast<DWORD>(std::min<uint64_t>(readSize - done, 1ull << 30));
+		DWORD bytesRead = 0;
+		if (!ReadFile(file, buffer.data() + done, toRead, &bytesRead, &overlapped)) {
+			result.error = static_cast<int>(GetLastError());
+			break;
+		}
+		if (bytesRead == 0) {
+			break;
+		}
+		done += bytesRead;
+	}
+
+	CloseHandle(file);
+
+	result.data = buffer.first(static_cast<size_t>(done));
+	if (request.onComplete) {
+		request.onComplete(result);
+	}
+}
+
+#else
+
+void RF::ThreadPoolFileBackend::Read(const FileReadRequest& request, std::vector<std::byte>& scratch) {
+	FileReadResult result;
+	result.userData = request.userData;
+
+	const int file = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat fileStat = {};
+	if (file < 0 || fstat(file, &fileStat) != 0) {
+		result.error = errno;
+		if (file >= 0) {
+			close(file);
+		}
+		if (request.onComplete) {
+			request.onComplete(result);
+		}
+		return;
+	}
+
+	const uint64_t readSize = RangeSize(static_cast<uint64_t>(fileStat.st_size), request.offset, request.size);
+	std::span<std::byte> buffer = request.destination;
+	if (buffer.empty()) {
+		scratch.resize(static_cast<size_t>(readSize));
+		buffer = scratch;
+	}
+	assert(buffer.size() >= readSize && "FileReadRequest destination is smaller than the file range");
+
+	uint64_t done = 0;
+	while (done < readSize) {
+		const ssize_t bytesRead = pread(file, buffer.data() + done, static_cast<size_t>(readSize - done), static_cast<off_t>(request.offset + done));
+		if (bytesRead < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			result.error = errno;
+			break;
+		}
+		if (bytesRead == 0) {
+			break;
+		}
+		done += static_cast<uint64_t>(bytesRead);
+	}
+
+	close(file);
+
+	result.data = buffer.first(static_cast<size_t>(done));
+	if (request.onComplete) {
+		request.onComplete(result);
+	}
+}
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace RF {
+	// Buffer address, file offset and length all have to be multiples of this for unbuffered (O_DIRECT) reads
+	constexpr size_t gDirectIoAlignment = 4096;
+
+	/// <summary>
+	/// Heap memory with a chosen alignment, capacity is rounded up to the alignment.
+	/// </summary>
+	class AlignedBuffer {
+	public:
+		AlignedBuffer() = default;
+		explicit AlignedBuffer(const size_t size, const size_t alignment = gDirectIoAlignment);
+		~AlignedBuffer();
+		AlignedBuffer(const AlignedBuffer&) = delete;
+		void operator=(const AlignedBuffer&) = delete;
+		AlignedBuffer(AlignedBuffer&& other) noexcept;
+		AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+		std::span<std::byte> Span() const;
+		size_t Capacity() const;
+
+	private:
+		void Release();
+
+		std::byte* mData = nullptr;
+		size_t mSize = 0;
+		size_t mCapacity = 0;
+		size_t mAlignment = 0;
+	};
+
+	struct FileReadResult {
+		uint64_t userData = 0;
+		// Points into the request's destination if one was given, else into backend memory that is reused after the callback
+		std::span<const std::byte> data = {};
+		// 0 on success, an errno style code otherwise
+		int error = 0;
+	};
+
+	struct FileReadRequest {
+		std::filesystem::path path = {};
+		uint64_t offset = 0;
+		// 0 reads from the offset to the end of the file
+		uint64_t size = 0;
+		// Optional memory to read into, has to be at least size bytes. Aligned memory with a capacity
+		// rounded up to gDirectIoAlignment (e.g. an AlignedBuffer) lets large reads bypass the page cache
+		std::span<std::byte> destination = {};
+		uint64_t userData = 0;
+		// Called on a backend thread, heavy work should be handed to the job system
+		std::function<void(const FileReadResult& result)> onComplete = nullptr;
+	};
+
+	struct AsyncFileSettings {
+		// Kernel queue size and max chunks in flight
+		unsigned int queueDepth = 64;
+		// Preregistered buffers small reads without a destination go into
+		unsigned int registeredBufferCount = 16;
+		size_t registeredBufferSize = 256 * 1024;
+		// Large reads are split into chunks of this size that are in flight at the same time
+		size_t chunkSize = 1024 * 1024;
+		bool useDirectIo = true;
+		size_t directIoThreshold = 4 * 1024 * 1024;
+		unsigned int fallbackThreadCount = 4;
+		bool forceFallback = false;
+	};
+
+	/// <summary>
+	/// Asynchronous whole file and range reads. Completion callbacks run on backend threads.
+	/// </summary>
+	class AsyncFileBackend {
+	public:
+		virtual ~AsyncFileBackend() = default;
+
+		/// <summary>
+		/// Queues the requests, backends that support it hand them to the OS in one batch.
+		/// </summary>
+		virtual void Submit(std::vector<FileReadRequest> requests) = 0;
+
+		/// <summary>
+		/// Blocks until every submitted request has had its callback called.
+		/// </summary>
+		virtual void WaitIdle() = 0;
+
+		virtual const char* Name() const = 0;
+	};
+
+	/// <summary>
+	/// io_uring on Linux when the kernel allows it, the thread pool backend otherwise.
+	/// </summary>
+	std::unique_ptr<AsyncFileBackend> CreateAsyncFileBackend(const AsyncFileSettings& settings = {});
+
+	/// <summary>
+	/// Portable fallback, a few threads doing blocking positional reads (pread / ReadFile with an offset).
+	/// </summary>
+	class ThreadPoolFileBackend : public AsyncFileBackend {
+	public:
+		explicit ThreadPoolFileBackend(const unsigned int threadCount);
+		~ThreadPoolFileBackend() override;
+		ThreadPoolFileBackend(const ThreadPoolFileBackend&) = delete;
+		void operator=(const ThreadPoolFileBackend&) = delete;
+
+		void Submit(std::vector<FileReadRequest> requests) override;
+		void WaitIdle() override;
+		const char* Name() const override;
+
+	private:
+		void ThreadLoop();
+		static void Read(const FileReadRequest& request, std::vector<std::byte>& scratch);
+
+		std::deque<FileReadRequest> mQueue;
+		size_t mActiveCount = 0;
+		bool mIsStopping = false;
+		std::mutex mMutex;
+		std::condition_variable mWorkCondition;
+		std::condition_variable mIdleCondition;
+		std::vector<std::thread> mThreads;
+	};
+}
@@ -0,0 +1,478 @@
+#include "stdafx.h"
+#ifdef __linux__
+#include "ioUringFileBackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+	constexpr uint64_t gWakeupTag = ~0ull;
+
+	int IoUringSetup(const unsigned int entries, io_uring_params* params) {
+		return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	int IoUringEnter(const int ringFd, const unsigned int toSubmit, const unsigned int minComplete, const unsigned int flags) {
+		return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+	}
+
+	int IoUringRegister(const int ringFd, const unsigned int opcode, const void* arguments, const unsigned int count) {
+		return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arguments, count));
+	}
+
+	unsigned int LoadAcquire(unsigned int* value) {
+		return std::atomic_ref<unsigned int>(*value).load(std::memory_order_acquire);
+	}
+
+	void StoreRelease(unsigned int* value, const unsigned int newValue) {
+		std::atomic_ref<unsigned int>(*value).store(newValue, std::memory_order_release);
+	}
+
+	uint64_t AlignUp(const uint64_t value, const uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+RF::IoUringFileBackend::~IoUringFileBackend() {
+	if (mRingThread.joinable()) {
+		{
+			std::lock_guard lock(mMutex);
+			mIsStopping = true;
+		}
+
+		const uint64_t one = 1;
+		[[maybe_unused]] const ssize_t written = write(mWakeFd, &one, sizeof(one));
+		mRingThread.join();
+	}
+
+	Release();
+}
+
+bool RF::IoUringFileBackend::Init(const AsyncFileSettings& settings) {
+	mSettings = settings;
+	mSettings.queueDepth = std::max(mSettings.queueDepth, 2u);
+	mSettings.chunkSize = static_cast<size_t>(AlignUp(std::max<size_t>(mSettings.chunkSize, gDirectIoAlignment), gDirectIoAlignment));
+	mSettings.registeredBufferSize = static_cast<size_t>(AlignUp(mSettings.registeredBufferSize, gDirectIoAlignment));
+
+	io_uring_params params = {};
+	mRingFd = IoUringSetup(mSettings.queueDepth, &params);
+	if (mRingFd < 0) {
+		mRingFd = -1;
+		return false;
+	}
+
+	mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (isSingleMap) {
+		mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+	}
+
+	mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+	if (mSqRing == MAP_FAILED) {
+		mSqRing = nullptr;
+		Release();
+		return false;
+	}
+
+	if (isSingleMap) {
+		mCqRing = mSqRing;
+	}
+	else {
+		mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+		if (mCqRing == MAP_FAILED) {
+			mCqRing = nullptr;
+			Release();
+			return false;
+		}
+	}
+
+	mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		Release();
+		return false;
+	}
+	mSqes = static_cast<io_uring_sqe*>(sqes);
+
+	std::byte* sqRing = static_cast<std::byte*>(mSqRing);
+	mSqHead = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.head);
+	mSqTail = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.tail);
+	mSqArray = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.array);
+	mSqMask = *reinterpret_cast<unsigned int*>(sqRing + params.sq_off.ring_mask);
+	mSqEntries = params.sq_entries;
+
+	std::byte* cqRing = static_cast<std::byte*>(mCqRing);
+	mCqHead = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.head);
+	mCqTail = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.tail);
+	mCqMask = *reinterpret_cast<unsigned int*>(cqRing + params.cq_off.ring_mask);
+	mCqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+	mWakeFd = eventfd(0, EFD_CLOEXEC);
+	if (mWakeFd < 0) {
+		mWakeFd = -1;
+		Release();
+		return false;
+	}
+
+	// Registering pins the pages once instead of on every read. It can fail on a low RLIMIT_MEMLOCK, reads then use plain buffers
+	if (mSettings.registeredBufferCount > 0) {
+		mRegisteredMemory = AlignedBuffer(mSettings.registeredBufferCount * mSettings.registeredBufferSize);
+
+		std::vector<iovec> buffers(mSettings.registeredBufferCount);
+		for (unsigned int i = 0; i < mSettings.registeredBufferCount; ++i) {
+			buffers[i].iov_base = mRegisteredMemory.Span().data() + i * mSettings.registeredBufferSize;
+			buffers[i].iov_len = mSettings.registeredBufferSize;
+		}
+
+		if (IoUringRegister(mRingFd, IORING_REGISTER_BUFFERS, buffers.data(), mSettings.registeredBufferCount) == 0) {
+			for (int i = static_cast<int>(mSettings.registeredBufferCount) - 1; i >= 0; --i) {
+				mFreeRegisteredBuffers.push_back(i);
+			}
+		}
+		else {
+			mRegisteredMemory = AlignedBuffer();
+		}
+	}
+
+	// One submission slot is kept for the wakeup read
+	mChunks.resize(mSqEntries - 1);
+	for (size_t i = mChunks.size(); i > 0; --i) {
+		mFreeChunks.push_back(i - 1);
+	}
+
+	mRingThread = std::thread([this]() { RingThreadLoop(); });
+	return true;
+}
+
+void RF::IoUringFileBackend::Submit(std::vector<FileReadRequest> requests) {
+	if (requests.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard lock(mMutex);
+		mOutstanding += requests.size();
+		for (FileReadRequest& request : requests) {
+			mIncoming.push_back(std::move(request));
+		}
+	}
+
+	const uint64_t one = 1;
+	[[maybe_unused]] const ssize_t written = write(mWakeFd, &one, sizeof(one));
+}
+
+void RF::IoUringFileBackend::WaitIdle() {
+	std::unique_lock lock(mMutex);
+	mIdleCondition.wait(lock, [this]() { return mOutstanding == 0; });
+}
+
+const char* RF::IoUringFileBackend::Name() const {
+	return "io_uring";
+}
+
+bool RF::IoUringFileBackend::HasRegisteredBuffers() const {
+	return mRegisteredMemory.Capacity() > 0;
+}
+
+void RF::IoUringFileBackend::RingThreadLoop() {
+	std::deque<FileReadRequest> backlog;
+	ArmWakeup();
+
+	while (true) {
+		bool isStopping = false;
+		{
+			std::lock_guard lock(mMutex);
+			for (FileReadRequest& request : mIncoming) {
+				backlog.push_back(std::move(request));
+			}
+			mIncoming.clear();
+			isStopping = mIsStopping;
+		}
+
+		StartReads(backlog);
+		SubmitChunks();
+
+		if (isStopping && backlog.empty() && mActiveReads.empty()) {
+			break;
+		}
+
+		// Submits everything queued since the last call and sleeps until at least one completion (or a wakeup) arrives
+		Enter(1);
+		ReapCompletions();
+	}
+}
+
+void RF::IoUringFileBackend::StartReads(std::deque<FileReadRequest>& backlog) {
+	// Bounded so thousands of queued requests don't turn into thousands of open files
+	while (!backlog.empty() && mActiveReads.size() < mSettings.queueDepth) {
+		auto read = std::make_unique<ActiveRead>();
+		read->request = std::move(backlog.front());
+		backlog.pop_front();
+
+		ActiveRead& activeRead = *read;
+		mActiveReads.push_back(std::move(read));
+
+		if (Open(activeRead)) {
+			activeRead.isWaiting = true;
+			mWaitingReads.push_back(&activeRead);
+		}
+		else {
+			TryFinish(activeRead);
+		}
+	}
+}
+
+bool RF::IoUringFileBackend::Open(ActiveRead& read) {
+	const FileReadRequest& request = read.request;
+	read.fileDescriptor = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat fileStat = {};
+	if (read.fileDescriptor < 0 || fstat(read.fileDescriptor, &fileStat) != 0) {
+		read.error = errno;
+		return false;
+	}
+
+	const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+	if (request.offset < fileSize) {
+		const uint64_t available = fileSize - request.offset;
+		read.readSize = request.size == 0 ? available : std::min(request.size, available);
+	}
+	if (read.readSize == 0) {
+		return false;
+	}
+
+	if (!request.destination.empty()) {
+		assert(request.destination.size() >= read.readSize && "FileReadRequest destination is smaller than the file range");
+		read.buffer = request.destination;
+	}
+	else if (read.readSize <= mSettings.registeredBufferSize && !mFreeRegisteredBuffers.empty()) {
+		read.registeredBuffer = mFreeRegisteredBuffers.back();
+		mFreeRegisteredBuffers.pop_back();
+		read.buffer = mRegisteredMemory.Span().subspan(static_cast<size_t>(read.registeredBuffer) * mSettings.registeredBufferSize, mSettings.registeredBufferSize);
+	}
+	else {
+		read.ownedBuffer = AlignedBuffer(static_cast<size_t>(read.readSize));
+		read.buffer = { read.ownedBuffer.Span().data(), read.ownedBuffer.Capacity() };
+	}
+
+	// O_DIRECT needs aligned memory, offset and lengths, the last chunk is rounded up so the buffer needs the slack
+	const bool canReadDirect = mSettings.useDirectIo
+		&& read.readSize >= mSettings.directIoThreshold
+		&& request.offset % gDirectIoAlignment == 0
+		&& reinterpret_cast<uintptr_t>(read.buffer.data()) % gDirectIoAlignment == 0
+		&& read.buffer.size() >= AlignUp(read.readSize, gDirectIoAlignment);
+	if (canReadDirect) {
+		const int flags = fcntl(read.fileDescriptor, F_GETFL);
+		read.isDirect = flags >= 0 && fcntl(read.fileDescriptor, F_SETFL, flags | O_DIRECT) == 0;
+	}
+	if (!read.isDirect) {
+		posix_fadvise(read.fileDescriptor, static_cast<off_t>(request.offset), static_cast<off_t>(read.readSize), POSIX_FADV_SEQUENTIAL);
+	}
+
+	return true;
+}
+
+void RF::IoUringFileBackend::SubmitChunks() {
+	while (!mWaitingReads.empty()) {
+		ActiveRead& read = *mWaitingReads.front();
+
+		while (read.error == 0 && read.submittedBytes < read.readSize) {
+			if (mFreeChunks.empty() || FreeSqeCount() == 0) {
+				return;
+			}
+
+			uint64_t length = std::min<uint64_t>(mSettings.chunkSize, read.readSize - read.submittedBytes);
+			if (read.isDirect) {
+				length = AlignUp(length, gDirectIoAlignment);
+			}
+
+			QueueChunk(read, read.submittedBytes, static_cast<uint32_t>(length));
+			read.submittedBytes += length;
+		}
+
+		read.isWaiting = false;
+		mWaitingReads.pop_front();
+		TryFinish(read);
+	}
+}
+
+void RF::IoUringFileBackend::QueueChunk(ActiveRead& read, const uint64_t position, const uint32_t length) {
+	const size_t chunkIndex = mFreeChunks.back();
+	mFreeChunks.pop_back();
+	mChunks[chunkIndex] = { &read, position, length };
+	++read.chunksInFlight;
+
+	io_uring_sqe* sqe = NextSqe();
+	sqe->opcode = read.registeredBuffer >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	sqe->fd = read.fileDescriptor;
+	sqe->off = read.request.offset + position;
+	sqe->addr = reinterpret_cast<uint64_t>(read.buffer.data() + position);
+	sqe->len = length;
+	sqe->user_data = chunkIndex;
+	if (read.registeredBuffer >= 0) {
+		sqe->buf_index = static_cast<uint16_t>(read.registeredBuffer);
+	}
+}
+
+io_uring_sqe* RF::IoUringFileBackend::NextSqe() {
+	const unsigned int tail = *mSqTail;
+	const unsigned int index = tail & mSqMask;
+
+	io_uring_sqe* sqe = &mSqes[index];
+	std::memset(sqe, 0, sizeof(io_uring_sqe));
+	mSqArray[index] = index;
+
+	StoreRelease(mSqTail, tail + 1);
+	++mUnsubmittedSqes;
+	return sqe;
+}
+
+unsigned int RF::IoUringFileBackend::FreeSqeCount() const {
+	// Keep one entry free for re-arming the wakeup read
+	const unsigned int used = *mSqTail - LoadAcquire(mSqHead);
+	return used + 1 < mSqEntries ? mSqEntries - used - 1 : 0;
+}
+
+void RF::IoUringFileBackend::Enter(const unsigned int minComplete) {
+	while (true) {
+		const int result = IoUringEnter(mRingFd, mUnsubmittedSqes, minComplete, IORING_ENTER_GETEVENTS);
+		if (result >= 0) {
+			mUnsubmittedSqes -= std::min(mUnsubmittedSqes, static_cast<unsigned int>(result));
+			return;
+		}
+
+		// EINTR: retry. EAGAIN/EBUSY: the completion queue is full, reaping makes room
+		if (errno != EINTR) {
+			ReapCompletions();
+		}
+	}
+}
+
+void RF::IoUringFileBackend::ReapCompletions() {
+	unsigned int head = *mCqHead;
+	const unsigned int tail = LoadAcquire(mCqTail);
+
+	while (head != tail) {
+		const io_uring_cqe& cqe = mCqes[head & mCqMask];
+		const uint64_t userData = cqe.user_data;
+		const int result = cqe.res;
+		++head;
+
+		if (userData == gWakeupTag) {
+			ArmWakeup();
+			continue;
+		}
+
+		OnChunkComplete(static_cast<size_t>(userData), result);
+	}
+
+	StoreRelease(mCqHead, head);
+}
+
+void RF::IoUringFileBackend::OnChunkComplete(const size_t chunkIndex, const int result) {
+	const Chunk chunk = mChunks[chunkIndex];
+	mFreeChunks.push_back(chunkIndex);
+
+	ActiveRead& read = *chunk.read;
+	--read.chunksInFlight;
+
+	if (result == -EINTR || result == -EAGAIN) {
+		QueueChunk(read, chunk.position, chunk.length);
+		return;
+	}
+
+	if (result < 0) {
+		read.error = -result;
+	}
+	else {
+		const uint64_t bytesRead = static_cast<uint64_t>(result);
+		const uint64_t wanted = read.readSize > chunk.position ? read.readSize - chunk.position : 0;
+		read.completedBytes += std::min(bytesRead, wanted);
+
+		// A short read before the end of the range, read the rest
+		const bool isShort = bytesRead > 0 && bytesRead < chunk.length && chunk.position + bytesRead < read.readSize;
+		if (isShort) {
+			QueueChunk(read, chunk.position + bytesRead, static_cast<uint32_t>(chunk.length - bytesRead));
+			return;
+		}
+	}
+
+	TryFinish(read);
+}
+
+void RF::IoUringFileBackend::TryFinish(ActiveRead& read) {
+	if (read.isWaiting || read.chunksInFlight > 0) {
+		return;
+	}
+
+	if (read.fileDescriptor >= 0) {
+		close(read.fileDescriptor);
+		read.fileDescriptor = -1;
+	}
+
+	FileReadResult result;
+	result.userData = read.request.userData;
+	result.error = read.error;
+	result.data = read.buffer.first(static_cast<size_t>(std::min(read.completedBytes, read.readSize)));
+	if (read.request.onComplete) {
+		read.request.onComplete(result);
+	}
+
+	if (read.registeredBuffer >= 0) {
+		mFreeRegisteredBuffers.push_back(read.registeredBuffer);
+	}
+
+	auto it = std::find_if(mActiveReads.begin(), mActiveReads.end(), [&read](const auto& active) { return active.get() == &read; });
+	std::iter_swap(it, mActiveReads.end() - 1);
+	mActiveReads.pop_back();
+
+	{
+		std::lock_guard lock(mMutex);
+		--mOutstanding;
+	}
+	mIdleCondition.notify_all();
+}
+
+void RF::IoUringFileBackend::ArmWakeup() {
+	io_uring_sqe* sqe = NextSqe();
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = mWakeFd;
+	sqe->addr = reinterpret_cast<uint64_t>(&mWakeValue);
+	sqe->len = sizeof(mWakeValue);
+	sqe->user_data = gWakeupTag;
+}
+
+void RF::IoUringFileBackend::Release() {
+	if (mSqes) {
+		munmap(mSqes, mSqesSize);
+	}
+	if (mCqRing && mCqRing != mSqRing) {
+		munmap(mCqRing, mCqRingSize);
+	}
+	if (mSqRing) {
+		munmap(mSqRing, mSqRingSize);
+	}
+	if (mWakeFd >= 0) {
+		close(mWakeFd);
+	}
+	if (mRingFd >= 0) {
+		close(mRingFd);
+	}
+
+	mSqes = nullptr;
+	mCqRing = nullptr;
+	mSqRing = nullptr;
+	mWakeFd = -1;
+	mRingFd = -1;
+}
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+#ifdef __linux__
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "asyncFileBackend.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace RF {
+	/// <summary>
+	/// Linux io_uring backend. A single ring thread turns requests into read chunks, submits them in batches with one
+	/// syscall and reaps the completions. Small reads without a destination go into preregistered buffers
+	/// (READ_FIXED), large reads into aligned memory use O_DIRECT when the file system supports it.
+	/// </summary>
+	class IoUringFileBackend : public AsyncFileBackend {
+	public:
+		IoUringFileBackend() = default;
+		~IoUringFileBackend() override;
+		IoUringFileBackend(const IoUringFileBackend&) = delete;
+		void operator=(const IoUringFileBackend&) = delete;
+
+		/// <returns>False if the kernel doesn't support io_uring or it is blocked (e.g. by seccomp).</returns>
+		bool Init(const AsyncFileSettings& settings);
+
+		void Submit(std::vector<FileReadRequest> requests) override;
+		void WaitIdle() override;
+		const char* Name() const override;
+
+		bool HasRegisteredBuffers() const;
+
+	private:
+		struct ActiveRead {
+			FileReadRequest request;
+			int fileDescriptor = -1;
+			std::span<std::byte> buffer;
+			AlignedBuffer ownedBuffer;
+			int registeredBuffer = -1;
+			uint64_t readSize = 0;
+			uint64_t submittedBytes = 0;
+			uint64_t completedBytes = 0;
+			unsigned int chunksInFlight = 0;
+			bool isWaiting = false;
+			bool isDirect = false;
+			int error = 0;
+		};
+
+		struct Chunk {
+			ActiveRead* read = nullptr;
+			uint64_t position = 0;
+			uint32_t length = 0;
+		};
+
+		void RingThreadLoop();
+		void StartReads(std::deque<FileReadRequest>& backlog);
+		bool Open(ActiveRead& read);
+		void SubmitChunks();
+		void QueueChunk(ActiveRead& read, const uint64_t position, const uint32_t length);
+		io_uring_sqe* NextSqe();
+		unsigned int FreeSqeCount() const;
+		void Enter(const unsigned int minComplete);
+		void ReapCompletions();
+		void OnChunkComplete(const size_t chunkIndex, const int result);
+		void TryFinish(ActiveRead& read);
+		void ArmWakeup();
+		void Release();
+
+		AsyncFileSettings mSettings;
+
+		int mRingFd = -1;
+		int mWakeFd = -1;
+		uint64_t mWakeValue = 0;
+		void* mSqRing = nullptr;
+		size_t mSqRingSize = 0;
+		void* mCqRing = nullptr;
+		size_t mCqRingSize = 0;
+		io_uring_sqe* mSqes = nullptr;
+		size_t mSqesSize = 0;
+		unsigned int* mSqHead = nullptr;
+		unsigned int* mSqTail = nullptr;
+		unsigned int* mSqArray = nullptr;
+		unsigned int mSqMask = 0;
+		unsigned int mSqEntries = 0;
+		unsigned int* mCqHead = nullptr;
+		unsigned int* mCqTail = nullptr;
+		unsigned int mCqMask = 0;
+		io_uring_cqe* mCqes = nullptr;
+		unsigned int mUnsubmittedSqes = 0;
+
+		// Ring thread only
+		AlignedBuffer mRegisteredMemory;
+		std::vector<int> mFreeRegisteredBuffers;
+		std::vector<Chunk> mChunks;
+		std::vector<size_t> mFreeChunks;
+		std::vector<std::unique_ptr<ActiveRead>> mActiveReads;
+		std::deque<ActiveRead*> mWaitingReads;
+
+		std::deque<FileReadRequest> mIncoming;
+		size_t mOutstanding = 0;
+		bool mIsStopping = false;
+		std::mutex mMutex;
+		std::condition_variable mIdleCondition;
+		std::thread mRingThread;
+	};
+}
+#endif
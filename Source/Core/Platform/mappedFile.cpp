@@ -0,0 +1,152 @@
+#include "stdafx.h"
+#include "mappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RF::MappedFile::~MappedFile() {
+	Close();
+}
+
+RF::MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+RF::MappedFile& RF::MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this == &other) {
+		return *this;
+	}
+
+	Close();
+	mData = std::exchange(other.mData, nullptr);
+	mSize = std::exchange(other.mSize, 0);
+	mIsOpen = std::exchange(other.mIsOpen, false);
+#ifdef _WIN32
+	mFileHandle = std::exchange(other.mFileHandle, nullptr);
+	mMappingHandle = std::exchange(other.mMappingHandle, nullptr);
+#else
+	mFileDescriptor = std::exchange(other.mFileDescriptor, -1);
+#endif
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool RF::MappedFile::Open(const std::filesystem::path& path) {
+	Close();
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	mFileHandle = file;
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+	mIsOpen = true;
+
+	// Empty files can't be mapped, they are still valid files though
+	if (mSize == 0) {
+		return true;
+	}
+
+	mMappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMappingHandle) {
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const std::byte*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (!mData) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void RF::MappedFile::Close() {
+	if (mData) {
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle) {
+		CloseHandle(mMappingHandle);
+	}
+	if (mFileHandle) {
+		CloseHandle(mFileHandle);
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mIsOpen = false;
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+}
+
+#else
+
+bool RF::MappedFile::Open(const std::filesystem::path& path) {
+	Close();
+
+	const int fileDescriptor = open(path.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	struct stat fileStat = {};
+	if (fstat(fileDescriptor, &fileStat) != 0) {
+		close(fileDescriptor);
+		return false;
+	}
+
+	mFileDescriptor = fileDescriptor;
+	mSize = static_cast<size_t>(fileStat.st_size);
+	mIsOpen = true;
+
+	// Empty files can't be mapped, they are still valid files though
+	if (mSize == 0) {
+		return true;
+	}
+
+	void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const std::byte*>(data);
+	return true;
+}
+
+void RF::MappedFile::Close() {
+	if (mData) {
+		munmap(const_cast<std::byte*>(mData), mSize);
+	}
+	if (mFileDescriptor >= 0) {
+		close(mFileDescriptor);
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mIsOpen = false;
+	mFileDescriptor = -1;
+}
+
+#endif
+
+bool RF::MappedFile::IsOpen() const {
+	return mIsOpen;
+}
+
+std::span<const std::byte> RF::MappedFile::Data() const {
+	return { mData, mSize };
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace RF {
+	/// <summary>
+	/// Read only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere).
+	/// The view stays valid until the MappedFile is closed or destroyed.
+	/// </summary>
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		void operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const;
+		std::span<const std::byte> Data() const;
+
+	private:
+		const std::byte* mData = nullptr;
+		size_t mSize = 0;
+		bool mIsOpen = false;
+
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+	};
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace RF {
+	namespace Hash {
+		constexpr uint64_t gFnvOffsetBasis = 14695981039346656037ull;
+		constexpr uint64_t gFnvPrime = 1099511628211ull;
+
+		/// <summary>
+		/// 64 bit FNV-1a hash, stable across runs and platforms so it can be stored in files.
+		/// </summary>
+		constexpr uint64_t Fnv1a64(const std::string_view text) noexcept {
+			uint64_t hash = gFnvOffsetBasis;
+			for (const char character : text) {
+				hash ^= static_cast<uint8_t>(character);
+				hash *= gFnvPrime;
+			}
+			return hash;
+		}
+	}
+}
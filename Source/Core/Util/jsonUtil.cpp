@@ -32,6 +32,20 @@ nlohmann::json RF::Json::Parse(const std::string& directory) {
 	return obj;
 }
 
+nlohmann::json RF::Json::Parse(std::span<const std::byte> data) {
+	if (data.empty()) {
+		return {};
+	}
+
+	const char* begin = reinterpret_cast<const char*>(data.data());
+	auto obj = nlohmann::json::parse(begin, begin + data.size(), nullptr, false);
+	if (obj.is_discarded()) {
+		return {};
+	}
+
+	return obj;
+}
+
 void RF::Json::Serialize(const std::string& directory, const nlohmann::json& obj) {
 	if (!isJson(directory)) {
 		return;
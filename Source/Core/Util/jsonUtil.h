@@ -1,4 +1,7 @@
 #pragma once
+#include <cstddef>
+#include <span>
+
 namespace RF {
 	namespace Json {
 		/// <summary>
@@ -8,6 +11,13 @@ namespace RF {
 		/// <returns>A nlohmann::json object containing the parsed data from the directory.</returns>
 		nlohmann::json Parse(const std::string& directory);
 
+		/// <summary>
+		/// Parses JSON straight from memory, e.g. a view returned by the VirtualFileSystem.
+		/// </summary>
+		/// <param name="data">The JSON text.</param>
+		/// <returns>The parsed object, empty if the data is empty or not valid JSON.</returns>
+		nlohmann::json Parse(std::span<const std::byte> data);
+
 		/// <summary>
 		/// Serializes a JSON object to a specified directory.
 		/// </summary>
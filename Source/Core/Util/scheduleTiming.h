@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace RF {
+	namespace ScheduleTiming {
+		inline double ElapsedMs(const std::chrono::steady_clock::time_point& from) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+		}
+
+		/// <summary>
+		/// Walks back from the task that finished last, always through the dependency that finished last, and sets
+		/// onCriticalPath on the way. Timing needs endMs and onCriticalPath.
+		/// </summary>
+		/// <returns>The critical path, first task to last.</returns>
+		template <typename Timing>
+		std::vector<size_t> MarkCriticalPath(std::vector<Timing>& timings, const std::vector<std::vector<size_t>>& dependencies) {
+			std::vector<size_t> path;
+			if (timings.empty()) {
+				return path;
+			}
+
+			size_t current = 0;
+			for (size_t i = 1; i < timings.size(); ++i) {
+				if (timings[i].endMs > timings[current].endMs) {
+					current = i;
+				}
+			}
+
+			while (true) {
+				timings[current].onCriticalPath = true;
+				path.push_back(current);
+
+				if (dependencies[current].empty()) {
+					break;
+				}
+
+				size_t latest = dependencies[current].front();
+				for (const size_t dependency : dependencies[current]) {
+					if (timings[dependency].endMs > timings[latest].endMs) {
+						latest = dependency;
+					}
+				}
+				current = latest;
+			}
+
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+	}
+}
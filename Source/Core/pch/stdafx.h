@@ -6,9 +6,12 @@
 #include <vector>
 #include <memory>
 #include <fstream>
+#include <cassert>
 
 // Windows
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 // External
 #include <nlohmann/json.hpp>
\ No newline at end of file
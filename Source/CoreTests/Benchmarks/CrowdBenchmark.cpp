@@ -0,0 +1,75 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/crowdSteering.h"
+
+namespace {
+	// 20k enemies closing in on the player from a 400 x 400 area with 50 pillars in the way
+	constexpr size_t gEnemyCount = 20000;
+	constexpr size_t gObstacleCount = 50;
+	constexpr float gArenaSize = 400.0f;
+	constexpr int gFrames = 30;
+
+	struct Horde {
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> velocityXs;
+		std::vector<float> velocityYs;
+	};
+
+	// Best frame time over the frames
+	double TimeFrames(RF::CrowdSteering& steering, Horde& horde) {
+		double best = 1e9;
+		for (int frame = 0; frame < gFrames; ++frame) {
+			const auto start = std::chrono::steady_clock::now();
+			steering.Update({ horde.xs, horde.ys, horde.velocityXs, horde.velocityYs, {}, {} }, Vector2(0.5f * gArenaSize, 0.5f * gArenaSize), 1.0f / 60.0f);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+namespace RFTests {
+
+	TEST(CrowdBenchmark, DISABLED_Horde20k) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> coordinate(0.0f, gArenaSize);
+		std::uniform_real_distribution<float> radius(1.0f, 4.0f);
+		Horde serialHorde;
+		for (size_t i = 0; i < gEnemyCount; ++i) {
+			serialHorde.xs.push_back(coordinate(random));
+			serialHorde.ys.push_back(coordinate(random));
+		}
+		serialHorde.velocityXs.resize(gEnemyCount);
+		serialHorde.velocityYs.resize(gEnemyCount);
+		Horde parallelHorde = serialHorde;
+
+		std::vector<float> obstacleXs;
+		std::vector<float> obstacleYs;
+		std::vector<float> obstacleRadii;
+		for (size_t i = 0; i < gObstacleCount; ++i) {
+			obstacleXs.push_back(coordinate(random));
+			obstacleYs.push_back(coordinate(random));
+			obstacleRadii.push_back(radius(random));
+		}
+
+		RF::JobSystem jobSystem;
+		RF::CrowdSteering serial;
+		RF::CrowdSteering parallel({}, &jobSystem);
+		serial.SetObstacles(obstacleXs, obstacleYs, obstacleRadii);
+		parallel.SetObstacles(obstacleXs, obstacleYs, obstacleRadii);
+		const double serialMs = TimeFrames(serial, serialHorde);
+		const double parallelMs = TimeFrames(parallel, parallelHorde);
+
+		std::printf("%zu agents, %zu obstacles, %u workers\n", gEnemyCount, gObstacleCount, jobSystem.WorkerCount());
+		std::printf("Steering update: one thread %.3f ms, job system %.3f ms\n", serialMs, parallelMs);
+		EXPECT_EQ(serialHorde.xs, parallelHorde.xs);
+	}
+}
@@ -0,0 +1,381 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Engine/ECS/commandBuffer.h"
+#include "Engine/ECS/prefab.h"
+#include "Engine/ECS/query.h"
+#include "Engine/ECS/worldSnapshot.h"
+#include "Util/jsonUtil.h"
+
+namespace {
+	struct BenchPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct BenchVelocity {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(BenchPosition, x, y)
+	NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(BenchVelocity, x, y)
+
+	struct BenchHealth {
+		int value = 100;
+		int armor = 0;
+	};
+	NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(BenchHealth, value, armor)
+
+	struct BenchEnemy {};
+
+	// The same status effect in both storages
+	struct BenchBurningTag {};
+	struct BenchBurning {
+		static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+	};
+
+	constexpr size_t gEntityCount = 1'000'000;
+	constexpr size_t gSpawnCount = 100'000;
+	constexpr size_t gPrefabSpawnCount = 10'000;
+	constexpr size_t gSnapshotEntityCount = 200'000;
+	constexpr size_t gChurnEntityCount = 100'000;
+	// Effects flipped per frame, about 60k flips a second at 60 fps
+	constexpr size_t gChurnFlipsPerFrame = 1'000;
+	constexpr size_t gChurnFrames = 120;
+	constexpr int gRuns = 20;
+
+	double MsSince(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsBenchmark, DISABLED_IteratePositionVelocity) {
+		RF::World world;
+		for (size_t i = 0; i < gEntityCount; ++i) {
+			world.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{ 1.0f, 0.5f });
+		}
+
+		constexpr float deltaTime = 1.0f / 60.0f;
+		double bestMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			world.ForEachChunk<BenchPosition, const BenchVelocity>([](std::span<const RF::Entity>, std::span<BenchPosition> positions, std::span<const BenchVelocity> velocities) {
+				for (size_t i = 0; i < positions.size(); ++i) {
+					positions[i].x += velocities[i].x * deltaTime;
+					positions[i].y += velocities[i].y * deltaTime;
+				}
+			});
+			bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::printf("%zu entities, Position += Velocity * dt: %.3f ms (best of %d, one thread)\n", gEntityCount, bestMs, gRuns);
+
+		RF::Query<RF::Write<BenchPosition>, RF::Read<BenchVelocity>> query(world);
+		double bestQueryMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			query.ForEachChunk([](std::span<const RF::Entity>, std::span<BenchPosition> positions, std::span<const BenchVelocity> velocities) {
+				for (size_t i = 0; i < positions.size(); ++i) {
+					positions[i].x += velocities[i].x * deltaTime;
+					positions[i].y += velocities[i].y * deltaTime;
+				}
+			});
+			bestQueryMs = std::min(bestQueryMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		std::printf("Same loop through a cached Query: %.3f ms\n", bestQueryMs);
+		EXPECT_GT(world.Get<BenchPosition>(RF::Ecs::MakeEntity(0, 1))->x, 0.0f);
+	}
+
+	TEST(EcsBenchmark, DISABLED_CommandBufferSpawns) {
+		double directMs = 1e9;
+		double playbackMs = 1e9;
+		double warmPlaybackMs = 1e9;
+		double memcpyMs = 1e9;
+
+		for (int run = 0; run < 5; ++run) {
+			{
+				RF::World world;
+				const auto start = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < gSpawnCount; ++i) {
+					world.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{ 1.0f, 0.5f });
+				}
+				directMs = std::min(directMs, MsSince(start));
+			}
+			{
+				RF::World world;
+				RF::CommandBuffer buffer;
+				for (size_t i = 0; i < gSpawnCount; ++i) {
+					buffer.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{ 1.0f, 0.5f });
+				}
+				auto start = std::chrono::steady_clock::now();
+				buffer.Playback(world);
+				playbackMs = std::min(playbackMs, MsSince(start));
+
+				// Again into chunks and entity records the world already has, without first touching fresh memory
+				std::vector<RF::Entity> spawned;
+				RF::Query<RF::Read<BenchPosition>>(world).ForEachChunk([&spawned](std::span<const RF::Entity> entities, std::span<const BenchPosition>) {
+					spawned.insert(spawned.end(), entities.begin(), entities.end());
+				});
+				for (const RF::Entity entity : spawned) {
+					world.Destroy(entity);
+				}
+				for (size_t i = 0; i < gSpawnCount; ++i) {
+					buffer.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{ 1.0f, 0.5f });
+				}
+				start = std::chrono::steady_clock::now();
+				buffer.Playback(world);
+				warmPlaybackMs = std::min(warmPlaybackMs, MsSince(start));
+			}
+			{
+				// Lower bound, the same bytes (components and entity handles) copied once
+				constexpr size_t bytes = gSpawnCount * (sizeof(BenchPosition) + sizeof(BenchVelocity) + sizeof(RF::Entity));
+				std::vector<std::byte> source(bytes, std::byte(1));
+				std::vector<std::byte> destination(bytes);
+				const auto start = std::chrono::steady_clock::now();
+				std::memcpy(destination.data(), source.data(), bytes);
+				memcpyMs = std::min(memcpyMs, MsSince(start));
+				EXPECT_EQ(destination[bytes - 1], std::byte(1));
+			}
+		}
+
+		std::printf("%zu spawns: World::Create %.3f ms, CommandBuffer playback %.3f ms (%.3f ms warm), memcpy of the same data %.3f ms\n", gSpawnCount, directMs, playbackMs, warmPlaybackMs, memcpyMs);
+	}
+
+	TEST(EcsBenchmark, DISABLED_ChangedFilterOnIdleProps) {
+		constexpr size_t propCount = 100'000;
+
+		RF::World world;
+		std::vector<RF::Entity> props;
+		for (size_t i = 0; i < propCount; ++i) {
+			props.push_back(world.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{}));
+		}
+
+		// Stand-in for per entity work like updating bounds or a spatial hash entry
+		float sum = 0.0f;
+		auto work = [&sum](std::span<const RF::Entity>, std::span<const BenchPosition> positions) {
+			for (const BenchPosition& position : positions) {
+				sum += std::sqrt(position.x * position.x + position.y * position.y);
+			}
+		};
+
+		RF::Query<RF::Read<BenchPosition>> all(world);
+		double allMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			all.ForEachChunk(work);
+			allMs = std::min(allMs, MsSince(start));
+		}
+		std::printf("%zu props, every chunk: %.3f ms\n", propCount, allMs);
+
+		RF::Query<RF::Read<BenchPosition>, RF::Changed<BenchPosition>> changed(world);
+		changed.ForEachChunk(work);
+		for (const size_t movedPerFrame : std::array<size_t, 4>{ 0, 10, 100, 1000 }) {
+			double changedMs = 1e9;
+			for (int run = 0; run < gRuns; ++run) {
+				// Props pushed around this frame, scattered over the map
+				for (size_t i = 0; i < movedPerFrame; ++i) {
+					world.Get<BenchPosition>(props[(i * 7919 + static_cast<size_t>(run) * 104729) % propCount])->y += 1.0f;
+				}
+
+				const auto start = std::chrono::steady_clock::now();
+				changed.ForEachChunk(work);
+				changedMs = std::min(changedMs, MsSince(start));
+			}
+			std::printf("%zu moved per frame, Changed<BenchPosition>: %.3f ms\n", movedPerFrame, changedMs);
+		}
+		EXPECT_GT(sum, 0.0f);
+	}
+
+	TEST(EcsBenchmark, DISABLED_PrefabInstantiate10k) {
+		RF::Ecs::RegisterJsonReader<BenchPosition>();
+		RF::Ecs::RegisterJsonReader<BenchVelocity>();
+		RF::Ecs::RegisterJsonReader<BenchHealth>();
+		RF::Ecs::TypeId<BenchEnemy>();
+		const nlohmann::json json = nlohmann::json::parse(R"({
+			"components": { "BenchPosition": {}, "BenchVelocity": { "x": -1.0 }, "BenchHealth": { "value": 250, "armor": 5 }, "BenchEnemy": {} }
+		})");
+
+		std::vector<BenchPosition> positions;
+		for (size_t i = 0; i < gPrefabSpawnCount; ++i) {
+			positions.push_back({ static_cast<float>(i), 100.0f });
+		}
+
+		double jsonMs = 1e9;
+		double createMs = 1e9;
+		double prefabMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			{
+				// Every spawn reads its defaults from JSON and adds components one by one
+				RF::World world;
+				const auto start = std::chrono::steady_clock::now();
+				const nlohmann::json& components = json.at("components");
+				for (size_t i = 0; i < gPrefabSpawnCount; ++i) {
+					const RF::Entity entity = world.Create(positions[i]);
+					world.Add(entity, components.at("BenchVelocity").get<BenchVelocity>());
+					world.Add(entity, BenchHealth{ RF::Json::TryGet(components.at("BenchHealth"), "value", 100), RF::Json::TryGet(components.at("BenchHealth"), "armor", 0) });
+					world.Add<BenchEnemy>(entity);
+				}
+				jsonMs = std::min(jsonMs, MsSince(start));
+			}
+			{
+				RF::World world;
+				RF::Prefab prefab;
+				prefab.Compile(world, json);
+				const auto start = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < gPrefabSpawnCount; ++i) {
+					world.Create(positions[i], *prefab.Get<BenchVelocity>(), *prefab.Get<BenchHealth>(), BenchEnemy{});
+				}
+				createMs = std::min(createMs, MsSince(start));
+			}
+			{
+				RF::World world;
+				RF::Prefab prefab;
+				ASSERT_TRUE(prefab.Compile(world, json));
+				const RF::ComponentOverride overrides[] = { RF::Ecs::Override(std::span<const BenchPosition>(positions)) };
+				const auto start = std::chrono::steady_clock::now();
+				const std::vector<RF::Entity> entities = world.InstantiateBatch(prefab, gPrefabSpawnCount, overrides);
+				prefabMs = std::min(prefabMs, MsSince(start));
+				EXPECT_EQ(world.Get<BenchHealth>(entities.back())->value, 250);
+			}
+		}
+
+		std::printf("%zu spawns: JSON defaults and Add per entity %.3f ms, World::Create per entity %.3f ms, InstantiateBatch %.3f ms\n",
+			gPrefabSpawnCount, jsonMs, createMs, prefabMs);
+	}
+
+	TEST(EcsBenchmark, DISABLED_Snapshot200k) {
+		RF::World world;
+		for (size_t i = 0; i < gSnapshotEntityCount; ++i) {
+			const RF::Entity entity = world.Create(BenchPosition{ static_cast<float>(i), 0.0f }, BenchVelocity{ 1.0f, 0.5f }, BenchHealth{});
+			if (i % 4 == 0) {
+				world.Add<BenchEnemy>(entity);
+			}
+		}
+
+		// Baseline: the same data as one JSON object per entity
+		const auto jsonStart = std::chrono::steady_clock::now();
+		nlohmann::json json = nlohmann::json::array();
+		world.ForEachChunk<const BenchPosition, const BenchVelocity, const BenchHealth>([&json](std::span<const RF::Entity> entities, std::span<const BenchPosition> positions, std::span<const BenchVelocity> velocities, std::span<const BenchHealth> healths) {
+			for (size_t i = 0; i < entities.size(); ++i) {
+				json.push_back({ { "BenchPosition", positions[i] }, { "BenchVelocity", velocities[i] }, { "BenchHealth", healths[i] } });
+			}
+		});
+		const std::string text = json.dump();
+		const double jsonSaveMs = MsSince(jsonStart);
+		const auto jsonLoadStart = std::chrono::steady_clock::now();
+		{
+			RF::World loaded;
+			for (const nlohmann::json& entity : nlohmann::json::parse(text)) {
+				loaded.Create(entity.at("BenchPosition").get<BenchPosition>(), entity.at("BenchVelocity").get<BenchVelocity>(), entity.at("BenchHealth").get<BenchHealth>());
+			}
+		}
+		const double jsonLoadMs = MsSince(jsonLoadStart);
+
+		RF::WorldSnapshot snapshot;
+		RF::World restored;
+		double captureMs = 1e9;
+		double restoreMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			auto start = std::chrono::steady_clock::now();
+			snapshot.Capture(world);
+			captureMs = std::min(captureMs, MsSince(start));
+
+			start = std::chrono::steady_clock::now();
+			ASSERT_TRUE(snapshot.Restore(restored));
+			restoreMs = std::min(restoreMs, MsSince(start));
+		}
+		EXPECT_EQ(restored.EntityCount(), gSnapshotEntityCount);
+
+		std::printf("%zu entities, %.1f MB snapshot: JSON save %.1f ms load %.1f ms, Capture %.3f ms, Restore %.3f ms\n",
+			gSnapshotEntityCount, static_cast<double>(snapshot.Data().size()) / (1024.0 * 1024.0), jsonSaveMs, jsonLoadMs, captureMs, restoreMs);
+	}
+
+	TEST(EcsBenchmark, DISABLED_StatusEffectChurn) {
+		// Per frame: ignite random entities, put out the ones whose effect ran out, update burning entities, then run
+		// the main movement query, which shows what fragmentation does to the rest of the frame
+		auto runFrames = [](auto&& setBurning, auto&& burnQuery, auto&& moveQuery, RF::World& world, const std::vector<RF::Entity>& entities, const size_t duration) {
+			std::vector<RF::Entity> ignited;
+			uint32_t seed = 12345;
+			double flipMs = 0.0;
+			double burnMs = 0.0;
+			double moveMs = 0.0;
+			for (size_t frame = 0; frame < gChurnFrames + duration; ++frame) {
+				const bool isMeasured = frame >= duration;
+				auto start = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < gChurnFlipsPerFrame / 2; ++i) {
+					seed = seed * 1664525u + 1013904223u;
+					ignited.push_back(entities[seed % entities.size()]);
+					setBurning(world, ignited.back(), true);
+				}
+				if (frame >= duration) {
+					const size_t first = (frame - duration) * (gChurnFlipsPerFrame / 2);
+					for (size_t i = first; i < first + gChurnFlipsPerFrame / 2; ++i) {
+						setBurning(world, ignited[i], false);
+					}
+				}
+				flipMs += isMeasured ? MsSince(start) : 0.0;
+
+				start = std::chrono::steady_clock::now();
+				burnQuery.Each([](BenchHealth& health) { --health.value; });
+				burnMs += isMeasured ? MsSince(start) : 0.0;
+
+				start = std::chrono::steady_clock::now();
+				moveQuery.Each([](BenchPosition& position, const BenchVelocity& velocity) { position.x += velocity.x; position.y += velocity.y; });
+				moveMs += isMeasured ? MsSince(start) : 0.0;
+			}
+			return std::array<double, 3>{ flipMs / gChurnFrames, burnMs / gChurnFrames, moveMs / gChurnFrames };
+		};
+
+		auto populate = [](RF::World& world, std::vector<RF::Entity>& entities) {
+			for (size_t i = 0; i < gChurnEntityCount; ++i) {
+				// A couple of archetypes, like a real scene, so tag moves fragment several of them
+				const RF::Entity entity = world.Create(BenchPosition{}, BenchVelocity{ 1.0f, 0.5f }, BenchHealth{});
+				if (i % 3 == 0) {
+					world.Add<BenchEnemy>(entity);
+				}
+				entities.push_back(entity);
+			}
+		};
+
+		// Effects lasting 10 frames keep about 5% of the entities burning, 100 frames about 40%
+		for (const size_t duration : std::array<size_t, 2>{ 10, 100 }) {
+			std::array<double, 3> archetypeMs = {};
+			{
+				RF::World world;
+				std::vector<RF::Entity> entities;
+				populate(world, entities);
+				RF::Query<RF::Write<BenchHealth>, RF::With<BenchBurningTag>> burnQuery(world);
+				RF::Query<RF::Write<BenchPosition>, RF::Read<BenchVelocity>> moveQuery(world);
+				archetypeMs = runFrames([](RF::World& w, const RF::Entity entity, const bool burning) { burning ? w.Add<BenchBurningTag>(entity) : w.Remove<BenchBurningTag>(entity); },
+					burnQuery, moveQuery, world, entities, duration);
+			}
+
+			std::array<double, 3> sparseMs = {};
+			{
+				RF::World world;
+				std::vector<RF::Entity> entities;
+				populate(world, entities);
+				RF::Query<RF::Write<BenchHealth>, RF::With<BenchBurning>> burnQuery(world);
+				RF::Query<RF::Write<BenchPosition>, RF::Read<BenchVelocity>> moveQuery(world);
+				sparseMs = runFrames([](RF::World& w, const RF::Entity entity, const bool burning) { burning ? w.Add<BenchBurning>(entity) : w.Remove<BenchBurning>(entity); },
+					burnQuery, moveQuery, world, entities, duration);
+			}
+
+			std::printf("%zu entities, %zu flips per frame, %zu frame effects (ms per frame): archetype tag flip %.3f burn %.3f move %.3f, sparse flip %.3f burn %.3f move %.3f\n",
+				gChurnEntityCount, gChurnFlipsPerFrame, duration, archetypeMs[0], archetypeMs[1], archetypeMs[2], sparseMs[0], sparseMs[1], sparseMs[2]);
+		}
+	}
+}
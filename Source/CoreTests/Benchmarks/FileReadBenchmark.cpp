@@ -0,0 +1,100 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "Platform/asyncFileBackend.h"
+#ifdef __linux__
+#include "Platform/ioUringFileBackend.h"
+#endif
+
+namespace {
+	constexpr size_t gMaxBytesPerSize = 64ull * 1024 * 1024;
+	constexpr size_t gMaxFilesPerSize = 512;
+
+	double MBPerSecond(const size_t bytes, const std::chrono::steady_clock::time_point& start) {
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+	}
+
+	double ReadWithIfstream(const std::vector<std::filesystem::path>& files, const size_t fileSize) {
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<char> buffer;
+		for (const std::filesystem::path& path : files) {
+			std::ifstream file(path, std::ios::binary);
+			buffer.resize(fileSize);
+			file.read(buffer.data(), static_cast<std::streamsize>(fileSize));
+		}
+		return MBPerSecond(files.size() * fileSize, start);
+	}
+
+	double ReadWithBackend(RF::AsyncFileBackend& backend, const std::vector<std::filesystem::path>& files, const size_t fileSize) {
+		// Large files get their own aligned destination (like the AssetStreamer does), small ones use backend buffers
+		const bool useDestinations = fileSize > 256 * 1024;
+		std::vector<RF::AlignedBuffer> buffers;
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<RF::FileReadRequest> requests;
+		requests.reserve(files.size());
+		for (const std::filesystem::path& path : files) {
+			RF::FileReadRequest request;
+			request.path = path;
+			if (useDestinations) {
+				buffers.emplace_back(fileSize);
+				request.destination = { buffers.back().Span().data(), buffers.back().Capacity() };
+			}
+			requests.push_back(std::move(request));
+		}
+
+		backend.Submit(std::move(requests));
+		backend.WaitIdle();
+		return MBPerSecond(files.size() * fileSize, start);
+	}
+}
+
+namespace RFTests {
+
+	TEST(FileReadBenchmark, DISABLED_IfstreamVsAsyncBackends) {
+		const std::filesystem::path root = std::filesystem::temp_directory_path() / "RuneForgeFileReadBenchmark";
+		std::filesystem::remove_all(root);
+		std::filesystem::create_directories(root);
+
+		RF::ThreadPoolFileBackend threadPool(4);
+		std::unique_ptr<RF::AsyncFileBackend> ioUring;
+#ifdef __linux__
+		auto ring = std::make_unique<RF::IoUringFileBackend>();
+		if (ring->Init({})) {
+			ioUring = std::move(ring);
+		}
+#endif
+
+		std::printf("%10s %6s %14s %14s %14s  (MB/s, warm page cache)\n", "size", "files", "ifstream", "thread pool", "io_uring");
+		for (size_t fileSize = 1024; fileSize <= 64ull * 1024 * 1024; fileSize *= 4) {
+			const size_t fileCount = std::clamp<size_t>(gMaxBytesPerSize / fileSize, 1, gMaxFilesPerSize);
+
+			std::vector<std::filesystem::path> files;
+			const std::vector<char> content(fileSize, 'x');
+			for (size_t i = 0; i < fileCount; ++i) {
+				files.push_back(root / (std::to_string(fileSize) + "_" + std::to_string(i) + ".bin"));
+				std::ofstream(files.back(), std::ios::binary).write(content.data(), static_cast<std::streamsize>(fileSize));
+			}
+
+			ReadWithIfstream(files, fileSize);
+			const double ifstreamSpeed = ReadWithIfstream(files, fileSize);
+			const double threadPoolSpeed = ReadWithBackend(threadPool, files, fileSize);
+			const double ioUringSpeed = ioUring ? ReadWithBackend(*ioUring, files, fileSize) : 0.0;
+
+			std::printf("%10zu %6zu %14.1f %14.1f %14.1f\n", fileSize, fileCount, ifstreamSpeed, threadPoolSpeed, ioUringSpeed);
+
+			for (const std::filesystem::path& path : files) {
+				std::filesystem::remove(path);
+			}
+		}
+
+		std::filesystem::remove_all(root);
+	}
+}
@@ -0,0 +1,166 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/flowField.h"
+
+namespace {
+	// 256 x 256 tiles, 15% walls and rough ground, refreshed at 30 Hz while the player walks and walls change
+	constexpr int gGridSize = 256;
+	constexpr int gFrames = 30;
+	constexpr int gChangesPerFrame = 8;
+	constexpr size_t gAgentCount = 20000;
+
+	double MsSince(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	Vector2i PlayerTile(const int frame) {
+		return Vector2i(gGridSize / 2 - gFrames / 2 + frame, gGridSize / 2);
+	}
+
+	void FillLevel(RF::FlowField& field) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		for (int y = 0; y < gGridSize; ++y) {
+			for (int x = 0; x < gGridSize; ++x) {
+				const float roll = chance(random);
+				field.SetCost(Vector2i(x, y), roll < 0.15f ? RF::FlowField::gWall : roll < 0.3f ? static_cast<uint8_t>(3) : static_cast<uint8_t>(1));
+			}
+		}
+		// The road the player walks along
+		for (int frame = 0; frame <= gFrames; ++frame) {
+			field.SetCost(PlayerTile(frame), 1);
+		}
+	}
+
+	// Plain single threaded Dijkstra over the whole grid with the field's step rules, what a goal move has to beat
+	std::vector<float> WholeGridDijkstra(const RF::FlowField& field) {
+		static const Vector2i offsets[8] = { Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1), Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1) };
+		auto isOpen = [&field](const Vector2i& tile) { return field.IsInside(tile) && field.GetCost(tile) != RF::FlowField::gWall; };
+		std::vector<float> values(static_cast<size_t>(gGridSize * gGridSize), RF::FlowField::gUnreachable);
+		using Entry = std::pair<float, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		const Vector2i goal = field.GetGoal();
+		values[static_cast<size_t>(goal.y * gGridSize + goal.x)] = 0.0f;
+		open.push({ 0.0f, goal.y * gGridSize + goal.x });
+		while (!open.empty()) {
+			const auto [value, index] = open.top();
+			open.pop();
+			if (value > values[static_cast<size_t>(index)]) {
+				continue;
+			}
+			const Vector2i tile(index % gGridSize, index / gGridSize);
+			for (int neighbour = 0; neighbour < 8; ++neighbour) {
+				const Vector2i next = tile + offsets[neighbour];
+				if (!isOpen(next) || (neighbour >= 4 && (!isOpen(Vector2i(next.x, tile.y)) || !isOpen(Vector2i(tile.x, next.y))))) {
+					continue;
+				}
+				const float nextValue = value + static_cast<float>(field.GetCost(next)) * (neighbour >= 4 ? 1.41421356f : 1.0f);
+				float& current = values[static_cast<size_t>(next.y * gGridSize + next.x)];
+				if (nextValue < current) {
+					current = nextValue;
+					open.push({ nextValue, next.y * gGridSize + next.x });
+				}
+			}
+		}
+		return values;
+	}
+
+	struct Timings {
+		double fullMs = 0.0;
+		double dijkstraMs = 0.0;
+		size_t fullPasses = 0;
+		double goalMoveMs = 0.0;
+		double costChangeMs = 0.0;
+		double samplingMs = 0.0;
+		size_t goalMovePasses = 0;
+		size_t costChangePasses = 0;
+	};
+
+	// Average times over the frames
+	Timings TimeFrames(RF::FlowField& field) {
+		Timings timings;
+		FillLevel(field);
+		field.SetGoal(PlayerTile(0));
+		auto start = std::chrono::steady_clock::now();
+		timings.fullPasses = field.Update();
+		timings.fullMs = MsSince(start);
+		start = std::chrono::steady_clock::now();
+		const std::vector<float> values = WholeGridDijkstra(field);
+		timings.dijkstraMs = MsSince(start);
+		for (int y = 0; y < gGridSize; y += 15) {
+			const float value = values[static_cast<size_t>(y * gGridSize + y)];
+			EXPECT_TRUE(value == field.GetIntegration(Vector2i(y, y)) || std::abs(value - field.GetIntegration(Vector2i(y, y))) < 1e-4f * value);
+		}
+
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> position(0.0f, static_cast<float>(gGridSize));
+		std::uniform_int_distribution<int> tile(0, gGridSize - 1);
+		std::vector<float> xs(gAgentCount);
+		std::vector<float> ys(gAgentCount);
+		for (size_t i = 0; i < gAgentCount; ++i) {
+			xs[i] = position(random);
+			ys[i] = position(random);
+		}
+		std::vector<float> directionXs(gAgentCount);
+		std::vector<float> directionYs(gAgentCount);
+
+		for (int frame = 0; frame < gFrames; ++frame) {
+			// The player walks one tile, which moves the goal
+			field.SetGoal(PlayerTile(frame + 1));
+			start = std::chrono::steady_clock::now();
+			timings.goalMovePasses += field.Update();
+			timings.goalMoveMs += MsSince(start);
+
+			for (int change = 0; change < gChangesPerFrame; ++change) {
+				const Vector2i changed(tile(random), tile(random));
+				// Not on the road, so the player never walks into a wall
+				if (changed.y != PlayerTile(0).y) {
+					field.SetCost(changed, field.GetCost(changed) == RF::FlowField::gWall ? static_cast<uint8_t>(1) : RF::FlowField::gWall);
+				}
+			}
+			start = std::chrono::steady_clock::now();
+			timings.costChangePasses += field.Update();
+			timings.costChangeMs += MsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			field.SampleDirections(xs, ys, directionXs, directionYs);
+			timings.samplingMs += MsSince(start);
+		}
+
+		timings.goalMoveMs /= gFrames;
+		timings.costChangeMs /= gFrames;
+		timings.samplingMs /= gFrames;
+		timings.goalMovePasses /= gFrames;
+		timings.costChangePasses /= gFrames;
+		return timings;
+	}
+}
+
+namespace RFTests {
+
+	TEST(FlowFieldBenchmark, DISABLED_Grid256At30Hz) {
+		RF::JobSystem jobSystem;
+		RF::FlowField serial(Vector2i(gGridSize, gGridSize));
+		RF::FlowField parallel(Vector2i(gGridSize, gGridSize), 1.0f, Vector2::Zero, &jobSystem);
+		const Timings serialTimings = TimeFrames(serial);
+		const Timings parallelTimings = TimeFrames(parallel);
+
+		constexpr int sectorCount = (gGridSize / RF::FlowField::gSectorSize) * (gGridSize / RF::FlowField::gSectorSize);
+		std::printf("%d x %d tiles, %d sectors, %d cost changes per frame, %zu agents, %u workers\n", gGridSize, gGridSize, sectorCount, gChangesPerFrame, gAgentCount, jobSystem.WorkerCount());
+		std::printf("From scratch:   one thread %.3f ms, job system %.3f ms, %zu sector passes, whole grid Dijkstra %.3f ms\n", serialTimings.fullMs, parallelTimings.fullMs, serialTimings.fullPasses, serialTimings.dijkstraMs);
+		std::printf("Goal moved:     one thread %.3f ms, job system %.3f ms, %zu sector passes\n", serialTimings.goalMoveMs, parallelTimings.goalMoveMs, serialTimings.goalMovePasses);
+		std::printf("Costs changed:  one thread %.3f ms, job system %.3f ms, %zu sector passes\n", serialTimings.costChangeMs, parallelTimings.costChangeMs, serialTimings.costChangePasses);
+		std::printf("Agent sampling: one thread %.3f ms, job system %.3f ms\n", serialTimings.samplingMs, parallelTimings.samplingMs);
+		EXPECT_LT(serialTimings.goalMoveMs + serialTimings.costChangeMs, 1000.0 / 30.0);
+	}
+}
@@ -0,0 +1,81 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Particles/particleSystem.h"
+
+namespace {
+	// 128 emitters of up to 4k particles over a 400 x 400 arena, about 400k particles once they're all full
+	constexpr uint32_t gEmitterCount = 128;
+	constexpr int gWarmUpUpdates = 90;
+	constexpr int gUpdates = 60;
+	constexpr float gUpdateTime = 1.0f / 60.0f;
+
+	struct Timings {
+		double updateMs = 0.0;
+		double writeMs = 0.0;
+		size_t count = 0;
+	};
+
+	Timings TimeUpdates(RF::ParticleSystem& particles) {
+		RF::EmitterSettings settings;
+		settings.maxParticles = 4096;
+		settings.spawnRate = 2500.0f;
+		settings.lifetime = 1.5f;
+		settings.lifetimeVariance = 0.3f;
+		settings.spawnExtent = Vector3(1.0f, 0.0f, 1.0f);
+		settings.velocity = Vector3(0.0f, 4.0f, 0.0f);
+		settings.velocitySpread = Vector3(3.0f, 2.0f, 3.0f);
+		settings.acceleration = Vector3(0.0f, -9.8f, 0.0f);
+		settings.drag = 0.5f;
+		settings.colors = { { 0.0f, 1.0f, 0.9f, 0.3f, 1.0f }, { 0.5f, 1.0f, 0.3f, 0.1f, 0.8f }, { 1.0f, 0.2f, 0.2f, 0.2f, 0.0f } };
+		settings.sizes = { { 0.0f, 0.1f }, { 0.2f, 0.5f }, { 1.0f, 0.8f } };
+		for (uint32_t i = 0; i < gEmitterCount; ++i) {
+			settings.seed = i + 1;
+			particles.AddEmitter(settings, Vector3(static_cast<float>(i % 16) * 25.0f, 0.0f, static_cast<float>(i / 16) * 50.0f));
+		}
+		for (int update = 0; update < gWarmUpUpdates; ++update) {
+			particles.Update(gUpdateTime);
+		}
+
+		Timings timings;
+		std::vector<RF::ParticleInstance> instances(gEmitterCount * settings.maxParticles);
+		for (int update = 0; update < gUpdates; ++update) {
+			const auto start = std::chrono::steady_clock::now();
+			particles.Update(gUpdateTime);
+			const auto updated = std::chrono::steady_clock::now();
+			particles.WriteInstances(Vector3(200.0f, 60.0f, -100.0f), Vector3(0.0f, -0.6f, 0.8f), instances);
+			const auto written = std::chrono::steady_clock::now();
+			timings.updateMs += std::chrono::duration<double, std::milli>(updated - start).count();
+			timings.writeMs += std::chrono::duration<double, std::milli>(written - updated).count();
+		}
+		timings.updateMs /= gUpdates;
+		timings.writeMs /= gUpdates;
+		timings.count = particles.Count();
+		return timings;
+	}
+}
+
+namespace RFTests {
+
+	TEST(ParticleBenchmark, DISABLED_Particles400k) {
+		RF::JobSystem jobSystem;
+		RF::ParticleSystem scalar;
+		scalar.SetAvx2Enabled(false);
+		const Timings scalarTimings = TimeUpdates(scalar);
+		RF::ParticleSystem vectorized;
+		const Timings vectorizedTimings = TimeUpdates(vectorized);
+		RF::ParticleSystem parallel(&jobSystem);
+		const Timings parallelTimings = TimeUpdates(parallel);
+
+		std::printf("%zu particles in %u emitters, %u workers\n", vectorizedTimings.count, gEmitterCount, jobSystem.WorkerCount());
+		std::printf("Update: scalar %.3f ms, AVX2 %.3f ms, AVX2 on the job system %.3f ms\n", scalarTimings.updateMs, vectorizedTimings.updateMs, parallelTimings.updateMs);
+		std::printf("Sorted instance output: one thread %.3f ms, job system %.3f ms\n", vectorizedTimings.writeMs, parallelTimings.writeMs);
+		EXPECT_EQ(scalarTimings.count, vectorizedTimings.count);
+	}
+}
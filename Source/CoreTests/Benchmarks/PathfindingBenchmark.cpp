@@ -0,0 +1,174 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/hierarchicalPathfinder.h"
+
+namespace {
+	// 512 x 512 tiles with 20% walls, long paths across the map as bosses and escorts would ask for
+	constexpr int gGridSize = 512;
+	constexpr int gQueryCount = 200;
+	constexpr int gRequestCount = 2000;
+	constexpr int gChangesPerFrame = 8;
+
+	double MsSince(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Plain A* over the whole grid, what every query would cost without the hierarchy
+	float FlatAStar(const RF::HierarchicalPathfinder& pathfinder, const Vector2i& start, const Vector2i& goal) {
+		const Vector2i offsets[8] = { Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1), Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1) };
+		const auto isOpen = [&pathfinder](const Vector2i& tile) { return pathfinder.IsInside(tile) && pathfinder.GetCost(tile) != RF::HierarchicalPathfinder::gWall; };
+		const auto heuristic = [&goal](const Vector2i& tile) {
+			const int dx = std::abs(tile.x - goal.x);
+			const int dy = std::abs(tile.y - goal.y);
+			return static_cast<float>(std::max(dx, dy)) + 0.41421356f * static_cast<float>(std::min(dx, dy));
+		};
+		std::vector<float> costs(static_cast<size_t>(gGridSize * gGridSize), std::numeric_limits<float>::infinity());
+		using Entry = std::pair<float, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		costs[static_cast<size_t>(start.y * gGridSize + start.x)] = 0.0f;
+		open.push({ heuristic(start), start.y * gGridSize + start.x });
+		while (!open.empty()) {
+			const int index = open.top().second;
+			open.pop();
+			const Vector2i tile(index % gGridSize, index / gGridSize);
+			const float cost = costs[static_cast<size_t>(index)];
+			if (tile == goal) {
+				return cost;
+			}
+			for (const Vector2i& offset : offsets) {
+				const Vector2i next = tile + offset;
+				const bool isDiagonal = offset.x != 0 && offset.y != 0;
+				if (!isOpen(next) || (isDiagonal && (!isOpen(Vector2i(next.x, tile.y)) || !isOpen(Vector2i(tile.x, next.y))))) {
+					continue;
+				}
+				const float nextCost = cost + static_cast<float>(pathfinder.GetCost(next)) * (isDiagonal ? 1.41421356f : 1.0f);
+				float& current = costs[static_cast<size_t>(next.y * gGridSize + next.x)];
+				if (nextCost < current) {
+					current = nextCost;
+					open.push({ nextCost + heuristic(next), next.y * gGridSize + next.x });
+				}
+			}
+		}
+		return std::numeric_limits<float>::infinity();
+	}
+
+	void FillLevel(RF::HierarchicalPathfinder& pathfinder) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		for (int y = 0; y < gGridSize; ++y) {
+			for (int x = 0; x < gGridSize; ++x) {
+				const float roll = chance(random);
+				pathfinder.SetCost(Vector2i(x, y), roll < 0.2f ? RF::HierarchicalPathfinder::gWall : roll < 0.35f ? static_cast<uint8_t>(3) : static_cast<uint8_t>(1));
+			}
+		}
+	}
+
+	// Open tile pairs at least half the map apart
+	std::vector<std::pair<Vector2i, Vector2i>> MakeQueries(const RF::HierarchicalPathfinder& pathfinder, const int count) {
+		std::mt19937 random(2);
+		std::uniform_int_distribution<int> coordinate(0, gGridSize - 1);
+		std::vector<std::pair<Vector2i, Vector2i>> queries;
+		while (static_cast<int>(queries.size()) < count) {
+			const Vector2i start(coordinate(random), coordinate(random));
+			const Vector2i goal(coordinate(random), coordinate(random));
+			if (pathfinder.GetCost(start) != RF::HierarchicalPathfinder::gWall && pathfinder.GetCost(goal) != RF::HierarchicalPathfinder::gWall
+				&& std::abs(start.x - goal.x) + std::abs(start.y - goal.y) > gGridSize / 2) {
+				queries.push_back({ start, goal });
+			}
+		}
+		return queries;
+	}
+
+	// Frames ProcessRequests() takes to answer every request with the default budget
+	int DrainRequests(RF::HierarchicalPathfinder& pathfinder, const std::vector<std::pair<Vector2i, Vector2i>>& queries, double& worstFrameMs) {
+		for (const auto& [start, goal] : queries) {
+			pathfinder.Request({ start, goal, nullptr });
+		}
+		int frames = 0;
+		worstFrameMs = 0.0;
+		while (pathfinder.PendingCount() > 0) {
+			const auto start = std::chrono::steady_clock::now();
+			pathfinder.ProcessRequests();
+			worstFrameMs = std::max(worstFrameMs, MsSince(start));
+			++frames;
+		}
+		return frames;
+	}
+}
+
+namespace RFTests {
+
+	TEST(PathfindingBenchmark, DISABLED_Hpa512) {
+		RF::JobSystem jobSystem;
+		RF::HierarchicalPathfinder pathfinder(Vector2i(gGridSize, gGridSize), {}, &jobSystem);
+		FillLevel(pathfinder);
+		auto start = std::chrono::steady_clock::now();
+		const size_t clusterCount = pathfinder.UpdateGraph();
+		const double buildMs = MsSince(start);
+
+		const std::vector<std::pair<Vector2i, Vector2i>> queries = MakeQueries(pathfinder, gQueryCount);
+		start = std::chrono::steady_clock::now();
+		float flatCost = 0.0f;
+		for (const auto& [from, to] : queries) {
+			const float cost = FlatAStar(pathfinder, from, to);
+			flatCost += cost == std::numeric_limits<float>::infinity() ? 0.0f : cost;
+		}
+		const double flatMs = MsSince(start) / gQueryCount;
+
+		start = std::chrono::steady_clock::now();
+		float hierarchicalCost = 0.0f;
+		for (const auto& [from, to] : queries) {
+			hierarchicalCost += pathfinder.FindPath(from, to).cost;
+		}
+		const double hierarchicalMs = MsSince(start) / gQueryCount;
+
+		start = std::chrono::steady_clock::now();
+		for (const auto& [from, to] : queries) {
+			pathfinder.FindPath(from, to);
+		}
+		const double cachedMs = MsSince(start) / gQueryCount;
+
+		// Doors opening and closing somewhere on the map
+		std::mt19937 random(3);
+		std::uniform_int_distribution<int> coordinate(0, gGridSize - 1);
+		for (int change = 0; change < gChangesPerFrame; ++change) {
+			const Vector2i tile(coordinate(random), coordinate(random));
+			pathfinder.SetCost(tile, pathfinder.GetCost(tile) == RF::HierarchicalPathfinder::gWall ? static_cast<uint8_t>(1) : RF::HierarchicalPathfinder::gWall);
+		}
+		start = std::chrono::steady_clock::now();
+		const size_t rebuiltCount = pathfinder.UpdateGraph();
+		const double updateMs = MsSince(start);
+
+		RF::PathfinderSettings uncached;
+		uncached.cacheCapacity = 0;
+		RF::HierarchicalPathfinder serial(Vector2i(gGridSize, gGridSize), uncached);
+		RF::HierarchicalPathfinder parallel(Vector2i(gGridSize, gGridSize), uncached, &jobSystem);
+		FillLevel(serial);
+		FillLevel(parallel);
+		serial.UpdateGraph();
+		parallel.UpdateGraph();
+		const std::vector<std::pair<Vector2i, Vector2i>> requests = MakeQueries(serial, gRequestCount);
+		double serialWorstMs = 0.0;
+		double parallelWorstMs = 0.0;
+		const int serialFrames = DrainRequests(serial, requests, serialWorstMs);
+		const int parallelFrames = DrainRequests(parallel, requests, parallelWorstMs);
+
+		std::printf("%d x %d tiles, %zu clusters, %zu abstract nodes, %u workers\n", gGridSize, gGridSize, clusterCount, pathfinder.GetAbstractNodeCount(), jobSystem.WorkerCount());
+		std::printf("Graph build %.3f ms, %d cost changes rebuild %zu clusters in %.3f ms\n", buildMs, gChangesPerFrame, rebuiltCount, updateMs);
+		std::printf("Per query: flat A* %.3f ms, hierarchical %.3f ms (%.1f%% longer), cached %.4f ms\n", flatMs, hierarchicalMs, 100.0 * (hierarchicalCost / flatCost - 1.0), cachedMs);
+		std::printf("%d requests at 1 ms a frame: one thread %d frames (worst %.3f ms), job system %d frames (worst %.3f ms)\n", gRequestCount, serialFrames, serialWorstMs, parallelFrames, parallelWorstMs);
+		EXPECT_LT(hierarchicalMs, flatMs);
+	}
+}
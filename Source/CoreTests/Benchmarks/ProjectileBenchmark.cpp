@@ -0,0 +1,93 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Projectiles/projectileSystem.h"
+
+namespace {
+	// 200k live projectiles of 4 types over a 400 x 400 arena with 2k enemies, ticked at 60 Hz
+	constexpr size_t gLiveCount = 200000;
+	constexpr size_t gTargetCount = 2000;
+	constexpr float gArenaSize = 400.0f;
+	constexpr int gTicks = 60;
+	constexpr float gTickTime = 1.0f / 60.0f;
+
+	struct Arena {
+		std::vector<float> targetXs;
+		std::vector<float> targetYs;
+		std::vector<float> targetRadii;
+	};
+
+	// Keeps the projectile count up, new ones replace the expired and used up ones
+	void Refill(RF::ProjectileSystem& projectiles, std::mt19937& random) {
+		std::uniform_real_distribution<float> coordinate(0.0f, gArenaSize);
+		std::uniform_real_distribution<float> speed(-60.0f, 60.0f);
+		std::uniform_int_distribution<int> type(0, 3);
+		for (size_t i = projectiles.Count(); i < gLiveCount; ++i) {
+			projectiles.Spawn(static_cast<RF::ProjectileTypeId>(type(random)), Vector2(coordinate(random), coordinate(random)), Vector2(speed(random), speed(random)), static_cast<uint32_t>(i));
+		}
+	}
+
+	// Average tick time, and hits per tick
+	double TimeTicks(RF::ProjectileSystem& projectiles, const Arena* arena, size_t& hitsPerTick) {
+		const RF::ProjectileType types[4] = { { 0.1f, 1.0f, 0 }, { 0.2f, 2.0f, 0 }, { 0.1f, 0.5f, 3 }, { 0.4f, 3.0f, 1 } };
+		for (const RF::ProjectileType& type : types) {
+			projectiles.Reserve(projectiles.AddType(type), gLiveCount / 2);
+		}
+		if (arena) {
+			projectiles.SetTargets(arena->targetXs, arena->targetYs, arena->targetRadii);
+		}
+
+		std::mt19937 random(2);
+		double totalMs = 0.0;
+		size_t hits = 0;
+		for (int tick = 0; tick < gTicks; ++tick) {
+			Refill(projectiles, random);
+			const auto start = std::chrono::steady_clock::now();
+			projectiles.Tick(gTickTime);
+			totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			hits += projectiles.GetHits().size();
+		}
+		hitsPerTick = hits / gTicks;
+		return totalMs / gTicks;
+	}
+}
+
+namespace RFTests {
+
+	TEST(ProjectileBenchmark, DISABLED_Projectiles200k) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> coordinate(0.0f, gArenaSize);
+		std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+		Arena arena;
+		for (size_t i = 0; i < gTargetCount; ++i) {
+			arena.targetXs.push_back(coordinate(random));
+			arena.targetYs.push_back(coordinate(random));
+			arena.targetRadii.push_back(radius(random));
+		}
+
+		RF::JobSystem jobSystem;
+		size_t hitsPerTick = 0;
+		RF::ProjectileSystem scalarMotion;
+		scalarMotion.SetAvx2Enabled(false);
+		const double scalarMotionMs = TimeTicks(scalarMotion, nullptr, hitsPerTick);
+		RF::ProjectileSystem avx2Motion;
+		const double avx2MotionMs = TimeTicks(avx2Motion, nullptr, hitsPerTick);
+
+		RF::ProjectileSystem serial(2.0f);
+		const double serialMs = TimeTicks(serial, &arena, hitsPerTick);
+		RF::ProjectileSystem parallel(2.0f, &jobSystem);
+		const double parallelMs = TimeTicks(parallel, &arena, hitsPerTick);
+
+		std::printf("%zu projectiles, %zu targets, %zu hits a tick, %u workers\n", gLiveCount, gTargetCount, hitsPerTick, jobSystem.WorkerCount());
+		std::printf("Motion only: scalar %.3f ms, AVX2 %.3f ms\n", scalarMotionMs, avx2MotionMs);
+		std::printf("Motion and swept hits: one thread %.3f ms, job system %.3f ms\n", serialMs, parallelMs);
+		EXPECT_GT(hitsPerTick, 0u);
+	}
+}
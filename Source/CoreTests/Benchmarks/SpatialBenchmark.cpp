@@ -0,0 +1,182 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Spatial/aabbTree.h"
+#include "Engine/Spatial/spatialHashGrid.h"
+
+namespace {
+	// 100k enemies on a 2048 x 2048 arena, about 19 within the query radius of each other
+	constexpr size_t gEntityCount = 100000;
+	constexpr float gArenaSize = 2048.0f;
+	constexpr float gQueryRadius = 16.0f;
+	constexpr int gRuns = 10;
+
+	// 20k static walls and 2k moving boss sized colliders, queried by 5k boxes and 5k rays per frame
+	constexpr size_t gStaticCount = 20000;
+	constexpr size_t gDynamicCount = 2000;
+	constexpr size_t gTreeQueryCount = 5000;
+
+	double MsSince(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	struct Frame {
+		double buildMs = 1e9;
+		double radiusMs = 1e9;
+		double nearestMs = 1e9;
+		size_t neighbourCount = 0;
+	};
+
+	// Best times over the runs, every run moves all entities a little before rebuilding
+	Frame TimeFrames(RF::SpatialHashGrid& grid, std::vector<float>& xs, std::vector<float>& ys) {
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+		std::vector<Vector2> centers(xs.size());
+		RF::SpatialQueryBatch results;
+
+		Frame best;
+		for (int run = 0; run < gRuns; ++run) {
+			for (size_t i = 0; i < xs.size(); ++i) {
+				xs[i] = std::clamp(xs[i] + step(random), 0.0f, gArenaSize);
+				ys[i] = std::clamp(ys[i] + step(random), 0.0f, gArenaSize);
+				centers[i] = Vector2(xs[i], ys[i]);
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			grid.Build(xs, ys);
+			best.buildMs = std::min(best.buildMs, MsSince(start));
+
+			start = std::chrono::steady_clock::now();
+			grid.QueryRadius(centers, gQueryRadius, results);
+			best.radiusMs = std::min(best.radiusMs, MsSince(start));
+			best.neighbourCount = results.Ids().size();
+
+			start = std::chrono::steady_clock::now();
+			grid.QueryNearest(centers, 8, 4.0f * gQueryRadius, results);
+			best.nearestMs = std::min(best.nearestMs, MsSince(start));
+		}
+		return best;
+	}
+
+	RF::Aabb RandomBox(std::mt19937& random, const float minSize, const float maxSize) {
+		std::uniform_real_distribution<float> coordinate(0.0f, gArenaSize);
+		std::uniform_real_distribution<float> size(minSize, maxSize);
+		const Vector2 min(coordinate(random), coordinate(random));
+		return { min, Vector2(min.x + size(random), min.y + size(random)) };
+	}
+
+	struct TreeFrame {
+		double updateMs = 1e9;
+		double queryMs = 1e9;
+		size_t overlapCount = 0;
+	};
+
+	// Best times over the runs of moving the dynamic colliders, then answering the overlap and ray queries
+	template <typename Update>
+	TreeFrame TimeTree(RF::AabbTree& tree, std::vector<RF::Aabb>& boxes, const Update& update) {
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+		std::vector<RF::Aabb> queries;
+		std::vector<Vector2> origins;
+		std::vector<Vector2> displacements;
+		for (size_t i = 0; i < gTreeQueryCount; ++i) {
+			queries.push_back(RandomBox(random, 2.0f, 8.0f));
+			origins.push_back(queries.back().min);
+			displacements.push_back(Vector2(step(random) * 20.0f, step(random) * 20.0f));
+		}
+		std::vector<RF::AabbTreeHit> hits(gTreeQueryCount);
+		RF::SpatialQueryBatch results;
+
+		TreeFrame best;
+		for (int run = 0; run < gRuns; ++run) {
+			std::vector<Vector2> moves(gDynamicCount);
+			for (size_t i = 0; i < gDynamicCount; ++i) {
+				moves[i] = Vector2(step(random), step(random));
+				RF::Aabb& box = boxes[gStaticCount + i];
+				box = { Vector2(box.min.x + moves[i].x, box.min.y + moves[i].y), Vector2(box.max.x + moves[i].x, box.max.y + moves[i].y) };
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			update(moves);
+			best.updateMs = std::min(best.updateMs, MsSince(start));
+
+			start = std::chrono::steady_clock::now();
+			tree.QueryOverlaps(queries, results);
+			tree.RayCast(origins, displacements, hits);
+			best.queryMs = std::min(best.queryMs, MsSince(start));
+			best.overlapCount = results.Ids().size();
+		}
+		return best;
+	}
+}
+
+namespace RFTests {
+
+	TEST(SpatialBenchmark, DISABLED_HashGrid100k) {
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> coordinate(0.0f, gArenaSize);
+		std::vector<float> xs(gEntityCount);
+		std::vector<float> ys(gEntityCount);
+		for (size_t i = 0; i < gEntityCount; ++i) {
+			xs[i] = coordinate(random);
+			ys[i] = coordinate(random);
+		}
+		std::vector<float> parallelXs = xs;
+		std::vector<float> parallelYs = ys;
+
+		RF::JobSystem jobSystem;
+		RF::SpatialHashGrid serial(gQueryRadius);
+		RF::SpatialHashGrid parallel(gQueryRadius, &jobSystem);
+		const Frame serialFrame = TimeFrames(serial, xs, ys);
+		const Frame parallelFrame = TimeFrames(parallel, parallelXs, parallelYs);
+
+		std::printf("%zu entities, %zu neighbours found, %u workers\n", gEntityCount, serialFrame.neighbourCount, jobSystem.WorkerCount());
+		std::printf("Build:                 one thread %.3f ms, job system %.3f ms\n", serialFrame.buildMs, parallelFrame.buildMs);
+		std::printf("Radius query for all:  one thread %.3f ms, job system %.3f ms\n", serialFrame.radiusMs, parallelFrame.radiusMs);
+		std::printf("8 nearest for all:     one thread %.3f ms, job system %.3f ms\n", serialFrame.nearestMs, parallelFrame.nearestMs);
+		EXPECT_EQ(serial.Count(), gEntityCount);
+	}
+
+	TEST(SpatialBenchmark, DISABLED_AabbTreeVsRebuild) {
+		std::mt19937 random(4);
+		std::vector<RF::Aabb> boxes;
+		for (size_t i = 0; i < gStaticCount; ++i) {
+			boxes.push_back(RandomBox(random, 2.0f, 40.0f));
+		}
+		for (size_t i = 0; i < gDynamicCount; ++i) {
+			boxes.push_back(RandomBox(random, 10.0f, 30.0f));
+		}
+		std::vector<RF::Aabb> rebuiltBoxes = boxes;
+
+		RF::JobSystem jobSystem;
+		// Level geometry is built top down once, only the moving colliders are inserted one at a time
+		RF::AabbTree incremental(1.0f, &jobSystem);
+		incremental.Build(std::span<const RF::Aabb>(boxes).first(gStaticCount));
+		std::vector<RF::ProxyId> proxies(gStaticCount);
+		for (size_t i = gStaticCount; i < boxes.size(); ++i) {
+			proxies.push_back(incremental.Create(boxes[i]));
+		}
+		const TreeFrame incrementalFrame = TimeTree(incremental, boxes, [&incremental, &proxies, &boxes](const std::vector<Vector2>& moves) {
+			for (size_t i = 0; i < gDynamicCount; ++i) {
+				incremental.Move(proxies[gStaticCount + i], boxes[gStaticCount + i], moves[i]);
+			}
+		});
+
+		RF::AabbTree rebuilt(1.0f, &jobSystem);
+		const TreeFrame rebuiltFrame = TimeTree(rebuilt, rebuiltBoxes, [&rebuilt, &rebuiltBoxes](const std::vector<Vector2>&) { rebuilt.Build(rebuiltBoxes); });
+
+		std::printf("%zu static and %zu moving colliders, %zu box and %zu ray queries, %u workers\n", gStaticCount, gDynamicCount, gTreeQueryCount, gTreeQueryCount, jobSystem.WorkerCount());
+		std::printf("Incremental: update %.3f ms, queries %.3f ms, height %d, area ratio %.1f\n", incrementalFrame.updateMs, incrementalFrame.queryMs, incremental.Height(), incremental.AreaRatio());
+		std::printf("Rebuilt:     update %.3f ms, queries %.3f ms, height %d, area ratio %.1f\n", rebuiltFrame.updateMs, rebuiltFrame.queryMs, rebuilt.Height(), rebuilt.AreaRatio());
+		// Fat boxes differ between the two, so only the rebuilt one matches the colliders' overlaps exactly
+		EXPECT_GT(incrementalFrame.overlapCount, 0u);
+		EXPECT_GT(rebuiltFrame.overlapCount, 0u);
+	}
+}
@@ -0,0 +1,99 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Engine/Lod/tickLodScheduler.h"
+
+namespace {
+	// A late wave, 20k enemies spread over a 300 x 300 arena around the player
+	constexpr size_t gEnemyCount = 20000;
+	constexpr float gArenaHalfSize = 150.0f;
+	constexpr int gFrames = 240;
+	constexpr float gFrameTime = 1.0f / 60.0f;
+
+	struct Enemies {
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> headings;
+	};
+
+	// Stands in for an enemy's AI, animation and steering, with a cost that doesn't depend on deltaTime
+	void TickEnemy(Enemies& enemies, const size_t enemy, const float deltaTime) {
+		float heading = enemies.headings[enemy];
+		for (int step = 0; step < 64; ++step) {
+			heading += 0.01f * std::sin(heading + static_cast<float>(step));
+		}
+		enemies.headings[enemy] = heading;
+		enemies.xs[enemy] += std::cos(heading) * deltaTime;
+		enemies.ys[enemy] += std::sin(heading) * deltaTime;
+	}
+
+	struct Timings {
+		double averageMs = 0.0;
+		double worstMs = 0.0;
+		size_t ticksPerFrame = 0;
+	};
+
+	Timings TimeFrames(Enemies enemies, const bool useLod) {
+		RF::TickLodScheduler scheduler;
+		for (size_t i = 0; i < gEnemyCount; ++i) {
+			scheduler.Add(static_cast<uint32_t>(i));
+		}
+
+		Timings timings;
+		size_t ticks = 0;
+		for (int frame = 0; frame < gFrames; ++frame) {
+			const auto start = std::chrono::steady_clock::now();
+			if (useLod) {
+				for (size_t i = 0; i < gEnemyCount; ++i) {
+					const float distance = std::sqrt(enemies.xs[i] * enemies.xs[i] + enemies.ys[i] * enemies.ys[i]);
+					scheduler.SetLod(static_cast<RF::TickLodId>(i), distance, distance < 20.0f);
+				}
+				for (const RF::TickLodItem& item : scheduler.Tick(gFrameTime)) {
+					TickEnemy(enemies, item.userData, item.deltaTime);
+					++ticks;
+				}
+			}
+			else {
+				for (size_t i = 0; i < gEnemyCount; ++i) {
+					TickEnemy(enemies, i, gFrameTime);
+				}
+				ticks += gEnemyCount;
+			}
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			timings.averageMs += ms;
+			timings.worstMs = std::max(timings.worstMs, ms);
+		}
+		timings.averageMs /= gFrames;
+		timings.ticksPerFrame = ticks / gFrames;
+		return timings;
+	}
+}
+
+namespace RFTests {
+
+	TEST(TickLodBenchmark, DISABLED_LateWave20k) {
+		std::mt19937 random(4);
+		std::uniform_real_distribution<float> coordinate(-gArenaHalfSize, gArenaHalfSize);
+		std::uniform_real_distribution<float> heading(0.0f, 6.28f);
+		Enemies enemies;
+		for (size_t i = 0; i < gEnemyCount; ++i) {
+			enemies.xs.push_back(coordinate(random));
+			enemies.ys.push_back(coordinate(random));
+			enemies.headings.push_back(heading(random));
+		}
+
+		const Timings full = TimeFrames(enemies, false);
+		const Timings lod = TimeFrames(enemies, true);
+		std::printf("%zu enemies: every frame %.3f ms (worst %.3f ms), tick LOD %.3f ms (worst %.3f ms), %.1fx less\n",
+			gEnemyCount, full.averageMs, full.worstMs, lod.averageMs, lod.worstMs, full.averageMs / lod.averageMs);
+		std::printf("Ticks a frame: %zu and %zu\n", full.ticksPerFrame, lod.ticksPerFrame);
+		EXPECT_LT(lod.ticksPerFrame * 3, full.ticksPerFrame);
+	}
+}
@@ -0,0 +1,106 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Engine/frameData.h"
+#include "Engine/Timers/timingWheel.h"
+
+namespace {
+	// 200k live timers of 0.1 to 30 seconds, every expired one is started again and 2k are restarted each frame,
+	// like cooldowns and buffs being refreshed
+	constexpr size_t gTimerCount = 200000;
+	constexpr size_t gRestartsPerFrame = 2000;
+	constexpr int gFrames = 600;
+	constexpr float gFrameTime = 1.0f / 60.0f;
+
+	struct Result {
+		double frameMs = 0.0;
+		size_t expiredPerFrame = 0;
+	};
+
+	Result TimeWheel() {
+		RF::TimingWheel wheel(gFrameTime);
+		wheel.Reserve(gTimerCount);
+		std::mt19937 random(6);
+		std::uniform_real_distribution<float> delay(0.1f, 30.0f);
+		std::vector<RF::TimerId> ids(gTimerCount);
+		size_t expiredCount = 0;
+		RF::TimerKindId kind = 0;
+		kind = wheel.AddKind([&wheel, &random, &delay, &ids, &expiredCount, &kind](std::span<const RF::TimerExpiry> expired) {
+			expiredCount += expired.size();
+			for (const RF::TimerExpiry& expiry : expired) {
+				ids[expiry.userData] = wheel.Schedule(kind, delay(random), expiry.userData);
+			}
+		});
+		for (uint32_t i = 0; i < gTimerCount; ++i) {
+			ids[i] = wheel.Schedule(kind, delay(random), i);
+		}
+
+		RF::FrameData frameData;
+		const auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < gFrames; ++frame) {
+			for (size_t i = 0; i < gRestartsPerFrame; ++i) {
+				const uint32_t timer = static_cast<uint32_t>(random() % gTimerCount);
+				wheel.Cancel(ids[timer]);
+				ids[timer] = wheel.Schedule(kind, delay(random), timer);
+			}
+			frameData.deltaTime = gFrameTime;
+			frameData.totalTime += frameData.deltaTime;
+			wheel.Update(frameData);
+		}
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return { totalMs / gFrames, expiredCount / gFrames };
+	}
+
+	// The same with the timers in a std::multimap keyed by expiry time, cancelled through stored iterators
+	Result TimeMap() {
+		using Timers = std::multimap<double, uint32_t>;
+		Timers timers;
+		std::mt19937 random(6);
+		std::uniform_real_distribution<float> delay(0.1f, 30.0f);
+		std::vector<Timers::iterator> entries(gTimerCount);
+		for (uint32_t i = 0; i < gTimerCount; ++i) {
+			entries[i] = timers.emplace(delay(random), i);
+		}
+
+		double time = 0.0;
+		size_t expiredCount = 0;
+		std::vector<uint32_t> expired;
+		const auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < gFrames; ++frame) {
+			for (size_t i = 0; i < gRestartsPerFrame; ++i) {
+				const uint32_t timer = static_cast<uint32_t>(random() % gTimerCount);
+				timers.erase(entries[timer]);
+				entries[timer] = timers.emplace(time + delay(random), timer);
+			}
+			time += gFrameTime;
+			expired.clear();
+			while (!timers.empty() && timers.begin()->first <= time) {
+				expired.push_back(timers.begin()->second);
+				timers.erase(timers.begin());
+			}
+			expiredCount += expired.size();
+			for (const uint32_t timer : expired) {
+				entries[timer] = timers.emplace(time + delay(random), timer);
+			}
+		}
+		const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return { totalMs / gFrames, expiredCount / gFrames };
+	}
+}
+
+namespace RFTests {
+
+	TEST(TimingWheelBenchmark, DISABLED_Timers200k) {
+		const Result wheel = TimeWheel();
+		const Result map = TimeMap();
+		std::printf("%zu timers, %zu restarts and about %zu expiries a frame\n", gTimerCount, gRestartsPerFrame, wheel.expiredPerFrame);
+		std::printf("Timing wheel %.3f ms a frame, std::multimap %.3f ms a frame\n", wheel.frameMs, map.frameMs);
+		EXPECT_GT(wheel.expiredPerFrame, 0u);
+	}
+}
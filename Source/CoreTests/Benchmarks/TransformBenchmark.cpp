@@ -0,0 +1,75 @@
+// Benchmarks are disabled by default, run them on a release build with
+// "Core Tests_Release --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Scene/transformHierarchy.h"
+
+namespace {
+	// 2000 ships with 10 attachments each, every attachment has 9 effects or sub parts: 202k nodes
+	constexpr size_t gRootCount = 2000;
+	constexpr size_t gChildCount = 10;
+	constexpr size_t gGrandChildCount = 9;
+	constexpr int gRuns = 20;
+
+	double MsSince(const std::chrono::steady_clock::time_point& start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::vector<RF::TransformId> BuildScene(RF::TransformHierarchy& hierarchy) {
+		std::vector<RF::TransformId> roots;
+		for (size_t root = 0; root < gRootCount; ++root) {
+			const RF::TransformId rootId = hierarchy.Create(RF::gNoTransform, { .x = static_cast<float>(root) });
+			roots.push_back(rootId);
+			for (size_t child = 0; child < gChildCount; ++child) {
+				const RF::TransformId childId = hierarchy.Create(rootId, { .x = 1.0f, .rotation = 0.1f * static_cast<float>(child) });
+				for (size_t grandChild = 0; grandChild < gGrandChildCount; ++grandChild) {
+					hierarchy.Create(childId, { .y = 0.5f });
+				}
+			}
+		}
+		hierarchy.Update();
+		return roots;
+	}
+
+	// Best time of Update() with every stride-th root moved before it
+	double TimeUpdate(RF::TransformHierarchy& hierarchy, const std::vector<RF::TransformId>& roots, const size_t stride) {
+		double bestMs = 1e9;
+		for (int run = 0; run < gRuns; ++run) {
+			for (size_t i = static_cast<size_t>(run) % stride; i < roots.size(); i += stride) {
+				hierarchy.SetLocal(roots[i], RF::Transform2D{ .x = static_cast<float>(i), .y = static_cast<float>(run) });
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			hierarchy.Update();
+			bestMs = std::min(bestMs, MsSince(start));
+		}
+		return bestMs;
+	}
+}
+
+namespace RFTests {
+
+	TEST(TransformBenchmark, DISABLED_Update200kNodes) {
+		RF::TransformHierarchy serial;
+		const std::vector<RF::TransformId> serialRoots = BuildScene(serial);
+
+		RF::JobSystem jobSystem;
+		RF::TransformHierarchy parallel(&jobSystem);
+		const std::vector<RF::TransformId> parallelRoots = BuildScene(parallel);
+
+		std::printf("%zu nodes in %zu levels, %u workers\n", serial.Count(), serial.LevelCount(), jobSystem.WorkerCount());
+		for (const size_t stride : std::array<size_t, 3>{ 1, 10, 100 }) {
+			const double serialMs = TimeUpdate(serial, serialRoots, stride);
+			const double parallelMs = TimeUpdate(parallel, parallelRoots, stride);
+			std::printf("1/%zu of the roots moved (%zu nodes updated): one thread %.3f ms, job system %.3f ms\n",
+				stride, serial.LastUpdatedCount(), serialMs, parallelMs);
+		}
+		EXPECT_EQ(serial.Count(), gRootCount * (1 + gChildCount * (1 + gGrandChildCount)));
+	}
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Spatial/aabbTree.h"
+
+namespace {
+	std::vector<RF::Aabb> RandomBoxes(const size_t count, const unsigned int seed) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> size(0.5f, 20.0f);
+		std::vector<RF::Aabb> boxes;
+		for (size_t i = 0; i < count; ++i) {
+			const Vector2 min(position(random), position(random));
+			boxes.push_back({ min, Vector2(min.x + size(random), min.y + size(random)) });
+		}
+		return boxes;
+	}
+
+	std::vector<uint32_t> Sorted(std::vector<uint32_t> ids) {
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+}
+
+namespace RFTests {
+
+	TEST(AabbTreeTests, StaysBalancedThroughChanges) {
+		const std::vector<RF::Aabb> boxes = RandomBoxes(2000, 1);
+		RF::AabbTree tree(0.5f);
+		std::vector<RF::ProxyId> proxies;
+		for (uint32_t i = 0; i < boxes.size(); ++i) {
+			proxies.push_back(tree.Create(boxes[i], i));
+		}
+		ASSERT_TRUE(tree.Validate());
+		EXPECT_EQ(tree.ProxyCount(), 2000u);
+		// Rotations go by perimeter rather than height, inserting one at a time still ends up about as tight as a
+		// top down build and not much higher
+		RF::AabbTree built(0.5f);
+		built.Build(boxes);
+		EXPECT_LT(tree.AreaRatio(), built.AreaRatio() * 1.1f);
+		EXPECT_LE(tree.Height(), 2 * built.Height());
+
+		// Sorted insertion is the worst case for a tree without rotations
+		RF::AabbTree sorted(0.5f);
+		for (int i = 0; i < 1024; ++i) {
+			const Vector2 min(static_cast<float>(i) * 2.0f, 0.0f);
+			sorted.Create({ min, Vector2(min.x + 1.0f, 1.0f) });
+		}
+		ASSERT_TRUE(sorted.Validate());
+		EXPECT_LE(sorted.Height(), 15);
+
+		// Identical boxes give the heuristic nothing to go by
+		RF::AabbTree stacked(0.5f);
+		for (int i = 0; i < 1024; ++i) {
+			stacked.Create({ Vector2(0.0f, 0.0f), Vector2(1.0f, 1.0f) });
+		}
+		ASSERT_TRUE(stacked.Validate());
+		EXPECT_LE(stacked.Height(), 20);
+
+		for (size_t i = 0; i < proxies.size(); i += 2) {
+			tree.Destroy(proxies[i]);
+		}
+		ASSERT_TRUE(tree.Validate());
+		EXPECT_EQ(tree.ProxyCount(), 1000u);
+
+		// Small moves stay inside the fat box, large ones reinsert
+		const RF::Aabb& box = boxes[1];
+		EXPECT_FALSE(tree.Move(proxies[1], { Vector2(box.min.x + 0.2f, box.min.y), Vector2(box.max.x + 0.2f, box.max.y) }));
+		EXPECT_TRUE(tree.Move(proxies[1], { Vector2(box.min.x + 50.0f, box.min.y), Vector2(box.max.x + 50.0f, box.max.y) }, Vector2(3.0f, 0.0f)));
+		EXPECT_GE(tree.GetFatBounds(proxies[1]).max.x, box.max.x + 50.0f + 6.0f);
+		EXPECT_EQ(tree.GetUserData(proxies[1]), 1u);
+		ASSERT_TRUE(tree.Validate());
+
+		const float ratio = tree.AreaRatio();
+		tree.Rebuild();
+		ASSERT_TRUE(tree.Validate());
+		EXPECT_GT(tree.AreaRatio(), 0.0f);
+		EXPECT_LT(tree.AreaRatio(), ratio * 2.0f);
+	}
+
+	TEST(AabbTreeTests, OverlapsMatchBruteForce) {
+		const std::vector<RF::Aabb> boxes = RandomBoxes(3000, 2);
+		const std::vector<RF::Aabb> queries = RandomBoxes(200, 3);
+		RF::JobSystem jobSystem(2);
+		RF::AabbTree incremental(0.0f, &jobSystem);
+		for (uint32_t i = 0; i < boxes.size(); ++i) {
+			incremental.Create(boxes[i], i);
+		}
+		RF::AabbTree built(0.0f);
+		built.Build(boxes);
+		ASSERT_TRUE(built.Validate());
+
+		RF::SpatialQueryBatch incrementalResults;
+		RF::SpatialQueryBatch builtResults;
+		incremental.QueryOverlaps(queries, incrementalResults);
+		built.QueryOverlaps(queries, builtResults);
+		for (size_t query = 0; query < queries.size(); ++query) {
+			std::vector<uint32_t> expected;
+			for (uint32_t i = 0; i < boxes.size(); ++i) {
+				if (RF::Bounds::Overlaps(boxes[i], queries[query])) {
+					expected.push_back(i);
+				}
+			}
+
+			// Incremental proxy ids aren't the box indices, the user data is
+			std::vector<uint32_t> found;
+			for (const uint32_t proxy : incrementalResults.Results(query)) {
+				found.push_back(incremental.GetUserData(proxy));
+			}
+			const std::span<const uint32_t> builtFound = builtResults.Results(query);
+			EXPECT_EQ(Sorted(found), expected);
+			EXPECT_EQ(Sorted(std::vector<uint32_t>(builtFound.begin(), builtFound.end())), expected);
+		}
+	}
+
+	TEST(AabbTreeTests, CastsFindTheClosestBox) {
+		// A corridor of walls along x, one every 10 units
+		std::vector<RF::Aabb> walls;
+		for (int i = 1; i <= 20; ++i) {
+			const float x = static_cast<float>(i) * 10.0f;
+			walls.push_back({ Vector2(x, -5.0f), Vector2(x + 1.0f, 5.0f) });
+		}
+		RF::AabbTree tree(0.0f);
+		tree.Build(walls);
+
+		const std::vector<Vector2> origins = { Vector2(0.0f, 0.0f), Vector2(55.0f, 0.0f), Vector2(0.0f, 8.0f), Vector2(10.5f, 0.0f) };
+		const std::vector<Vector2> displacements = { Vector2(100.0f, 0.0f), Vector2(-100.0f, 0.0f), Vector2(100.0f, 0.0f), Vector2(0.0f, 1.0f) };
+		std::vector<RF::AabbTreeHit> hits(origins.size());
+		tree.RayCast(origins, displacements, hits);
+		EXPECT_EQ(hits[0].userData, 0u);
+		EXPECT_FLOAT_EQ(hits[0].fraction, 0.1f);
+		EXPECT_EQ(hits[1].userData, 4u);
+		EXPECT_FLOAT_EQ(hits[1].fraction, 0.04f);
+		// Passes above the walls
+		EXPECT_EQ(hits[2].proxy, RF::gNullProxy);
+		// Starts inside a wall
+		EXPECT_EQ(hits[3].userData, 0u);
+		EXPECT_EQ(hits[3].fraction, 0.0f);
+
+		// The first box passes over the walls, the second one is tall enough to reach down to them
+		const std::vector<RF::Aabb> boxes = { { Vector2(-4.0f, 10.0f), Vector2(4.0f, 18.0f) }, { Vector2(-4.0f, 4.0f), Vector2(4.0f, 16.0f) } };
+		const std::vector<Vector2> sweeps = { Vector2(100.0f, 0.0f), Vector2(100.0f, 0.0f) };
+		std::vector<RF::AabbTreeHit> sweepHits(boxes.size());
+		tree.Sweep(boxes, sweeps, sweepHits);
+		EXPECT_EQ(sweepHits[0].proxy, RF::gNullProxy);
+		EXPECT_EQ(sweepHits[1].userData, 0u);
+		EXPECT_FLOAT_EQ(sweepHits[1].fraction, 0.06f);
+	}
+}
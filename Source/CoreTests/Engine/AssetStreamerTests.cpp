@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+#include "Engine/Assets/assetStreamer.h"
+#include "Engine/FileSystem/virtualFileSystem.h"
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Metrics/metrics.h"
+#include "Platform/asyncFileBackend.h"
+
+namespace {
+	class AssetStreamerTests : public testing::Test {
+	protected:
+		void SetUp() override {
+			mRoot = std::filesystem::temp_directory_path() / "RuneForgeStreamerTests";
+			std::filesystem::remove_all(mRoot);
+			std::filesystem::create_directories(mRoot);
+
+			for (const char* name : { "critical.txt", "visible.txt", "prefetch.txt", "number.txt" }) {
+				std::ofstream(mRoot / name) << name;
+			}
+			std::ofstream(mRoot / "number.txt") << "1234";
+
+			ASSERT_TRUE(mFileSystem.MountDirectory(mRoot));
+		}
+
+		void TearDown() override {
+			mFileSystem.UnmountAll();
+			std::filesystem::remove_all(mRoot);
+		}
+
+		// Processes completions until at least one was delivered
+		static void DeliverOne(RF::AssetStreamer& streamer) {
+			while (streamer.ProcessCompletions() == 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		std::filesystem::path mRoot;
+		RF::VirtualFileSystem mFileSystem;
+		RF::JobSystem mJobSystem = RF::JobSystem(2);
+		RF::Metrics mMetrics;
+	};
+}
+
+namespace RFTests {
+
+	TEST_F(AssetStreamerTests, HigherPriorityIsServedFirst) {
+		RF::AssetStreamerSettings settings;
+		settings.ioThreadCount = 1;
+		settings.maxInFlight = 1;
+		RF::AssetStreamer streamer(mFileSystem, mJobSystem, &mMetrics, settings);
+
+		std::vector<std::string> order;
+		auto record = [&order](const RF::StreamResult& result) { order.push_back(result.path); };
+
+		// The prefetch request takes the only in flight slot until it is delivered
+		streamer.Request({ .path = "prefetch.txt", .priority = RF::StreamPriority::Prefetch, .onComplete = record });
+		while (mMetrics.Summarize("AssetStreamer/ioMs").count == 0) {
+			std::this_thread::yield();
+		}
+		streamer.Request({ .path = "visible.txt", .priority = RF::StreamPriority::Visible, .onComplete = record });
+		streamer.Request({ .path = "critical.txt", .priority = RF::StreamPriority::Critical, .onComplete = record });
+
+		DeliverOne(streamer);
+		DeliverOne(streamer);
+		DeliverOne(streamer);
+
+		const std::vector<std::string> expected = { "prefetch.txt", "critical.txt", "visible.txt" };
+		EXPECT_EQ(order, expected);
+		EXPECT_EQ(mMetrics.Summarize("AssetStreamer/latencyMs").count, 3u);
+		EXPECT_EQ(mMetrics.Summarize("AssetStreamer/latencyMs/Critical").count, 1u);
+	}
+
+	TEST_F(AssetStreamerTests, DecodeRunsBeforeCompletion) {
+		RF::AssetStreamer streamer(mFileSystem, mJobSystem, &mMetrics);
+		int value = 0;
+
+		streamer.Request({
+			.path = "number.txt",
+			.decode = [](RF::StreamResult& result) {
+				const std::string text(reinterpret_cast<const char*>(result.data.data()), result.data.size());
+				result.asset = std::make_shared<int>(std::stoi(text));
+			},
+			.onComplete = [&value](const RF::StreamResult& result) {
+				ASSERT_EQ(result.status, RF::StreamStatus::Loaded);
+				value = *std::static_pointer_cast<int>(result.asset);
+			},
+		});
+		streamer.Flush();
+
+		EXPECT_EQ(value, 1234);
+		EXPECT_EQ(mMetrics.Summarize("AssetStreamer/decodeMs").count, 1u);
+	}
+
+	TEST_F(AssetStreamerTests, MissingFilesAndCancellation) {
+		RF::AssetStreamerSettings settings;
+		settings.ioThreadCount = 1;
+		settings.maxInFlight = 1;
+		RF::AssetStreamer streamer(mFileSystem, mJobSystem, &mMetrics, settings);
+
+		RF::StreamStatus missingStatus = RF::StreamStatus::Loaded;
+		bool cancelledCalled = false;
+
+		streamer.Request({ .path = "missing.txt", .onComplete = [&missingStatus](const RF::StreamResult& result) { missingStatus = result.status; } });
+		const RF::StreamRequestId cancelled = streamer.Request({ .path = "visible.txt", .onComplete = [&cancelledCalled](const RF::StreamResult&) { cancelledCalled = true; } });
+		EXPECT_TRUE(streamer.Cancel(cancelled));
+
+		streamer.Flush();
+
+		EXPECT_EQ(missingStatus, RF::StreamStatus::NotFound);
+		EXPECT_FALSE(cancelledCalled);
+		EXPECT_FALSE(streamer.Cancel(cancelled));
+		EXPECT_EQ(mMetrics.Counter("AssetStreamer/cancelled"), 1);
+		EXPECT_EQ(streamer.PendingCount(), 0u);
+	}
+
+	TEST_F(AssetStreamerTests, ReadsThroughFileBackend) {
+		std::unique_ptr<RF::AsyncFileBackend> backend = RF::CreateAsyncFileBackend({});
+		RF::AssetStreamerSettings settings;
+		settings.fileBackend = backend.get();
+		RF::AssetStreamer streamer(mFileSystem, mJobSystem, &mMetrics, settings);
+
+		std::string text;
+		RF::StreamStatus missingStatus = RF::StreamStatus::Loaded;
+		streamer.Request({
+			.path = "number.txt",
+			.decode = [&text](RF::StreamResult& result) { text.assign(reinterpret_cast<const char*>(result.data.data()), result.data.size()); },
+		});
+		streamer.Request({ .path = "missing.txt", .onComplete = [&missingStatus](const RF::StreamResult& result) { missingStatus = result.status; } });
+		streamer.Flush();
+
+		EXPECT_EQ(text, "1234");
+		EXPECT_EQ(missingStatus, RF::StreamStatus::NotFound);
+		EXPECT_EQ(mMetrics.Counter("AssetStreamer/bytes"), 4);
+	}
+
+	TEST(MetricsTests, SummaryAndReport) {
+		RF::Metrics metrics(4);
+		for (int i = 1; i <= 10; ++i) {
+			metrics.Record("frameMs", static_cast<double>(i));
+		}
+		metrics.Increment("spawns", 5);
+
+		const RF::MetricSummary summary = metrics.Summarize("frameMs");
+		EXPECT_EQ(summary.count, 10u);
+		EXPECT_DOUBLE_EQ(summary.min, 1.0);
+		EXPECT_DOUBLE_EQ(summary.max, 10.0);
+		EXPECT_DOUBLE_EQ(summary.mean, 5.5);
+		// Percentiles only look at the last 4 samples
+		EXPECT_GE(summary.p50, 7.0);
+		EXPECT_EQ(metrics.Counter("spawns"), 5);
+
+		const nlohmann::json report = metrics.BuildReport();
+		EXPECT_EQ(report["stats"]["frameMs"]["count"].get<uint64_t>(), 10u);
+		EXPECT_EQ(report["counters"]["spawns"].get<int64_t>(), 5);
+	}
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/crowdSteering.h"
+
+namespace {
+	struct Crowd {
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> velocityXs;
+		std::vector<float> velocityYs;
+
+		RF::CrowdAgents Agents() { return { xs, ys, velocityXs, velocityYs, {}, {} }; }
+	};
+
+	Crowd RandomCrowd(const size_t count, const float extent) {
+		std::mt19937 random(21);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> velocity(-3.0f, 3.0f);
+		Crowd crowd;
+		for (size_t i = 0; i < count; ++i) {
+			crowd.xs.push_back(position(random));
+			crowd.ys.push_back(position(random));
+			crowd.velocityXs.push_back(velocity(random));
+			crowd.velocityYs.push_back(velocity(random));
+		}
+		return crowd;
+	}
+
+	float Distance(const Crowd& crowd, const size_t a, const size_t b) {
+		return std::hypot(crowd.xs[a] - crowd.xs[b], crowd.ys[a] - crowd.ys[b]);
+	}
+}
+
+namespace RFTests {
+
+	TEST(CrowdSteeringTests, SameResultsHoweverSplit) {
+		// Dense enough that most agents have neighbours in other jobs' chunks
+		Crowd serial = RandomCrowd(5000, 40.0f);
+		Crowd parallel = serial;
+		const std::vector<float> obstacleXs = { 0.0f, 20.0f, -15.0f };
+		const std::vector<float> obstacleYs = { 0.0f, -10.0f, 25.0f };
+		const std::vector<float> obstacleRadii = { 3.0f, 1.0f, 5.0f };
+
+		RF::JobSystem jobSystem(3);
+		RF::CrowdSteering serialSteering;
+		RF::CrowdSteering parallelSteering({}, &jobSystem);
+		serialSteering.SetObstacles(obstacleXs, obstacleYs, obstacleRadii);
+		parallelSteering.SetObstacles(obstacleXs, obstacleYs, obstacleRadii);
+		for (int frame = 0; frame < 5; ++frame) {
+			serialSteering.Update(serial.Agents(), Vector2(100.0f, 50.0f), 1.0f / 60.0f);
+			parallelSteering.Update(parallel.Agents(), Vector2(100.0f, 50.0f), 1.0f / 60.0f);
+		}
+
+		EXPECT_EQ(serial.xs, parallel.xs);
+		EXPECT_EQ(serial.ys, parallel.ys);
+		EXPECT_EQ(serial.velocityXs, parallel.velocityXs);
+		EXPECT_EQ(serial.velocityYs, parallel.velocityYs);
+	}
+
+	TEST(CrowdSteeringTests, SeeksWhileKeepingApart) {
+		// Three agents stacked on top of each other chase a target
+		Crowd crowd = { { 0.0f, 0.0f, 0.1f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+		RF::CrowdSteering steering;
+		for (int frame = 0; frame < 120; ++frame) {
+			steering.Update(crowd.Agents(), Vector2(0.0f, 100.0f), 1.0f / 60.0f);
+		}
+
+		for (size_t i = 0; i < 3; ++i) {
+			EXPECT_GT(crowd.ys[i], 3.0f);
+			EXPECT_LE(std::hypot(crowd.velocityXs[i], crowd.velocityYs[i]), steering.GetSettings().maxSpeed + 1e-4f);
+		}
+		EXPECT_GT(Distance(crowd, 0, 1), 0.5f);
+		EXPECT_GT(Distance(crowd, 0, 2), 0.5f);
+		EXPECT_GT(Distance(crowd, 1, 2), 0.5f);
+
+		// Directions replace the target, e.g. from a flow field
+		const std::vector<float> directionXs = { 1.0f, 1.0f, 1.0f };
+		const std::vector<float> directionYs = { 0.0f, 0.0f, 0.0f };
+		RF::CrowdAgents agents = crowd.Agents();
+		agents.directionXs = directionXs;
+		agents.directionYs = directionYs;
+		for (int frame = 0; frame < 120; ++frame) {
+			steering.Update(agents, Vector2(0.0f, 100.0f), 1.0f / 60.0f);
+		}
+		for (size_t i = 0; i < 3; ++i) {
+			EXPECT_GT(crowd.velocityXs[i], 0.0f);
+			EXPECT_GT(crowd.velocityXs[i], std::abs(crowd.velocityYs[i]));
+		}
+	}
+
+	TEST(CrowdSteeringTests, GoesAroundObstacles) {
+		// A pillar right between the agent and its target
+		const std::vector<float> obstacleXs = { 10.0f };
+		const std::vector<float> obstacleYs = { 0.0f };
+		const std::vector<float> obstacleRadii = { 2.0f };
+		RF::CrowdSteering steering;
+		steering.SetObstacles(obstacleXs, obstacleYs, obstacleRadii);
+
+		Crowd crowd = { { 0.0f }, { 0.0f }, { 0.0f }, { 0.0f } };
+		float closest = 1e9f;
+		for (int frame = 0; frame < 480; ++frame) {
+			steering.Update(crowd.Agents(), Vector2(20.0f, 0.0f), 1.0f / 60.0f);
+			closest = std::min(closest, std::hypot(crowd.xs[0] - 10.0f, crowd.ys[0]));
+		}
+
+		EXPECT_GT(closest, obstacleRadii[0]);
+		EXPECT_NEAR(crowd.xs[0], 20.0f, 1.0f);
+		EXPECT_NEAR(crowd.ys[0], 0.0f, 1.0f);
+	}
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include "Engine/ECS/commandBuffer.h"
+#include "Engine/ECS/query.h"
+#include "Engine/Jobs/jobSystem.h"
+
+namespace {
+	struct CommandPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct CommandVelocity {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct CommandHealth {
+		int value = 100;
+	};
+
+	struct CommandDead {};
+
+	// Every entity shoots a projectile and kills itself when its health is gone, recorded from parallel chunk jobs
+	std::vector<RF::Entity> RunParallelFrame(RF::World& world, RF::JobSystem& jobSystem) {
+		RF::CommandBufferSet commands(jobSystem);
+		RF::Query<RF::Read<CommandPosition>, RF::Read<CommandHealth>> query(world);
+
+		query.BeginIteration();
+		jobSystem.ParallelFor(query.ChunkCount(), 1, [&query, &commands](const size_t begin, const size_t end) {
+			for (size_t chunk = begin; chunk < end; ++chunk) {
+				RF::CommandBuffer& buffer = commands.Get();
+				buffer.SetSortKey(chunk);
+				query.ForEachChunkInRange(chunk, chunk + 1, [&buffer](std::span<const RF::Entity> entities, std::span<const CommandPosition> positions, std::span<const CommandHealth> healths) {
+					for (size_t i = 0; i < entities.size(); ++i) {
+						buffer.Create(positions[i], CommandVelocity{ 1.0f, 0.0f });
+						if (healths[i].value <= 0) {
+							buffer.Destroy(entities[i]);
+						}
+					}
+				});
+			}
+		});
+		query.EndIteration();
+		commands.Playback(world);
+
+		std::vector<RF::Entity> entities;
+		RF::Query<RF::Read<CommandVelocity>>(world).ForEachChunk([&entities](std::span<const RF::Entity> chunkEntities, std::span<const CommandVelocity>) {
+			entities.insert(entities.end(), chunkEntities.begin(), chunkEntities.end());
+		});
+		return entities;
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsCommandBufferTests, PlaceholdersAndPlayback) {
+		RF::World world;
+		const RF::Entity existing = world.Create(CommandHealth{ 10 });
+		const RF::Entity doomed = world.Create(CommandHealth{ 0 });
+
+		RF::CommandBuffer buffer;
+		const RF::Entity spawned = buffer.Create(CommandPosition{ 1.0f, 2.0f }, CommandHealth{ 5 });
+		EXPECT_TRUE(RF::CommandBuffer::IsPlaceholder(spawned));
+		buffer.Add(spawned, CommandVelocity{ 3.0f, 4.0f });
+		buffer.Add<CommandDead>(existing);
+		buffer.Remove<CommandHealth>(existing);
+		buffer.Destroy(doomed);
+		for (int i = 0; i < 1000; ++i) {
+			buffer.Create(CommandPosition{ static_cast<float>(i), 0.0f });
+		}
+		EXPECT_EQ(world.EntityCount(), 2u);
+
+		EXPECT_EQ(buffer.CommandCount(), 1005u);
+		buffer.Playback(world);
+
+		const RF::Entity real = buffer.Resolve(spawned);
+		ASSERT_TRUE(world.IsAlive(real));
+		EXPECT_EQ(world.Get<CommandPosition>(real)->y, 2.0f);
+		EXPECT_EQ(world.Get<CommandHealth>(real)->value, 5);
+		EXPECT_EQ(world.Get<CommandVelocity>(real)->y, 4.0f);
+		EXPECT_TRUE(world.Has<CommandDead>(existing));
+		EXPECT_FALSE(world.Has<CommandHealth>(existing));
+		EXPECT_FALSE(world.IsAlive(doomed));
+		EXPECT_EQ(buffer.CommandCount(), 0u);
+
+		float sum = 0.0f;
+		RF::Query<RF::Read<CommandPosition>, RF::Without<CommandHealth>>(world).Each([&sum](const CommandPosition& position) { sum += position.x; });
+		EXPECT_EQ(sum, 999.0f * 1000.0f / 2.0f);
+	}
+
+	TEST(EcsCommandBufferTests, SortedRunsKeepTheirPlaceholders) {
+		RF::World world;
+		RF::CommandBuffer buffer;
+		std::vector<RF::Entity> placeholders;
+		// The position runs end up next to each other in the group and in sort order, but not in placeholder order
+		for (const uint64_t sortKey : { 2, 1, 3 }) {
+			buffer.SetSortKey(sortKey);
+			for (int i = 0; i < 3; ++i) {
+				const float value = static_cast<float>(sortKey * 10 + static_cast<uint64_t>(i));
+				placeholders.push_back(sortKey == 1 ? buffer.Create(CommandHealth{ static_cast<int>(value) }) : buffer.Create(CommandPosition{ value, 0.0f }));
+			}
+		}
+		EXPECT_EQ(buffer.CommandCount(), 9u);
+		buffer.Playback(world);
+
+		for (size_t i = 0; i < placeholders.size(); ++i) {
+			const RF::Entity entity = buffer.Resolve(placeholders[i]);
+			const float expected = static_cast<float>((i < 3 ? 20 : i < 6 ? 10 : 30) + i % 3);
+			if (i >= 3 && i < 6) {
+				EXPECT_EQ(world.Get<CommandHealth>(entity)->value, static_cast<int>(expected));
+			}
+			else {
+				EXPECT_EQ(world.Get<CommandPosition>(entity)->x, expected);
+			}
+		}
+	}
+
+	TEST(EcsCommandBufferTests, ParallelRecordingIsDeterministic) {
+		RF::JobSystem jobSystem(3);
+		std::vector<std::vector<RF::Entity>> results;
+		std::vector<std::vector<float>> positions;
+
+		for (int run = 0; run < 2; ++run) {
+			RF::World world;
+			for (int i = 0; i < 5000; ++i) {
+				world.Create(CommandPosition{ static_cast<float>(i), 0.0f }, CommandHealth{ i % 7 == 0 ? 0 : 10 });
+			}
+
+			results.push_back(RunParallelFrame(world, jobSystem));
+
+			std::vector<float> runPositions;
+			RF::Query<RF::Read<CommandPosition>, RF::Read<CommandVelocity>>(world).Each([&runPositions](const CommandPosition& position, const CommandVelocity&) {
+				runPositions.push_back(position.x);
+			});
+			positions.push_back(runPositions);
+			EXPECT_EQ(world.EntityCount(), 5000u + 5000u - 715u);
+		}
+
+		EXPECT_EQ(results[0], results[1]);
+		EXPECT_EQ(positions[0], positions[1]);
+	}
+}
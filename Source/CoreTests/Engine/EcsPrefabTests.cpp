@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Engine/ECS/prefab.h"
+#include "Engine/ECS/world.h"
+
+namespace {
+	struct PrefabPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+	NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(PrefabPosition, x, y)
+
+	struct PrefabHealth {
+		int value = 100;
+		int armor = 0;
+	};
+	NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(PrefabHealth, value, armor)
+
+	struct PrefabNoReader {
+		int value = 0;
+	};
+
+	struct PrefabEnemy {};
+
+	void RegisterTypes() {
+		RF::Ecs::RegisterJsonReader<PrefabPosition>();
+		RF::Ecs::RegisterJsonReader<PrefabHealth>();
+		RF::Ecs::TypeId<PrefabNoReader>();
+		RF::Ecs::TypeId<PrefabEnemy>();
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsPrefabTests, CompilesJsonIntoATemplateRow) {
+		RegisterTypes();
+		RF::World world;
+		RF::Prefab prefab;
+		ASSERT_TRUE(prefab.Compile(world, nlohmann::json::parse(R"({
+			"components": { "PrefabPosition": { "y": 2.5 }, "PrefabHealth": { "armor": 3 }, "PrefabEnemy": {} }
+		})"))) << prefab.Error();
+
+		EXPECT_EQ(prefab.Mask(), (RF::Ecs::MakeMask<PrefabPosition, PrefabHealth, PrefabEnemy>()));
+		EXPECT_EQ(prefab.Types().size(), 2u);
+		EXPECT_EQ(prefab.Get<PrefabPosition>()->y, 2.5f);
+		EXPECT_EQ(prefab.Get<PrefabHealth>()->value, 100);
+		EXPECT_EQ(prefab.Get<PrefabHealth>()->armor, 3);
+		EXPECT_EQ(prefab.Get<PrefabNoReader>(), nullptr);
+	}
+
+	TEST(EcsPrefabTests, ReportsBadPrefabs) {
+		RegisterTypes();
+		RF::World world;
+		RF::Prefab prefab;
+		EXPECT_FALSE(prefab.Compile(world, nlohmann::json::parse(R"({ "PrefabHealth": {} })")));
+		EXPECT_FALSE(prefab.Compile(world, nlohmann::json::parse(R"({ "components": { "Unknown": {} } })")));
+		EXPECT_FALSE(prefab.Compile(world, nlohmann::json::parse(R"({ "components": { "PrefabEnemy": { "boss": true } } })")));
+		EXPECT_FALSE(prefab.Compile(world, nlohmann::json::parse(R"({ "components": { "PrefabNoReader": { "value": 1 } } })")));
+		EXPECT_FALSE(prefab.Compile(world, nlohmann::json::parse(R"({ "components": { "PrefabHealth": { "value": "lots" } } })")));
+		EXPECT_FALSE(prefab.Error().empty());
+
+		// No fields means defaults, which needs no reader
+		EXPECT_TRUE(prefab.Compile(world, nlohmann::json::parse(R"({ "components": { "PrefabNoReader": {} } })")));
+		EXPECT_TRUE(prefab.Error().empty());
+	}
+
+	TEST(EcsPrefabTests, InstantiateBatchBroadcastsAndOverrides) {
+		RegisterTypes();
+		RF::World world;
+		RF::Prefab prefab;
+		ASSERT_TRUE(prefab.Compile(world, nlohmann::json::parse(R"({
+			"components": { "PrefabPosition": {}, "PrefabHealth": { "value": 40 }, "PrefabEnemy": {} }
+		})")));
+
+		// Spans several chunks, with a chunk started by an entity that is already there
+		world.Create(PrefabPosition{}, PrefabHealth{}, PrefabEnemy{});
+		constexpr size_t count = 3000;
+		std::vector<PrefabPosition> positions;
+		for (size_t i = 0; i < count; ++i) {
+			positions.push_back({ static_cast<float>(i), -static_cast<float>(i) });
+		}
+		const RF::ComponentOverride overrides[] = { RF::Ecs::Override(std::span<const PrefabPosition>(positions)) };
+		const std::vector<RF::Entity> entities = world.InstantiateBatch(prefab, count, overrides);
+
+		ASSERT_EQ(entities.size(), count);
+		EXPECT_EQ(world.EntityCount(), count + 1);
+		for (size_t i = 0; i < count; ++i) {
+			ASSERT_EQ(world.Get<PrefabPosition>(entities[i])->x, static_cast<float>(i));
+			ASSERT_EQ(world.Get<PrefabPosition>(entities[i])->y, -static_cast<float>(i));
+			ASSERT_EQ(world.Get<PrefabHealth>(entities[i])->value, 40);
+			ASSERT_TRUE(world.Has<PrefabEnemy>(entities[i]));
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "Engine/ECS/ecsProfiler.h"
+#include "Engine/ECS/systemScheduler.h"
+#include "Engine/frameData.h"
+
+namespace {
+	struct ProfiledPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct ProfiledVelocity {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct ProfiledStunned {
+		static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+		float seconds = 0.0f;
+	};
+}
+
+namespace RFTests {
+
+	TEST(EcsProfilerTests, ReportsOccupancy) {
+		RF::World world;
+		RF::EcsProfiler profiler(world);
+		for (int i = 0; i < 1000; ++i) {
+			world.Create(ProfiledPosition{});
+		}
+		for (int i = 0; i < 10; ++i) {
+			world.Add<ProfiledStunned>(world.Create(ProfiledPosition{}, ProfiledVelocity{}));
+		}
+
+		bool foundPositions = false;
+		for (const RF::ArchetypeOccupancy& archetype : profiler.Archetypes()) {
+			if (archetype.components != "ProfiledPosition") {
+				continue;
+			}
+			foundPositions = true;
+			EXPECT_EQ(archetype.entityCount, 1000u);
+			EXPECT_EQ(archetype.chunkCount, (1000 + archetype.chunkCapacity - 1) / archetype.chunkCapacity);
+			EXPECT_GT(archetype.fillRatio, 0.0);
+			EXPECT_LE(archetype.fillRatio, 1.0);
+			EXPECT_EQ(archetype.reservedBytes, archetype.chunkCount * RF::gChunkSize);
+			EXPECT_EQ(archetype.usedBytes, 1000 * (sizeof(RF::Entity) + sizeof(ProfiledPosition)));
+		}
+		EXPECT_TRUE(foundPositions);
+
+		size_t checkedComponents = 0;
+		for (const RF::ComponentOccupancy& component : profiler.Components()) {
+			if (component.name == "ProfiledPosition") {
+				EXPECT_EQ(component.entityCount, 1010u);
+				EXPECT_EQ(component.usedBytes, 1010 * sizeof(ProfiledPosition));
+				++checkedComponents;
+			}
+			else if (component.name == "ProfiledStunned") {
+				EXPECT_TRUE(component.isSparse);
+				EXPECT_EQ(component.entityCount, 10u);
+				EXPECT_GE(component.reservedBytes, component.usedBytes);
+				++checkedComponents;
+			}
+		}
+		EXPECT_EQ(checkedComponents, 2u);
+	}
+
+	TEST(EcsProfilerTests, CountsArchetypeTransitions) {
+		RF::World world;
+		std::vector<RF::Entity> entities;
+		for (int i = 0; i < 20; ++i) {
+			entities.push_back(world.Create(ProfiledPosition{}));
+		}
+
+		{
+			RF::EcsProfiler profiler(world);
+			for (const RF::Entity entity : entities) {
+				world.Add<ProfiledVelocity>(entity);
+			}
+			for (size_t i = 0; i < 5; ++i) {
+				world.Remove<ProfiledVelocity>(entities[i]);
+			}
+			// Sparse components don't move the entity
+			world.Add<ProfiledStunned>(entities[0]);
+
+			const std::vector<RF::ArchetypeTransitionCount> transitions = profiler.Transitions();
+			ASSERT_EQ(transitions.size(), 2u);
+			EXPECT_EQ(transitions[0].count, 20u);
+			EXPECT_EQ(transitions[1].count, 5u);
+			EXPECT_EQ(transitions[0].from, transitions[1].to);
+
+			const nlohmann::json report = profiler.BuildReport();
+			EXPECT_EQ(report["transitions"][0]["from"], "ProfiledPosition");
+			EXPECT_EQ(report["transitions"][0]["to"], "ProfiledPosition+ProfiledVelocity");
+		}
+
+		// The profiler unhooks itself, moves after it is gone aren't recorded anywhere
+		world.Add<ProfiledVelocity>(entities[0]);
+		EXPECT_TRUE(world.Has<ProfiledVelocity>(entities[0]));
+	}
+
+	TEST(EcsProfilerTests, RanksSystems) {
+		RF::World world;
+		RF::JobSystem jobSystem(2);
+		RF::SystemScheduler scheduler(world, jobSystem);
+		RF::EcsProfiler profiler(world, &scheduler, 2);
+
+		for (int i = 0; i < 3000; ++i) {
+			world.Create(ProfiledPosition{}, ProfiledVelocity{ 1.0f, 0.0f });
+		}
+		for (int i = 0; i < 500; ++i) {
+			world.Create(ProfiledPosition{});
+		}
+
+		scheduler.AddChunkSystem<RF::Write<ProfiledPosition>, RF::Read<ProfiledVelocity>>({ .name = "Move" },
+			[](const RF::FrameData& frameData, std::span<const RF::Entity>, std::span<ProfiledPosition> positions, std::span<const ProfiledVelocity> velocities) {
+				for (size_t i = 0; i < positions.size(); ++i) {
+					positions[i].x += velocities[i].x * frameData.deltaTime;
+				}
+			});
+		scheduler.AddChunkSystem<RF::Read<ProfiledPosition>>({ .name = "Render" },
+			[](const RF::FrameData&, std::span<const RF::Entity>, std::span<const ProfiledPosition>) {});
+		scheduler.Add({ .name = "Slow", .run = [](const RF::FrameData&) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); } });
+
+		const RF::FrameData frameData = { 1.0f, 1.0f };
+		for (int frame = 0; frame < 3; ++frame) {
+			scheduler.Run(frameData);
+			profiler.Sample();
+		}
+		EXPECT_EQ(profiler.SampleCount(), 3u);
+
+		const std::vector<RF::SystemSample> byTime = profiler.TopSystemsByTime();
+		ASSERT_EQ(byTime.size(), 2u);
+		EXPECT_EQ(byTime[0].name, "Slow");
+		EXPECT_GE(byTime[0].ms, 5.0);
+
+		const std::vector<RF::SystemSample> byEntities = profiler.TopSystemsByEntities();
+		ASSERT_EQ(byEntities.size(), 2u);
+		EXPECT_EQ(byEntities[0].name, "Render");
+		EXPECT_EQ(byEntities[0].entityCount, 3500.0);
+		EXPECT_EQ(byEntities[1].name, "Move");
+		EXPECT_EQ(byEntities[1].entityCount, 3000.0);
+
+		const nlohmann::json report = profiler.BuildReport();
+		EXPECT_EQ(report["totals"]["entities"], 3500u);
+		EXPECT_EQ(report["totals"]["sampledFrames"], 3u);
+		EXPECT_EQ(report["systemsByEntities"][0]["name"], "Render");
+		EXPECT_FALSE(profiler.Summary().empty());
+	}
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Engine/ECS/query.h"
+
+namespace {
+	struct QueryPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct QueryVelocity {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct QueryHealth {
+		int value = 100;
+	};
+
+	struct QueryDead {};
+
+	template <typename QueryType>
+	size_t CountVisited(QueryType&& query) {
+		size_t count = 0;
+		query.ForEachChunk([&count](std::span<const RF::Entity> entities, auto...) { count += entities.size(); });
+		return count;
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsQueryTests, FiltersAndSpans) {
+		RF::World world;
+		for (int i = 0; i < 100; ++i) {
+			const RF::Entity entity = world.Create(QueryPosition{}, QueryVelocity{ 1.0f, 0.0f });
+			if (i % 4 == 0) {
+				world.Add<QueryDead>(entity);
+			}
+		}
+		world.Create(QueryPosition{});
+
+		RF::Query<RF::Write<QueryPosition>, RF::Read<QueryVelocity>, RF::Without<QueryDead>> query(world);
+		static_assert(decltype(query)::gDataTermCount == 2);
+		EXPECT_EQ(query.EntityCount(), 75u);
+
+		query.ForEachChunk([](std::span<const RF::Entity> entities, std::span<QueryPosition> positions, std::span<const QueryVelocity> velocities) {
+			ASSERT_EQ(entities.size(), positions.size());
+			for (size_t i = 0; i < positions.size(); ++i) {
+				positions[i].x += velocities[i].x;
+			}
+		});
+
+		float movedSum = 0.0f;
+		RF::Query<RF::Read<QueryPosition>, RF::With<QueryDead>>(world).Each([&movedSum](const QueryPosition& position) { movedSum += position.x; });
+		EXPECT_EQ(movedSum, 0.0f);
+
+		float sum = 0.0f;
+		RF::Query<RF::Read<QueryPosition>>(world).Each([&sum](const QueryPosition& position) { sum += position.x; });
+		EXPECT_EQ(sum, 75.0f);
+	}
+
+	TEST(EcsQueryTests, MatchesNewArchetypesIncrementally) {
+		RF::World world;
+		RF::Query<RF::Read<QueryHealth>> query(world);
+		EXPECT_EQ(query.EntityCount(), 0u);
+		EXPECT_TRUE(query.MatchedArchetypes().empty());
+
+		world.Create(QueryHealth{ 1 });
+		world.Create(QueryHealth{ 2 }, QueryPosition{});
+		world.Create(QueryPosition{});
+		EXPECT_EQ(query.EntityCount(), 2u);
+		EXPECT_EQ(query.MatchedArchetypes().size(), 2u);
+
+		EXPECT_EQ(RF::Query<RF::Read<QueryHealth>>::ReadMask(), RF::Ecs::MakeMask<QueryHealth>());
+		EXPECT_TRUE(RF::Query<RF::Read<QueryHealth>>::WriteMask().none());
+	}
+
+	TEST(EcsQueryTests, ChangedAndAddedSkipUntouchedChunks) {
+		RF::World world;
+		std::vector<RF::Entity> entities;
+		for (int i = 0; i < 2000; ++i) {
+			entities.push_back(world.Create(QueryPosition{}, QueryVelocity{}));
+		}
+		const uint32_t chunkCapacity = world.GetArchetype(world.GetOrCreateArchetype(RF::Ecs::MakeMask<QueryPosition, QueryVelocity>())).ChunkCapacity();
+		ASSERT_LT(chunkCapacity, 1000u);
+
+		RF::Query<RF::Read<QueryPosition>, RF::Changed<QueryPosition>> changed(world);
+		EXPECT_EQ(CountVisited(changed), 2000u);
+		EXPECT_EQ(CountVisited(changed), 0u);
+
+		// A single write wakes up only its chunk
+		world.Get<QueryPosition>(entities[chunkCapacity + 1])->x = 1.0f;
+		EXPECT_EQ(CountVisited(changed), chunkCapacity);
+		EXPECT_EQ(CountVisited(changed), 0u);
+
+		// A system filtering on what it writes doesn't see its own writes, others do
+		RF::Query<RF::Write<QueryPosition>, RF::Changed<QueryPosition>> writer(world);
+		EXPECT_EQ(CountVisited(writer), 2000u);
+		EXPECT_EQ(CountVisited(writer), 0u);
+		EXPECT_EQ(CountVisited(changed), 2000u);
+
+		// Reads and writes of other components don't count
+		RF::Query<RF::Write<QueryVelocity>>(world).Each([](QueryVelocity& velocity) { velocity.x = 1.0f; });
+		EXPECT_EQ(CountVisited(changed), 0u);
+
+		// Adding a component moves the entity to a new archetype where it counts as added, it also changes the chunk
+		// it left and, for Changed<QueryPosition>, the chunk it arrives in
+		RF::Query<RF::Read<QueryHealth>, RF::Added<QueryHealth>> added(world);
+		EXPECT_EQ(CountVisited(added), 0u);
+		world.Add(entities[0], QueryHealth{ 5 });
+		EXPECT_EQ(CountVisited(added), 1u);
+		EXPECT_EQ(CountVisited(added), 0u);
+		EXPECT_EQ(CountVisited(changed), chunkCapacity + 1);
+
+		// Writing is a change but not an addition
+		world.Get<QueryHealth>(entities[0])->value = 1;
+		EXPECT_EQ(CountVisited(added), 0u);
+		EXPECT_EQ(CountVisited(RF::Query<RF::Read<QueryHealth>, RF::Changed<QueryHealth>>(world)), 1u);
+	}
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "Engine/ECS/worldSnapshot.h"
+#include "Engine/ECS/world.h"
+
+namespace {
+	struct SnapshotPosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct SnapshotTarget {
+		RF::Entity entity = RF::Entity::Null;
+	};
+
+	struct SnapshotFrozen {};
+
+	struct SnapshotBurning {
+		static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+		float damage = 0.0f;
+	};
+
+	// Mixed archetypes, several chunks, holes in the entity table and entities pointing at each other
+	std::vector<RF::Entity> Populate(RF::World& world) {
+		std::vector<RF::Entity> entities;
+		for (int i = 0; i < 3000; ++i) {
+			const RF::Entity entity = world.Create(SnapshotPosition{ static_cast<float>(i), 1.0f });
+			if (i % 3 == 0) {
+				world.Add(entity, SnapshotTarget{ entities.empty() ? RF::Entity::Null : entities.back() });
+			}
+			if (i % 5 == 0) {
+				world.Add<SnapshotFrozen>(entity);
+			}
+			entities.push_back(entity);
+		}
+		for (size_t i = 0; i < entities.size(); i += 7) {
+			world.Destroy(entities[i]);
+		}
+		return entities;
+	}
+
+	void ExpectSameWorld(RF::World& expected, RF::World& actual, const std::vector<RF::Entity>& entities) {
+		EXPECT_EQ(actual.EntityCount(), expected.EntityCount());
+		for (const RF::Entity entity : entities) {
+			ASSERT_EQ(actual.IsAlive(entity), expected.IsAlive(entity));
+			if (!expected.IsAlive(entity)) {
+				continue;
+			}
+			ASSERT_EQ(actual.Get<SnapshotPosition>(entity)->x, expected.Get<SnapshotPosition>(entity)->x);
+			ASSERT_EQ(actual.Has<SnapshotFrozen>(entity), expected.Has<SnapshotFrozen>(entity));
+			ASSERT_EQ(actual.Has<SnapshotTarget>(entity), expected.Has<SnapshotTarget>(entity));
+			if (expected.Has<SnapshotTarget>(entity)) {
+				ASSERT_EQ(actual.Get<SnapshotTarget>(entity)->entity, expected.Get<SnapshotTarget>(entity)->entity);
+			}
+		}
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsSnapshotTests, RoundTripKeepsHandles) {
+		RF::World world;
+		const std::vector<RF::Entity> entities = Populate(world);
+		RF::WorldSnapshot snapshot;
+		snapshot.Capture(world);
+
+		// Restoring into a world that registered nothing yet and holds other entities
+		RF::World restored;
+		restored.Create(SnapshotPosition{ -1.0f, -1.0f });
+		ASSERT_TRUE(snapshot.Restore(restored));
+		ExpectSameWorld(world, restored, entities);
+
+		// The entity table comes along, so both worlds hand out the same next handles
+		EXPECT_EQ(restored.Create(), world.Create());
+		EXPECT_EQ(restored.Create(), world.Create());
+	}
+
+	TEST(EcsSnapshotTests, RestoresFromFile) {
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "RuneForgeSnapshotTests.bin";
+		RF::World world;
+		const std::vector<RF::Entity> entities = Populate(world);
+		RF::WorldSnapshot snapshot;
+		snapshot.Capture(world);
+		ASSERT_TRUE(snapshot.WriteFile(path));
+
+		RF::World restored;
+		ASSERT_TRUE(RF::WorldSnapshot::RestoreFromFile(restored, path));
+		ExpectSameWorld(world, restored, entities);
+		EXPECT_FALSE(RF::WorldSnapshot::RestoreFromFile(restored, path.parent_path() / "RuneForgeMissingSnapshot.bin"));
+		std::filesystem::remove(path);
+	}
+
+	TEST(EcsSnapshotTests, RewindsThroughARing) {
+		RF::World world;
+		const RF::Entity entity = world.Create(SnapshotPosition{});
+		std::array<RF::WorldSnapshot, 4> ring;
+		for (int frame = 0; frame < 10; ++frame) {
+			ring[static_cast<size_t>(frame) % ring.size()].Capture(world);
+			world.Get<SnapshotPosition>(entity)->x += 1.0f;
+			world.Create(SnapshotPosition{ static_cast<float>(frame), 0.0f });
+		}
+
+		// The ring holds frames 6 to 9
+		ASSERT_TRUE(ring[7 % ring.size()].Restore(world));
+		EXPECT_EQ(world.Get<SnapshotPosition>(entity)->x, 7.0f);
+		EXPECT_EQ(world.EntityCount(), 8u);
+		ASSERT_TRUE(ring[9 % ring.size()].Restore(world));
+		EXPECT_EQ(world.Get<SnapshotPosition>(entity)->x, 9.0f);
+	}
+
+	TEST(EcsSnapshotTests, KeepsSparseComponents) {
+		RF::World world;
+		const std::vector<RF::Entity> entities = Populate(world);
+		for (size_t i = 1; i < entities.size(); i += 7) {
+			world.Add(entities[i], SnapshotBurning{ static_cast<float>(i) });
+		}
+		RF::WorldSnapshot snapshot;
+		snapshot.Capture(world);
+
+		RF::World restored;
+		ASSERT_TRUE(snapshot.Restore(restored));
+		ExpectSameWorld(world, restored, entities);
+		for (size_t i = 0; i < entities.size(); ++i) {
+			ASSERT_EQ(restored.Has<SnapshotBurning>(entities[i]), world.Has<SnapshotBurning>(entities[i]));
+			if (world.Has<SnapshotBurning>(entities[i])) {
+				ASSERT_EQ(restored.Get<SnapshotBurning>(entities[i])->damage, static_cast<float>(i));
+			}
+		}
+	}
+
+	TEST(EcsSnapshotTests, RejectsBadData) {
+		RF::World world;
+		Populate(world);
+		RF::WorldSnapshot snapshot;
+		snapshot.Capture(world);
+		const std::span<const std::byte> data = snapshot.Data();
+
+		RF::World target;
+		const RF::Entity survivor = target.Create(SnapshotPosition{ 5.0f, 5.0f });
+		EXPECT_FALSE(RF::WorldSnapshot::Restore(target, data.first(data.size() / 2)));
+		EXPECT_FALSE(RF::WorldSnapshot::Restore(target, data.first(sizeof(RF::WorldSnapshotHeader) - 1)));
+
+		std::vector<std::byte> corrupted(data.begin(), data.end());
+		corrupted[0] = std::byte{ 0 };
+		EXPECT_FALSE(RF::WorldSnapshot::Restore(target, corrupted));
+
+		// A live entity whose generation doesn't match the entity table
+		RF::WorldSnapshotHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+		corrupted.assign(data.begin(), data.end());
+		corrupted[header.generationsOffset + sizeof(uint32_t)] ^= std::byte{ 1 };
+		EXPECT_FALSE(RF::WorldSnapshot::Restore(target, corrupted));
+
+		// Failed restores leave the world alone
+		EXPECT_EQ(target.EntityCount(), 1u);
+		EXPECT_EQ(target.Get<SnapshotPosition>(survivor)->x, 5.0f);
+		EXPECT_TRUE(RF::WorldSnapshot::Restore(target, data));
+		EXPECT_EQ(target.EntityCount(), world.EntityCount());
+	}
+}
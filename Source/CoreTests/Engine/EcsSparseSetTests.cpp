@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Engine/ECS/query.h"
+
+namespace {
+	struct SparsePosition {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct SparseBurning {
+		static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+		float damage = 1.0f;
+	};
+
+	struct SparseFrozen {
+		static constexpr RF::ComponentStorage gStorage = RF::ComponentStorage::Sparse;
+	};
+}
+
+namespace RFTests {
+
+	TEST(EcsSparseSetTests, AddAndRemoveKeepTheArchetype) {
+		RF::World world;
+		const RF::Entity entity = world.Create(SparsePosition{ 1.0f, 2.0f });
+		const size_t archetypeCount = world.ArchetypeCount();
+
+		world.Add(entity, SparseBurning{ 5.0f });
+		world.Add<SparseFrozen>(entity);
+		EXPECT_EQ(world.ArchetypeCount(), archetypeCount);
+		EXPECT_TRUE(world.Has<SparseBurning>(entity));
+		EXPECT_TRUE(world.Has<SparseFrozen>(entity));
+		EXPECT_EQ(world.Get<SparseBurning>(entity)->damage, 5.0f);
+		EXPECT_EQ(world.Get<SparsePosition>(entity)->y, 2.0f);
+
+		world.Remove<SparseBurning>(entity);
+		EXPECT_FALSE(world.Has<SparseBurning>(entity));
+		EXPECT_EQ(world.Get<SparseBurning>(entity), nullptr);
+
+		// Created with the entity, sparse components still go to their set
+		const RF::Entity spawned = world.Create(SparsePosition{}, SparseBurning{ 3.0f });
+		EXPECT_EQ(world.ArchetypeCount(), archetypeCount);
+		EXPECT_EQ(world.Get<SparseBurning>(spawned)->damage, 3.0f);
+
+		// Destroying drops the entity from every set, the recycled index doesn't inherit it
+		world.Destroy(entity);
+		EXPECT_EQ(world.FindSparseSet(RF::Ecs::TypeId<SparseFrozen>())->Count(), 0u);
+		const RF::Entity recycled = world.Create(SparsePosition{});
+		EXPECT_EQ(RF::Ecs::EntityIndex(recycled), RF::Ecs::EntityIndex(entity));
+		EXPECT_FALSE(world.Has<SparseFrozen>(recycled));
+	}
+
+	TEST(EcsSparseSetTests, SwapRemoveKeepsSlotsConsistent) {
+		RF::World world;
+		std::vector<RF::Entity> entities;
+		for (int i = 0; i < 5000; ++i) {
+			entities.push_back(world.Create(SparsePosition{}));
+			world.Add(entities.back(), SparseBurning{ static_cast<float>(i) });
+		}
+		for (size_t i = 0; i < entities.size(); i += 3) {
+			world.Remove<SparseBurning>(entities[i]);
+		}
+
+		const RF::SparseSet* set = world.FindSparseSet(RF::Ecs::TypeId<SparseBurning>());
+		EXPECT_EQ(set->Count(), 3333u);
+		for (size_t i = 0; i < entities.size(); ++i) {
+			ASSERT_EQ(world.Has<SparseBurning>(entities[i]), i % 3 != 0);
+			if (i % 3 != 0) {
+				ASSERT_EQ(world.Get<SparseBurning>(entities[i])->damage, static_cast<float>(i));
+			}
+		}
+	}
+
+	TEST(EcsSparseSetTests, QueriesMixStorages) {
+		RF::World world;
+		for (int i = 0; i < 1000; ++i) {
+			const RF::Entity entity = world.Create(SparsePosition{});
+			if (i % 2 == 0) {
+				world.Add(entity, SparseBurning{ 2.0f });
+			}
+			if (i % 10 == 0) {
+				world.Add<SparseFrozen>(entity);
+			}
+		}
+		// Burning without a position doesn't match
+		world.Add<SparseBurning>(world.Create());
+
+		RF::Query<RF::Write<SparsePosition>, RF::Read<SparseBurning>, RF::Without<SparseFrozen>> burning(world);
+		EXPECT_EQ(burning.EntityCount(), 400u);
+		burning.Each([](SparsePosition& position, const SparseBurning& effect) { position.x += effect.damage; });
+
+		RF::Query<RF::Read<SparsePosition>, RF::With<SparseFrozen>> frozen(world);
+		float frozenSum = 0.0f;
+		frozen.Each([&frozenSum](const SparsePosition& position) { frozenSum += position.x; });
+		EXPECT_EQ(frozen.EntityCount(), 100u);
+		EXPECT_EQ(frozenSum, 0.0f);
+
+		RF::Query<RF::Read<SparsePosition>, RF::Without<SparseFrozen>> unfrozen(world);
+		float unfrozenSum = 0.0f;
+		unfrozen.Each([&unfrozenSum](const SparsePosition& position) { unfrozenSum += position.x; });
+		EXPECT_EQ(unfrozen.EntityCount(), 900u);
+		EXPECT_EQ(unfrozenSum, 800.0f);
+	}
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+#include "Engine/ECS/systemScheduler.h"
+#include "Engine/frameData.h"
+
+namespace {
+	struct ScheduledPosition {
+		float x = 0.0f;
+	};
+
+	struct ScheduledVelocity {
+		float x = 0.0f;
+	};
+
+	struct ScheduledHealth {
+		int value = 100;
+	};
+
+	void Sleep() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
+
+namespace RFTests {
+
+	TEST(EcsSystemSchedulerTests, OrderFollowsAccess) {
+		RF::World world;
+		RF::JobSystem jobSystem(2);
+		RF::SystemScheduler scheduler(world, jobSystem);
+
+		scheduler.Add({ .name = "Input", .writes = RF::Ecs::MakeMask<ScheduledVelocity>(), .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Move", .reads = RF::Ecs::MakeMask<ScheduledVelocity>(), .writes = RF::Ecs::MakeMask<ScheduledPosition>(), .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Regen", .writes = RF::Ecs::MakeMask<ScheduledHealth>(), .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Render", .reads = RF::Ecs::MakeMask<ScheduledPosition>(), .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Cleanup", .after = { "Regen" }, .before = { "Input" }, .run = [](const RF::FrameData&) {} });
+		ASSERT_TRUE(scheduler.Build());
+
+		EXPECT_EQ(scheduler.Dependencies("Move"), std::vector<std::string>{ "Input" });
+		EXPECT_EQ(scheduler.Dependencies("Render"), std::vector<std::string>{ "Move" });
+		EXPECT_EQ(scheduler.Dependencies("Input"), std::vector<std::string>{ "Cleanup" });
+		EXPECT_EQ(scheduler.Dependencies("Cleanup"), std::vector<std::string>{ "Regen" });
+		EXPECT_TRUE(scheduler.Dependencies("Regen").empty());
+	}
+
+	TEST(EcsSystemSchedulerTests, RunsIndependentSystemsInParallel) {
+		RF::World world;
+		RF::JobSystem jobSystem(3);
+		RF::SystemScheduler scheduler(world, jobSystem);
+
+		for (int i = 0; i < 20000; ++i) {
+			world.Create(ScheduledPosition{}, ScheduledVelocity{ 1.0f });
+		}
+
+		std::atomic<int> running = 0;
+		std::atomic<int> maxRunning = 0;
+		auto track = [&running, &maxRunning](const RF::FrameData&) {
+			const int current = ++running;
+			int expected = maxRunning.load();
+			while (current > expected && !maxRunning.compare_exchange_weak(expected, current)) {}
+			Sleep();
+			--running;
+		};
+
+		scheduler.Add({ .name = "A", .reads = RF::Ecs::MakeMask<ScheduledHealth>(), .run = track });
+		scheduler.Add({ .name = "B", .reads = RF::Ecs::MakeMask<ScheduledHealth>(), .run = track });
+		scheduler.AddChunkSystem<RF::Write<ScheduledPosition>, RF::Read<ScheduledVelocity>>({ .name = "Move" },
+			[](const RF::FrameData& frameData, std::span<const RF::Entity>, std::span<ScheduledPosition> positions, std::span<const ScheduledVelocity> velocities) {
+				for (size_t i = 0; i < positions.size(); ++i) {
+					positions[i].x += velocities[i].x * frameData.deltaTime;
+				}
+			}, 2);
+		scheduler.Add({ .name = "Slow", .reads = RF::Ecs::MakeMask<ScheduledPosition>(), .run = [](const RF::FrameData&) { Sleep(); Sleep(); } });
+
+		const RF::FrameData frameData = { 1.0f, 1.0f };
+		scheduler.Run(frameData);
+		scheduler.Run(frameData);
+
+		EXPECT_GE(maxRunning.load(), 2);
+		float sum = 0.0f;
+		world.Each<const ScheduledPosition>([&sum](const ScheduledPosition& position) { sum += position.x; });
+		EXPECT_EQ(sum, 40000.0f);
+		// Only counted while a profiler is attached
+		EXPECT_EQ(scheduler.Timings()[2].entityCount, 0u);
+
+		EXPECT_EQ(scheduler.CriticalPath(), (std::vector<std::string>{ "Move", "Slow" }));
+		const nlohmann::json trace = scheduler.BuildTrace();
+		EXPECT_GE(trace["traceEvents"].size(), 5u);
+		EXPECT_GT(trace["otherData"]["criticalPathMs"].get<double>(), 9.0);
+	}
+
+	TEST(EcsSystemSchedulerTests, ExclusiveSystemsRunAlone) {
+		RF::World world;
+		RF::JobSystem jobSystem(2);
+		RF::SystemScheduler scheduler(world, jobSystem);
+
+		scheduler.Add({ .name = "Read", .reads = RF::Ecs::MakeMask<ScheduledPosition>(), .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Spawn", .exclusive = true, .run = [](const RF::FrameData&) {} });
+		scheduler.Add({ .name = "Other", .reads = RF::Ecs::MakeMask<ScheduledHealth>(), .run = [](const RF::FrameData&) {} });
+		ASSERT_TRUE(scheduler.Build());
+
+		EXPECT_EQ(scheduler.Dependencies("Spawn"), std::vector<std::string>{ "Read" });
+		EXPECT_EQ(scheduler.Dependencies("Other"), std::vector<std::string>{ "Spawn" });
+	}
+}
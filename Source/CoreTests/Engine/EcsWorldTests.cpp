@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "Engine/ECS/world.h"
+
+namespace {
+	struct Position {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct Velocity {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	struct Health {
+		int value = 100;
+	};
+
+	struct Dead {};
+}
+
+namespace RFTests {
+
+	TEST(EcsWorldTests, GenerationsInvalidateHandles) {
+		RF::World world;
+		const RF::Entity first = world.Create(Position{ 1.0f, 2.0f });
+		world.Destroy(first);
+		const RF::Entity second = world.Create(Position{ 3.0f, 4.0f });
+
+		EXPECT_EQ(RF::Ecs::EntityIndex(first), RF::Ecs::EntityIndex(second));
+		EXPECT_FALSE(world.IsAlive(first));
+		EXPECT_TRUE(world.IsAlive(second));
+		EXPECT_EQ(world.Get<Position>(first), nullptr);
+		EXPECT_FALSE(world.IsAlive(RF::Entity::Null));
+		EXPECT_EQ(world.EntityCount(), 1u);
+	}
+
+	TEST(EcsWorldTests, AddAndRemoveMoveBetweenArchetypes) {
+		RF::World world;
+		const RF::Entity entity = world.Create(Position{ 1.0f, 2.0f }, Velocity{ 3.0f, 4.0f });
+
+		world.Add(entity, Health{ 50 });
+		world.Add<Dead>(entity);
+		ASSERT_TRUE(world.Has<Health>(entity));
+		EXPECT_TRUE(world.Has<Dead>(entity));
+		EXPECT_EQ(world.Get<Position>(entity)->y, 2.0f);
+		EXPECT_EQ(world.Get<Health>(entity)->value, 50);
+
+		world.Remove<Velocity>(entity);
+		EXPECT_FALSE(world.Has<Velocity>(entity));
+		EXPECT_EQ(world.Get<Position>(entity)->x, 1.0f);
+		EXPECT_EQ(world.Get<Health>(entity)->value, 50);
+
+		// Position+Velocity, +Health, +Dead and -Velocity, plus the empty archetype
+		EXPECT_EQ(world.ArchetypeCount(), 5u);
+	}
+
+	TEST(EcsWorldTests, RemovalKeepsChunksDense) {
+		RF::World world;
+		std::vector<RF::Entity> entities;
+		for (int i = 0; i < 5000; ++i) {
+			entities.push_back(world.Create(Health{ i }));
+		}
+		for (size_t i = 0; i < entities.size(); i += 2) {
+			world.Destroy(entities[i]);
+		}
+
+		for (size_t i = 1; i < entities.size(); i += 2) {
+			ASSERT_EQ(world.Get<Health>(entities[i])->value, static_cast<int>(i));
+		}
+
+		const RF::Archetype& archetype = world.GetArchetype(world.GetOrCreateArchetype(RF::Ecs::MakeMask<Health>()));
+		EXPECT_EQ(archetype.EntityCount(), 2500u);
+		EXPECT_EQ(archetype.ChunkCount(), (2500 + archetype.ChunkCapacity() - 1) / archetype.ChunkCapacity());
+	}
+
+	TEST(EcsWorldTests, IteratesMatchingArchetypes) {
+		RF::World world;
+		for (int i = 0; i < 1000; ++i) {
+			const RF::Entity entity = world.Create(Position{}, Velocity{ 1.0f, 2.0f });
+			if (i % 3 == 0) {
+				world.Add<Health>(entity);
+			}
+		}
+		world.Create(Position{});
+
+		world.Each<Position, const Velocity>([](Position& position, const Velocity& velocity) {
+			position.x += velocity.x;
+			position.y += velocity.y;
+		});
+
+		float sum = 0.0f;
+		size_t chunkCount = 0;
+		world.ForEachChunk<const Position>([&sum, &chunkCount](std::span<const RF::Entity> entities, std::span<const Position> positions) {
+			EXPECT_EQ(entities.size(), positions.size());
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(positions.data()) % RF::gChunkColumnAlignment, 0u);
+			for (const Position& position : positions) {
+				sum += position.x + position.y;
+			}
+			++chunkCount;
+		});
+
+		EXPECT_EQ(sum, 3000.0f);
+		EXPECT_EQ(chunkCount, 3u);
+	}
+
+	TEST(EcsWorldTests, TypeNames) {
+		EXPECT_EQ(RF::Ecs::TypeName<Position>(), "Position");
+		EXPECT_EQ(RF::Ecs::GetComponentInfo(RF::Ecs::TypeId<Dead>()).size, 0u);
+
+		RF::ComponentTypeId id = 0;
+		ASSERT_TRUE(RF::Ecs::FindComponentType("Velocity", id));
+		EXPECT_EQ(id, RF::Ecs::TypeId<Velocity>());
+	}
+}
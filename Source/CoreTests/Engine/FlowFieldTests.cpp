@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/flowField.h"
+
+namespace {
+	const Vector2i gOffsets[8] = { Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1), Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1) };
+
+	bool IsOpen(const RF::FlowField& field, const Vector2i& tile) {
+		return field.IsInside(tile) && field.GetCost(tile) != RF::FlowField::gWall;
+	}
+
+	// Same rules as the field: diagonals can't cut corners, stepping into a tile costs its cost times the step length
+	bool CanStep(const RF::FlowField& field, const Vector2i& from, const Vector2i& to) {
+		return IsOpen(field, to) && (from.x == to.x || from.y == to.y || (IsOpen(field, Vector2i(to.x, from.y)) && IsOpen(field, Vector2i(from.x, to.y))));
+	}
+
+	float StepCost(const RF::FlowField& field, const Vector2i& into, const Vector2i& offset) {
+		return static_cast<float>(field.GetCost(into)) * (offset.x != 0 && offset.y != 0 ? 1.41421356f : 1.0f);
+	}
+
+	// Plain single threaded Dijkstra over the whole grid
+	std::vector<float> ReferenceIntegration(const RF::FlowField& field) {
+		const Vector2i size = field.GetSize();
+		std::vector<float> values(static_cast<size_t>(size.x * size.y), RF::FlowField::gUnreachable);
+		using Entry = std::pair<float, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		if (IsOpen(field, field.GetGoal())) {
+			values[static_cast<size_t>(field.GetGoal().y * size.x + field.GetGoal().x)] = 0.0f;
+			open.push({ 0.0f, field.GetGoal().y * size.x + field.GetGoal().x });
+		}
+		while (!open.empty()) {
+			const auto [value, index] = open.top();
+			open.pop();
+			if (value > values[static_cast<size_t>(index)]) {
+				continue;
+			}
+			const Vector2i tile(index % size.x, index / size.x);
+			for (const Vector2i& offset : gOffsets) {
+				const Vector2i next = tile + offset;
+				if (!field.IsInside(next) || !IsOpen(field, tile) || !CanStep(field, tile, next)) {
+					continue;
+				}
+				const float nextValue = value + StepCost(field, next, offset);
+				float& current = values[static_cast<size_t>(next.y * size.x + next.x)];
+				if (nextValue < current) {
+					current = nextValue;
+					open.push({ nextValue, next.y * size.x + next.x });
+				}
+			}
+		}
+		return values;
+	}
+
+	void ExpectMatchesReference(const RF::FlowField& field) {
+		const std::vector<float> expected = ReferenceIntegration(field);
+		const Vector2i size = field.GetSize();
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				const Vector2i tile(x, y);
+				const float value = expected[static_cast<size_t>(y * size.x + x)];
+				ASSERT_EQ(field.IsReachable(tile), value != RF::FlowField::gUnreachable) << x << ", " << y;
+				if (!field.IsReachable(tile)) {
+					EXPECT_EQ(field.GetDirection(tile).LengthSquared(), 0.0f);
+					continue;
+				}
+				ASSERT_NEAR(field.GetIntegration(tile), value, 1e-4f * value) << x << ", " << y;
+
+				// The direction steps to a neighbour the tile's value came from
+				const Vector2 direction = field.GetDirection(tile);
+				if (tile == field.GetGoal()) {
+					EXPECT_EQ(direction.LengthSquared(), 0.0f);
+					continue;
+				}
+				const Vector2i step((direction.x > 0.5f) - (direction.x < -0.5f), (direction.y > 0.5f) - (direction.y < -0.5f));
+				ASSERT_TRUE(CanStep(field, tile, tile + step)) << x << ", " << y;
+				EXPECT_NEAR(field.GetIntegration(tile + step) + StepCost(field, tile, step), value, 1e-4f * value) << x << ", " << y;
+			}
+		}
+	}
+
+	void RandomCosts(RF::FlowField& field, std::mt19937& random) {
+		std::uniform_int_distribution<int> cost(1, 5);
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		for (int y = 0; y < field.GetSize().y; ++y) {
+			for (int x = 0; x < field.GetSize().x; ++x) {
+				field.SetCost(Vector2i(x, y), chance(random) < 0.2f ? RF::FlowField::gWall : static_cast<uint8_t>(cost(random)));
+			}
+		}
+	}
+}
+
+namespace RFTests {
+
+	TEST(FlowFieldTests, MatchesDijkstra) {
+		// Not a multiple of the sector size, so edge sectors are partial
+		RF::JobSystem jobSystem(3);
+		RF::FlowField field(Vector2i(100, 70), 1.0f, Vector2::Zero, &jobSystem);
+		std::mt19937 random(31);
+		RandomCosts(field, random);
+		field.SetCost(Vector2i(40, 30), 1);
+		field.SetGoal(Vector2i(40, 30));
+		EXPECT_GT(field.Update(), 0u);
+		ExpectMatchesReference(field);
+
+		// Nothing changed, nothing to do
+		EXPECT_EQ(field.Update(), 0u);
+		field.SetGoal(Vector2i(40, 30));
+		EXPECT_EQ(field.Update(), 0u);
+
+		field.SetCost(Vector2i(3, 3), 1);
+		field.SetGoal(Vector2i(3, 3));
+		field.Update();
+		ExpectMatchesReference(field);
+	}
+
+	TEST(FlowFieldTests, IncrementalUpdatesMatchFullRecompute) {
+		RF::JobSystem jobSystem(2);
+		RF::FlowField field(Vector2i(80, 80), 1.0f, Vector2::Zero, &jobSystem);
+		std::mt19937 random(32);
+		RandomCosts(field, random);
+		field.SetCost(Vector2i(10, 60), 1);
+		field.SetGoal(Vector2i(10, 60));
+		const size_t fullPasses = field.Update();
+
+		std::uniform_int_distribution<int> coordinate(0, 79);
+		std::uniform_int_distribution<int> cost(1, 5);
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		size_t incrementalPasses = 0;
+		for (int batch = 0; batch < 20; ++batch) {
+			// Walls going up and coming down, and tiles getting cheaper and more expensive
+			for (int change = 0; change < 5; ++change) {
+				const Vector2i tile(coordinate(random), coordinate(random));
+				if (tile != field.GetGoal()) {
+					field.SetCost(tile, chance(random) < 0.5f ? RF::FlowField::gWall : static_cast<uint8_t>(cost(random)));
+				}
+			}
+			incrementalPasses += field.Update();
+			ExpectMatchesReference(field);
+		}
+		EXPECT_LT(incrementalPasses, 20 * fullPasses);
+
+		// A wall around the goal cuts everything off
+		for (const Vector2i& offset : gOffsets) {
+			field.SetCost(field.GetGoal() + offset, RF::FlowField::gWall);
+		}
+		field.Update();
+		EXPECT_FALSE(field.IsReachable(Vector2i(79, 0)));
+		ExpectMatchesReference(field);
+	}
+
+	TEST(FlowFieldTests, GoalMovesMatchFullRecompute) {
+		RF::JobSystem jobSystem(2);
+		RF::FlowField field(Vector2i(90, 60), 1.0f, Vector2::Zero, &jobSystem);
+		std::mt19937 random(45);
+		RandomCosts(field, random);
+		Vector2i goal(45, 30);
+		field.SetCost(goal, 1);
+		field.SetGoal(goal);
+		const size_t fullPasses = field.Update();
+
+		// A player walking a tile at a time, then jumping across the map
+		size_t movePasses = 0;
+		size_t moves = 0;
+		std::uniform_int_distribution<int> step(-1, 1);
+		while (moves < 20) {
+			const Vector2i next = goal + Vector2i(step(random), step(random));
+			if (next == goal || !field.IsInside(next) || field.GetCost(next) == RF::FlowField::gWall) {
+				continue;
+			}
+			goal = next;
+			++moves;
+			field.SetGoal(goal);
+			movePasses += field.Update();
+			ExpectMatchesReference(field);
+		}
+		EXPECT_LT(movePasses, moves * fullPasses);
+
+		field.SetCost(Vector2i(5, 55), 1);
+		field.SetGoal(Vector2i(5, 55));
+		field.Update();
+		ExpectMatchesReference(field);
+
+		// Onto a tile walled off from the old goal, and back out
+		for (const Vector2i& offset : gOffsets) {
+			field.SetCost(Vector2i(80, 10) + offset, RF::FlowField::gWall);
+		}
+		field.SetCost(Vector2i(80, 10), 1);
+		field.Update();
+		field.SetGoal(Vector2i(80, 10));
+		field.Update();
+		EXPECT_FALSE(field.IsReachable(Vector2i(5, 55)));
+		ExpectMatchesReference(field);
+		field.SetGoal(Vector2i(5, 55));
+		field.Update();
+		ExpectMatchesReference(field);
+	}
+
+	TEST(FlowFieldTests, SamplesDirectionsInWorldSpace) {
+		// A corridor of 2 unit tiles along x starting at (-10, -10), with the goal at its right end
+		RF::FlowField field(Vector2i(20, 3), 2.0f, Vector2(-10.0f, -10.0f));
+		for (int x = 0; x < 20; ++x) {
+			field.SetCost(Vector2i(x, 0), RF::FlowField::gWall);
+			field.SetCost(Vector2i(x, 2), RF::FlowField::gWall);
+		}
+		field.SetGoal(Vector2i(19, 1));
+		field.Update();
+
+		EXPECT_EQ(field.TileOf(Vector2(-9.0f, -7.5f)), Vector2i(0, 1));
+		const Vector2 direction = field.SampleDirection(Vector2(-9.0f, -7.5f));
+		EXPECT_EQ(direction.x, 1.0f);
+		EXPECT_EQ(direction.y, 0.0f);
+		EXPECT_EQ(field.SampleDirection(Vector2(-20.0f, 0.0f)).LengthSquared(), 0.0f);
+		EXPECT_EQ(field.SampleDirection(Vector2(-9.0f, -9.0f)).LengthSquared(), 0.0f);
+		EXPECT_FLOAT_EQ(field.GetIntegration(Vector2i(0, 1)), 19.0f);
+
+		const std::vector<float> xs = { -9.0f, 29.0f, 100.0f };
+		const std::vector<float> ys = { -7.5f, -7.5f, 0.0f };
+		std::vector<float> directionXs(3);
+		std::vector<float> directionYs(3);
+		field.SampleDirections(xs, ys, directionXs, directionYs);
+		EXPECT_EQ(directionXs, std::vector<float>({ 1.0f, 0.0f, 0.0f }));
+		EXPECT_EQ(directionYs, std::vector<float>({ 0.0f, 0.0f, 0.0f }));
+	}
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Navigation/hierarchicalPathfinder.h"
+
+namespace {
+	const Vector2i gOffsets[8] = { Vector2i(1, 0), Vector2i(-1, 0), Vector2i(0, 1), Vector2i(0, -1), Vector2i(1, 1), Vector2i(-1, 1), Vector2i(1, -1), Vector2i(-1, -1) };
+
+	bool IsOpen(const RF::HierarchicalPathfinder& pathfinder, const Vector2i& tile) {
+		return pathfinder.IsInside(tile) && pathfinder.GetCost(tile) != RF::HierarchicalPathfinder::gWall;
+	}
+
+	bool CanStep(const RF::HierarchicalPathfinder& pathfinder, const Vector2i& from, const Vector2i& to) {
+		const Vector2i offset = to - from;
+		return std::abs(offset.x) <= 1 && std::abs(offset.y) <= 1 && IsOpen(pathfinder, to)
+			&& (from.x == to.x || from.y == to.y || (IsOpen(pathfinder, Vector2i(to.x, from.y)) && IsOpen(pathfinder, Vector2i(from.x, to.y))));
+	}
+
+	float StepCost(const RF::HierarchicalPathfinder& pathfinder, const Vector2i& from, const Vector2i& to) {
+		return static_cast<float>(pathfinder.GetCost(to)) * (from.x != to.x && from.y != to.y ? 1.41421356f : 1.0f);
+	}
+
+	// Plain Dijkstra over the whole grid, infinity if the goal can't be reached
+	float ReferenceCost(const RF::HierarchicalPathfinder& pathfinder, const Vector2i& start, const Vector2i& goal) {
+		const Vector2i size = pathfinder.GetSize();
+		std::vector<float> costs(static_cast<size_t>(size.x * size.y), std::numeric_limits<float>::infinity());
+		if (!IsOpen(pathfinder, start) || !IsOpen(pathfinder, goal)) {
+			return std::numeric_limits<float>::infinity();
+		}
+		using Entry = std::pair<float, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		costs[static_cast<size_t>(start.y * size.x + start.x)] = 0.0f;
+		open.push({ 0.0f, start.y * size.x + start.x });
+		while (!open.empty()) {
+			const auto [cost, index] = open.top();
+			open.pop();
+			const Vector2i tile(index % size.x, index / size.x);
+			if (tile == goal) {
+				return cost;
+			}
+			if (cost > costs[static_cast<size_t>(index)]) {
+				continue;
+			}
+			for (const Vector2i& offset : gOffsets) {
+				const Vector2i next = tile + offset;
+				if (!CanStep(pathfinder, tile, next)) {
+					continue;
+				}
+				const float nextCost = cost + StepCost(pathfinder, tile, next);
+				float& current = costs[static_cast<size_t>(next.y * size.x + next.x)];
+				if (nextCost < current) {
+					current = nextCost;
+					open.push({ nextCost, next.y * size.x + next.x });
+				}
+			}
+		}
+		return std::numeric_limits<float>::infinity();
+	}
+
+	// Walks the path and checks it is legal and costs what the result says
+	void ExpectValidPath(const RF::HierarchicalPathfinder& pathfinder, const RF::PathResult& result) {
+		ASSERT_EQ(result.status, RF::PathStatus::Found);
+		ASSERT_FALSE(result.tiles.empty());
+		EXPECT_EQ(result.tiles.front(), result.start);
+		EXPECT_EQ(result.tiles.back(), result.goal);
+		float cost = 0.0f;
+		for (size_t i = 1; i < result.tiles.size(); ++i) {
+			ASSERT_TRUE(CanStep(pathfinder, result.tiles[i - 1], result.tiles[i])) << i;
+			cost += StepCost(pathfinder, result.tiles[i - 1], result.tiles[i]);
+		}
+		EXPECT_NEAR(cost, result.cost, 1e-3f * cost);
+	}
+
+	void RandomCosts(RF::HierarchicalPathfinder& pathfinder, std::mt19937& random) {
+		std::uniform_int_distribution<int> cost(1, 3);
+		std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+		for (int y = 0; y < pathfinder.GetSize().y; ++y) {
+			for (int x = 0; x < pathfinder.GetSize().x; ++x) {
+				pathfinder.SetCost(Vector2i(x, y), chance(random) < 0.2f ? RF::HierarchicalPathfinder::gWall : static_cast<uint8_t>(cost(random)));
+			}
+		}
+	}
+
+	Vector2i RandomTile(const RF::HierarchicalPathfinder& pathfinder, std::mt19937& random) {
+		std::uniform_int_distribution<int> x(0, pathfinder.GetSize().x - 1);
+		std::uniform_int_distribution<int> y(0, pathfinder.GetSize().y - 1);
+		return Vector2i(x(random), y(random));
+	}
+}
+
+namespace RFTests {
+
+	TEST(HierarchicalPathfinderTests, FindsValidNearOptimalPaths) {
+		// Not a multiple of the cluster size, so edge clusters are partial
+		RF::JobSystem jobSystem(2);
+		RF::HierarchicalPathfinder pathfinder(Vector2i(100, 75), {}, &jobSystem);
+		std::mt19937 random(41);
+		RandomCosts(pathfinder, random);
+		EXPECT_EQ(pathfinder.UpdateGraph(), 7u * 5u);
+		EXPECT_GT(pathfinder.GetAbstractNodeCount(), 0u);
+
+		int foundCount = 0;
+		for (int i = 0; i < 200; ++i) {
+			const Vector2i start = RandomTile(pathfinder, random);
+			const Vector2i goal = RandomTile(pathfinder, random);
+			const float optimal = ReferenceCost(pathfinder, start, goal);
+			const RF::PathResult result = pathfinder.FindPath(start, goal);
+			ASSERT_EQ(result.status == RF::PathStatus::Found, optimal != std::numeric_limits<float>::infinity()) << start.x << ", " << start.y << " to " << goal.x << ", " << goal.y;
+			if (result.status == RF::PathStatus::Found) {
+				ExpectValidPath(pathfinder, result);
+				// Paths bend through entrances, but not by much
+				EXPECT_GE(result.cost, optimal - 1e-3f * optimal);
+				EXPECT_LE(result.cost, 1.3f * optimal + 2.0f);
+				++foundCount;
+			}
+		}
+		EXPECT_GT(foundCount, 100);
+
+		const RF::PathResult same = pathfinder.FindPath(Vector2i(0, 0), Vector2i(0, 0));
+		EXPECT_EQ(same.status, IsOpen(pathfinder, Vector2i(0, 0)) ? RF::PathStatus::Found : RF::PathStatus::NotFound);
+	}
+
+	TEST(HierarchicalPathfinderTests, IncrementalUpdatesMatchRebuild) {
+		RF::JobSystem jobSystem(2);
+		RF::HierarchicalPathfinder pathfinder(Vector2i(128, 128), {}, &jobSystem);
+		std::mt19937 random(42);
+		RandomCosts(pathfinder, random);
+		pathfinder.SetCost(Vector2i(2, 2), 1);
+		pathfinder.SetCost(Vector2i(120, 120), 1);
+		const RF::PathResult before = pathfinder.FindPath(Vector2i(2, 2), Vector2i(120, 120));
+		ExpectValidPath(pathfinder, before);
+		EXPECT_TRUE(pathfinder.FindPath(Vector2i(2, 2), Vector2i(120, 120)).isCached);
+
+		// A wall in the middle of the cached path only rebuilds the clusters around it and drops the path
+		const Vector2i blocked = before.tiles[before.tiles.size() / 2];
+		pathfinder.SetCost(blocked, RF::HierarchicalPathfinder::gWall);
+		EXPECT_LE(pathfinder.UpdateGraph(), 5u);
+		const RF::PathResult after = pathfinder.FindPath(Vector2i(2, 2), Vector2i(120, 120));
+		EXPECT_FALSE(after.isCached);
+		ExpectValidPath(pathfinder, after);
+		EXPECT_EQ(std::find(after.tiles.begin(), after.tiles.end(), blocked), after.tiles.end());
+
+		for (int change = 0; change < 40; ++change) {
+			const Vector2i tile = RandomTile(pathfinder, random);
+			pathfinder.SetCost(tile, pathfinder.GetCost(tile) == RF::HierarchicalPathfinder::gWall ? static_cast<uint8_t>(1) : RF::HierarchicalPathfinder::gWall);
+		}
+		pathfinder.UpdateGraph();
+
+		// Built from scratch with the same costs, the graph and so every path is the same
+		RF::HierarchicalPathfinder rebuilt(Vector2i(128, 128));
+		for (int y = 0; y < 128; ++y) {
+			for (int x = 0; x < 128; ++x) {
+				rebuilt.SetCost(Vector2i(x, y), pathfinder.GetCost(Vector2i(x, y)));
+			}
+		}
+		rebuilt.UpdateGraph();
+		EXPECT_EQ(pathfinder.GetAbstractNodeCount(), rebuilt.GetAbstractNodeCount());
+		for (int i = 0; i < 100; ++i) {
+			const Vector2i start = RandomTile(pathfinder, random);
+			const Vector2i goal = RandomTile(pathfinder, random);
+			const RF::PathResult expected = rebuilt.FindPath(start, goal);
+			const RF::PathResult result = pathfinder.FindPath(start, goal);
+			ASSERT_EQ(result.status, expected.status);
+			EXPECT_EQ(result.tiles, expected.tiles);
+			EXPECT_EQ(result.cost, expected.cost);
+		}
+	}
+
+	TEST(HierarchicalPathfinderTests, ProcessesRequestsInOrderWithinBudget) {
+		RF::JobSystem jobSystem(3);
+		RF::PathfinderSettings settings;
+		settings.frameBudgetMs = 0.0;
+		settings.cacheCapacity = 8;
+		RF::HierarchicalPathfinder pathfinder(Vector2i(96, 96), settings, &jobSystem);
+		std::mt19937 random(43);
+		RandomCosts(pathfinder, random);
+
+		std::vector<RF::PathResult> delivered;
+		std::vector<RF::PathRequestId> ids;
+		std::vector<std::pair<Vector2i, Vector2i>> queries;
+		for (int i = 0; i < 30; ++i) {
+			// Every third request repeats the one before it
+			queries.push_back(i % 3 == 2 ? queries.back() : std::make_pair(RandomTile(pathfinder, random), RandomTile(pathfinder, random)));
+			ids.push_back(pathfinder.Request({ queries.back().first, queries.back().second, [&delivered](const RF::PathResult& result) { delivered.push_back(result); } }));
+		}
+		EXPECT_TRUE(pathfinder.Cancel(ids[4]));
+		EXPECT_FALSE(pathfinder.Cancel(ids[4]));
+		EXPECT_EQ(pathfinder.PendingCount(), 29u);
+
+		// No budget at all still serves one search a frame, and every cache hit
+		int frames = 0;
+		while (pathfinder.PendingCount() > 0) {
+			EXPECT_GT(pathfinder.ProcessRequests(), 0u);
+			++frames;
+		}
+		EXPECT_GT(frames, 1);
+		EXPECT_FALSE(pathfinder.Cancel(ids[0]));
+		ASSERT_EQ(delivered.size(), 29u);
+		EXPECT_GT(pathfinder.GetCacheStats().hits, 0u);
+		EXPECT_LE(pathfinder.GetCacheStats().size, 8u);
+
+		size_t next = 0;
+		for (size_t i = 0; i < ids.size(); ++i) {
+			if (i == 4) {
+				continue;
+			}
+			const RF::PathResult& result = delivered[next++];
+			EXPECT_EQ(result.id, ids[i]);
+			EXPECT_EQ(result.start, queries[i].first);
+			EXPECT_EQ(result.goal, queries[i].second);
+			const float optimal = ReferenceCost(pathfinder, result.start, result.goal);
+			EXPECT_EQ(result.status == RF::PathStatus::Found, optimal != std::numeric_limits<float>::infinity());
+			if (result.status == RF::PathStatus::Found) {
+				ExpectValidPath(pathfinder, result);
+			}
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <numeric>
+
+#include "Engine/Jobs/jobSystem.h"
+
+namespace RFTests {
+
+	TEST(JobSystemTests, RunAndWait) {
+		RF::JobSystem jobSystem(2);
+		RF::JobCounter counter;
+		std::atomic<int> sum = 0;
+
+		for (int i = 1; i <= 100; ++i) {
+			jobSystem.Run([&sum, i]() { sum += i; }, &counter);
+		}
+		jobSystem.Wait(counter);
+
+		EXPECT_TRUE(counter.IsDone());
+		EXPECT_EQ(sum.load(), 5050);
+	}
+
+	TEST(JobSystemTests, ParallelForCoversEveryIndexOnce) {
+		RF::JobSystem jobSystem(3);
+		std::vector<int> hits(1000, 0);
+
+		jobSystem.ParallelFor(hits.size(), 64, [&hits](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				++hits[i];
+			}
+		});
+
+		EXPECT_EQ(std::accumulate(hits.begin(), hits.end(), 0), 1000);
+		for (const int hit : hits) {
+			EXPECT_EQ(hit, 1);
+		}
+	}
+
+	TEST(JobSystemTests, ThreadIndex) {
+		RF::JobSystem jobSystem(2);
+		RF::JobCounter counter;
+		std::atomic<unsigned int> workerIndex = 0;
+
+		EXPECT_EQ(RF::JobSystem::CurrentThreadIndex(), 0u);
+		jobSystem.Run([&workerIndex]() { workerIndex = RF::JobSystem::CurrentThreadIndex(); }, &counter);
+		jobSystem.Wait(counter);
+
+		// The waiting thread may have picked the job up itself
+		EXPECT_LE(workerIndex.load(), jobSystem.WorkerCount());
+	}
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Engine/Collision/narrowphase.h"
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Spatial/spatialHashGrid.h"
+
+namespace {
+	struct Circles {
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> radii;
+
+		RF::CircleSet Set() const { return { xs, ys, radii }; }
+	};
+
+	struct Capsules {
+		std::vector<float> startXs;
+		std::vector<float> startYs;
+		std::vector<float> endXs;
+		std::vector<float> endYs;
+		std::vector<float> radii;
+
+		RF::CapsuleSet Set() const { return { startXs, startYs, endXs, endYs, radii }; }
+	};
+
+	struct ReferenceContact {
+		Vector2 normal;
+		float depth = 0.0f;
+		bool hit = false;
+	};
+
+	// One pair at a time on Vector2, what the batched paths have to match
+	ReferenceContact ReferenceCircles(const Vector2& a, const float radiusA, const Vector2& b, const float radiusB) {
+		const Vector2 offset = b - a;
+		const float distance = offset.Length();
+		ReferenceContact contact;
+		contact.normal = distance > 1e-6f ? offset / distance : Vector2::UnitX;
+		contact.depth = radiusA + radiusB - distance;
+		contact.hit = contact.depth > 0.0f;
+		return contact;
+	}
+
+	ReferenceContact ReferenceCapsule(const Vector2& start, const Vector2& end, const float radiusA, const Vector2& center, const float radiusB) {
+		const Vector2 segment = end - start;
+		const float lengthSquared = segment.LengthSquared();
+		const float t = lengthSquared > 0.0f ? std::clamp((center - start).Dot(segment) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+		return ReferenceCircles(start + segment * t, radiusA, center, radiusB);
+	}
+
+	Circles RandomCircles(const size_t count, std::mt19937& random) {
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+		Circles circles;
+		for (size_t i = 0; i < count; ++i) {
+			circles.xs.push_back(position(random));
+			circles.ys.push_back(position(random));
+			circles.radii.push_back(radius(random));
+		}
+		return circles;
+	}
+
+	std::vector<RF::CollisionPair> RandomPairs(const size_t count, const uint32_t aCount, const uint32_t bCount, std::mt19937& random) {
+		std::uniform_int_distribution<uint32_t> a(0, aCount - 1);
+		std::uniform_int_distribution<uint32_t> b(0, bCount - 1);
+		std::vector<RF::CollisionPair> pairs;
+		for (size_t i = 0; i < count; ++i) {
+			pairs.push_back({ a(random), b(random) });
+		}
+		return pairs;
+	}
+
+	void ExpectMatches(const RF::ContactBatch& contacts, const size_t pair, const ReferenceContact& expected) {
+		EXPECT_NEAR(contacts.NormalXs()[pair], expected.normal.x, 1e-5f) << "pair " << pair;
+		EXPECT_NEAR(contacts.NormalYs()[pair], expected.normal.y, 1e-5f) << "pair " << pair;
+		EXPECT_NEAR(contacts.Depths()[pair], expected.depth, 1e-4f) << "pair " << pair;
+		EXPECT_EQ(contacts.IsHit(pair), expected.hit) << "pair " << pair;
+	}
+}
+
+namespace RFTests {
+
+	TEST(NarrowphaseTests, CirclesMatchScalarReference) {
+		std::mt19937 random(11);
+		Circles circles = RandomCircles(500, random);
+		// Two circles on the same spot have no direction between them
+		circles.xs[1] = circles.xs[0];
+		circles.ys[1] = circles.ys[0];
+		std::vector<RF::CollisionPair> pairs = RandomPairs(3001, 500, 500, random);
+		pairs[0] = { 0, 1 };
+		pairs[1] = { 2, 2 };
+
+		RF::JobSystem jobSystem(2);
+		for (const bool avx2 : { true, false }) {
+			RF::Narrowphase narrowphase(&jobSystem);
+			narrowphase.SetAvx2Enabled(avx2);
+			RF::ContactBatch contacts;
+			narrowphase.CirclesVsCircles(pairs, circles.Set(), contacts);
+			ASSERT_EQ(contacts.Count(), pairs.size());
+			EXPECT_EQ(contacts.HitMasks().size(), (pairs.size() + 7) / 8);
+
+			size_t hits = 0;
+			for (size_t i = 0; i < pairs.size(); ++i) {
+				const RF::CollisionPair& pair = pairs[i];
+				const ReferenceContact expected = ReferenceCircles(Vector2(circles.xs[pair.a], circles.ys[pair.a]), circles.radii[pair.a], Vector2(circles.xs[pair.b], circles.ys[pair.b]), circles.radii[pair.b]);
+				ExpectMatches(contacts, i, expected);
+				hits += static_cast<size_t>(expected.hit);
+			}
+			EXPECT_EQ(contacts.NormalXs()[0], 1.0f);
+
+			size_t visited = 0;
+			contacts.ForEachHit([&contacts, &visited](const size_t pair) {
+				EXPECT_TRUE(contacts.IsHit(pair));
+				++visited;
+			});
+			EXPECT_EQ(visited, hits);
+		}
+	}
+
+	TEST(NarrowphaseTests, CapsulesMatchScalarReference) {
+		std::mt19937 random(12);
+		const Circles circles = RandomCircles(400, random);
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+		Capsules capsules;
+		for (size_t i = 0; i < 100; ++i) {
+			capsules.startXs.push_back(position(random));
+			capsules.startYs.push_back(position(random));
+			capsules.endXs.push_back(capsules.startXs.back() + offset(random));
+			capsules.endYs.push_back(capsules.startYs.back() + offset(random));
+			capsules.radii.push_back(1.0f);
+		}
+		// A capsule without length is a circle
+		capsules.endXs[0] = capsules.startXs[0];
+		capsules.endYs[0] = capsules.startYs[0];
+		const std::vector<RF::CollisionPair> pairs = RandomPairs(2000, 100, 400, random);
+
+		RF::JobSystem jobSystem(2);
+		for (const bool avx2 : { true, false }) {
+			RF::Narrowphase narrowphase(&jobSystem);
+			narrowphase.SetAvx2Enabled(avx2);
+			RF::ContactBatch contacts;
+			narrowphase.CapsulesVsCircles(pairs, capsules.Set(), circles.Set(), contacts);
+			ASSERT_EQ(contacts.Count(), pairs.size());
+			for (size_t i = 0; i < pairs.size(); ++i) {
+				const RF::CollisionPair& pair = pairs[i];
+				const ReferenceContact expected = ReferenceCapsule(Vector2(capsules.startXs[pair.a], capsules.startYs[pair.a]), Vector2(capsules.endXs[pair.a], capsules.endYs[pair.a]),
+					capsules.radii[pair.a], Vector2(circles.xs[pair.b], circles.ys[pair.b]), circles.radii[pair.b]);
+				ExpectMatches(contacts, i, expected);
+			}
+		}
+
+		// A circle beside the middle of a horizontal capsule is pushed straight up
+		const Capsules wall = { { 0.0f }, { 0.0f }, { 10.0f }, { 0.0f }, { 1.0f } };
+		const Circles ball = { { 4.0f }, { 1.5f }, { 1.0f } };
+		RF::Narrowphase narrowphase;
+		RF::ContactBatch contacts;
+		const std::vector<RF::CollisionPair> single = { { 0, 0 } };
+		narrowphase.CapsulesVsCircles(single, wall.Set(), ball.Set(), contacts);
+		EXPECT_TRUE(contacts.IsHit(0));
+		EXPECT_FLOAT_EQ(contacts.NormalYs()[0], 1.0f);
+		EXPECT_FLOAT_EQ(contacts.Depths()[0], 0.5f);
+	}
+
+	TEST(NarrowphaseTests, ResolvesBroadphasePairs) {
+		std::mt19937 random(13);
+		const Circles circles = RandomCircles(2000, random);
+		RF::SpatialHashGrid grid(8.0f);
+		grid.Build(circles.xs, circles.ys);
+		std::vector<Vector2> centers;
+		for (size_t i = 0; i < circles.xs.size(); ++i) {
+			centers.push_back(Vector2(circles.xs[i], circles.ys[i]));
+		}
+		// The largest radius sum is 8
+		RF::SpatialQueryBatch candidates;
+		grid.QueryRadius(centers, 8.0f, candidates);
+
+		std::vector<RF::CollisionPair> pairs;
+		RF::Narrowphase::AppendPairs(candidates, true, pairs);
+		RF::Narrowphase narrowphase;
+		RF::ContactBatch contacts;
+		narrowphase.CirclesVsCircles(pairs, circles.Set(), contacts);
+		size_t hits = 0;
+		contacts.ForEachHit([&hits](const size_t) { ++hits; });
+
+		size_t expected = 0;
+		for (size_t a = 0; a < circles.xs.size(); ++a) {
+			for (size_t b = a + 1; b < circles.xs.size(); ++b) {
+				const ReferenceContact contact = ReferenceCircles(centers[a], circles.radii[a], centers[b], circles.radii[b]);
+				expected += static_cast<size_t>(contact.hit);
+			}
+		}
+		EXPECT_GT(expected, 0u);
+		EXPECT_EQ(hits, expected);
+	}
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Particles/particleSystem.h"
+
+namespace {
+	std::vector<RF::ParticleInstance> Instances(RF::ParticleSystem& particles, const Vector3& cameraPosition, const Vector3& cameraForward) {
+		std::vector<RF::ParticleInstance> instances(particles.Count());
+		instances.resize(particles.WriteInstances(cameraPosition, cameraForward, instances));
+		return instances;
+	}
+
+	bool Equal(std::span<const RF::ParticleInstance> a, std::span<const RF::ParticleInstance> b) {
+		return std::ranges::equal(a, b, [](const RF::ParticleInstance& lhs, const RF::ParticleInstance& rhs) {
+			return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.size == rhs.size && lhs.color == rhs.color;
+		});
+	}
+}
+
+namespace RFTests {
+
+	TEST(ParticleSystemTests, SimulatesForcesAndCurves) {
+		RF::EmitterSettings settings;
+		settings.spawnRate = 0.0f;
+		settings.lifetime = 10.0f;
+		settings.velocity = Vector3(1.0f, 2.0f, 3.0f);
+		settings.acceleration = Vector3(0.0f, -10.0f, 0.0f);
+		settings.drag = 0.5f;
+		settings.sizes = { { 0.0f, 1.0f }, { 1.0f, 3.0f } };
+		settings.colors = { { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f } };
+
+		RF::ParticleSystem scalar;
+		RF::ParticleSystem vectorized;
+		scalar.SetAvx2Enabled(false);
+		// Not a multiple of eight, so the AVX2 path has a scalar tail
+		scalar.Burst(scalar.AddEmitter(settings, Vector3(5.0f, 0.0f, 0.0f)), 13);
+		vectorized.Burst(vectorized.AddEmitter(settings, Vector3(5.0f, 0.0f, 0.0f)), 13);
+		// The first update only spawns them
+		for (int update = 0; update < 5; ++update) {
+			scalar.Update(0.25f);
+			vectorized.Update(0.25f);
+		}
+
+		Vector3 position(5.0f, 0.0f, 0.0f);
+		Vector3 velocity = settings.velocity;
+		const float dragFactor = 1.0f / (1.0f + 0.5f * 0.25f);
+		for (int update = 0; update < 4; ++update) {
+			velocity.x = velocity.x * dragFactor;
+			velocity.y = velocity.y * dragFactor - 10.0f * 0.25f;
+			velocity.z = velocity.z * dragFactor;
+			position.x += velocity.x * 0.25f;
+			position.y += velocity.y * 0.25f;
+			position.z += velocity.z * 0.25f;
+		}
+
+		const std::vector<RF::ParticleInstance> scalarInstances = Instances(scalar, Vector3(0.0f, 0.0f, -10.0f), Vector3::UnitZ);
+		const std::vector<RF::ParticleInstance> vectorizedInstances = Instances(vectorized, Vector3(0.0f, 0.0f, -10.0f), Vector3::UnitZ);
+		ASSERT_EQ(scalarInstances.size(), 13u);
+		EXPECT_TRUE(Equal(scalarInstances, vectorizedInstances));
+		for (const RF::ParticleInstance& instance : scalarInstances) {
+			EXPECT_NEAR(instance.x, position.x, 1e-5f);
+			EXPECT_NEAR(instance.y, position.y, 1e-5f);
+			EXPECT_NEAR(instance.z, position.z, 1e-5f);
+			// A tenth of the way through life, the curves are sampled at the start of that table entry
+			EXPECT_NEAR(instance.size, 1.0f + 2.0f * 6.0f / 63.0f, 1e-5f);
+			EXPECT_EQ(instance.color & 0xFFu, 231u);
+			EXPECT_EQ(instance.color >> 24, 231u);
+		}
+	}
+
+	TEST(ParticleSystemTests, ExpiredParticlesAreRemoved) {
+		RF::EmitterSettings settings;
+		settings.spawnRate = 80.0f;
+		settings.lifetime = 0.5f;
+		settings.velocitySpread = Vector3(1.0f, 1.0f, 1.0f);
+		RF::ParticleSystem particles;
+		const RF::ParticleEmitterId steady = particles.AddEmitter(settings, Vector3::Zero);
+		settings.maxParticles = 25;
+		const RF::ParticleEmitterId capped = particles.AddEmitter(settings, Vector3::Zero);
+
+		// 10 particles an update, each dies in the fourth update after the one that spawned it
+		for (int update = 0; update < 10; ++update) {
+			particles.Update(0.125f);
+		}
+		EXPECT_EQ(particles.Count(steady), 40u);
+		EXPECT_EQ(particles.Count(capped), 25u);
+		EXPECT_EQ(Instances(particles, Vector3::Zero, Vector3::UnitX).size(), 65u);
+
+		particles.SetEmitting(steady, false);
+		particles.Burst(capped, 100);
+		particles.Update(0.125f);
+		EXPECT_EQ(particles.Count(steady), 30u);
+		EXPECT_EQ(particles.Count(capped), 25u);
+		particles.SetEmitting(capped, false);
+		for (int update = 0; update < 3; ++update) {
+			particles.Update(0.125f);
+		}
+		EXPECT_EQ(particles.Count(steady), 0u);
+		EXPECT_GT(particles.Count(capped), 0u);
+		particles.Update(0.125f);
+		EXPECT_EQ(particles.Count(), 0u);
+	}
+
+	TEST(ParticleSystemTests, InstancesAreSortedBackToFront) {
+		RF::EmitterSettings settings;
+		settings.spawnRate = 1000.0f;
+		settings.lifetime = 5.0f;
+		settings.spawnExtent = Vector3(20.0f, 20.0f, 20.0f);
+		settings.velocitySpread = Vector3(3.0f, 3.0f, 3.0f);
+		RF::ParticleSystem particles;
+		particles.AddEmitter(settings, Vector3(0.0f, 0.0f, 0.0f));
+		settings.seed = 2;
+		particles.AddEmitter(settings, Vector3(10.0f, -30.0f, 5.0f));
+		for (int update = 0; update < 3; ++update) {
+			particles.Update(0.1f);
+		}
+
+		const Vector3 cameraPosition(3.0f, 2.0f, -50.0f);
+		const Vector3 cameraForward(0.6f, 0.0f, 0.8f);
+		const std::vector<RF::ParticleInstance> instances = Instances(particles, cameraPosition, cameraForward);
+		ASSERT_EQ(instances.size(), 600u);
+		auto depth = [&cameraPosition, &cameraForward](const RF::ParticleInstance& instance) {
+			return (instance.x - cameraPosition.x) * cameraForward.x + (instance.y - cameraPosition.y) * cameraForward.y + (instance.z - cameraPosition.z) * cameraForward.z;
+		};
+		for (size_t i = 1; i < instances.size(); ++i) {
+			EXPECT_GE(depth(instances[i - 1]), depth(instances[i]));
+		}
+
+		// A smaller buffer gets the farthest particles
+		std::vector<RF::ParticleInstance> farthest(100);
+		EXPECT_EQ(particles.WriteInstances(cameraPosition, cameraForward, farthest), 100u);
+		EXPECT_TRUE(Equal(farthest, std::span(instances).first(100)));
+	}
+
+	TEST(ParticleSystemTests, ParallelMatchesSerial) {
+		RF::JobSystem jobSystem(3);
+		RF::ParticleSystem serial;
+		RF::ParticleSystem parallel(&jobSystem);
+
+		RF::EmitterSettings settings;
+		settings.maxParticles = 20000;
+		settings.lifetime = 0.4f;
+		settings.lifetimeVariance = 0.5f;
+		settings.spawnExtent = Vector3(5.0f, 5.0f, 5.0f);
+		settings.velocitySpread = Vector3(4.0f, 4.0f, 4.0f);
+		settings.acceleration = Vector3(0.0f, -9.8f, 0.0f);
+		settings.drag = 0.3f;
+		settings.sizes = { { 0.0f, 0.2f }, { 0.3f, 1.0f }, { 1.0f, 0.0f } };
+		for (uint32_t i = 0; i < 6; ++i) {
+			// One emitter big enough to be split into several jobs, and small ones
+			settings.seed = i + 1;
+			settings.spawnRate = i == 0 ? 60000.0f : 300.0f;
+			const Vector3 position(static_cast<float>(i) * 7.0f, 0.0f, static_cast<float>(i % 2) * 4.0f);
+			serial.AddEmitter(settings, position);
+			parallel.AddEmitter(settings, position);
+		}
+
+		for (int update = 0; update < 20; ++update) {
+			if (update % 5 == 0) {
+				serial.Burst(3, 2000);
+				parallel.Burst(3, 2000);
+			}
+			serial.Update(1.0f / 60.0f);
+			parallel.Update(1.0f / 60.0f);
+			ASSERT_EQ(serial.Count(), parallel.Count());
+		}
+		EXPECT_GT(serial.Count(0), 2 * RF::ParticleSystem::gParticlesPerJob);
+
+		const std::vector<RF::ParticleInstance> serialInstances = Instances(serial, Vector3(-20.0f, 10.0f, -20.0f), Vector3(0.6f, 0.0f, 0.8f));
+		const std::vector<RF::ParticleInstance> parallelInstances = Instances(parallel, Vector3(-20.0f, 10.0f, -20.0f), Vector3(0.6f, 0.0f, 0.8f));
+		EXPECT_TRUE(Equal(serialInstances, parallelInstances));
+	}
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Projectiles/projectileSystem.h"
+
+namespace RFTests {
+
+	TEST(ProjectileSystemTests, IntegratesAndExpires) {
+		RF::ProjectileSystem scalar;
+		RF::ProjectileSystem vectorized;
+		scalar.SetAvx2Enabled(false);
+		const RF::ProjectileTypeId scalarType = scalar.AddType({ 0.1f, 0.45f, 0 });
+		const RF::ProjectileTypeId vectorizedType = vectorized.AddType({ 0.1f, 0.45f, 0 });
+		// Not a multiple of eight, so the AVX2 path has a scalar tail
+		for (int i = 0; i < 13; ++i) {
+			const Vector2 velocity(static_cast<float>(i), -2.0f * static_cast<float>(i));
+			scalar.Spawn(scalarType, Vector2(1.0f, 2.0f), velocity, static_cast<uint32_t>(i));
+			vectorized.Spawn(vectorizedType, Vector2(1.0f, 2.0f), velocity, static_cast<uint32_t>(i));
+		}
+
+		for (int tick = 0; tick < 4; ++tick) {
+			scalar.Tick(0.1f);
+			vectorized.Tick(0.1f);
+		}
+		ASSERT_EQ(scalar.Count(), 13u);
+		ASSERT_EQ(vectorized.Count(scalarType), 13u);
+		EXPECT_EQ(std::vector<float>(scalar.Xs(scalarType).begin(), scalar.Xs(scalarType).end()), std::vector<float>(vectorized.Xs(vectorizedType).begin(), vectorized.Xs(vectorizedType).end()));
+		EXPECT_EQ(std::vector<float>(scalar.Ys(scalarType).begin(), scalar.Ys(scalarType).end()), std::vector<float>(vectorized.Ys(vectorizedType).begin(), vectorized.Ys(vectorizedType).end()));
+		EXPECT_NEAR(scalar.Xs(scalarType)[12], 1.0f + 12.0f * 0.4f, 1e-4f);
+		EXPECT_NEAR(scalar.Ys(scalarType)[12], 2.0f - 24.0f * 0.4f, 1e-4f);
+
+		scalar.Tick(0.1f);
+		vectorized.Tick(0.1f);
+		EXPECT_EQ(scalar.Count(), 0u);
+		EXPECT_EQ(vectorized.Count(), 0u);
+		EXPECT_TRUE(scalar.GetHits().empty());
+	}
+
+	TEST(ProjectileSystemTests, FastProjectilesDontTunnel) {
+		RF::ProjectileSystem projectiles;
+		const RF::ProjectileTypeId bullet = projectiles.AddType({ 0.1f, 2.0f, 0 });
+		const RF::ProjectileTypeId lance = projectiles.AddType({ 0.1f, 2.0f, 2 });
+		const std::vector<float> xs = { 10.0f, 20.0f, 21.5f, 23.0f, 24.5f };
+		const std::vector<float> ys = { 0.0f, 10.0f, 10.0f, 10.0f, 10.0f };
+		const std::vector<float> radii = { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
+		projectiles.SetTargets(xs, ys, radii);
+
+		// 1000 units a second moves about 17 units a tick, right over the target
+		projectiles.Spawn(bullet, Vector2(0.0f, 0.0f), Vector2(1000.0f, 0.0f), 7);
+		projectiles.Spawn(bullet, Vector2(0.0f, 5.0f), Vector2(1000.0f, 0.0f), 8);
+		projectiles.Spawn(bullet, Vector2(11.0f, 0.0f), Vector2(1000.0f, 0.0f), 9);
+		// Through four targets in a row, stopping at the third
+		projectiles.Spawn(lance, Vector2(15.0f, 10.0f), Vector2(1000.0f, 0.0f), 10);
+		projectiles.Tick(1.0f / 60.0f);
+
+		const std::span<const RF::ProjectileHit> hits = projectiles.GetHits();
+		ASSERT_EQ(hits.size(), 4u);
+		EXPECT_EQ(hits[0].target, 0u);
+		EXPECT_EQ(hits[0].owner, 7u);
+		EXPECT_EQ(hits[0].type, bullet);
+		EXPECT_NEAR(hits[0].x, 9.4f, 1e-3f);
+		EXPECT_NEAR(hits[0].y, 0.0f, 1e-3f);
+		for (uint32_t i = 0; i < 3; ++i) {
+			EXPECT_EQ(hits[1 + i].target, 1u + i);
+			EXPECT_EQ(hits[1 + i].owner, 10u);
+			EXPECT_EQ(hits[1 + i].type, lance);
+		}
+		EXPECT_EQ(projectiles.Count(bullet), 2u);
+		EXPECT_EQ(projectiles.Count(lance), 0u);
+	}
+
+	TEST(ProjectileSystemTests, PiercingHitsTargetsOnce) {
+		RF::ProjectileSystem projectiles;
+		const RF::ProjectileTypeId orb = projectiles.AddType({ 0.5f, 10.0f, 100 });
+		const std::vector<float> xs = { 0.0f };
+		const std::vector<float> ys = { 0.0f };
+		const std::vector<float> radii = { 5.0f };
+		projectiles.SetTargets(xs, ys, radii);
+
+		// Slow enough to stay inside the target for many ticks
+		projectiles.Spawn(orb, Vector2(-1.0f, 0.0f), Vector2(1.0f, 0.0f));
+		projectiles.Tick(0.1f);
+		EXPECT_EQ(projectiles.GetHits().size(), 1u);
+		for (int tick = 0; tick < 10; ++tick) {
+			projectiles.Tick(0.1f);
+			EXPECT_TRUE(projectiles.GetHits().empty());
+		}
+		EXPECT_EQ(projectiles.Count(), 1u);
+	}
+
+	TEST(ProjectileSystemTests, OverlappingTargetsAreHitOnceEach) {
+		RF::ProjectileSystem projectiles;
+		const RF::ProjectileTypeId lance = projectiles.AddType({ 0.1f, 10.0f, 10 });
+		const std::vector<float> xs = { 1.0f, 1.3f };
+		const std::vector<float> ys = { 0.0f, 0.0f };
+		const std::vector<float> radii = { 0.5f, 0.5f };
+		projectiles.SetTargets(xs, ys, radii);
+
+		// Inside both targets for several ticks, it used to alternate between them and spend every pierce
+		projectiles.Spawn(lance, Vector2(0.0f, 0.0f), Vector2(6.0f, 0.0f));
+		std::vector<uint32_t> hitTargets;
+		for (int tick = 0; tick < 60; ++tick) {
+			projectiles.Tick(1.0f / 60.0f);
+			for (const RF::ProjectileHit& hit : projectiles.GetHits()) {
+				hitTargets.push_back(hit.target);
+			}
+		}
+		EXPECT_EQ(hitTargets, std::vector<uint32_t>({ 0, 1 }));
+		EXPECT_EQ(projectiles.Count(lance), 1u);
+
+		// Spawned inside a target counts as a hit on the first tick only
+		RF::ProjectileSystem melee;
+		const RF::ProjectileTypeId swing = melee.AddType({ 0.5f, 1.0f, 10 });
+		melee.SetTargets(xs, ys, radii);
+		melee.Spawn(swing, Vector2(1.1f, 0.0f), Vector2(0.0f, 0.0f));
+		melee.Tick(1.0f / 60.0f);
+		EXPECT_EQ(melee.GetHits().size(), 2u);
+		melee.Tick(1.0f / 60.0f);
+		EXPECT_TRUE(melee.GetHits().empty());
+	}
+
+	TEST(ProjectileSystemTests, ParallelMatchesSerial) {
+		RF::JobSystem jobSystem(3);
+		RF::ProjectileSystem serial;
+		RF::ProjectileSystem parallel(2.0f, &jobSystem);
+		const RF::ProjectileType types[3] = { { 0.1f, 1.0f, 0 }, { 0.3f, 2.0f, 1 }, { 0.05f, 0.5f, 4 } };
+		for (const RF::ProjectileType& type : types) {
+			serial.AddType(type);
+			parallel.AddType(type);
+		}
+
+		std::mt19937 random(51);
+		std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> speed(-80.0f, 80.0f);
+		std::uniform_int_distribution<int> type(0, 2);
+		std::vector<float> xs;
+		std::vector<float> ys;
+		std::vector<float> radii;
+		for (int i = 0; i < 500; ++i) {
+			xs.push_back(coordinate(random));
+			ys.push_back(coordinate(random));
+			radii.push_back(0.5f + 0.001f * static_cast<float>(i));
+		}
+		serial.SetTargets(xs, ys, radii);
+		parallel.SetTargets(xs, ys, radii);
+
+		size_t hitCount = 0;
+		for (int tick = 0; tick < 20; ++tick) {
+			for (int i = 0; i < 2500; ++i) {
+				const RF::ProjectileTypeId spawned = static_cast<RF::ProjectileTypeId>(type(random));
+				const Vector2 position(coordinate(random), coordinate(random));
+				const Vector2 velocity(speed(random), speed(random));
+				serial.Spawn(spawned, position, velocity, static_cast<uint32_t>(i));
+				parallel.Spawn(spawned, position, velocity, static_cast<uint32_t>(i));
+			}
+			serial.Tick(1.0f / 60.0f);
+			parallel.Tick(1.0f / 60.0f);
+
+			const std::span<const RF::ProjectileHit> serialHits = serial.GetHits();
+			const std::span<const RF::ProjectileHit> parallelHits = parallel.GetHits();
+			ASSERT_EQ(serialHits.size(), parallelHits.size());
+			for (size_t i = 0; i < serialHits.size(); ++i) {
+				EXPECT_EQ(serialHits[i].target, parallelHits[i].target);
+				EXPECT_EQ(serialHits[i].owner, parallelHits[i].owner);
+				EXPECT_EQ(serialHits[i].x, parallelHits[i].x);
+			}
+			hitCount += serialHits.size();
+			for (RF::ProjectileTypeId i = 0; i < 3; ++i) {
+				EXPECT_EQ(serial.Count(i), parallel.Count(i));
+			}
+		}
+		EXPECT_GT(hitCount, 0u);
+		EXPECT_GT(serial.Count(), 4096u);
+	}
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Spatial/spatialHashGrid.h"
+
+namespace {
+	struct Points {
+		std::vector<float> xs;
+		std::vector<float> ys;
+	};
+
+	// Spread around the origin so cells have negative coordinates too
+	Points RandomPoints(const size_t count, const float extent) {
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> coordinate(-extent, extent);
+		Points points;
+		for (size_t i = 0; i < count; ++i) {
+			points.xs.push_back(coordinate(random));
+			points.ys.push_back(coordinate(random));
+		}
+		return points;
+	}
+
+	std::vector<uint32_t> Sorted(std::vector<uint32_t> ids) {
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+
+	std::vector<uint32_t> BruteForceRadius(const Points& points, const Vector2& center, const float radius) {
+		std::vector<uint32_t> ids;
+		for (size_t i = 0; i < points.xs.size(); ++i) {
+			const float dx = points.xs[i] - center.x;
+			const float dy = points.ys[i] - center.y;
+			if (dx * dx + dy * dy <= radius * radius) {
+				ids.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		return ids;
+	}
+}
+
+namespace RFTests {
+
+	TEST(SpatialHashGridTests, QueriesMatchBruteForce) {
+		const Points points = RandomPoints(5000, 200.0f);
+		RF::SpatialHashGrid grid(8.0f);
+		grid.Build(points.xs, points.ys);
+		ASSERT_EQ(grid.Count(), 5000u);
+
+		for (const Vector2& center : { Vector2(0.0f, 0.0f), Vector2(-150.5f, 33.0f), Vector2(199.0f, -199.0f) }) {
+			for (const float radius : { 3.0f, 8.0f, 40.0f }) {
+				std::vector<uint32_t> found;
+				grid.QueryRadius(center, radius, found);
+				EXPECT_EQ(Sorted(found), BruteForceRadius(points, center, radius));
+			}
+		}
+
+		const Vector2 min(-20.0f, -5.0f);
+		const Vector2 max(35.0f, 12.5f);
+		std::vector<uint32_t> expected;
+		for (size_t i = 0; i < points.xs.size(); ++i) {
+			if (points.xs[i] >= min.x && points.xs[i] <= max.x && points.ys[i] >= min.y && points.ys[i] <= max.y) {
+				expected.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		std::vector<uint32_t> found;
+		grid.QueryAabb(min, max, found);
+		EXPECT_EQ(Sorted(found), expected);
+
+		// A box larger than the bucket table walks every bucket once
+		found.clear();
+		grid.QueryAabb(Vector2(-1000.0f, -1000.0f), Vector2(1000.0f, 1000.0f), found);
+		EXPECT_EQ(found.size(), 5000u);
+
+		// A bigger table only changes which far away points share buckets
+		RF::SpatialHashGrid sparse(8.0f, nullptr, 60000);
+		sparse.Build(points.xs, points.ys);
+		EXPECT_EQ(sparse.BucketCount(), 65536u);
+		found.clear();
+		sparse.QueryRadius(Vector2(-150.5f, 33.0f), 40.0f, found);
+		EXPECT_EQ(Sorted(found), BruteForceRadius(points, Vector2(-150.5f, 33.0f), 40.0f));
+	}
+
+	TEST(SpatialHashGridTests, NearestAreSortedByDistance) {
+		const Points points = RandomPoints(3000, 100.0f);
+		RF::SpatialHashGrid grid(4.0f);
+		grid.Build(points.xs, points.ys);
+
+		const Vector2 center(12.0f, -7.0f);
+		std::vector<uint32_t> nearest;
+		grid.QueryNearest(center, 10, 500.0f, nearest);
+		ASSERT_EQ(nearest.size(), 10u);
+
+		std::vector<uint32_t> all(points.xs.size());
+		for (uint32_t i = 0; i < all.size(); ++i) {
+			all[i] = i;
+		}
+		auto distance = [&points, &center](const uint32_t id) {
+			return (points.xs[id] - center.x) * (points.xs[id] - center.x) + (points.ys[id] - center.y) * (points.ys[id] - center.y);
+		};
+		std::sort(all.begin(), all.end(), [&distance](const uint32_t lhs, const uint32_t rhs) { return distance(lhs) < distance(rhs); });
+		EXPECT_EQ(nearest, std::vector<uint32_t>(all.begin(), all.begin() + 10));
+
+		// The radius caps the search
+		nearest.clear();
+		grid.QueryNearest(center, 10, 0.5f, nearest);
+		for (const uint32_t id : nearest) {
+			EXPECT_LE(distance(id), 0.25f);
+		}
+
+		// Unbounded, and from a center that has no cell
+		nearest.clear();
+		grid.QueryNearest(center, 5, std::numeric_limits<float>::infinity(), nearest);
+		EXPECT_EQ(nearest, std::vector<uint32_t>(all.begin(), all.begin() + 5));
+		nearest.clear();
+		grid.QueryNearest(Vector2(1e30f, 0.0f), 1, std::numeric_limits<float>::infinity(), nearest);
+		EXPECT_EQ(nearest.size(), 1u);
+		std::vector<uint32_t> found;
+		grid.QueryRadius(center, std::numeric_limits<float>::infinity(), found);
+		EXPECT_EQ(found.size(), points.xs.size());
+	}
+
+	TEST(SpatialHashGridTests, ParallelBuildAndBatchesMatchSerial) {
+		const Points points = RandomPoints(60000, 1000.0f);
+		std::vector<uint32_t> ids(points.xs.size());
+		for (size_t i = 0; i < ids.size(); ++i) {
+			ids[i] = static_cast<uint32_t>(i * 3 + 1);
+		}
+
+		RF::JobSystem jobSystem(3);
+		RF::SpatialHashGrid serial(10.0f);
+		RF::SpatialHashGrid parallel(10.0f, &jobSystem);
+		serial.Build(points.xs, points.ys, ids);
+		parallel.Build(points.xs, points.ys, ids);
+
+		std::vector<Vector2> centers;
+		for (size_t i = 0; i < 2000; ++i) {
+			centers.push_back(Vector2(points.xs[i * 7], points.ys[i * 7]));
+		}
+
+		RF::SpatialQueryBatch serialResults;
+		RF::SpatialQueryBatch parallelResults;
+		serial.QueryRadius(centers, 10.0f, serialResults);
+		parallel.QueryRadius(centers, 10.0f, parallelResults);
+		ASSERT_EQ(parallelResults.QueryCount(), centers.size());
+		// Same order, not just the same sets
+		EXPECT_TRUE(std::ranges::equal(serialResults.Ids(), parallelResults.Ids()));
+
+		for (size_t i = 0; i < centers.size(); i += 97) {
+			std::vector<uint32_t> single;
+			serial.QueryRadius(centers[i], 10.0f, single);
+			EXPECT_TRUE(std::ranges::equal(parallelResults.Results(i), single));
+			EXPECT_NE(std::ranges::find(single, ids[i * 7]), single.end());
+		}
+
+		parallel.QueryNearest(centers, 4, 50.0f, parallelResults);
+		for (size_t i = 0; i < centers.size(); ++i) {
+			ASSERT_EQ(parallelResults.Results(i).size(), 4u);
+			EXPECT_EQ(parallelResults.Results(i)[0], ids[i * 7]);
+		}
+	}
+
+	TEST(SpatialHashGridTests, EmptyGrid) {
+		RF::SpatialHashGrid grid(1.0f);
+		grid.Build({}, {});
+		std::vector<uint32_t> found;
+		grid.QueryRadius(Vector2(0.0f, 0.0f), 5.0f, found);
+		grid.QueryNearest(Vector2(0.0f, 0.0f), 3, 5.0f, found);
+		EXPECT_TRUE(found.empty());
+
+		RF::SpatialQueryBatch results;
+		grid.QueryRadius(std::span<const Vector2>(), 1.0f, results);
+		EXPECT_EQ(results.QueryCount(), 0u);
+	}
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <mutex>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Startup/subsystemRegistry.h"
+
+namespace RFTests {
+
+	TEST(SubsystemRegistryTests, DependenciesFinishFirst) {
+		RF::JobSystem jobSystem(3);
+		RF::SubsystemRegistry registry;
+		std::mutex orderMutex;
+		std::vector<std::string> order;
+
+		auto record = [&order, &orderMutex](const std::string& name) {
+			return [&order, &orderMutex, name]() {
+				std::lock_guard lock(orderMutex);
+				order.push_back(name);
+			};
+		};
+
+		registry.Register({ .name = "Renderer", .dependencies = { "Window" }, .init = record("Renderer") });
+		registry.Register({ .name = "Config", .init = record("Config") });
+		registry.Register({ .name = "Window", .dependencies = { "Config" }, .init = record("Window"), .mainThreadOnly = true });
+		registry.Register({ .name = "Audio", .dependencies = { "Config" }, .init = record("Audio") });
+
+		ASSERT_TRUE(registry.InitializeAll(jobSystem));
+		ASSERT_EQ(order.size(), 4u);
+
+		auto position = [&order](const std::string& name) {
+			return std::find(order.begin(), order.end(), name) - order.begin();
+		};
+		EXPECT_LT(position("Config"), position("Window"));
+		EXPECT_LT(position("Config"), position("Audio"));
+		EXPECT_LT(position("Window"), position("Renderer"));
+	}
+
+	TEST(SubsystemRegistryTests, MainThreadOnlyRunsOnCaller) {
+		RF::JobSystem jobSystem(2);
+		RF::SubsystemRegistry registry;
+
+		registry.Register({ .name = "Config", .init = []() {} });
+		registry.Register({ .name = "Window", .dependencies = { "Config" }, .init = []() {}, .mainThreadOnly = true });
+
+		ASSERT_TRUE(registry.InitializeAll(jobSystem));
+		EXPECT_EQ(registry.Timings()[1].threadIndex, 0u);
+	}
+
+	TEST(SubsystemRegistryTests, CriticalPathAndReport) {
+		RF::JobSystem jobSystem(2);
+		RF::SubsystemRegistry registry;
+		auto sleepFor = [](int ms) {
+			return [ms]() { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+		};
+
+		registry.Register({ .name = "Config", .init = sleepFor(1) });
+		registry.Register({ .name = "Assets", .dependencies = { "Config" }, .init = sleepFor(40) });
+		registry.Register({ .name = "Audio", .dependencies = { "Config" }, .init = sleepFor(1) });
+		registry.Register({ .name = "ECS", .dependencies = { "Assets", "Audio" }, .init = sleepFor(1) });
+
+		ASSERT_TRUE(registry.InitializeAll(jobSystem));
+
+		const std::vector<std::string> expected = { "Config", "Assets", "ECS" };
+		EXPECT_EQ(registry.CriticalPath(), expected);
+
+		const nlohmann::json report = registry.BuildReport();
+		EXPECT_EQ(report["subsystems"].size(), 4u);
+		EXPECT_EQ(report["criticalPath"].size(), 3u);
+		EXPECT_GE(report["serialMs"].get<double>(), report["criticalPathMs"].get<double>());
+	}
+}
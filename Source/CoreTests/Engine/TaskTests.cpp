@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+#include "Engine/Assets/assetStreamer.h"
+#include "Engine/FileSystem/virtualFileSystem.h"
+#include "Engine/Tasks/taskScheduler.h"
+#include "Engine/frameData.h"
+
+namespace {
+	class TaskTests : public testing::Test {
+	protected:
+		// Runs one frame and lets every resumed task run until it suspends again
+		void Step(const float deltaTime = 0.1f) {
+			mFrameData.deltaTime = deltaTime;
+			mFrameData.totalTime += deltaTime;
+			mScheduler.Update(mFrameData);
+			mScheduler.WaitUntilSuspended();
+		}
+
+		RF::JobSystem mJobSystem = RF::JobSystem(2);
+		RF::TaskScheduler mScheduler = RF::TaskScheduler(mJobSystem);
+		RF::FrameData mFrameData;
+	};
+
+	RF::Task<int> DoubleNextFrame(RF::TaskScheduler& scheduler, const int value) {
+		co_await scheduler.NextFrame();
+		co_return value * 2;
+	}
+
+	RF::Task<> QuadrupleInTwoFrames(RF::TaskScheduler& scheduler, int& result, uint64_t& finishedFrame) {
+		const int doubled = co_await DoubleNextFrame(scheduler, 10);
+		result = co_await DoubleNextFrame(scheduler, doubled);
+		finishedFrame = scheduler.FrameIndex();
+	}
+
+	RF::Task<> RecordAfterDelay(RF::TaskScheduler& scheduler, std::vector<int>& order, const double seconds, const int id) {
+		co_await scheduler.Delay(seconds);
+		order.push_back(id);
+	}
+
+	RF::Task<> SumWithJobs(RF::TaskScheduler& scheduler, RF::JobSystem& jobSystem, RF::JobCounter& counter, std::atomic<int>& sum, bool& isDone) {
+		for (int i = 1; i <= 10; ++i) {
+			jobSystem.Run([&sum, i]() { sum += i; }, &counter);
+		}
+		co_await scheduler.WaitFor(counter);
+		isDone = sum == 55;
+	}
+
+	// A spawn wave script, the wave size comes from a file
+	RF::Task<> SpawnWave(RF::TaskScheduler& scheduler, RF::AssetStreamer& streamer, int& spawnCount) {
+		RF::StreamRequest request = {
+			.path = "wave.txt",
+			.decode = [](RF::StreamResult& result) { result.asset = std::make_shared<int>(static_cast<int>(result.data[0]) - '0'); },
+		};
+		const RF::StreamResult wave = co_await scheduler.LoadAsset(streamer, std::move(request));
+
+		const int count = *std::static_pointer_cast<int>(wave.asset);
+		for (int i = 0; i < count; ++i) {
+			co_await scheduler.NextFrame();
+			++spawnCount;
+		}
+	}
+
+	RF::Task<> WaitForever(RF::TaskScheduler& scheduler) {
+		co_await DoubleNextFrame(scheduler, 1);
+		co_await scheduler.Delay(1000.0);
+	}
+}
+
+namespace RFTests {
+
+	TEST_F(TaskTests, NestedTasksAndNextFrame) {
+		int result = 0;
+		uint64_t finishedFrame = 0;
+		mScheduler.Spawn(QuadrupleInTwoFrames(mScheduler, result, finishedFrame));
+
+		mScheduler.WaitUntilSuspended();
+		EXPECT_EQ(mScheduler.ActiveCount(), 1u);
+
+		Step();
+		Step();
+
+		EXPECT_EQ(result, 40);
+		EXPECT_EQ(finishedFrame, 2u);
+		EXPECT_EQ(mScheduler.ActiveCount(), 0u);
+		EXPECT_EQ(RF::TaskFramePool::LiveFrameCount(), 0u);
+	}
+
+	TEST_F(TaskTests, DelayUsesSimTime) {
+		std::vector<int> order;
+		mScheduler.Spawn(RecordAfterDelay(mScheduler, order, 1.0, 2));
+		mScheduler.Spawn(RecordAfterDelay(mScheduler, order, 0.5, 1));
+		mScheduler.WaitUntilSuspended();
+
+		Step(0.4f);
+		EXPECT_TRUE(order.empty());
+		Step(0.4f);
+		EXPECT_EQ(order, std::vector<int>{ 1 });
+		Step(0.4f);
+		EXPECT_EQ(order, (std::vector<int>{ 1, 2 }));
+	}
+
+	TEST_F(TaskTests, WaitsForJobCounter) {
+		RF::JobCounter counter;
+		std::atomic<int> sum = 0;
+		bool isDone = false;
+		mScheduler.Spawn(SumWithJobs(mScheduler, mJobSystem, counter, sum, isDone));
+
+		while (mScheduler.ActiveCount() > 0) {
+			Step();
+		}
+
+		EXPECT_TRUE(isDone);
+	}
+
+	TEST_F(TaskTests, LoadsAssets) {
+		const std::filesystem::path root = std::filesystem::temp_directory_path() / "RuneForgeTaskTests";
+		std::filesystem::create_directories(root);
+		std::ofstream(root / "wave.txt") << "3";
+
+		RF::VirtualFileSystem fileSystem;
+		ASSERT_TRUE(fileSystem.MountDirectory(root));
+		int spawnCount = 0;
+		{
+			RF::AssetStreamer streamer(fileSystem, mJobSystem, nullptr);
+			mScheduler.Spawn(SpawnWave(mScheduler, streamer, spawnCount));
+
+			while (mScheduler.ActiveCount() > 0) {
+				streamer.ProcessCompletions();
+				Step();
+			}
+		}
+		fileSystem.UnmountAll();
+		std::filesystem::remove_all(root);
+
+		EXPECT_EQ(spawnCount, 3);
+	}
+
+	TEST_F(TaskTests, UnfinishedTasksAreDestroyed) {
+		{
+			RF::TaskScheduler scheduler(mJobSystem);
+			scheduler.Spawn(WaitForever(scheduler));
+			scheduler.WaitUntilSuspended();
+			EXPECT_GT(RF::TaskFramePool::LiveFrameCount(), 0u);
+		}
+		EXPECT_EQ(RF::TaskFramePool::LiveFrameCount(), 0u);
+	}
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Engine/Lod/tickLodScheduler.h"
+
+namespace RFTests {
+
+	TEST(TickLodSchedulerTests, BucketsTickAtTheirRateWithTheTimeSinceTheLastTick) {
+		RF::TickLodScheduler scheduler;
+		const RF::TickLodId near = scheduler.Add(10);
+		const RF::TickLodId middle = scheduler.Add(11);
+		const RF::TickLodId far = scheduler.Add(12);
+		scheduler.SetLod(near, 5.0f, false);
+		scheduler.SetLod(middle, 40.0f, false);
+		scheduler.SetLod(far, 500.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(near), 0u);
+		EXPECT_EQ(scheduler.GetBucket(middle), 1u);
+		EXPECT_EQ(scheduler.GetBucket(far), 3u);
+
+		std::vector<int> tickCounts(3, 0);
+		std::vector<float> tickedTimes(3, 0.0f);
+		for (int frame = 0; frame < 16; ++frame) {
+			for (const RF::TickLodItem& item : scheduler.Tick(0.25f)) {
+				EXPECT_EQ(item.userData, 10 + item.id);
+				++tickCounts[item.id];
+				tickedTimes[item.id] += item.deltaTime;
+				// The first tick of each also gets the time from being added to its first frame
+				if (tickCounts[item.id] > 1) {
+					EXPECT_FLOAT_EQ(item.deltaTime, 0.25f * static_cast<float>(1 << scheduler.GetBucket(item.id)));
+				}
+			}
+		}
+		EXPECT_EQ(tickCounts, std::vector<int>({ 16, 8, 2 }));
+		// Nothing is lost, each has been given the time up to its last tick
+		EXPECT_FLOAT_EQ(tickedTimes[near], 4.0f);
+		EXPECT_FLOAT_EQ(tickedTimes[middle], 3.75f);
+		EXPECT_FLOAT_EQ(tickedTimes[far], 2.25f);
+	}
+
+	TEST(TickLodSchedulerTests, BucketsAreSpreadEvenlyOverFrames) {
+		RF::TickLodScheduler scheduler;
+		std::vector<RF::TickLodId> ids;
+		for (uint32_t i = 0; i < 1000; ++i) {
+			ids.push_back(scheduler.Add(i));
+			scheduler.SetLod(ids.back(), i % 2 == 0 ? 200.0f : 30.0f, false);
+		}
+		EXPECT_EQ(scheduler.CountInBucket(1), 500u);
+		EXPECT_EQ(scheduler.CountInBucket(3), 500u);
+
+		// 250 from the every other frame bucket and 62 or 63 from the every 8th frame one
+		std::vector<int> seen(1000, 0);
+		for (int frame = 0; frame < 8; ++frame) {
+			const std::span<const RF::TickLodItem> due = scheduler.Tick(1.0f / 60.0f);
+			EXPECT_GE(due.size(), 312u);
+			EXPECT_LE(due.size(), 313u);
+			for (const RF::TickLodItem& item : due) {
+				++seen[item.userData];
+			}
+		}
+		for (uint32_t i = 0; i < 1000; ++i) {
+			EXPECT_EQ(seen[i], i % 2 == 0 ? 1 : 4);
+		}
+	}
+
+	TEST(TickLodSchedulerTests, HysteresisVisibilityAndRemoval) {
+		RF::TickLodSettings settings;
+		settings.maxVisibleBucket = 1;
+		RF::TickLodScheduler scheduler(settings);
+		const RF::TickLodId id = scheduler.Add();
+
+		// Slower only once past the boundary by the hysteresis, faster right away
+		scheduler.SetLod(id, 26.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(id), 0u);
+		scheduler.SetLod(id, 28.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(id), 1u);
+		scheduler.SetLod(id, 26.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(id), 1u);
+		scheduler.SetLod(id, 24.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(id), 0u);
+		scheduler.SetLod(id, 1000.0f, true);
+		EXPECT_EQ(scheduler.GetBucket(id), 1u);
+		scheduler.SetLod(id, 1000.0f, false);
+		EXPECT_EQ(scheduler.GetBucket(id), 3u);
+
+		// Ticked once over the 8 frames, then sped up it gets the time it missed on its next tick
+		float tickedTime = 0.0f;
+		for (int frame = 0; frame < 11; ++frame) {
+			if (frame == 8) {
+				scheduler.SetLod(id, 0.0f, false);
+			}
+			for (const RF::TickLodItem& item : scheduler.Tick(0.5f)) {
+				tickedTime += item.deltaTime;
+			}
+		}
+		EXPECT_FLOAT_EQ(tickedTime, 5.5f);
+
+		const RF::TickLodId other = scheduler.Add(7);
+		scheduler.Remove(id);
+		EXPECT_EQ(scheduler.Count(), 1u);
+		const std::span<const RF::TickLodItem> due = scheduler.Tick(0.5f);
+		ASSERT_EQ(due.size(), 1u);
+		EXPECT_EQ(due[0].id, other);
+		EXPECT_EQ(scheduler.Add(), id);
+	}
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Engine/frameData.h"
+#include "Engine/Timers/timingWheel.h"
+
+namespace {
+	constexpr float gTickDuration = 0.25f;
+
+	// Expired timers with the tick they expired on, in the order the callbacks saw them
+	struct Recorder {
+		struct Entry {
+			uint32_t userData = 0;
+			uint64_t tick = 0;
+			RF::TimerKindId kind = 0;
+		};
+
+		RF::TimerKindId AddKind(RF::TimingWheel& wheel) {
+			const RF::TimerKindId kind = static_cast<RF::TimerKindId>(batchCounts.size());
+			batchCounts.push_back(0);
+			return wheel.AddKind([this, &wheel, kind](std::span<const RF::TimerExpiry> expired) {
+				++batchCounts[kind];
+				for (const RF::TimerExpiry& expiry : expired) {
+					entries.push_back({ expiry.userData, wheel.NextTick() - 1, kind });
+				}
+			});
+		}
+
+		std::vector<Entry> entries;
+		std::vector<int> batchCounts;
+	};
+
+	// Ticks are exact in float, so totalTime can be set directly for big jumps
+	void UpdateTo(RF::TimingWheel& wheel, const uint64_t tick) {
+		RF::FrameData frameData;
+		frameData.totalTime = static_cast<float>(tick) * gTickDuration;
+		wheel.Update(frameData);
+	}
+}
+
+namespace RFTests {
+
+	TEST(TimingWheelTests, ExpiresOnTheirTickInBatchesPerKind) {
+		RF::TimingWheel wheel(gTickDuration);
+		Recorder recorder;
+		const RF::TimerKindId buffs = recorder.AddKind(wheel);
+		const RF::TimerKindId cooldowns = recorder.AddKind(wheel);
+		wheel.Schedule(buffs, 1.0f, 1);
+		wheel.Schedule(cooldowns, 1.0f, 2);
+		wheel.Schedule(buffs, 1.0f, 3);
+		wheel.Schedule(buffs, 0.5f, 4);
+		// Rounded to a tick, and never the tick that already passed
+		wheel.Schedule(cooldowns, 0.0f, 5);
+		wheel.Schedule(cooldowns, 0.3f, 6);
+		EXPECT_EQ(wheel.Count(), 6u);
+
+		// Driven by totalTime, adding up float deltas like the frame loop does
+		RF::FrameData frameData;
+		for (int frame = 0; frame < 16; ++frame) {
+			frameData.deltaTime = 1.0f / 16.0f;
+			frameData.totalTime += frameData.deltaTime;
+			wheel.Update(frameData);
+		}
+		EXPECT_EQ(wheel.NextTick(), 5u);
+		EXPECT_EQ(wheel.Count(), 0u);
+
+		ASSERT_EQ(recorder.entries.size(), 6u);
+		const std::vector<std::pair<uint32_t, uint64_t>> expected = { { 5, 1 }, { 6, 1 }, { 4, 2 }, { 1, 4 }, { 3, 4 }, { 2, 4 } };
+		for (size_t i = 0; i < expected.size(); ++i) {
+			EXPECT_EQ(recorder.entries[i].userData, expected[i].first);
+			EXPECT_EQ(recorder.entries[i].tick, expected[i].second);
+		}
+		// Both buffs of tick 4 came in one call
+		EXPECT_EQ(recorder.batchCounts[buffs], 2);
+		EXPECT_EQ(recorder.batchCounts[cooldowns], 2);
+	}
+
+	TEST(TimingWheelTests, FarTimersMoveDownTheLevels) {
+		RF::TimingWheel wheel(gTickDuration);
+		Recorder recorder;
+		const RF::TimerKindId kind = recorder.AddKind(wheel);
+		// One for every level, and ones on the level boundaries
+		const std::vector<uint64_t> delays = { 1, 255, 256, 257, 4000, 65535, 65536, 65537, 1000000, 16777216, 20000000 };
+		for (size_t i = 0; i < delays.size(); ++i) {
+			wheel.Schedule(kind, static_cast<float>(delays[i]) * gTickDuration, static_cast<uint32_t>(i));
+		}
+
+		// A few big jumps, and single steps over the boundaries
+		for (const uint64_t tick : { uint64_t(200), uint64_t(70000), uint64_t(16777210), uint64_t(16777216), uint64_t(16777217), uint64_t(20000001) }) {
+			UpdateTo(wheel, tick);
+		}
+		ASSERT_EQ(recorder.entries.size(), delays.size());
+		for (size_t i = 0; i < delays.size(); ++i) {
+			EXPECT_EQ(recorder.entries[i].userData, i);
+			EXPECT_EQ(recorder.entries[i].tick, delays[i]);
+		}
+	}
+
+	TEST(TimingWheelTests, RepeatAndCancel) {
+		RF::TimingWheel wheel(gTickDuration);
+		Recorder recorder;
+		const RF::TimerKindId followUps = recorder.AddKind(wheel);
+		std::vector<uint64_t> ticks;
+		RF::TimerId damageOverTime = RF::gInvalidTimer;
+		RF::TimerId doomed = RF::gInvalidTimer;
+		const RF::TimerKindId damage = wheel.AddKind([&wheel, &ticks, &damageOverTime, &doomed, followUps](std::span<const RF::TimerExpiry> expired) {
+			for (const RF::TimerExpiry& expiry : expired) {
+				EXPECT_EQ(expiry.id, damageOverTime);
+				ticks.push_back(wheel.NextTick() - 1);
+				if (ticks.size() == 2) {
+					// From inside a callback, the cancelled timer never expires and the new one counts from this tick
+					EXPECT_TRUE(wheel.Cancel(doomed));
+					wheel.Schedule(followUps, 0.25f, 9);
+				}
+				if (ticks.size() == 4) {
+					EXPECT_TRUE(wheel.Cancel(expiry.id));
+				}
+			}
+		});
+
+		damageOverTime = wheel.Schedule(damage, 0.5f, 0, 1.0f);
+		doomed = wheel.Schedule(damage, 1000.0f, 1);
+		EXPECT_TRUE(wheel.IsPending(doomed));
+		UpdateTo(wheel, 30);
+		EXPECT_EQ(ticks, std::vector<uint64_t>({ 2, 6, 10, 14 }));
+		ASSERT_EQ(recorder.entries.size(), 1u);
+		EXPECT_EQ(recorder.entries[0].userData, 9u);
+		EXPECT_EQ(recorder.entries[0].tick, 7u);
+		EXPECT_EQ(wheel.Count(), 0u);
+		EXPECT_FALSE(wheel.IsPending(doomed));
+		EXPECT_FALSE(wheel.Cancel(doomed));
+
+		// Pooled nodes are reused, under a new id
+		const RF::TimerId reused = wheel.Schedule(followUps, 1.0f);
+		EXPECT_NE(reused, damageOverTime);
+		EXPECT_NE(reused, doomed);
+		EXPECT_FALSE(wheel.IsPending(damageOverTime));
+		EXPECT_TRUE(wheel.IsPending(reused));
+	}
+
+	TEST(TimingWheelTests, MatchesAnOrderedMap) {
+		RF::TimingWheel wheel(gTickDuration);
+		std::map<uint64_t, std::vector<uint32_t>> expired;
+		const RF::TimerKindId kind = wheel.AddKind([&wheel, &expired](std::span<const RF::TimerExpiry> batch) {
+			for (const RF::TimerExpiry& expiry : batch) {
+				expired[wheel.NextTick() - 1].push_back(expiry.userData);
+			}
+		});
+
+		struct Scheduled {
+			RF::TimerId id = RF::gInvalidTimer;
+			uint64_t expiryTick = 0;
+		};
+		std::mt19937 random(50);
+		std::uniform_int_distribution<uint32_t> delay(1, 100000);
+		std::map<uint64_t, std::vector<uint32_t>> expected;
+		std::vector<Scheduled> scheduled;
+		for (uint64_t tick = 1; tick <= 120000; ++tick) {
+			if (tick < 20000) {
+				for (int i = 0; i < 3; ++i) {
+					// Scheduled between updates, so counted from the last processed tick
+					const uint32_t userData = static_cast<uint32_t>(scheduled.size());
+					const uint64_t expiryTick = tick - 1 + delay(random);
+					scheduled.push_back({ wheel.Schedule(kind, static_cast<float>(expiryTick - tick + 1) * gTickDuration, userData), expiryTick });
+					expected[expiryTick].push_back(userData);
+				}
+				const uint32_t victim = static_cast<uint32_t>(random() % scheduled.size());
+				if (wheel.Cancel(scheduled[victim].id)) {
+					std::erase(expected[scheduled[victim].expiryTick], victim);
+				}
+			}
+			UpdateTo(wheel, tick);
+		}
+
+		EXPECT_EQ(wheel.Count(), 0u);
+		std::erase_if(expected, [](const auto& entry) { return entry.second.empty(); });
+		// Timers of the same tick may come in any order
+		for (auto& [tick, userData] : expired) {
+			std::sort(userData.begin(), userData.end());
+		}
+		EXPECT_EQ(expired, expected);
+	}
+}
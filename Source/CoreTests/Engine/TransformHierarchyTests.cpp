@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Engine/Jobs/jobSystem.h"
+#include "Engine/Scene/transformHierarchy.h"
+
+namespace {
+	// Plain recursive composition, what Update() has to match
+	RF::Affine2D ReferenceWorld(const RF::TransformHierarchy& hierarchy, const RF::TransformId id) {
+		const RF::TransformId parent = hierarchy.GetParent(id);
+		const RF::Affine2D local = hierarchy.GetLocal(id);
+		return parent == RF::gNoTransform ? local : RF::Transforms::Multiply(ReferenceWorld(hierarchy, parent), local);
+	}
+
+	void ExpectMatchesReference(const RF::TransformHierarchy& hierarchy, const std::vector<RF::TransformId>& ids) {
+		for (const RF::TransformId id : ids) {
+			if (!hierarchy.IsAlive(id)) {
+				continue;
+			}
+
+			const RF::Affine2D expected = ReferenceWorld(hierarchy, id);
+			const RF::Affine2D world = hierarchy.GetWorld(id);
+			ASSERT_NEAR(world.m00, expected.m00, 1e-4f);
+			ASSERT_NEAR(world.m01, expected.m01, 1e-4f);
+			ASSERT_NEAR(world.m10, expected.m10, 1e-4f);
+			ASSERT_NEAR(world.m11, expected.m11, 1e-4f);
+			ASSERT_NEAR(world.tx, expected.tx, 1e-2f);
+			ASSERT_NEAR(world.ty, expected.ty, 1e-2f);
+		}
+	}
+
+	RF::Transform2D RandomLocal(std::mt19937& random) {
+		std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> scale(0.8f, 1.2f);
+		return { position(random), position(random), angle(random), scale(random), scale(random) };
+	}
+
+	// Every node picks a random earlier node as parent, or none
+	std::vector<RF::TransformId> BuildRandomTree(RF::TransformHierarchy& hierarchy, const size_t count, std::mt19937& random) {
+		std::vector<RF::TransformId> ids;
+		for (size_t i = 0; i < count; ++i) {
+			const size_t parent = std::uniform_int_distribution<size_t>(0, i)(random);
+			ids.push_back(hierarchy.Create(parent == i ? RF::gNoTransform : ids[parent], RandomLocal(random)));
+		}
+		return ids;
+	}
+}
+
+namespace RFTests {
+
+	TEST(TransformHierarchyTests, ChildrenFollowParents) {
+		RF::TransformHierarchy hierarchy;
+		const RF::TransformId ship = hierarchy.Create(RF::gNoTransform, { .x = 10.0f, .y = 0.0f, .rotation = 1.5707964f });
+		const RF::TransformId turret = hierarchy.Create(ship, { .x = 2.0f });
+		const RF::TransformId muzzle = hierarchy.Create(turret, { .x = 1.0f, .scaleX = 2.0f });
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LevelCount(), 3u);
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), 3u);
+
+		// The ship faces +y, so its children are in front of it along y
+		const RF::Affine2D muzzleWorld = hierarchy.GetWorld(muzzle);
+		EXPECT_NEAR(muzzleWorld.tx, 10.0f, 1e-5f);
+		EXPECT_NEAR(muzzleWorld.ty, 3.0f, 1e-5f);
+		EXPECT_NEAR(muzzleWorld.m10, 2.0f, 1e-5f);
+
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), 0u);
+
+		hierarchy.SetLocal(turret, RF::Transform2D{ .x = 4.0f });
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), 2u);
+		EXPECT_NEAR(hierarchy.GetWorld(muzzle).ty, 5.0f, 1e-5f);
+
+		hierarchy.SetParent(muzzle, RF::gNoTransform);
+		hierarchy.Update();
+		EXPECT_NEAR(hierarchy.GetWorld(muzzle).tx, 1.0f, 1e-5f);
+		EXPECT_EQ(hierarchy.GetParent(muzzle), RF::gNoTransform);
+
+		hierarchy.SetParent(muzzle, turret);
+		hierarchy.Destroy(ship);
+		hierarchy.Update();
+		EXPECT_FALSE(hierarchy.IsAlive(turret));
+		EXPECT_FALSE(hierarchy.IsAlive(muzzle));
+		EXPECT_EQ(hierarchy.Count(), 0u);
+	}
+
+	TEST(TransformHierarchyTests, OnlyDirtySubtreesAreVisited) {
+		std::mt19937 random(7);
+		RF::TransformHierarchy hierarchy;
+		std::vector<RF::TransformId> ids = BuildRandomTree(hierarchy, 3000, random);
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), 3000u);
+		ExpectMatchesReference(hierarchy, ids);
+
+		for (int frame = 0; frame < 20; ++frame) {
+			std::vector<bool> isDirty(ids.size(), false);
+			for (int i = 0; i < 10; ++i) {
+				const size_t node = std::uniform_int_distribution<size_t>(0, ids.size() - 1)(random);
+				hierarchy.SetLocal(ids[node], RandomLocal(random));
+				isDirty[node] = true;
+			}
+
+			// A node is recomputed if it or any ancestor was set, ids were created parents first
+			size_t expectedCount = 0;
+			for (size_t i = 0; i < ids.size(); ++i) {
+				for (RF::TransformId node = ids[i]; node != RF::gNoTransform; node = hierarchy.GetParent(node)) {
+					if (isDirty[node]) {
+						++expectedCount;
+						break;
+					}
+				}
+			}
+
+			hierarchy.Update();
+			EXPECT_EQ(hierarchy.LastUpdatedCount(), expectedCount);
+			ExpectMatchesReference(hierarchy, ids);
+		}
+	}
+
+	TEST(TransformHierarchyTests, StructuralChangesKeepWorldTransforms) {
+		std::mt19937 random(11);
+		RF::TransformHierarchy hierarchy;
+		std::vector<RF::TransformId> ids = BuildRandomTree(hierarchy, 2000, random);
+		hierarchy.Update();
+
+		for (int frame = 0; frame < 10; ++frame) {
+			for (int i = 0; i < 20; ++i) {
+				const RF::TransformId node = ids[std::uniform_int_distribution<size_t>(0, ids.size() - 1)(random)];
+				const RF::TransformId parent = ids[std::uniform_int_distribution<size_t>(0, ids.size() - 1)(random)];
+				if (!hierarchy.IsAlive(node) || !hierarchy.IsAlive(parent)) {
+					continue;
+				}
+
+				bool isAncestor = false;
+				for (RF::TransformId ancestor = parent; ancestor != RF::gNoTransform; ancestor = hierarchy.GetParent(ancestor)) {
+					isAncestor |= ancestor == node;
+				}
+				if (!isAncestor) {
+					hierarchy.SetParent(node, parent);
+				}
+			}
+
+			const RF::TransformId doomed = ids[std::uniform_int_distribution<size_t>(0, ids.size() - 1)(random)];
+			if (hierarchy.IsAlive(doomed)) {
+				hierarchy.Destroy(doomed);
+			}
+			ids.push_back(hierarchy.Create(hierarchy.IsAlive(ids[0]) ? ids[0] : RF::gNoTransform, RandomLocal(random)));
+
+			hierarchy.Update();
+			ExpectMatchesReference(hierarchy, ids);
+		}
+	}
+
+	TEST(TransformHierarchyTests, ParallelLevelsMatchReference) {
+		RF::JobSystem jobSystem(3);
+		RF::TransformHierarchy hierarchy(&jobSystem);
+
+		// Wide levels so Update() splits them over jobs
+		std::mt19937 random(3);
+		std::vector<RF::TransformId> ids;
+		for (int root = 0; root < 100; ++root) {
+			const RF::TransformId rootId = hierarchy.Create(RF::gNoTransform, RandomLocal(random));
+			ids.push_back(rootId);
+			for (int child = 0; child < 20; ++child) {
+				const RF::TransformId childId = hierarchy.Create(rootId, RandomLocal(random));
+				ids.push_back(childId);
+				for (int grandChild = 0; grandChild < 20; ++grandChild) {
+					ids.push_back(hierarchy.Create(childId, RandomLocal(random)));
+				}
+			}
+		}
+
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), ids.size());
+		ExpectMatchesReference(hierarchy, ids);
+
+		hierarchy.SetLocal(ids[0], RandomLocal(random));
+		hierarchy.Update();
+		EXPECT_EQ(hierarchy.LastUpdatedCount(), 1u + 20u + 400u);
+		ExpectMatchesReference(hierarchy, ids);
+	}
+}
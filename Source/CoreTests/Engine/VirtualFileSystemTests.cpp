@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Engine/FileSystem/pakArchive.h"
+#include "Engine/FileSystem/virtualFileSystem.h"
+
+namespace {
+	std::span<const std::byte> AsBytes(std::string_view text) {
+		return std::as_bytes(std::span<const char>(text.data(), text.size()));
+	}
+
+	std::string AsString(std::span<const std::byte> data) {
+		return std::string(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	// Writes a copy of a pak with a field overwritten
+	void WritePatched(const std::filesystem::path& source, const std::filesystem::path& destination, const size_t offset, const uint64_t value) {
+		std::ifstream in(source, std::ios::binary);
+		std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		std::memcpy(bytes.data() + offset, &value, sizeof(value));
+		std::ofstream(destination, std::ios::binary) << bytes;
+	}
+
+	class VirtualFileSystemTests : public testing::Test {
+	protected:
+		void SetUp() override {
+			mRoot = std::filesystem::temp_directory_path() / "RuneForgeVfsTests";
+			std::filesystem::remove_all(mRoot);
+			std::filesystem::create_directories(mRoot / "Loose" / "Textures");
+
+			std::ofstream(mRoot / "Loose" / "Textures" / "grass.txt") << "loose grass";
+			std::ofstream(mRoot / "Loose" / "readme.txt") << "loose readme";
+		}
+
+		void TearDown() override {
+			std::filesystem::remove_all(mRoot);
+		}
+
+		std::filesystem::path mRoot;
+	};
+}
+
+namespace RFTests {
+
+	TEST_F(VirtualFileSystemTests, PakRoundTrip) {
+		RF::PakWriter writer;
+		for (int i = 0; i < 100; ++i) {
+			const std::string content = "file number " + std::to_string(i);
+			writer.Add("Data\\file" + std::to_string(i) + ".txt", AsBytes(content));
+		}
+		ASSERT_TRUE(writer.Write(mRoot / "base.pak"));
+
+		RF::PakArchive pak;
+		ASSERT_TRUE(pak.Open(mRoot / "base.pak"));
+		EXPECT_EQ(pak.Entries().size(), 100u);
+
+		for (int i = 0; i < 100; ++i) {
+			const RF::PakEntry* entry = pak.Find("Data/file" + std::to_string(i) + ".txt");
+			ASSERT_NE(entry, nullptr);
+			EXPECT_EQ(AsString(pak.Read(*entry)), "file number " + std::to_string(i));
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(pak.Read(*entry).data()) % RF::gPakDataAlignment, 0u);
+		}
+		EXPECT_EQ(pak.Find("Data/missing.txt"), nullptr);
+	}
+
+	TEST_F(VirtualFileSystemTests, RejectsInvalidPak) {
+		std::ofstream(mRoot / "broken.pak") << "not a pak file at all, just some text";
+
+		RF::PakArchive pak;
+		EXPECT_FALSE(pak.Open(mRoot / "broken.pak"));
+		EXPECT_FALSE(pak.Open(mRoot / "missing.pak"));
+	}
+
+	TEST_F(VirtualFileSystemTests, RejectsMalformedPak) {
+		RF::PakWriter writer;
+		writer.Add("a.txt", AsBytes("first"));
+		writer.Add("b.txt", AsBytes("second"));
+		ASSERT_TRUE(writer.Write(mRoot / "good.pak"));
+		RF::PakHeader header;
+		std::ifstream(mRoot / "good.pak", std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+		ASSERT_EQ(header.entryCount, 2u);
+
+		// Counts and sizes that would wrap around when added to an offset
+		const size_t entry = static_cast<size_t>(header.tableOffset);
+		const std::vector<std::pair<size_t, uint64_t>> patches = {
+			{ offsetof(RF::PakHeader, entryCount), uint64_t(1) << 60 },
+			{ offsetof(RF::PakHeader, tableOffset), ~uint64_t(0) & ~uint64_t(7) },
+			{ entry + offsetof(RF::PakEntry, size), ~uint64_t(0) - 16 },
+			{ entry + offsetof(RF::PakEntry, offset), ~uint64_t(0) - 16 },
+			// Unsorted hashes, Find() couldn't binary search them
+			{ entry + offsetof(RF::PakEntry, pathHash), ~uint64_t(0) },
+		};
+		for (const auto& [offset, value] : patches) {
+			WritePatched(mRoot / "good.pak", mRoot / "bad.pak", offset, value);
+			RF::PakArchive pak;
+			EXPECT_FALSE(pak.Open(mRoot / "bad.pak")) << offset;
+		}
+	}
+
+	TEST_F(VirtualFileSystemTests, LooseFilesAndMountPoints) {
+		RF::VirtualFileSystem vfs;
+		ASSERT_TRUE(vfs.MountDirectory(mRoot / "Loose", "Assets"));
+
+		EXPECT_EQ(AsString(vfs.Read("Assets/Textures/grass.txt")), "loose grass");
+		EXPECT_EQ(AsString(vfs.Read("./Assets\\readme.txt")), "loose readme");
+		EXPECT_TRUE(vfs.Exists("Assets/readme.txt"));
+		EXPECT_FALSE(vfs.Exists("readme.txt"));
+		EXPECT_TRUE(vfs.Read("Assets/missing.txt").empty());
+
+		// Nothing outside the mounted directory
+		std::ofstream(mRoot / "secret.txt") << "secret";
+		EXPECT_TRUE(vfs.Read("Assets/../secret.txt").empty());
+		EXPECT_TRUE(vfs.Read("Assets/Textures/../../secret.txt").empty());
+		EXPECT_FALSE(vfs.Exists("Assets/../secret.txt"));
+		RF::FileLocation location;
+		EXPECT_FALSE(vfs.Resolve("Assets/../secret.txt", location));
+
+		// Reading the same file again hands out the same mapping
+		EXPECT_EQ(vfs.Read("Assets/readme.txt").data(), vfs.Read("Assets/readme.txt").data());
+	}
+
+	TEST_F(VirtualFileSystemTests, LaterMountsShadowEarlierOnes) {
+		RF::PakWriter base;
+		base.Add("Textures/grass.txt", AsBytes("base grass"));
+		base.Add("Textures/stone.txt", AsBytes("base stone"));
+		ASSERT_TRUE(base.Write(mRoot / "base.pak"));
+
+		RF::PakWriter patch;
+		patch.Add("Textures/stone.txt", AsBytes("patched stone"));
+		ASSERT_TRUE(patch.Write(mRoot / "patch01.pak"));
+
+		RF::VirtualFileSystem vfs;
+		ASSERT_TRUE(vfs.MountDirectory(mRoot / "Loose"));
+		EXPECT_EQ(vfs.MountPaksInDirectory(mRoot), 2u);
+
+		EXPECT_EQ(AsString(vfs.Read("Textures/grass.txt")), "base grass");
+		EXPECT_EQ(AsString(vfs.Read("Textures/stone.txt")), "patched stone");
+		EXPECT_EQ(AsString(vfs.Read("readme.txt")), "loose readme");
+
+		vfs.UnmountAll();
+		EXPECT_EQ(vfs.MountCount(), 0u);
+		EXPECT_FALSE(vfs.Exists("Textures/grass.txt"));
+	}
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "Platform/asyncFileBackend.h"
+#ifdef __linux__
+#include "Platform/ioUringFileBackend.h"
+#endif
+
+namespace {
+	std::vector<char> MakeContent(const size_t size, const char seed) {
+		std::vector<char> content(size);
+		for (size_t i = 0; i < size; ++i) {
+			content[i] = static_cast<char>(seed + static_cast<char>(i % 251));
+		}
+		return content;
+	}
+
+	std::unique_ptr<RF::AsyncFileBackend> CreateBackend(const std::string& name) {
+		RF::AsyncFileSettings settings;
+		settings.queueDepth = 8;
+		settings.registeredBufferCount = 2;
+		settings.registeredBufferSize = 64 * 1024;
+		settings.chunkSize = 256 * 1024;
+		settings.directIoThreshold = 1024 * 1024;
+		settings.fallbackThreadCount = 2;
+
+#ifdef __linux__
+		if (name == "io_uring") {
+			auto backend = std::make_unique<RF::IoUringFileBackend>();
+			return backend->Init(settings) ? std::move(backend) : nullptr;
+		}
+#endif
+		return std::make_unique<RF::ThreadPoolFileBackend>(settings.fallbackThreadCount);
+	}
+
+	class AsyncFileBackendTests : public testing::TestWithParam<std::string> {
+	protected:
+		void SetUp() override {
+			mBackend = CreateBackend(GetParam());
+			if (!mBackend) {
+				GTEST_SKIP() << GetParam() << " is not available on this machine";
+			}
+
+			mRoot = std::filesystem::temp_directory_path() / ("RuneForgeAsyncFileTests_" + GetParam());
+			std::filesystem::remove_all(mRoot);
+			std::filesystem::create_directories(mRoot);
+		}
+
+		void TearDown() override {
+			mBackend.reset();
+			std::filesystem::remove_all(mRoot);
+		}
+
+		std::filesystem::path WriteFile(const std::string& name, const std::vector<char>& content) {
+			const std::filesystem::path path = mRoot / name;
+			std::ofstream(path, std::ios::binary).write(content.data(), static_cast<std::streamsize>(content.size()));
+			return path;
+		}
+
+		std::filesystem::path mRoot;
+		std::unique_ptr<RF::AsyncFileBackend> mBackend;
+	};
+}
+
+namespace RFTests {
+
+	TEST_P(AsyncFileBackendTests, BatchOfSmallFiles) {
+		constexpr size_t fileCount = 50;
+		std::vector<std::vector<char>> contents;
+		std::vector<RF::FileReadRequest> requests;
+		std::atomic<size_t> matches = 0;
+
+		for (size_t i = 0; i < fileCount; ++i) {
+			// Mixes sizes that fit in the registered buffers with ones that don't
+			contents.push_back(MakeContent(1000 + i * 3000, static_cast<char>(i)));
+		}
+		for (size_t i = 0; i < fileCount; ++i) {
+			RF::FileReadRequest request;
+			request.path = WriteFile("small" + std::to_string(i) + ".bin", contents[i]);
+			request.userData = i;
+			request.onComplete = [&contents, &matches](const RF::FileReadResult& result) {
+				const std::vector<char>& expected = contents[result.userData];
+				if (result.error == 0 && result.data.size() == expected.size() && std::memcmp(result.data.data(), expected.data(), expected.size()) == 0) {
+					++matches;
+				}
+			};
+			requests.push_back(std::move(request));
+		}
+
+		mBackend->Submit(std::move(requests));
+		mBackend->WaitIdle();
+
+		EXPECT_EQ(matches.load(), fileCount);
+	}
+
+	TEST_P(AsyncFileBackendTests, LargeFileIntoDestination) {
+		const std::vector<char> content = MakeContent(3 * 1024 * 1024 + 123, 7);
+		RF::AlignedBuffer buffer(content.size());
+
+		RF::FileReadRequest request;
+		request.path = WriteFile("large.bin", content);
+		request.destination = { buffer.Span().data(), buffer.Capacity() };
+
+		int error = -1;
+		size_t size = 0;
+		request.onComplete = [&error, &size](const RF::FileReadResult& result) {
+			error = result.error;
+			size = result.data.size();
+		};
+		mBackend->Submit({ request });
+		mBackend->WaitIdle();
+
+		EXPECT_EQ(error, 0);
+		ASSERT_EQ(size, content.size());
+		EXPECT_EQ(std::memcmp(buffer.Span().data(), content.data(), content.size()), 0);
+	}
+
+	TEST_P(AsyncFileBackendTests, RangesAndErrors) {
+		const std::vector<char> content = MakeContent(10000, 3);
+
+		RF::FileReadRequest range;
+		range.path = WriteFile("range.bin", content);
+		range.offset = 1000;
+		range.size = 500;
+		std::vector<char> rangeData;
+		range.onComplete = [&rangeData](const RF::FileReadResult& result) {
+			const char* begin = reinterpret_cast<const char*>(result.data.data());
+			rangeData.assign(begin, begin + result.data.size());
+		};
+
+		RF::FileReadRequest missing;
+		missing.path = mRoot / "missing.bin";
+		int missingError = 0;
+		missing.onComplete = [&missingError](const RF::FileReadResult& result) { missingError = result.error; };
+
+		mBackend->Submit({ range, missing });
+		mBackend->WaitIdle();
+
+		EXPECT_EQ(rangeData, std::vector<char>(content.begin() + 1000, content.begin() + 1500));
+		EXPECT_NE(missingError, 0);
+	}
+
+	INSTANTIATE_TEST_SUITE_P(Backends, AsyncFileBackendTests, testing::Values("ThreadPool", "io_uring"));
+}
@@ -10,6 +10,7 @@ project(NAME)
     kind("ConsoleApp")
 
     dependson{ CORE_NAME, EXTERNAL_NAME }
+    links{ CORE_NAME }
 
     debugdir(directories.bin)
     targetdir(directories.bin)